@@ -132,6 +132,10 @@ project("ImageViewer")
 
 group("Tools")
 
+project("AOBaker")
+	ToolSetup()
+	files({ "src/tools/AOBaker.cpp" })
+
 project("AtmosphericScatteringEstimator")
 	ToolSetup()
 	files({ "src/tools/AtmosphericScatteringEstimator.cpp" })
@@ -145,6 +149,22 @@ project("ControllerTest")
 	ToolSetup()
 	files({ "src/tools/controllertest/**.hpp", "src/tools/controllertest/**.cpp", })
 
+project("MeshBenchmark")
+	ToolSetup()
+	files({ "src/tools/MeshBenchmark.cpp" })
+
+project("MeshConverter")
+	ToolSetup()
+	files({ "src/tools/MeshConverter.cpp" })
+
+project("MipmapGenerator")
+	ToolSetup()
+	files({ "src/tools/MipmapGenerator.cpp" })
+
+project("ResourcePacker")
+	ToolSetup()
+	files({ "src/tools/ResourcePacker.cpp" })
+
 project("SHExtractor")
 	ToolSetup()	
 	files({ "src/tools/SHExtractor.cpp" })
@@ -162,7 +182,7 @@ group("Meta")
 project("ALL")
 	CPPSetup()
 	kind("ConsoleApp")
-	dependson( {"Engine", "PBRDemo", "Playground", "Atmosphere", "ImageViewer", "AtmosphericScatteringEstimator", "BRDFEstimator", "SHExtractor", "ControllerTest" })
+	dependson( {"Engine", "PBRDemo", "Playground", "Atmosphere", "ImageViewer", "AtmosphericScatteringEstimator", "BRDFEstimator", "SHExtractor", "ControllerTest", "MeshBenchmark", "MeshConverter", "MipmapGenerator", "AOBaker", "ResourcePacker" })
 
 -- Actions
 
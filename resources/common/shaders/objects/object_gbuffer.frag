@@ -21,8 +21,11 @@ layout (location = 2) out vec3 fragEffects; ///< Effects.
 void main(){
 	
 	// Compute the normal at the fragment using the tangent space matrix and the normal read in the normal map.
-	vec3 n = texture(texture1, In.uv).rgb;
-	n = normalize(n * 2.0 - 1.0);
+	// Only the XY components are stored, to support two-channels compressed normal maps.
+	vec3 n;
+	n.xy = texture(texture1, In.uv).rg * 2.0 - 1.0;
+	n.z = sqrt(max(0.0, 1.0 - dot(n.xy, n.xy)));
+	n = normalize(n);
 	
 	// Store values.
 	fragColor.rgb = texture(texture0,  In.uv).rgb;
@@ -4,8 +4,7 @@
 layout(location = 0) in vec3 v; ///< Position.
 layout(location = 1) in vec3 n; ///< Normal.
 layout(location = 2) in vec2 uv; ///< Texture coordinates.
-layout(location = 3) in vec3 tang; ///< Tangent.
-layout(location = 4) in vec3 binor; ///< Binormal.
+layout(location = 3) in vec4 tang; ///< Tangent, and binormal orientation in w.
 
 uniform mat4 mvp; ///< MVP transformation matrix.
 uniform mat3 normalMatrix; ///< Normal transformation matrix.
@@ -26,9 +25,10 @@ void main(){
 	Out.uv = uv;
 
 	// Compute the TBN matrix (from tangent space to view space).
-	vec3 T = normalize(normalMatrix * tang);
-	vec3 B = normalize(normalMatrix * binor);
+	// The binormal is rebuilt from the normal and tangent, its orientation is stored in the tangent w component.
+	vec3 T = normalize(normalMatrix * tang.xyz);
 	vec3 N = normalize(normalMatrix * n);
+	vec3 B = (tang.w < 0.0 ? -1.0 : 1.0) * normalize(cross(N, T));
 	Out.tbn = mat3(T, B, N);
 	
 }
@@ -87,8 +87,11 @@ void main(){
 	}
 	
 	// Compute the normal at the fragment using the tangent space matrix and the normal read in the normal map.
-	vec3 n = texture(texture1,localUV).rgb;
-	n = normalize(n * 2.0 - 1.0);
+	// Only the XY components are stored, to support two-channels compressed normal maps.
+	vec3 n;
+	n.xy = texture(texture1, localUV).rg * 2.0 - 1.0;
+	n.z = sqrt(max(0.0, 1.0 - dot(n.xy, n.xy)));
+	n = normalize(n);
 	
 	// Store values.
 	fragColor.rgb = texture(texture0, localUV).rgb;
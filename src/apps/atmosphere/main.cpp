@@ -56,7 +56,7 @@ int main(int argc, char** argv) {
 	
 	// Framebuffer to store the rendered atmosphere result before tonemapping and upscaling to the window size.
 	std::shared_ptr<Framebuffer> atmosphereFramebuffer(new Framebuffer(renderResolution[0], renderResolution[1], GL_RGB32F, true));
-	const GLuint precomputedScattering = Resources::manager().getTexture("scattering-precomputed", false).id;
+	const std::shared_ptr<TextureInfos> precomputedScattering = Resources::manager().getTexture("scattering-precomputed", false);
 	
 	// Atmosphere screen quad.
 	std::shared_ptr<ProgramInfos> atmosphereProgram = Resources::manager().getProgram2D("atmosphere");
@@ -140,7 +140,7 @@ int main(int argc, char** argv) {
 		glUniformMatrix4fv(atmosphereProgram->uniform("clipToWorld"), 1, GL_FALSE, &clipToWorld[0][0]);
 		glUniform3fv(atmosphereProgram->uniform("viewPos"), 1, &camera.position()[0]);
 		glUniform3fv(atmosphereProgram->uniform("lightDirection"), 1, &lightDirection[0]);
-		ScreenQuad::draw(precomputedScattering);
+		ScreenQuad::draw(precomputedScattering->id);
 		atmosphereFramebuffer->unbind();
 		
 		// Tonemapping and final screen.
@@ -38,6 +38,8 @@ int main(int argc, char** argv) {
 	}
 	
 	Resources::manager().addResources("../../../resources/pbrdemo");
+	// Reload modified shaders, textures and meshes while running.
+	Resources::manager().watchFiles(true);
 	// Initialize random generator;
 	Random::seed();
 	// Query the renderer identifier, and the supported OpenGL version.
@@ -56,6 +58,9 @@ int main(int argc, char** argv) {
 	double remainingTime = 0.0;
 	const double dt = 1.0/120.0; // Small physics timestep.
 	
+	// Scene textures and meshes are loaded in the background, and uploaded progressively.
+	Object::loadAsynchronously = true;
+	
 	std::vector<std::shared_ptr<Scene>> scenes;
 	scenes.emplace_back(new DragonScene());
 	scenes.emplace_back(new SphereScene());
@@ -79,12 +84,27 @@ int main(int argc, char** argv) {
 		}
 		
 		
+		// Upload resources loaded in the background.
+		Resources::manager().update();
+		
 		// Start a new frame for the interface.
 		Interface::beginFrame();
 		
 		// Handle scene switching.
 		if(ImGui::Begin("Renderer")){
 			ImGui::Text("%.1f ms, %.1f fps", ImGui::GetIO().DeltaTime*1000.0f, ImGui::GetIO().Framerate);
+			const size_t pendingCount = Resources::manager().pendingCount();
+			if(pendingCount > 0){
+				ImGui::Text("Loading %lu resources...", (unsigned long)pendingCount);
+			}
+			if(ImGui::CollapsingHeader("Resources")){
+				const Resources::Statistics textures = Resources::manager().getStatistics(Resources::Textures);
+				const Resources::Statistics meshes = Resources::manager().getStatistics(Resources::Meshes);
+				const float toMB = 1.0f / (1024.0f * 1024.0f);
+				ImGui::Text("Textures: %lu (%.1f MB), %lu unused (%.1f MB)", (unsigned long)textures.count, float(textures.size) * toMB, (unsigned long)textures.unusedCount, float(textures.unusedSize) * toMB);
+				ImGui::Text("Meshes: %lu (%.1f MB), %lu unused (%.1f MB)", (unsigned long)meshes.count, float(meshes.size) * toMB, (unsigned long)meshes.unusedCount, float(meshes.unusedSize) * toMB);
+				ImGui::Text("Half float and compressed textures: %.1f MB saved", float(textures.savedSize) * toMB);
+			}
 			
 			if(ImGui::Combo("Scene", &selected_scene, sceneNames, scenes.size()+1)){
 				if(selected_scene == scenes.size()){
@@ -6,6 +6,7 @@
 
 class DeskScene : public Scene {
 public:
+	DeskScene() : Scene("desk") {}
 	void init();
 	void update(double fullTime, double frameTime);
 	
@@ -40,7 +41,7 @@ void DeskScene::init(){
 	
 	// Background creation.
 	background = Object(Object::Type::Skybox, "skybox", {}, {{"small_apartment", true }});
-	backgroundReflection = Resources::manager().getCubemap("small_apartment").id;
+	backgroundReflection = Resources::manager().getCubemapAsync("small_apartment");
 	loadSphericalHarmonics("small_apartment_shcoeffs");
 	
 	// Compute the bounding box of the shadow casters.
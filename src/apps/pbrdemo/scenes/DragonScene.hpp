@@ -6,6 +6,7 @@
 
 class DragonScene : public Scene {
 public:
+	DragonScene() : Scene("dragon") {}
 	void init();
 	void update(double fullTime, double frameTime);
 };
@@ -37,7 +38,7 @@ void DragonScene::init(){
 	
 	// Background creation.
 	background = Object(Object::Type::Skybox, "skybox", {}, {{"corsica_beach_cube", true }});
-	backgroundReflection = Resources::manager().getCubemap("corsica_beach_cube").id;
+	backgroundReflection = Resources::manager().getCubemapAsync("corsica_beach_cube");
 	loadSphericalHarmonics("corsica_beach_cube_shcoeffs");
 	
 	// Compute the bounding box of the shadow casters.
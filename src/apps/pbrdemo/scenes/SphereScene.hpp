@@ -6,6 +6,7 @@
 
 class SphereScene : public Scene {
 public:
+	SphereScene() : Scene("spheres") {}
 	void init();
 	void update(double fullTime, double frameTime);
 };
@@ -30,7 +31,7 @@ void SphereScene::init(){
 	
 	// Background creation.
 	background = Object(Object::Type::Skybox, "skybox", {}, {{"studio", true }});
-	backgroundReflection = Resources::manager().getCubemap("studio").id;
+	backgroundReflection = Resources::manager().getCubemapAsync("studio");
 	loadSphericalHarmonics("studio_shcoeffs");
 	
 	// Compute the bounding box of the shadow casters.
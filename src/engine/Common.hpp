@@ -60,6 +60,9 @@
  \defgroup Helpers Helpers
  \brief Various utility helpers.
  
+ \defgroup Raycaster Raycaster
+ \brief CPU ray and proximity queries against meshes.
+ 
  \defgroup Shaders Shaders
  \brief OpenGL GLSL shaders.
  \details Those shaders are small programs compiled at runtime and executed by the GPU cores. They can process vertices (vertex shader), primitives (geometry shader) and compute per-pixel values (fragment shader).
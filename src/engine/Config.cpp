@@ -8,6 +8,8 @@
 
 #include "Config.hpp"
 #include "resources/ResourcesManager.hpp"
+#include "helpers/Telemetry.hpp"
+#include "resources/ArtifactCache.hpp"
 
 #include <sstream>
 
@@ -36,6 +38,7 @@ Config::Config(int argc, char** argv){
 	// Extract logging settings;
 	std::string logPath;
 	bool logVerbose = false;
+	std::string telemetryPath;
 	
 	for(const auto & arg : _rawArguments){
 		const std::string key = arg.first;
@@ -45,6 +48,12 @@ Config::Config(int argc, char** argv){
 			logVerbose = true;
 		} else if(key == "log-path"){
 			logPath = values[0];
+		} else if(key == "telemetry"){
+			telemetryPath = values.empty() ? "telemetry" : values[0];
+		} else if(key == "cache-path"){
+			ArtifactCache::directory = values[0];
+		} else if(key == "cache-size"){
+			ArtifactCache::budget = std::stoull(values[0]) * 1024ull * 1024ull;
 		}
 	}
 	
@@ -52,6 +61,9 @@ Config::Config(int argc, char** argv){
 		Log::setDefaultFile(logPath);
 	}
 	Log::setDefaultVerbose(logVerbose);
+	if(!telemetryPath.empty()){
+		Telemetry::enable(telemetryPath);
+	}
 	
 }
 
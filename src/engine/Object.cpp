@@ -1,7 +1,10 @@
 #include "Object.hpp"
 
+float Object::levelOfDetailThreshold = 0.001f;
 
-Object::Object() {}
+bool Object::loadAsynchronously = false;
+
+Object::Object() : _mesh(std::make_shared<MeshInfos>()) {}
 
 Object::Object(const Object::Type & type, const std::string& meshPath, const std::vector<std::pair<std::string, bool>>& texturesPaths, const std::vector<std::pair<std::string, bool>>& cubemapPaths, bool castShadows) {
 
@@ -21,18 +24,10 @@ Object::Object(const Object::Type & type, const std::string& meshPath, const std
 		break;
 	}
 
-	// Load geometry.
-	_mesh = Resources::manager().getMesh(meshPath);
-
-	// Load and upload the textures.
-	for (unsigned int i = 0; i < texturesPaths.size(); ++i) {
-		const auto & textureName = texturesPaths[i];
-		_textures.push_back(Resources::manager().getTexture(textureName.first, textureName.second));
-	}
-	for (unsigned int i = 0; i < cubemapPaths.size(); ++i) {
-		const auto & textureName = cubemapPaths[i];
-		_textures.push_back(Resources::manager().getCubemap(textureName.first, textureName.second));
-	}
+	// Load geometry. The bounding box of shadow casters is needed right away to fit the lights frusta.
+	_mesh = (Object::loadAsynchronously && !_castShadow) ? Resources::manager().getMeshAsync(meshPath) : Resources::manager().getMesh(meshPath);
+	
+	loadTextures(texturesPaths, cubemapPaths);
 	
 	_model = glm::mat4(1.0f);
 	checkGLError();
@@ -47,21 +42,34 @@ Object::Object(std::shared_ptr<ProgramInfos> & program, const std::string& meshP
 	// Load the shaders
 	_program = program;
 	
-	// Load geometry.
-	_mesh = Resources::manager().getMesh(meshPath);
+	// Load geometry. The bounding box of shadow casters is needed right away to fit the lights frusta.
+	_mesh = (Object::loadAsynchronously && !_castShadow) ? Resources::manager().getMeshAsync(meshPath) : Resources::manager().getMesh(meshPath);
+	
+	loadTextures(texturesPaths, cubemapPaths);
+	_model = glm::mat4(1.0f);
+	checkGLError();
 	
-	// Load and upload the textures.
+}
+
+void Object::loadTextures(const std::vector<std::pair<std::string, bool>>& texturesPaths, const std::vector<std::pair<std::string, bool>>& cubemapPaths){
+	Resources & resources = Resources::manager();
+	// Load and upload the textures, in the background if requested.
 	for (unsigned int i = 0; i < texturesPaths.size(); ++i) {
 		const auto & textureName = texturesPaths[i];
-		_textures.push_back(Resources::manager().getTexture(textureName.first, textureName.second));
+		if(Object::loadAsynchronously){
+			_textures.push_back(resources.getTextureAsync(textureName.first, textureName.second));
+		} else {
+			_textures.push_back(resources.getTexture(textureName.first, textureName.second));
+		}
 	}
 	for (unsigned int i = 0; i < cubemapPaths.size(); ++i) {
 		const auto & textureName = cubemapPaths[i];
-		_textures.push_back(Resources::manager().getCubemap(textureName.first, textureName.second));
+		if(Object::loadAsynchronously){
+			_textures.push_back(resources.getCubemapAsync(textureName.first, textureName.second));
+		} else {
+			_textures.push_back(resources.getCubemap(textureName.first, textureName.second));
+		}
 	}
-	_model = glm::mat4(1.0f);
-	checkGLError();
-	
 }
 
 void Object::update(const glm::mat4& model) {
@@ -106,29 +114,77 @@ void Object::draw(const glm::mat4& view, const glm::mat4& projection) const {
 	// Bind the textures.
 	for (unsigned int i = 0; i < _textures.size(); ++i){
 		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(_textures[i].cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, _textures[i].id);
+		glBindTexture(_textures[i]->cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, _textures[i]->id);
 	}
-	drawGeometry();
+	// The skybox is always rendered in full.
+	drawGeometry(_material == Object::Skybox ? 0 : levelOfDetail(projection * view));
 	glUseProgram(0);
 }
 
 
-void Object::drawGeometry() const {
-	glBindVertexArray(_mesh.vId);
-	glDrawElements(GL_TRIANGLES, _mesh.count, GL_UNSIGNED_INT, (void*)0);
+void Object::drawGeometry(const unsigned int level) const {
+	// The mesh might still be loading.
+	if(_mesh->count == 0){
+		return;
+	}
+	glBindVertexArray(_mesh->vId);
+	if(level < _mesh->levels.size()){
+		const MeshLevel & lod = _mesh->levels[level];
+		glDrawElements(GL_TRIANGLES, (GLsizei)lod.indexCount, GL_UNSIGNED_INT, (void*)(sizeof(unsigned int) * lod.firstIndex));
+	} else {
+		glDrawElements(GL_TRIANGLES, _mesh->count, GL_UNSIGNED_INT, (void*)0);
+	}
 	glBindVertexArray(0);
 }
 
+unsigned int Object::levelOfDetail(const glm::mat4 & viewProjection) const {
+	if(_mesh->levels.size() < 2){
+		return 0;
+	}
+	const BoundingSphere sphere = getBoundingBox().getSphere();
+	const glm::vec4 center = viewProjection * glm::vec4(sphere.center, 1.0f);
+	// Objects behind the viewpoint use the most detailed level.
+	if(center.w <= 0.0f){
+		return 0;
+	}
+	// Vertical scaling from world space to clip space, then perspective division. The viewport height is 2 in NDC.
+	const float scale = glm::length(glm::vec3(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1]));
+	return levelForSize(sphere.radius * scale / center.w);
+}
 
-void Object::clean() const {
-	glDeleteVertexArrays(1, &_mesh.vId);
-	for (auto & texture : _textures) {
-		glDeleteTextures(1, &(texture.id));
+unsigned int Object::levelOfDetail(const glm::vec3 & viewpoint, const float projectionScale) const {
+	if(_mesh->levels.size() < 2){
+		return 0;
+	}
+	const BoundingSphere sphere = getBoundingBox().getSphere();
+	const float distance = glm::length(sphere.center - viewpoint);
+	if(distance <= sphere.radius){
+		return 0;
 	}
+	return levelForSize(sphere.radius * projectionScale / distance);
+}
+
+unsigned int Object::levelForSize(const float projectedSize) const {
+	// Errors are relative to the bounding box diagonal, which is also the bounding sphere diameter.
+	unsigned int level = 0;
+	for(unsigned int lid = 1; lid < _mesh->levels.size(); ++lid){
+		if(_mesh->levels[lid].error * projectedSize > Object::levelOfDetailThreshold){
+			break;
+		}
+		level = lid;
+	}
+	return level;
+}
+
+
+void Object::clean() {
+	// Release the shared resources, the manager will evict them if needed.
+	_mesh = std::make_shared<MeshInfos>();
+	_textures.clear();
 }
 
 BoundingBox Object::getBoundingBox() const {
-	return _mesh.bbox.transformed(_model);
+	return _mesh->bbox.transformed(_model);
 }
 
 
@@ -54,11 +54,25 @@ public:
 	
 	/**
 	 Just bind and draw the geometry, with no implicit shader or textures.
+	 \param level the level of detail to draw
 	 */
-	void drawGeometry() const;
+	void drawGeometry(const unsigned int level = 0) const;
 	
-	/** Clean internal data */
-	void clean() const;
+	/** Select the level of detail to use when rendering the object, based on the projected size of its bounding box.
+	 \param viewProjection the view-projection matrix of the camera or light
+	 \return the index of the level
+	 */
+	unsigned int levelOfDetail(const glm::mat4 & viewProjection) const;
+	
+	/** Select the level of detail to use when rendering the object with a perspective projection centered on a given point, such as a point light cubemap.
+	 \param viewpoint the center of projection
+	 \param projectionScale the vertical scaling factor of the projection (1 for a 90 degrees field of view)
+	 \return the index of the level
+	 */
+	unsigned int levelOfDetail(const glm::vec3 & viewpoint, const float projectionScale) const;
+	
+	/** Release the object resources. They are shared with other objects through the resources manager. */
+	void clean();
 	
 	/** Query the bounding box of the object.
 	 \return the bounding box
@@ -75,12 +89,30 @@ public:
 	 */
 	const glm::mat4 & model() const { return _model; }
 	
+	/// Maximum screen-space error allowed when selecting a level of detail, as a fraction of the viewport height.
+	static float levelOfDetailThreshold;
+	
+	/// Should the textures of new objects, and the meshes of objects not casting shadows, be loaded in the background.
+	static bool loadAsynchronously;
+	
 private:
 	
+	/** Load the textures of the object, in the background if requested.
+	 \param texturesPaths names and SRGB flags of the 2D textures to use
+	 \param cubemapPaths names and SRGB flags of the cubemap textures to use
+	 */
+	void loadTextures(const std::vector<std::pair<std::string, bool>>& texturesPaths, const std::vector<std::pair<std::string, bool>>& cubemapPaths);
+	
+	/** Select the most simplified level of detail whose error is acceptable at a given projected size.
+	 \param projectedSize the projected size of the object bounding box, as a fraction of the viewport height
+	 \return the index of the level
+	 */
+	unsigned int levelForSize(const float projectedSize) const;
+	
 	std::shared_ptr<ProgramInfos> _program; ///< Shader responsible for the object rendering.
-	MeshInfos _mesh; ///< Geometry of the object.
+	std::shared_ptr<MeshInfos> _mesh; ///< Geometry of the object.
 	
-	std::vector<TextureInfos> _textures; ///< Textures used by the object.
+	std::vector<std::shared_ptr<TextureInfos>> _textures; ///< Textures used by the object.
 	
 	glm::mat4 _model; ///< The transformation matrix of the 3D model.
 	
@@ -1,7 +1,7 @@
 #include "Scene.hpp"
 #include "Common.hpp"
 
-Scene::Scene(){};
+Scene::Scene(const std::string & name) : backgroundReflection(std::make_shared<TextureInfos>()), _name(name) {};
 
 Scene::~Scene(){};
 
@@ -44,7 +44,7 @@ BoundingBox Scene::computeBoundingBox(bool onlyShadowCasters){
 	return bbox;
 }
 
-void Scene::clean() const {
+void Scene::clean() {
 	for(auto & object : objects){
 		object.clean();
 	}
@@ -58,4 +58,11 @@ void Scene::clean() const {
 	for(auto& spotLight : spotLights){
 		spotLight.clean();
 	}
+	// The scene will be loaded again by the next call to init.
+	objects.clear();
+	directionalLights.clear();
+	pointLights.clear();
+	spotLights.clear();
+	backgroundReflection = std::make_shared<TextureInfos>();
+	_loaded = false;
 };
@@ -16,8 +16,15 @@ class Scene {
 
 public:
 
-	/** Constructor */
-	Scene();
+	/** Constructor
+	 \param name the scene name, used to record the assets it loads (none by default)
+	 */
+	Scene(const std::string & name = "");
+	
+	/** Query the scene name.
+	 \return the name
+	 */
+	const std::string & name() const { return _name; }
 	
 	/** Performs initialization against the graphics API.
 	 */
@@ -29,8 +36,8 @@ public:
 	 */
 	virtual void update(double fullTime, double frameTime) = 0;
 	
-	/** Clean internal resources. */
-	void clean() const;
+	/** Clean internal resources and release the shared ones. The scene can be loaded again afterwards. */
+	void clean();
 	
 	/// Destructor
 	virtual ~Scene();
@@ -40,7 +47,7 @@ public:
 	Object background; ///< Background object. \todo Make more flexible, to be able to use a screenquad or a color.
 	std::vector<glm::vec3> backgroundIrradiance; ///< RGB SH-coefficients of the background irradiance, computed using SHExtractor. \see SphericalHarmonics
 	
-	GLuint backgroundReflection; ///< Cubemap texture ID of the background radiance.
+	std::shared_ptr<TextureInfos> backgroundReflection; ///< Cubemap texture of the background radiance.
 	std::vector<DirectionalLight> directionalLights; ///< Directional lights present in the scene.
 	std::vector<PointLight> pointLights; ///< Omni-directional lights present in the scene.
 	std::vector<SpotLight> spotLights; ///< Spotlights present in the scene.
@@ -60,6 +67,7 @@ protected:
 	BoundingBox computeBoundingBox(bool onlyShadowCasters = false);
 	
 	bool _loaded = false; ///< Has the scene already been loaded from disk.
+	std::string _name; ///< The scene name.
 
 };
 #endif
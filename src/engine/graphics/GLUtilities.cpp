@@ -1,5 +1,11 @@
 #include "GLUtilities.hpp"
 #include "../resources/ImageUtilities.hpp"
+#include "../resources/TextureContainer.hpp"
+#include "../helpers/ThreadUtilities.hpp"
+#include "../helpers/Telemetry.hpp"
+#include <glm/gtc/packing.hpp>
+#include <cstring>
+#include <algorithm>
 
 std::string getGLErrorString(GLenum error) {
 	std::string msg;
@@ -289,21 +295,88 @@ GLuint GLUtilities::createProgram(const std::string & vertexContent, const std::
 
 
 
+bool GLUtilities::decodeImages(const std::vector<std::string> & paths, const bool flip, const bool cubemap, std::vector<DecodedImage> & images){
+	// A container holds all levels and faces, already in the expected orientation.
+	if(paths.size() == 1 && TextureContainer::isContainer(paths[0])){
+		bool containerCubemap = false;
+		if(!TextureContainer::load(paths[0], images, containerCubemap)){
+			Log::Error() << Log::Resources << "Unable to load the texture at path " << paths[0] << "." << std::endl;
+			return false;
+		}
+		if(containerCubemap != cubemap){
+			Log::Error() << Log::Resources << "The texture at path " << paths[0] << " is " << (containerCubemap ? "a cubemap" : "a 2D texture") << ", expected " << (cubemap ? "a cubemap" : "a 2D texture") << "." << std::endl;
+			for(DecodedImage & image : images){
+				free(image.data);
+			}
+			images.clear();
+			return false;
+		}
+		return true;
+	}
+	images.assign(paths.size(), DecodedImage());
+	// Each image is extracted and decoded independently, on behalf of the asset loaded on this thread.
+	// Blocks of a single image are decoded in parallel, images of a set are decoded on one thread each.
+	const std::string assetName = Telemetry::currentAsset();
+	const unsigned int blockThreads = paths.size() > 1 ? 1 : 0;
+	ThreadUtilities::parallelFor(paths.size(), [&paths, &images, &assetName, flip, blockThreads](size_t begin, size_t end, unsigned int){
+		Telemetry::Asset asset(assetName);
+		for(size_t iid = begin; iid < end; ++iid){
+			DecodedImage & image = images[iid];
+			image.hdr = ImageUtilities::isHDR(paths[iid]);
+			image.status = ImageUtilities::loadNativeImage(paths[iid], image.width, image.height, image.channels, &image.data, image.half, flip, false, blockThreads);
+		}
+	});
+	// Report errors and cleanup.
+	bool success = true;
+	for(size_t iid = 0; iid < images.size(); ++iid){
+		if(images[iid].status != 0){
+			Log::Error() << Log::Resources << "Unable to load the texture at path " << paths[iid] << "." << std::endl;
+			success = false;
+		}
+	}
+	if(!success){
+		for(DecodedImage & image : images){
+			free(image.data);
+			image.data = NULL;
+		}
+	}
+	return success;
+}
+
 TextureInfos GLUtilities::loadTexture(const std::vector<std::string>& paths, bool sRGB){
+	if(paths.empty()){
+		TextureInfos infos;
+		infos.cubemap = false;
+		return infos;
+	}
+	// Decode all levels at once.
+	std::vector<DecodedImage> images;
+	if(!decodeImages(paths, !ImageUtilities::isHDR(paths[0]), false, images)){
+		TextureInfos infos;
+		infos.cubemap = false;
+		infos.hdr = ImageUtilities::isHDR(paths[0]);
+		return infos;
+	}
+	return uploadTexture(images, sRGB);
+}
+
+TextureInfos GLUtilities::uploadTexture(std::vector<DecodedImage> & images, bool sRGB, GLuint textureId){
+	Telemetry::Scope scope(Telemetry::Upload, "texture");
 	TextureInfos infos;
 	infos.cubemap = false;
-	if(paths.empty()){
+	if(images.empty()){
 		return infos;
 	}
 	
-	// Create 2D texture.
-	GLuint textureId;
-	glGenTextures(1, &textureId);
+	// Create 2D texture, unless its content is replaced.
+	if(textureId == 0){
+		glGenTextures(1, &textureId);
+	}
 	glBindTexture(GL_TEXTURE_2D, textureId);
 	
-	// Set proper max mipmap level.
-	if(paths.size()>1){
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)(paths.size())-1);
+	// Set proper max mipmap level. Compressed textures can't generate their mipmaps.
+	if(images.size()>1 || images[0].compressedFormat != 0){
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)(images.size())-1);
 	} else {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
 	}
@@ -314,71 +387,100 @@ TextureInfos GLUtilities::loadTexture(const std::vector<std::string>& paths, boo
 	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	// Image infos.
-	infos.hdr = ImageUtilities::isHDR(paths[0]);
-	unsigned int width = 0;
-	unsigned int height = 0;
-	unsigned int channels = 4;
+	infos.hdr = images[0].hdr;
+	infos.sRGB = sRGB && !infos.hdr;
+	
+	infos.half = infos.hdr && images[0].half;
 	
 	// For now, we assume HDR images to be 3-channels, LDR images to be 4.
 	const GLenum format = GLenum(infos.hdr ? GL_RGB : GL_RGBA);
-	const GLenum type = GLenum(infos.hdr ? GL_FLOAT : GL_UNSIGNED_BYTE);
-	const GLenum preciseFormat = GLenum(infos.hdr ? GL_RGB32F : (sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA));
-	
-	for(unsigned int mipid = 0; mipid < paths.size(); ++mipid){
-		
-		const std::string path = paths[mipid];
-		
-		void* image;
-		int ret = ImageUtilities::loadImage(path, width, height, channels, &image, !infos.hdr);
-		
-		if (ret != 0) {
-			Log::Error() << Log::Resources << "Unable to load the texture at path " << path << "." << std::endl;
-			if(image != NULL){
-				free(image);
-			}
-			return infos;
+	const GLenum preciseFormat = GLenum(infos.hdr ? (infos.half ? GL_RGB16F : GL_RGB32F) : (sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA));
+	
+	const size_t pixelSize = infos.hdr ? 3 * (infos.half ? sizeof(uint16_t) : sizeof(float)) : 4;
+	// Size of the texture stored as floats or 8-bits RGBA.
+	const size_t referencePixelSize = infos.hdr ? 3 * sizeof(float) : 4;
+	size_t referenceSize = 0;
+	// Half float rows are not always aligned on 4 bytes.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, infos.half ? 2 : 4);
+	
+	for(unsigned int mipid = 0; mipid < images.size(); ++mipid){
+		DecodedImage & image = images[mipid];
+		if(image.compressedFormat != 0){
+			glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)mipid, image.compressedFormat, (GLsizei)image.width, (GLsizei)image.height, 0, (GLsizei)image.size(), image.data);
+			infos.size += image.size();
+		} else {
+			const GLenum type = GLenum(image.hdr ? (image.half ? GL_HALF_FLOAT : GL_FLOAT) : GL_UNSIGNED_BYTE);
+			glTexImage2D(GL_TEXTURE_2D, (GLint)mipid, preciseFormat, (GLsizei)image.width, (GLsizei)image.height, 0, format, type, image.data);
+			infos.size += size_t(image.width) * image.height * pixelSize;
 		}
-		
-		glTexImage2D(GL_TEXTURE_2D, (GLint)mipid, preciseFormat, (GLsizei)width, (GLsizei)height, 0, format, type, image);
-		free(image);
-		
+		referenceSize += size_t(image.width) * image.height * referencePixelSize;
+		free(image.data);
+		image.data = NULL;
 	}
+	infos.compressed = images[0].compressedFormat != 0;
 	
 	// If only level 0 was given, generate mipmaps pyramid automatically.
-	if(paths.size() == 1){
+	if(images.size() == 1 && !infos.compressed){
 		glGenerateMipmap(GL_TEXTURE_2D);
+		// The whole pyramid takes a third more memory.
+		infos.size += infos.size / 3;
+		referenceSize += referenceSize / 3;
 	}
+	// Tiny compressed levels can be larger than their uncompressed version.
+	infos.savedSize = referenceSize > infos.size ? referenceSize - infos.size : 0;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	
 	glBindTexture(GL_TEXTURE_2D, 0);
 	
 	infos.id = textureId;
-	infos.width = width;
-	infos.height = height;
+	infos.width = images[0].width;
+	infos.height = images[0].height;
+	scope.setBytes(infos.size);
 	return infos;
 }
 
 TextureInfos GLUtilities::loadTextureCubemap(const std::vector<std::vector<std::string>> & allPaths, bool sRGB){
-	TextureInfos infos;
-	infos.cubemap = true;
-	if(allPaths.empty() ){
+	// If not enough images, return empty texture.
+	if(allPaths.empty() || allPaths.front().size() < 6){
 		Log::Error() << Log::Resources << "Unable to find cubemap." << std::endl;
+		TextureInfos infos;
+		infos.cubemap = true;
 		return infos;
 	}
-	
-	// If not enough images, return empty texture.
-	if(allPaths.front().size() == 0 ){
+	// Decode all levels and sides at once. We don't need to flip them.
+	std::vector<std::string> paths;
+	for(const auto & levelPaths : allPaths){
+		paths.insert(paths.end(), levelPaths.begin(), levelPaths.begin() + 6);
+	}
+	std::vector<DecodedImage> images;
+	if(!decodeImages(paths, false, true, images)){
+		TextureInfos infos;
+		infos.cubemap = true;
+		infos.hdr = ImageUtilities::isHDR(paths[0]);
+		return infos;
+	}
+	return uploadTextureCubemap(images, sRGB);
+}
+
+TextureInfos GLUtilities::uploadTextureCubemap(std::vector<DecodedImage> & images, bool sRGB, GLuint textureId){
+	Telemetry::Scope scope(Telemetry::Upload, "cubemap");
+	TextureInfos infos;
+	infos.cubemap = true;
+	if(images.size() < 6){
 		Log::Error() << Log::Resources << "Unable to find cubemap." << std::endl;
 		return infos;
 	}
+	const size_t levelCount = images.size() / 6;
 	
-	// Create and bind texture.
-	GLuint textureId;
-	glGenTextures(1, &textureId);
+	// Create and bind texture, unless its content is replaced.
+	if(textureId == 0){
+		glGenTextures(1, &textureId);
+	}
 	glBindTexture(GL_TEXTURE_CUBE_MAP, textureId);
 	
-	// Set proper max mipmap level.
-	if(allPaths.size()>1){
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (int)(allPaths.size())-1);
+	// Set proper max mipmap level. Compressed textures can't generate their mipmaps.
+	if(levelCount>1 || images[0].compressedFormat != 0){
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (int)(levelCount)-1);
 	} else {
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 1000);
 	}
@@ -390,132 +492,228 @@ TextureInfos GLUtilities::loadTextureCubemap(const std::vector<std::vector<std::
 	glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 	
 	// Image infos.
-	unsigned int width = 0;
-	unsigned int height = 0;
-	unsigned int channels = 4;
-	infos.hdr = ImageUtilities::isHDR(allPaths[0][0]);
+	infos.hdr = images[0].hdr;
+	infos.sRGB = sRGB && !infos.hdr;
+	
+	infos.half = infos.hdr && images[0].half;
 	
 	// For now, we assume HDR images to be 3-channels, LDR images to be 4.
 	const GLenum format = GLenum(infos.hdr ? GL_RGB : GL_RGBA);
-	const GLenum type = GLenum(infos.hdr ? GL_FLOAT : GL_UNSIGNED_BYTE);
-	const GLenum preciseFormat = GLenum(infos.hdr ? GL_RGB32F : (sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA));
+	const GLenum preciseFormat = GLenum(infos.hdr ? (infos.half ? GL_RGB16F : GL_RGB32F) : (sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA));
 	
-	for(unsigned int mipid = 0; mipid < allPaths.size(); ++mipid){
-		
-		const std::vector<std::string> paths = allPaths[mipid];
-		// For each side, load the image and upload it in the right slot.
-		// We don't need to flip them.
-		
+	const size_t pixelSize = infos.hdr ? 3 * (infos.half ? sizeof(uint16_t) : sizeof(float)) : 4;
+	// Size of the texture stored as floats or 8-bits RGBA.
+	const size_t referencePixelSize = infos.hdr ? 3 * sizeof(float) : 4;
+	size_t referenceSize = 0;
+	// Half float rows are not always aligned on 4 bytes.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, infos.half ? 2 : 4);
+	
+	for(unsigned int mipid = 0; mipid < levelCount; ++mipid){
+		// For each side, upload the image in the right slot.
 		for(size_t side = 0; side < 6; ++side){
-			void* image;
-			int ret = ImageUtilities::loadImage(paths[side], width, height, channels, &image, false);
-			if (ret != 0) {
-				Log::Error() << Log::Resources << "Unable to load the texture at path " << paths[side] << "." << std::endl;
-				free(image);
-				return infos;
+			DecodedImage & image = images[6 * mipid + side];
+			const GLenum target = GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + side);
+			if(image.compressedFormat != 0){
+				glCompressedTexImage2D(target, (GLint)mipid, image.compressedFormat, (GLsizei)image.width, (GLsizei)image.height, 0, (GLsizei)image.size(), image.data);
+				infos.size += image.size();
+			} else {
+				const GLenum type = GLenum(image.hdr ? (image.half ? GL_HALF_FLOAT : GL_FLOAT) : GL_UNSIGNED_BYTE);
+				glTexImage2D(target, (GLint)mipid, preciseFormat, (GLsizei)image.width, (GLsizei)image.height, 0, format, type, image.data);
+				infos.size += size_t(image.width) * image.height * pixelSize;
 			}
-			
-			glTexImage2D(GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + side), (GLint)mipid, preciseFormat, (GLsizei)width, (GLsizei)height, 0, format, type, image);
-			free(image);
+			referenceSize += size_t(image.width) * image.height * referencePixelSize;
+			free(image.data);
+			image.data = NULL;
 		}
-		
 	}
+	infos.compressed = images[0].compressedFormat != 0;
 	
 	// If only level 0 was given, generate mipmaps pyramid automatically.
-	if(allPaths.size() == 1){
+	if(levelCount == 1 && !infos.compressed){
 		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+		// The whole pyramid takes a third more memory.
+		infos.size += infos.size / 3;
+		referenceSize += referenceSize / 3;
 	}
+	// Tiny compressed levels can be larger than their uncompressed version.
+	infos.savedSize = referenceSize > infos.size ? referenceSize - infos.size : 0;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 	
 	infos.id = textureId;
-	infos.width = width;
-	infos.height = height;
+	infos.width = images[0].width;
+	infos.height = images[0].height;
+	scope.setBytes(infos.size);
 	return infos;
 }
 
 
-MeshInfos GLUtilities::setupBuffers(const Mesh & mesh){
+/** \brief Describe how a vertex attribute is stored in a buffer.
+ \ingroup Graphics
+ */
+struct VertexAttributeFormat {
+	GLuint location; ///< The attribute location in shaders.
+	GLint components; ///< The number of components.
+	GLenum type; ///< The component type.
+	GLboolean normalized; ///< Should integer values be normalized.
+	size_t size; ///< Size of the attribute for one vertex, in bytes.
+};
+
+/** Pack a unit vector and a sign in a 10:10:10:2 signed normalized integer, as read by OpenGL with the GL_INT_2_10_10_10_REV type.
+ \param v the vector to pack
+ \param w the sign to store in the last component
+ \return the packed vector
+ */
+uint32_t packVector1010102(const glm::vec3 & v, const float w){
+	const glm::vec3 c = glm::round(glm::clamp(v, -1.0f, 1.0f) * 511.0f);
+	const uint32_t x = uint32_t(int(c.x)) & 0x3FF;
+	const uint32_t y = uint32_t(int(c.y)) & 0x3FF;
+	const uint32_t z = uint32_t(int(c.z)) & 0x3FF;
+	const uint32_t s = uint32_t(w < 0.0f ? -1 : 1) & 0x3;
+	return x | (y << 10) | (z << 20) | (s << 30);
+}
+
+MeshInfos GLUtilities::setupBuffers(const Mesh & mesh, const VertexLayout layout){
+	return GLUtilities::setupBuffers(MeshView(mesh), layout);
+}
+
+MeshInfos GLUtilities::setupBuffers(const MeshView & mesh, const VertexLayout layout, const MeshInfos * reuse){
+	Telemetry::Scope scope(Telemetry::Upload, "mesh");
 	MeshInfos infos;
-	GLuint vbo = 0;
-	GLuint vbo_nor = 0;
-	GLuint vbo_uv = 0;
-	GLuint vbo_tan = 0;
-	GLuint vbo_binor = 0;
-	
-	// Create an array buffer to host the geometry data.
-	if(mesh.positions.size() > 0){
-		glGenBuffers(1, &vbo);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.positions.size() * 3, &(mesh.positions[0]), GL_STATIC_DRAW);
+	const size_t count = mesh.vertexCount;
+	
+	// Tangents store the orientation of the binormal in their fourth component, B = w * cross(N, T).
+	std::vector<glm::vec4> tangents;
+	if(mesh.tangents != nullptr && count > 0){
+		tangents.resize(count);
+		for(size_t vid = 0; vid < count; ++vid){
+			float w = 1.0f;
+			if(mesh.binormals != nullptr && mesh.normals != nullptr){
+				w = glm::dot(glm::cross(mesh.normals[vid], mesh.tangents[vid]), mesh.binormals[vid]) < 0.0f ? -1.0f : 1.0f;
+			}
+			tangents[vid] = glm::vec4(mesh.tangents[vid], w);
+		}
 	}
 	
-	if(mesh.normals.size() > 0){
-		glGenBuffers(1, &vbo_nor);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_nor);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.normals.size() * 3, &(mesh.normals[0]), GL_STATIC_DRAW);
+	// Texture coordinates in [0,1] can use 16-bits normalized integers, others are stored as half floats.
+	bool unitTexcoords = true;
+	if(mesh.texcoords != nullptr){
+		for(size_t vid = 0; vid < count && unitTexcoords; ++vid){
+			const glm::vec2 & uv = mesh.texcoords[vid];
+			unitTexcoords = uv.x >= 0.0f && uv.x <= 1.0f && uv.y >= 0.0f && uv.y <= 1.0f;
+		}
 	}
 	
-	if(mesh.texcoords.size() > 0){
-		glGenBuffers(1, &vbo_uv);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_uv);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.texcoords.size() * 2, &(mesh.texcoords[0]), GL_STATIC_DRAW);
+	// Attributes formats, and pointers to their content.
+	const bool packed = layout == Packed;
+	std::vector<VertexAttributeFormat> formats;
+	std::vector<const void *> sources;
+	if(mesh.positions != nullptr && count > 0){
+		formats.push_back({ 0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) });
+		sources.push_back(mesh.positions);
 	}
-	
-	if(mesh.tangents.size() > 0){
-		glGenBuffers(1, &vbo_tan);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_tan);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.tangents.size() * 3, &(mesh.tangents[0]), GL_STATIC_DRAW);
+	if(mesh.normals != nullptr && count > 0){
+		formats.push_back(packed ? VertexAttributeFormat{ 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(uint32_t) } : VertexAttributeFormat{ 1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) });
+		sources.push_back(mesh.normals);
 	}
-	
-	if(mesh.binormals.size() > 0){
-		glGenBuffers(1, &vbo_binor);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_binor);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.binormals.size() * 3, &(mesh.binormals[0]), GL_STATIC_DRAW);
+	if(mesh.texcoords != nullptr && count > 0){
+		formats.push_back(!packed ? VertexAttributeFormat{ 2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2) } : (unitTexcoords ? VertexAttributeFormat{ 2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(uint32_t) } : VertexAttributeFormat{ 2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(uint32_t) }));
+		sources.push_back(mesh.texcoords);
 	}
-	
-	// Generate a vertex array.
-	GLuint vao = 0;
-	glGenVertexArrays (1, &vao);
-	glBindVertexArray(vao);
-	
-	// Setup attributes.
-	unsigned int currentAttribute = 0;
-	if(vbo > 0){
-		glEnableVertexAttribArray(currentAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glVertexAttribPointer(currentAttribute, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-		++currentAttribute;
-	}
-	if(vbo_nor > 0){
-		glEnableVertexAttribArray(currentAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_nor);
-		glVertexAttribPointer(currentAttribute, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-		++currentAttribute;
+	if(!tangents.empty()){
+		formats.push_back(packed ? VertexAttributeFormat{ 3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(uint32_t) } : VertexAttributeFormat{ 3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4) });
+		sources.push_back(&tangents[0]);
 	}
-	if(vbo_uv > 0){
-		glEnableVertexAttribArray(currentAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_uv);
-		glVertexAttribPointer(currentAttribute, 2, GL_FLOAT, GL_FALSE, 0, NULL);
-		++currentAttribute;
+	
+	// Generate a vertex array, or reset the reused one.
+	GLuint vao = (reuse != nullptr) ? reuse->vId : 0;
+	if(vao == 0){
+		glGenVertexArrays (1, &vao);
+		glBindVertexArray(vao);
+	} else {
+		glBindVertexArray(vao);
+		for(GLuint location = 0; location < 4; ++location){
+			glDisableVertexAttribArray(location);
+		}
 	}
-	if(vbo_tan > 0){
-		glEnableVertexAttribArray(currentAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_tan);
-		glVertexAttribPointer(currentAttribute, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-		++currentAttribute;
+	// Vertex buffers are reused in order, when available.
+	const std::vector<GLuint> reusedBuffers = (reuse != nullptr) ? reuse->bIds : std::vector<GLuint>();
+	const auto nextBuffer = [&infos, &reusedBuffers](){
+		GLuint vbo = 0;
+		if(infos.bIds.size() < reusedBuffers.size()){
+			vbo = reusedBuffers[infos.bIds.size()];
+		} else {
+			glGenBuffers(1, &vbo);
+		}
+		infos.bIds.push_back(vbo);
+		return vbo;
+	};
+	
+	if(layout == Separate){
+		// One buffer per attribute.
+		for(size_t aid = 0; aid < formats.size(); ++aid){
+			const VertexAttributeFormat & format = formats[aid];
+			glBindBuffer(GL_ARRAY_BUFFER, nextBuffer());
+			glBufferData(GL_ARRAY_BUFFER, format.size * count, sources[aid], GL_STATIC_DRAW);
+			infos.size += format.size * count;
+			glEnableVertexAttribArray(format.location);
+			glVertexAttribPointer(format.location, format.components, format.type, format.normalized, 0, NULL);
+		}
+	} else if(!formats.empty()){
+		// One interleaved buffer, with all the attributes of a vertex contiguous.
+		size_t stride = 0;
+		std::vector<size_t> offsets(formats.size());
+		for(size_t aid = 0; aid < formats.size(); ++aid){
+			offsets[aid] = stride;
+			stride += formats[aid].size;
+		}
+		std::vector<char> vertices(stride * count);
+		for(size_t aid = 0; aid < formats.size(); ++aid){
+			const VertexAttributeFormat & format = formats[aid];
+			char * dst = &vertices[offsets[aid]];
+			if(format.type == GL_FLOAT){
+				const char * src = (const char *)sources[aid];
+				for(size_t vid = 0; vid < count; ++vid){
+					std::memcpy(dst + vid * stride, src + vid * format.size, format.size);
+				}
+				continue;
+			}
+			// Quantized attributes.
+			for(size_t vid = 0; vid < count; ++vid){
+				uint32_t value = 0;
+				if(format.location == 1){
+					value = packVector1010102(mesh.normals[vid], 1.0f);
+				} else if(format.location == 3){
+					value = packVector1010102(glm::vec3(tangents[vid]), tangents[vid].w);
+				} else {
+					value = unitTexcoords ? glm::packUnorm2x16(mesh.texcoords[vid]) : glm::packHalf2x16(mesh.texcoords[vid]);
+				}
+				std::memcpy(dst + vid * stride, &value, sizeof(uint32_t));
+			}
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, nextBuffer());
+		glBufferData(GL_ARRAY_BUFFER, vertices.size(), &vertices[0], GL_STATIC_DRAW);
+		infos.size += vertices.size();
+		for(size_t aid = 0; aid < formats.size(); ++aid){
+			const VertexAttributeFormat & format = formats[aid];
+			glEnableVertexAttribArray(format.location);
+			glVertexAttribPointer(format.location, format.components, format.type, format.normalized, (GLsizei)stride, (const void *)offsets[aid]);
+		}
 	}
-	if(vbo_binor > 0){
-		glEnableVertexAttribArray(currentAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo_binor);
-		glVertexAttribPointer(currentAttribute, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-		++currentAttribute;
+	
+	// Release the reused buffers that are not needed anymore.
+	if(reusedBuffers.size() > infos.bIds.size()){
+		glDeleteBuffers(GLsizei(reusedBuffers.size() - infos.bIds.size()), &reusedBuffers[infos.bIds.size()]);
 	}
 	
 	// We load the indices data
-	GLuint ebo = 0;
-	glGenBuffers(1, &ebo);
+	GLuint ebo = (reuse != nullptr) ? reuse->eId : 0;
+	if(ebo == 0){
+		glGenBuffers(1, &ebo);
+	}
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.indices.size(), &(mesh.indices[0]), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.indexCount, mesh.indices, GL_STATIC_DRAW);
+	infos.size += sizeof(unsigned int) * mesh.indexCount;
 	
 	glBindVertexArray(0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -523,10 +721,48 @@ MeshInfos GLUtilities::setupBuffers(const Mesh & mesh){
 	
 	infos.vId = vao;
 	infos.eId = ebo;
-	infos.count = (GLsizei)mesh.indices.size();
+	infos.count = (GLsizei)mesh.indexCount;
+	// A mesh without levels of detail has a single level containing all triangles.
+	if(mesh.levels != nullptr && mesh.levelCount > 0){
+		infos.levels.assign(mesh.levels, mesh.levels + mesh.levelCount);
+		infos.count = (GLsizei)infos.levels[0].indexCount;
+	} else {
+		infos.levels.push_back({ 0, (uint32_t)mesh.indexCount, 0.0f });
+	}
+	scope.setBytes(infos.size);
 	return infos;
 }
 
+void GLUtilities::deleteTexture(TextureInfos & infos){
+	glDeleteTextures(1, &infos.id);
+	infos = TextureInfos();
+}
+
+void GLUtilities::deleteMesh(MeshInfos & infos){
+	glDeleteVertexArrays(1, &infos.vId);
+	glDeleteBuffers(1, &infos.eId);
+	if(!infos.bIds.empty()){
+		glDeleteBuffers((GLsizei)infos.bIds.size(), &infos.bIds[0]);
+	}
+	infos = MeshInfos();
+}
+
+bool GLUtilities::isExtensionSupported(const std::string & name){
+	// Query the list once, the context doesn't change.
+	static std::vector<std::string> extensions;
+	if(extensions.empty()){
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for(GLint eid = 0; eid < count; ++eid){
+			const GLubyte * extension = glGetStringi(GL_EXTENSIONS, GLuint(eid));
+			if(extension != NULL){
+				extensions.push_back(std::string(reinterpret_cast<const char *>(extension)));
+			}
+		}
+	}
+	return std::find(extensions.begin(), extensions.end(), name) != extensions.end();
+}
+
 void GLUtilities::saveDefaultFramebuffer(const unsigned int width, const unsigned int height, const std::string & path){
 	
 	GLint currentBoundFB = 0;
@@ -554,6 +790,34 @@ void GLUtilities::saveFramebuffer(const std::shared_ptr<Framebuffer> & framebuff
 	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)currentBoundFB);
 }
 
+void GLUtilities::readFramebuffer(const std::shared_ptr<Framebuffer> & framebuffer, const unsigned int width, const unsigned int height, DecodedImage & image){
+	
+	GLint currentBoundFB = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &currentBoundFB);
+	
+	framebuffer->bind();
+	GLenum type, format;
+	GLUtilities::getTypeAndFormat(framebuffer->typedFormat(), type, format);
+	
+	glFlush();
+	glFinish();
+	
+	free(image.data);
+	image = DecodedImage();
+	image.width = width;
+	image.height = height;
+	// Half float framebuffers are read back as floats.
+	image.hdr = type == GL_FLOAT || type == GL_HALF_FLOAT;
+	image.channels = image.hdr ? 3 : 4;
+	image.data = malloc(image.size());
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, (GLsizei)width, (GLsizei)height, image.hdr ? GL_RGB : GL_RGBA, image.hdr ? GL_FLOAT : GL_UNSIGNED_BYTE, image.data);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	image.status = 0;
+	
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)currentBoundFB);
+}
+
 
 void GLUtilities::savePixels(const GLenum type, const GLenum format, const unsigned int width, const unsigned int height, const unsigned int components, const std::string & path, const bool flip, const bool ignoreAlpha){
 	
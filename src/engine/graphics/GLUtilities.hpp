@@ -49,12 +49,47 @@ struct TextureInfos {
 	unsigned int mipmap; ///< The number of mipmaps.
 	bool cubemap; ///< Denote if the texture is a cubemap.
 	bool hdr; ///< Denote if the texture is HDR (float values).
+	bool half; ///< Denote if the HDR texture is stored as half floats.
+	bool compressed; ///< Denote if the texture is stored as compressed blocks.
+	bool sRGB; ///< Denote if gamma conversion is applied to the texture when used.
+	size_t size; ///< The GPU memory used by the texture, in bytes.
+	size_t savedSize; ///< The GPU memory saved by storing half floats or compressed blocks instead of floats or 8-bits RGBA, in bytes.
 	
 	/** Default constructor. */
-	TextureInfos() : id(0), width(0), height(0), mipmap(0), cubemap(false), hdr(false) {}
+	TextureInfos() : id(0), width(0), height(0), mipmap(0), cubemap(false), hdr(false), half(false), compressed(false), sRGB(false), size(0), savedSize(0) {}
 
 };
 
+/**
+ \brief Image decoded in memory, waiting to be uploaded to the GPU.
+ \ingroup Graphics
+ */
+struct DecodedImage {
+	void * data; ///< The pixels data, allocated with malloc.
+	unsigned int width; ///< The image width.
+	unsigned int height; ///< The image height.
+	unsigned int channels; ///< The number of channels.
+	bool hdr; ///< Denote if the pixels are floats.
+	bool half; ///< Denote if the HDR pixels are half floats.
+	GLenum compressedFormat; ///< The OpenGL format of the compressed blocks, 0 if the pixels are not compressed.
+	unsigned int blockSize; ///< The size of a compressed block of 4x4 pixels, in bytes.
+	int status; ///< The loading status, 0 if successful.
+	
+	/** Default constructor. */
+	DecodedImage() : data(NULL), width(0), height(0), channels(4), hdr(false), half(false), compressedFormat(0), blockSize(0), status(1) {}
+	
+	/** Query the size of the pixels data.
+	 \return the size in bytes
+	 */
+	size_t size() const {
+		if(compressedFormat != 0){
+			return size_t((width + 3) / 4) * size_t((height + 3) / 4) * blockSize;
+		}
+		return size_t(width) * height * channels * (hdr ? (half ? sizeof(uint16_t) : sizeof(float)) : 1);
+	}
+	
+};
+
 /**
  \brief Store geometry informations.
  \ingroup Graphics
@@ -62,11 +97,14 @@ struct TextureInfos {
 struct MeshInfos {
 	GLuint vId; ///< The vertex array OpenGL ID.
 	GLuint eId; ///< The element buffer OpenGL ID.
+	std::vector<GLuint> bIds; ///< The vertex buffers OpenGL IDs.
 	GLsizei count; ///< The number of vertices.
 	BoundingBox bbox; ///< The mesh bounding box in model space.
+	std::vector<MeshLevel> levels; ///< The levels of detail, as ranges of the element buffer.
+	size_t size; ///< The GPU memory used by the buffers, in bytes.
 	
 	/** Default constructor. */
-	MeshInfos() : vId(0), eId(0), count(0), bbox() {}
+	MeshInfos() : vId(0), eId(0), bIds(), count(0), bbox(), levels(), size(0) {}
 
 };
 
@@ -79,6 +117,13 @@ class GLUtilities {
 	
 public:
 	
+	/// \brief Storage layout of the mesh vertex attributes on the GPU.
+	enum VertexLayout {
+		Separate, ///< One float buffer per attribute (48 bytes per vertex).
+		Interleaved, ///< One buffer with the float attributes of each vertex contiguous (48 bytes per vertex).
+		Packed ///< One interleaved buffer with 10:10:10:2 normals and tangents and 16-bits texture coordinates (24 bytes per vertex).
+	};
+	
 	/** Create a shader of a given type from a string. Extract additional informations from the shader.
 	 \param prog the content of the shader
 	 \param type the type of shader (GL_VERTEX_SHADER,...)
@@ -115,12 +160,66 @@ public:
 	 */
 	static TextureInfos loadTextureCubemap(const std::vector<std::vector<std::string>> & paths, bool sRGB);
 	
+	/** Load and decode a set of images on multiple threads, without any OpenGL call. HDR images stored as half floats are kept as is.
+	 \param paths the images paths
+	 \param flip should the images be vertically flipped
+	 \param cubemap are the images expected to be cubemap faces, checked against the content of containers
+	 \param images will contain the decoded images, in the same order
+	 \return true if all images were loaded, else the images are released
+	 \note This can be called from any thread.
+	 */
+	static bool decodeImages(const std::vector<std::string> & paths, const bool flip, const bool cubemap, std::vector<DecodedImage> & images);
+	
+	/** Send decoded images to the GPU as a 2D texture, and release them.
+	 \param images the decoded images, one for each mipmap level of the texture
+	 \param sRGB denotes if gamma conversion should be applied to the texture when used
+	 \param textureId an existing texture to replace the content of, or 0 to create a new texture
+	 \return the texture informations, including the OpenGL ID
+	 \note If only one image is present, the mipmaps will be generated automatically.
+	 */
+	static TextureInfos uploadTexture(std::vector<DecodedImage> & images, bool sRGB, GLuint textureId = 0);
+	
+	/** Send decoded images to the GPU as a cubemap texture, and release them.
+	 \param images the decoded images, six (one per face) for each mipmap level of the texture
+	 \param sRGB denotes if gamma conversion should be applied to the texture when used
+	 \param textureId an existing cubemap to replace the content of, or 0 to create a new texture
+	 \return the texture informations, including the OpenGL ID
+	 \note If only six images are present, the mipmaps will be generated automatically.
+	 */
+	static TextureInfos uploadTextureCubemap(std::vector<DecodedImage> & images, bool sRGB, GLuint textureId = 0);
+	
 	/** Mesh loading: send a mesh data to the GPU.
 	 \param mesh the mesh to upload
+	 \param layout the vertex attributes storage layout
+	 \return the mesh infos, including OpenGL array/buffer IDs
+	 \note The attribute locations are: position (0), normal (1), uvs (2), tangent (3). The binormal orientation is stored in the tangent w component, B = w * cross(N, T).
+	 */
+	static MeshInfos setupBuffers(const Mesh & mesh, const VertexLayout layout = Packed);
+	
+	/** Upload mesh data from a non-owning view to the GPU, for instance from a memory-mapped file.
+	 \param mesh the mesh view
+	 \param layout the vertex attributes storage layout
+	 \param reuse an existing mesh whose vertex array and buffers should be filled instead of creating new ones, if any
 	 \return the mesh infos, including OpenGL array/buffer IDs
-	 \note The order of attribute locations is: position, normal, uvs, tangents, binormals.
+	 \note The attribute locations are: position (0), normal (1), uvs (2), tangent (3). The binormal orientation is stored in the tangent w component, B = w * cross(N, T).
 	 */
-	static MeshInfos setupBuffers(const Mesh & mesh);
+	static MeshInfos setupBuffers(const MeshView & mesh, const VertexLayout layout = Packed, const MeshInfos * reuse = nullptr);
+	
+	/** Release the GPU objects of a texture.
+	 \param infos the texture informations, reset to an empty texture
+	 */
+	static void deleteTexture(TextureInfos & infos);
+	
+	/** Release the GPU objects of a mesh: vertex array, vertex and element buffers.
+	 \param infos the mesh informations, reset to an empty mesh
+	 */
+	static void deleteMesh(MeshInfos & infos);
+	
+	/** Check if an OpenGL extension is supported by the current context.
+	 \param name the extension name
+	 \return true if the extension is supported
+	 */
+	static bool isExtensionSupported(const std::string & name);
 	
 	/** Save a given framebuffer content to the disk.
 	 \param framebuffer the framebuffer to save
@@ -133,6 +232,14 @@ public:
 	 */
 	static void saveFramebuffer(const std::shared_ptr<Framebuffer> & framebuffer, const unsigned int width, const unsigned int height, const std::string & path, const bool flip = true, const bool ignoreAlpha = false);
 	
+	/** Read back a given framebuffer content to the CPU.
+	 \param framebuffer the framebuffer to read
+	 \param width the width of the region to read
+	 \param height the height of the region to read
+	 \param image will contain the pixels, as RGB floats for float and half float framebuffers and RGBA bytes else, bottom row first
+	 */
+	static void readFramebuffer(const std::shared_ptr<Framebuffer> & framebuffer, const unsigned int width, const unsigned int height, DecodedImage & image);
+	
 	/** Save the window framebuffer content to the disk.
 	 \param width the width of the region to save
 	 \param height the height of the region to save
@@ -94,6 +94,8 @@ void ProgramInfos::reload()
 	const std::string fragmentContent = Resources::manager().getShader(_fragmentName, Resources::Fragment);
 	const std::string geometryContent = _geometryName.empty() ? "" : Resources::manager().getShader(_geometryName, Resources::Geometry);
 	const std::string debugName = "(" + _vertexName + ", " + (_geometryName.empty() ? "" : (_geometryName + ", ")) + _fragmentName + ")";
+	// Replace the previous program.
+	glDeleteProgram(_id);
 	_id = GLUtilities::createProgram(vertexContent, fragmentContent, geometryContent, bindings, debugName);
 	
 	// For each stored uniform, update its location, and update textures slots and cached values.
@@ -112,6 +114,10 @@ void ProgramInfos::reload()
 	glUseProgram(0);
 }
 
+bool ProgramInfos::dependsOn(const std::string & fileName) const {
+	return fileName == _vertexName + ".vert" || fileName == _fragmentName + ".frag" || (!_geometryName.empty() && fileName == _geometryName + ".geom");
+}
+
 
 void ProgramInfos::validate(){
 	glValidateProgram(_id);
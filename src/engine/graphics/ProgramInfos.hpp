@@ -45,6 +45,12 @@ public:
 	 */
 	void reload();
 	
+	/** Query if a shader file is one of the program stages.
+	 \param fileName the shader file name, with its extension
+	 \return true if the program uses the shader
+	 */
+	bool dependsOn(const std::string & fileName) const;
+	
 	/** Perform full program validation and log the results.
 	 \note Depending on the driver and GPU, some performance hints can be output.
 	 */
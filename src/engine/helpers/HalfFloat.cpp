@@ -0,0 +1,132 @@
+#include "HalfFloat.hpp"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+/// SSE instructions are available.
+#define HALF_FLOAT_SSE
+#endif
+
+/** Reinterpret the bits of a float as an integer.
+ \param value the float
+ \return the float bits
+ */
+inline uint32_t floatBits(const float value){
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(float));
+	return bits;
+}
+
+/** Reinterpret the bits of an integer as a float.
+ \param bits the float bits
+ \return the float
+ */
+inline float bitsFloat(const uint32_t bits){
+	float value;
+	std::memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+float HalfFloat::toFloat(const uint16_t half){
+	// Move the exponent and mantissa in place and rebias the exponent.
+	const uint32_t shiftedExponent = 0x7C00u << 13;
+	uint32_t bits = (uint32_t(half) & 0x7FFFu) << 13;
+	const uint32_t exponent = bits & shiftedExponent;
+	bits += (127u - 15u) << 23;
+	if(exponent == shiftedExponent){
+		// Infinities and NaNs get the maximal exponent.
+		bits += (128u - 16u) << 23;
+	} else if(exponent == 0){
+		// Denormals are renormalized by the floating point unit.
+		bits = floatBits(bitsFloat(bits + (1u << 23)) - bitsFloat(113u << 23));
+	}
+	return bitsFloat(bits | ((uint32_t(half) & 0x8000u) << 16));
+}
+
+uint16_t HalfFloat::fromFloat(const float value){
+	uint32_t bits = floatBits(value);
+	const uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+	uint32_t half = 0;
+	if(bits >= ((127u + 16u) << 23)){
+		// Too large values become infinities, NaNs stay NaNs.
+		half = bits > (255u << 23) ? 0x7E00u : 0x7C00u;
+	} else if(bits < ((127u - 14u) << 23)){
+		// Denormals: let the floating point unit align and round the mantissa.
+		const uint32_t magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+		half = floatBits(bitsFloat(bits) + bitsFloat(magic)) - magic;
+	} else {
+		// Rebias the exponent and round the mantissa to nearest even.
+		const uint32_t odd = (bits >> 13) & 1u;
+		bits += ((uint32_t)(15 - 127) << 23) + 0xFFFu + odd;
+		half = bits >> 13;
+	}
+	return uint16_t(half | (sign >> 16));
+}
+
+void HalfFloat::toFloats(const uint16_t * src, const size_t count, float * dst){
+	size_t i = 0;
+#ifdef HALF_FLOAT_SSE
+	// Eight values at a time: rebias the exponent with a multiplication, that also handles denormals, and restore infinities, NaNs and signs.
+	const __m128i noSignMask = _mm_set1_epi32(0x7FFF);
+	const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+	const __m128i maxFinite = _mm_set1_epi32(0x7BFF);
+	const __m128i infNanExponent = _mm_set1_epi32(255 << 23);
+	const __m128i zero = _mm_setzero_si128();
+	for(; i + 8 <= count; i += 8){
+		const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const __m128i words[2] = { _mm_unpacklo_epi16(halves, zero), _mm_unpackhi_epi16(halves, zero) };
+		for(int j = 0; j < 2; ++j){
+			const __m128i expMant = _mm_and_si128(words[j], noSignMask);
+			const __m128i sign = _mm_slli_epi32(_mm_xor_si128(words[j], expMant), 16);
+			const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)), magic);
+			const __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(expMant, maxFinite), infNanExponent);
+			_mm_storeu_ps(dst + i + 4 * j, _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan))));
+		}
+	}
+#endif
+	for(; i < count; ++i){
+		uint16_t half;
+		std::memcpy(&half, src + i, sizeof(uint16_t));
+		dst[i] = toFloat(half);
+	}
+}
+
+void HalfFloat::fromFloats(const float * src, const size_t count, uint16_t * dst){
+	size_t i = 0;
+#ifdef HALF_FLOAT_SSE
+	// Same steps as the scalar version, with masks to select between the normal, denormal and special cases.
+	const __m128i signMask = _mm_set1_epi32(int(0x80000000u));
+	const __m128i maxRegular = _mm_set1_epi32((127 + 16) << 23);
+	const __m128i nanBit = _mm_set1_epi32(0x200);
+	const __m128i infinity = _mm_set1_epi32(0x7C00);
+	const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+	const __m128i denormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+	for(; i + 8 <= count; i += 8){
+		__m128i results[2];
+		for(int j = 0; j < 2; ++j){
+			const __m128 value = _mm_loadu_ps(src + i + 4 * j);
+			const __m128 sign = _mm_and_ps(value, _mm_castsi128_ps(signMask));
+			const __m128 absValue = _mm_xor_ps(value, sign);
+			const __m128i absBits = _mm_castps_si128(absValue);
+			const __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absValue, absValue));
+			const __m128i isRegular = _mm_cmpgt_epi32(maxRegular, absBits);
+			const __m128i special = _mm_or_si128(_mm_and_si128(isNan, nanBit), infinity);
+			const __m128i isDenormal = _mm_cmpgt_epi32(minNormal, absBits);
+			const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absValue, _mm_castsi128_ps(denormalMagic))), denormalMagic);
+			const __m128i odd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+			const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absBits, normalBias), odd), 13);
+			const __m128i regular = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+			const __m128i half = _mm_or_si128(_mm_and_si128(isRegular, regular), _mm_andnot_si128(isRegular, special));
+			const __m128i result = _mm_or_si128(half, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+			// Sign-extend the low 16 bits so that packing doesn't saturate.
+			results[j] = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(results[0], results[1]));
+	}
+#endif
+	for(; i < count; ++i){
+		dst[i] = fromFloat(src[i]);
+	}
+}
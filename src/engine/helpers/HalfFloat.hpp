@@ -0,0 +1,44 @@
+#ifndef HalfFloat_h
+#define HalfFloat_h
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ \brief Convert between 32-bits floats and 16-bits half floats (IEEE 754 binary16), with SSE2 paths for arrays.
+ \details Conversions to half floats round to nearest even. Values too large become infinities, NaNs stay NaNs.
+ \ingroup Helpers
+ */
+class HalfFloat {
+	
+public:
+	
+	/** Convert a half float to a float.
+	 \param half the half float bits
+	 \return the float value
+	 */
+	static float toFloat(const uint16_t half);
+	
+	/** Convert a float to a half float.
+	 \param value the float value
+	 \return the half float bits
+	 */
+	static uint16_t fromFloat(const float value);
+	
+	/** Convert an array of half floats to floats.
+	 \param src the half floats, can be unaligned
+	 \param count the number of values
+	 \param dst the destination floats
+	 */
+	static void toFloats(const uint16_t * src, const size_t count, float * dst);
+	
+	/** Convert an array of floats to half floats.
+	 \param src the floats
+	 \param count the number of values
+	 \param dst the destination half floats
+	 */
+	static void fromFloats(const float * src, const size_t count, uint16_t * dst);
+	
+};
+
+#endif
@@ -2,6 +2,9 @@
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <memory>
 
 
 #ifdef _WIN32
@@ -16,6 +19,12 @@
 // but we want it to always be created.
 Log* Log::_defaultLogger = new Log();
 
+/// Thread owning the default logger.
+static const std::thread::id defaultLoggerThread = std::this_thread::get_id();
+
+/// Serialize the output of complete lines from multiple threads.
+static std::mutex outputMutex;
+
 void Log::set(LogLevel l){
 	_level = l;
 	_appendPrefix = true;
@@ -28,6 +37,7 @@ void Log::set(LogLevel l){
 
 Log::Log(){
 	_level = LogLevel::INFO;
+	_threadLogger = false;
 	_logToStdOut = true;
 	_verbose = false;
 	_ignoreUntilFlush = false;
@@ -57,6 +67,7 @@ Log::Log(){
 
 Log::Log(const std::string & filePath, const bool logToStdin, const bool verbose){
 	_level = LogLevel::INFO;
+	_threadLogger = false;
 	_logToStdOut = logToStdin;
 	_verbose = verbose;
 	_ignoreUntilFlush = false;
@@ -99,29 +110,52 @@ void Log::setDefaultVerbose(const bool verbose){
 }
 
 Log& Log::Info(){
-	_defaultLogger->set(LogLevel::INFO);
-	return *_defaultLogger;
+	Log & log = Log::current();
+	log.set(LogLevel::INFO);
+	return log;
 }
 
 Log& Log::Warning(){
-	_defaultLogger->set(LogLevel::WARNING);
-	return *_defaultLogger;
+	Log & log = Log::current();
+	log.set(LogLevel::WARNING);
+	return log;
 }
 
 Log& Log::Error(){
-	_defaultLogger->set(LogLevel::ERROR);
-	return *_defaultLogger;
+	Log & log = Log::current();
+	log.set(LogLevel::ERROR);
+	return log;
 }
 
 Log& Log::Verbose(){
-	_defaultLogger->set(LogLevel::VERBOSE);
-	return *_defaultLogger;
+	Log & log = Log::current();
+	log.set(LogLevel::VERBOSE);
+	return log;
+}
+
+Log & Log::current(){
+	if(std::this_thread::get_id() == defaultLoggerThread){
+		return *_defaultLogger;
+	}
+	// Other threads build their lines separately, with the same settings.
+	static thread_local std::unique_ptr<Log> threadLogger;
+	if(!threadLogger){
+		threadLogger.reset(new Log());
+		threadLogger->_logToStdOut = _defaultLogger->_logToStdOut;
+		threadLogger->_useColors = _defaultLogger->_useColors;
+		threadLogger->_threadLogger = true;
+	}
+	threadLogger->_verbose = _defaultLogger->_verbose;
+	return *threadLogger;
 }
 
 void Log::flush(){
 	if(!_ignoreUntilFlush){
 		
 		const std::string finalStr =  _stream.str();
+		// Lines from secondary threads are written to the default logger file.
+		std::lock_guard<std::mutex> lock(outputMutex);
+		std::ofstream & file = _threadLogger ? _defaultLogger->_file : _file;
 		
 		if(_logToStdOut){
 			if(_level == LogLevel::INFO || _level == LogLevel::VERBOSE){
@@ -130,8 +164,8 @@ void Log::flush(){
 				std::cerr << finalStr << std::flush;
 			}
 		}
-		if(_file.is_open()){
-			_file << finalStr << std::flush;
+		if(file.is_open()){
+			file << finalStr << std::flush;
 		}
 	}
 	_ignoreUntilFlush = false;
@@ -14,6 +14,7 @@
 
 /**
  \brief Provides logging utilities, either to the standard/error output or to a file, with multiple criticality levels.
+ \details The default logger can be used from multiple threads: each secondary thread builds its lines in its own logger, and complete lines are output one at a time.
  \ingroup Helpers
  */
 class Log {
@@ -184,6 +185,11 @@ private:
 	 */
 	void appendIfNeeded();
 	
+	/** Query the logger to use on the calling thread. This is the default logger on the thread that created it, and a thread-local logger with the same settings on other threads.
+	 \return the logger for the calling thread
+	 */
+	static Log & current();
+	
 	LogLevel _level; ///< The current criticality level.
 	bool _logToStdOut; ///< Should the logs be output to standard output.
 	std::ofstream _file; ///< The output log file stream.
@@ -192,6 +198,7 @@ private:
 	bool _ignoreUntilFlush; ///< Internal flag to ignore the current line if it is verbose.
 	bool _appendPrefix; ///< Should a domain or level prefix be appended to the current line.
 	bool _useColors; ///< Should color formatting be used.
+	bool _threadLogger; ///< Is this the logger of a secondary thread, writing to the default logger file.
 	
 	static Log* _defaultLogger; ///< Default static logger.
 };
@@ -0,0 +1,225 @@
+#include "Telemetry.hpp"
+#include "Logger.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <map>
+
+bool Telemetry::_enabled = false;
+
+/// \brief A recorded stage.
+struct TelemetryEvent {
+	std::string name; ///< The asset name.
+	double start; ///< Start time since recording was enabled, in microseconds.
+	double duration; ///< Duration in microseconds.
+	size_t bytes; ///< Processed bytes.
+	Telemetry::Stage stage; ///< The stage.
+	unsigned int thread; ///< Index of the thread the stage was executed on.
+};
+
+/// \brief All recorded data, shared by all threads.
+struct TelemetryRecord {
+	std::mutex mutex; ///< Protect the record.
+	std::vector<TelemetryEvent> events; ///< Recorded stages.
+	std::map<std::string, std::pair<size_t, size_t>> cache; ///< Cache hits and misses per asset.
+	std::map<std::thread::id, unsigned int> threads; ///< Index of each thread, in order of appearance.
+	std::chrono::steady_clock::time_point origin; ///< Time at which recording was enabled.
+	std::string path; ///< Output path prefix.
+};
+
+/** Access the shared telemetry record.
+ \return the record
+ */
+TelemetryRecord & telemetryRecord(){
+	static TelemetryRecord record;
+	return record;
+}
+
+/// The asset currently loaded on each thread.
+thread_local std::string telemetryAsset;
+
+const std::string telemetryStageNames[Telemetry::StageCount] = { "read", "inflate", "decode", "parse", "tangents", "mipmaps", "compress", "upload" };
+
+/** Escape a string for JSON output.
+ \param str the string to escape
+ \return the escaped string, between quotes
+ */
+std::string jsonString(const std::string & str){
+	std::stringstream res;
+	res << "\"";
+	for(const char c : str){
+		if(c == '"' || c == '\\'){
+			res << "\\" << c;
+		} else if((unsigned char)(c) < 0x20){
+			res << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+		} else {
+			res << c;
+		}
+	}
+	res << "\"";
+	return res.str();
+}
+
+Telemetry::Scope::Scope(const Stage stage, const std::string & name) : _stage(stage), _active(Telemetry::_enabled) {
+	if(!_active){
+		return;
+	}
+	_name = telemetryAsset.empty() ? name : telemetryAsset;
+	_start = std::chrono::steady_clock::now();
+}
+
+Telemetry::Scope::~Scope(){
+	if(_active){
+		Telemetry::record(_stage, _name, _start, std::chrono::steady_clock::now(), _bytes);
+	}
+}
+
+Telemetry::Asset::Asset(const std::string & name) : _active(Telemetry::_enabled) {
+	if(_active){
+		_previous = telemetryAsset;
+		telemetryAsset = name;
+	}
+}
+
+Telemetry::Asset::~Asset(){
+	if(_active){
+		telemetryAsset = _previous;
+	}
+}
+
+void Telemetry::enable(const std::string & path){
+	TelemetryRecord & record = telemetryRecord();
+	{
+		std::lock_guard<std::mutex> lock(record.mutex);
+		record.path = path;
+		record.origin = std::chrono::steady_clock::now();
+	}
+	if(!_enabled){
+		// The record has been created before, it will still be alive when saving.
+		std::atexit(Telemetry::save);
+	}
+	_enabled = true;
+}
+
+std::string Telemetry::currentAsset(){
+	return _enabled ? telemetryAsset : std::string();
+}
+
+void Telemetry::cacheAccess(const std::string & name, const bool hit){
+	if(!_enabled){
+		return;
+	}
+	TelemetryRecord & record = telemetryRecord();
+	std::lock_guard<std::mutex> lock(record.mutex);
+	std::pair<size_t, size_t> & counts = record.cache[name];
+	if(hit){
+		++counts.first;
+	} else {
+		++counts.second;
+	}
+}
+
+void Telemetry::record(const Stage stage, const std::string & name, const std::chrono::steady_clock::time_point & start, const std::chrono::steady_clock::time_point & end, const size_t bytes){
+	TelemetryRecord & record = telemetryRecord();
+	std::lock_guard<std::mutex> lock(record.mutex);
+	const auto thread = record.threads.insert(std::make_pair(std::this_thread::get_id(), (unsigned int)(record.threads.size())));
+	TelemetryEvent event;
+	event.name = name;
+	event.start = std::chrono::duration<double, std::micro>(start - record.origin).count();
+	event.duration = std::chrono::duration<double, std::micro>(end - start).count();
+	event.bytes = bytes;
+	event.stage = stage;
+	event.thread = thread.first->second;
+	record.events.push_back(event);
+}
+
+void Telemetry::save(){
+	if(!_enabled){
+		return;
+	}
+	TelemetryRecord & record = telemetryRecord();
+	std::lock_guard<std::mutex> lock(record.mutex);
+	
+	/// \brief Accumulated statistics of a stage.
+	struct StageTotal {
+		size_t count = 0; ///< Number of executions.
+		double duration = 0.0; ///< Total duration in microseconds.
+		size_t bytes = 0; ///< Total processed bytes.
+	};
+	std::map<std::string, std::vector<StageTotal>> assets;
+	std::vector<StageTotal> totals(StageCount);
+	for(const TelemetryEvent & event : record.events){
+		std::vector<StageTotal> & assetTotals = assets[event.name];
+		assetTotals.resize(StageCount);
+		for(StageTotal * total : { &assetTotals[event.stage], &totals[event.stage] }){
+			++total->count;
+			total->duration += event.duration;
+			total->bytes += event.bytes;
+		}
+	}
+	for(const auto & cache : record.cache){
+		assets[cache.first].resize(StageCount);
+	}
+	
+	// Summary, times in milliseconds.
+	const auto writeStages = [](std::ostream & out, const std::vector<StageTotal> & stages, const std::string & indent){
+		for(size_t sid = 0; sid < stages.size(); ++sid){
+			if(stages[sid].count == 0){
+				continue;
+			}
+			out << ",\n" << indent << jsonString(telemetryStageNames[sid]) << ": { \"count\": " << stages[sid].count << ", \"time\": " << stages[sid].duration / 1000.0 << ", \"bytes\": " << stages[sid].bytes << " }";
+		}
+	};
+	size_t hits = 0;
+	size_t misses = 0;
+	for(const auto & cache : record.cache){
+		hits += cache.second.first;
+		misses += cache.second.second;
+	}
+	std::ofstream summary(record.path + "_summary.json");
+	if(!summary.is_open()){
+		Log::Error() << Log::Utilities << "Unable to save telemetry summary to \"" << record.path << "_summary.json\"." << std::endl;
+		return;
+	}
+	summary << "{\n\t\"totals\": {\n\t\t\"hits\": " << hits << ", \"misses\": " << misses;
+	writeStages(summary, totals, "\t\t");
+	summary << "\n\t},\n\t\"assets\": {";
+	bool first = true;
+	for(const auto & asset : assets){
+		const auto cache = record.cache.find(asset.first);
+		const size_t assetHits = cache != record.cache.end() ? cache->second.first : 0;
+		const size_t assetMisses = cache != record.cache.end() ? cache->second.second : 0;
+		summary << (first ? "\n" : ",\n") << "\t\t" << jsonString(asset.first) << ": {\n\t\t\t\"hits\": " << assetHits << ", \"misses\": " << assetMisses;
+		writeStages(summary, asset.second, "\t\t\t");
+		summary << "\n\t\t}";
+		first = false;
+	}
+	summary << "\n\t}\n}\n";
+	summary.close();
+	
+	// Trace in the Chrome trace event format, times in microseconds.
+	std::ofstream trace(record.path + "_trace.json");
+	if(!trace.is_open()){
+		Log::Error() << Log::Utilities << "Unable to save telemetry trace to \"" << record.path << "_trace.json\"." << std::endl;
+		return;
+	}
+	trace << std::fixed << std::setprecision(3);
+	trace << "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	for(size_t tid = 0; tid < record.threads.size(); ++tid){
+		trace << "\t{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << tid << ", \"args\": { \"name\": \"Thread " << tid << "\" } },\n";
+	}
+	for(const TelemetryEvent & event : record.events){
+		trace << "\t{ \"name\": " << jsonString(telemetryStageNames[event.stage]) << ", \"cat\": \"assets\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << event.thread;
+		trace << ", \"ts\": " << event.start << ", \"dur\": " << event.duration;
+		trace << ", \"args\": { \"asset\": " << jsonString(event.name) << ", \"bytes\": " << event.bytes << " } },\n";
+	}
+	// Final metadata event, so that all other events can be followed by a comma.
+	trace << "\t{ \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": { \"name\": \"Assets loading\" } }\n";
+	trace << "] }\n";
+	trace.close();
+	Log::Info() << Log::Utilities << "Saved telemetry for " << assets.size() << " assets to \"" << record.path << "_summary.json\" and \"" << record.path << "_trace.json\"." << std::endl;
+}
@@ -0,0 +1,131 @@
+#ifndef Telemetry_h
+#define Telemetry_h
+
+#include <string>
+#include <chrono>
+#include <cstddef>
+
+/**
+ \brief Record the time spent in each stage of assets loading, the number of bytes processed and the resources cache hits and misses. When enabled, a JSON summary per asset and a Chrome trace (to open in about:tracing) are saved at exit.
+ \details Stages are timed with scopes, that can be used from any thread. They are attributed to the asset currently being loaded on the thread, see Telemetry::Asset. When disabled, scopes do nothing.
+ \ingroup Helpers
+ */
+class Telemetry {
+
+public:
+
+	/// \brief Stages of assets loading.
+	enum Stage {
+		Read = 0, ///< Reading or mapping the file.
+		Inflate, ///< Decompressing from a zip archive or a resource pack.
+		Decode, ///< Decoding an image.
+		Parse, ///< Parsing a mesh.
+		Tangents, ///< Generating mesh tangent frames.
+		Mipmaps, ///< Generating texture mipmap levels.
+		Compress, ///< Compressing texture blocks.
+		Upload, ///< Sending data to the GPU.
+		StageCount ///< Number of stages.
+	};
+	
+	/**
+	 \brief Time a stage of the asset currently loaded on this thread, from construction to destruction.
+	 */
+	class Scope {
+	public:
+	
+		/** Constructor. Start timing.
+		 \param stage the stage to time
+		 \param name name of the asset, used if no asset is currently loaded on this thread
+		 */
+		Scope(const Stage stage, const std::string & name = "");
+		
+		/** Set the number of bytes processed by the stage.
+		 \param bytes the byte count
+		 */
+		void setBytes(const size_t bytes){ _bytes = bytes; }
+		
+		/** Destructor. Record the stage. */
+		~Scope();
+		
+		/** Assignment operator (disabled). */
+		Scope& operator= (const Scope&) = delete;
+		
+		/** Copy constructor (disabled). */
+		Scope (const Scope&) = delete;
+	
+	private:
+	
+		std::string _name; ///< The fallback asset name.
+		std::chrono::steady_clock::time_point _start; ///< Start time.
+		size_t _bytes = 0; ///< Processed bytes.
+		Stage _stage; ///< The timed stage.
+		bool _active; ///< Was telemetry enabled when the scope started.
+	};
+	
+	/**
+	 \brief Mark an asset as being loaded on this thread, until destruction. Stages recorded in the meantime are attributed to it.
+	 */
+	class Asset {
+	public:
+	
+		/** Constructor.
+		 \param name the asset name
+		 */
+		Asset(const std::string & name);
+		
+		/** Destructor. Restore the previous asset. */
+		~Asset();
+		
+		/** Assignment operator (disabled). */
+		Asset& operator= (const Asset&) = delete;
+		
+		/** Copy constructor (disabled). */
+		Asset (const Asset&) = delete;
+	
+	private:
+	
+		std::string _previous; ///< The asset loaded on this thread before this one.
+		bool _active; ///< Was telemetry enabled at construction.
+	};
+	
+	/** Enable recording. The summary and trace will be saved at exit.
+	 \param path the output path prefix, the files will be saved at path_summary.json and path_trace.json
+	 */
+	static void enable(const std::string & path);
+	
+	/** Query if recording is enabled.
+	 \return true if stages are recorded
+	 */
+	static bool enabled(){ return _enabled; }
+	
+	/** Query the asset currently loaded on this thread, to forward it to worker threads with Telemetry::Asset.
+	 \return the asset name, empty if none or if recording is disabled
+	 */
+	static std::string currentAsset();
+	
+	/** Record a lookup in the resources cache.
+	 \param name the asset name
+	 \param hit was the asset already loaded
+	 */
+	static void cacheAccess(const std::string & name, const bool hit);
+	
+	/** Save the summary and the trace of all recorded stages. Called at exit when enabled.
+	 */
+	static void save();
+
+private:
+
+	/** Record a stage.
+	 \param stage the stage
+	 \param name the asset name
+	 \param start the stage start time
+	 \param end the stage end time
+	 \param bytes the number of bytes processed
+	 */
+	static void record(const Stage stage, const std::string & name, const std::chrono::steady_clock::time_point & start, const std::chrono::steady_clock::time_point & end, const size_t bytes);
+	
+	static bool _enabled; ///< Is recording enabled.
+
+};
+
+#endif
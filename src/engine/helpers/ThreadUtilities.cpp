@@ -0,0 +1,84 @@
+#include "ThreadUtilities.hpp"
+#include <algorithm>
+
+unsigned int ThreadUtilities::threadCount(){
+	return (std::max)(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadUtilities::parallelFor(const size_t count, const std::function<void(size_t, size_t, unsigned int)> & task, unsigned int threads){
+	if(count == 0){
+		return;
+	}
+	if(threads == 0){
+		threads = ThreadUtilities::threadCount();
+	}
+	const unsigned int rangesCount = (unsigned int)(std::min)(size_t(threads), count);
+	if(rangesCount == 1){
+		task(0, count, 0);
+		return;
+	}
+	// Launch the workers, each one processing a contiguous range.
+	std::vector<std::thread> workers;
+	workers.reserve(rangesCount - 1);
+	for(unsigned int rid = 1; rid < rangesCount; ++rid){
+		const size_t begin = count * rid / rangesCount;
+		const size_t end = count * (rid + 1) / rangesCount;
+		workers.emplace_back(std::cref(task), begin, end, rid);
+	}
+	// The current thread handles the first range.
+	task(0, count / rangesCount, 0);
+	for(auto & worker : workers){
+		worker.join();
+	}
+}
+
+ThreadPool::ThreadPool(unsigned int threads) : _stop(false) {
+	if(threads == 0){
+		threads = ThreadUtilities::threadCount();
+	}
+	_workers.reserve(threads);
+	for(unsigned int tid = 0; tid < threads; ++tid){
+		_workers.emplace_back(&ThreadPool::run, this);
+	}
+}
+
+void ThreadPool::push(const std::function<void()> & task){
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_tasks.push_back(task);
+	}
+	_condition.notify_one();
+}
+
+size_t ThreadPool::waitingCount(){
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _tasks.size();
+}
+
+void ThreadPool::run(){
+	while(true){
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]{ return _stop || !_tasks.empty(); });
+			if(_stop){
+				return;
+			}
+			task = std::move(_tasks.front());
+			_tasks.pop_front();
+		}
+		task();
+	}
+}
+
+ThreadPool::~ThreadPool(){
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+		_tasks.clear();
+	}
+	_condition.notify_all();
+	for(auto & worker : _workers){
+		worker.join();
+	}
+}
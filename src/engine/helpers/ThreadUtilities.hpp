@@ -0,0 +1,80 @@
+#ifndef ThreadUtilities_h
+#define ThreadUtilities_h
+
+#include <functional>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+/**
+ \brief Provide helpers to split work over multiple threads.
+ \ingroup Helpers
+ */
+class ThreadUtilities {
+	
+public:
+	
+	/** Query the number of threads to use by default for parallel work.
+	 \return the number of hardware threads available, at least one
+	 */
+	static unsigned int threadCount();
+	
+	/** Split an interval of items in contiguous ranges and process each range on its own thread. The calling thread processes the first range.
+	 \param count the number of items to process
+	 \param task the function to apply to each range, receiving the first item, the item after the last one and the range index
+	 \param threads the number of ranges to use (0 to use the default thread count)
+	 \note If there are less items than threads, fewer ranges are created.
+	 */
+	static void parallelFor(const size_t count, const std::function<void(size_t, size_t, unsigned int)> & task, unsigned int threads = 0);
+	
+};
+
+/**
+ \brief Set of persistent worker threads executing tasks in submission order.
+ \ingroup Helpers
+ */
+class ThreadPool {
+	
+public:
+	
+	/** Constructor. Start the workers.
+	 \param threads the number of workers (0 to use the default thread count)
+	 */
+	ThreadPool(unsigned int threads = 0);
+	
+	/** Submit a task, executed by the first available worker.
+	 \param task the task to execute
+	 */
+	void push(const std::function<void()> & task);
+	
+	/** Query the number of tasks submitted but not started yet.
+	 \return the number of waiting tasks
+	 */
+	size_t waitingCount();
+	
+	/** Destructor. Wait for the tasks in progress, discard the others and stop the workers. */
+	~ThreadPool();
+	
+	/** Assignment operator (disabled). */
+	ThreadPool& operator= (const ThreadPool&) = delete;
+	
+	/** Copy constructor (disabled). */
+	ThreadPool (const ThreadPool&) = delete;
+	
+private:
+	
+	/** Worker loop, executing tasks until the pool is stopped. */
+	void run();
+	
+	std::vector<std::thread> _workers; ///< The worker threads.
+	std::deque<std::function<void()>> _tasks; ///< Tasks waiting for a worker.
+	std::mutex _mutex; ///< Protect the tasks list and the stop flag.
+	std::condition_variable _condition; ///< Signal new tasks to the workers.
+	bool _stop; ///< Should the workers stop.
+	
+};
+
+#endif
@@ -19,6 +19,8 @@ void DirectionalLight::init(const std::vector<GLuint>& textureIds){
 	// Load the shaders
 	_program = Resources::manager().getProgram2D("directional_light");
 	_programDepth = Resources::manager().getProgram("object_depth", "object_basic", "light_shadow");
+	_debugProgram = Resources::manager().getProgramHandle("light_debug", "object_basic", "light_debug");
+	_debugMesh = Resources::manager().getMeshHandle("light_arrow");
 
 }
 
@@ -57,7 +59,7 @@ void DirectionalLight::drawShadow(const std::vector<Object> & objects) const {
 		}
 		const glm::mat4 lightMVP = _mvp * object.model();
 		glUniformMatrix4fv(_programDepth->uniform("mvp"), 1, GL_FALSE, &lightMVP[0][0]);
-		object.drawGeometry();
+		object.drawGeometry(object.levelOfDetail(_mvp));
 	}
 	glUseProgram(0);
 	
@@ -71,8 +73,8 @@ void DirectionalLight::drawShadow(const std::vector<Object> & objects) const {
 
 void DirectionalLight::drawDebug(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) const {
 	
-	const std::shared_ptr<ProgramInfos> debugProgram = Resources::manager().getProgram("light_debug", "object_basic", "light_debug");
-	const MeshInfos debugMesh = Resources::manager().getMesh("light_arrow");
+	const ProgramInfos * debugProgram = Resources::manager().resolve(_debugProgram);
+	const MeshInfos * debugMesh = Resources::manager().resolve(_debugMesh);
 	
 	glm::mat4 vp = projectionMatrix * viewMatrix * glm::inverse(_viewMatrix) * glm::scale(glm::mat4(1.0f), glm::vec3(0.2f));
 	const glm::vec3 colorLow = _color/(std::max)(_color[0], (std::max)(_color[1], _color[2]));
@@ -81,9 +83,9 @@ void DirectionalLight::drawDebug(const glm::mat4& viewMatrix, const glm::mat4& p
 	glUniformMatrix4fv(debugProgram->uniform("mvp"), 1, GL_FALSE, &vp[0][0]);
 	glUniform3fv(debugProgram->uniform("lightColor"), 1,  &colorLow[0]);
 	
-	glBindVertexArray(debugMesh.vId);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, debugMesh.eId);
-	glDrawElements(GL_TRIANGLES, debugMesh.count, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(debugMesh->vId);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, debugMesh->eId);
+	glDrawElements(GL_TRIANGLES, debugMesh->count, GL_UNSIGNED_INT, (void*)0);
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
@@ -110,5 +112,7 @@ void DirectionalLight::update(const glm::vec3 & newDirection){
 void DirectionalLight::clean() const {
 	_blur->clean();
 	_shadowPass->clean();
+	Resources::manager().release(_debugProgram);
+	Resources::manager().release(_debugMesh);
 }
 
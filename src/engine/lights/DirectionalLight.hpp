@@ -67,6 +67,7 @@ private:
 	
 	std::shared_ptr<ProgramInfos> _program; ///< Light rendering program.
 	std::shared_ptr<ProgramInfos> _programDepth; ///< Shadow map program.
+	MeshHandle _debugMesh; ///< Debug visualisation arrow.
 	std::vector<GLuint> _textures; ///< The G-buffer textures.
 };
 
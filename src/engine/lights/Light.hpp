@@ -1,6 +1,7 @@
 #ifndef Light_h
 #define Light_h
 #include "../Common.hpp"
+#include "../resources/ResourceHandle.hpp"
 #include <map>
 
 /**
@@ -31,6 +32,7 @@ protected:
 	glm::mat4 _mvp; ///< MVP matrix for shadow casting.
 	glm::vec3 _color; ///< Colored intensity.
 	bool _castShadows; ///< Is the light casting shadows (and thus use a shadow map).
+	ProgramHandle _debugProgram; ///< Debug visualisation program.
 };
 
 
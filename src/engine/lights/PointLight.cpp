@@ -32,6 +32,7 @@ void PointLight::init(const std::vector<GLuint>& textureIds){
 	_textureIds.emplace_back(_shadowFramebuffer->textureId());
 	// Load the shaders
 	_programDepth = Resources::manager().getProgram("object_layer_depth", "object_layer", "light_shadow_linear", "object_layer");
+	_debugProgram = Resources::manager().getProgramHandle("light_debug", "object_basic", "light_debug");
 	checkGLError();
 }
 
@@ -70,9 +71,9 @@ void PointLight::draw(const glm::mat4& viewMatrix, const glm::mat4& projectionMa
 		glBindTexture(GL_TEXTURE_CUBE_MAP, _textureIds[_textureIds.size()-1]);
 	}
 	// Select the geometry.
-	glBindVertexArray(_sphere.vId);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sphere.eId);
-	glDrawElements(GL_TRIANGLES, _sphere.count, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(_sphere->vId);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sphere->eId);
+	glDrawElements(GL_TRIANGLES, _sphere->count, GL_UNSIGNED_INT, (void*)0);
 	
 	glBindVertexArray(0);
 	glUseProgram(0);
@@ -104,7 +105,7 @@ void PointLight::drawShadow(const std::vector<Object> & objects) const {
 			continue;
 		}
 		glUniformMatrix4fv(_programDepth->uniform("model"), 1, GL_FALSE, &(object.model()[0][0]));
-		object.drawGeometry();
+		object.drawGeometry(object.levelOfDetail(_lightPosition, 1.0f));
 	}
 	glUseProgram(0);
 	
@@ -115,7 +116,7 @@ void PointLight::drawShadow(const std::vector<Object> & objects) const {
 
 void PointLight::drawDebug(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) const {
 	
-	const std::shared_ptr<ProgramInfos> debugProgram = Resources::manager().getProgram("light_debug", "object_basic", "light_debug");
+	const ProgramInfos * debugProgram = Resources::manager().resolve(_debugProgram);
 	
 	// Compute the model matrix to scale the sphere based on the radius.
 	const glm::mat4 modelMatrix = glm::scale(glm::translate(glm::mat4(1.0f), _lightPosition), glm::vec3(_radius));
@@ -126,9 +127,9 @@ void PointLight::drawDebug(const glm::mat4& viewMatrix, const glm::mat4& project
 	glUniformMatrix4fv(debugProgram->uniform("mvp"), 1, GL_FALSE, &mvp[0][0]);
 	glUniform3fv(debugProgram->uniform("lightColor"), 1,  &colorLow[0]);
 	
-	glBindVertexArray(_sphere.vId);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sphere.eId);
-	glDrawElements(GL_TRIANGLES, _sphere.count, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(_sphere->vId);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sphere->eId);
+	glDrawElements(GL_TRIANGLES, _sphere->count, GL_UNSIGNED_INT, (void*)0);
 	glBindVertexArray(0);
 	glUseProgram(0);
 
@@ -169,4 +170,5 @@ void PointLight::update(const glm::vec3 & newPosition){
 
 void PointLight::clean() const {
 	_shadowFramebuffer->clean();
+	Resources::manager().release(_debugProgram);
 }
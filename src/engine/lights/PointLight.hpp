@@ -70,7 +70,7 @@ private:
 	float _radius; ///< The attenuation radius.
 	float _farPlane; ///< The projection matrices far plane.
 	
-	MeshInfos _sphere; ///< The supporting geometry.
+	std::shared_ptr<MeshInfos> _sphere; ///< The supporting geometry.
 	std::shared_ptr<ProgramInfos> _program; ///< Light rendering program.
 	std::shared_ptr<ProgramInfos> _programDepth; ///< Shadow map program.
 	std::vector<GLuint> _textureIds; ///< The G-buffer textures.
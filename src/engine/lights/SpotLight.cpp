@@ -27,6 +27,7 @@ void SpotLight::init(const std::vector<GLuint>& textureIds){
 	// Load the shaders.
 	_program = Resources::manager().getProgram("spot_light", "object_basic", "spot_light");
 	_programDepth = Resources::manager().getProgram("object_depth", "object_basic", "light_shadow");
+	_debugProgram = Resources::manager().getProgramHandle("light_debug", "object_basic", "light_debug");
 	checkGLError();
 }
 
@@ -65,9 +66,9 @@ void SpotLight::draw(const glm::mat4& viewMatrix, const glm::mat4& projectionMat
 	}
 	
 	// Select the geometry.
-	glBindVertexArray(_cone.vId);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _cone.eId);
-	glDrawElements(GL_TRIANGLES, _cone.count, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(_cone->vId);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _cone->eId);
+	glDrawElements(GL_TRIANGLES, _cone->count, GL_UNSIGNED_INT, (void*)0);
 	
 	glBindVertexArray(0);
 	glUseProgram(0);
@@ -90,7 +91,7 @@ void SpotLight::drawShadow(const std::vector<Object> & objects) const {
 		}
 		const glm::mat4 lightMVP = _mvp * object.model();
 		glUniformMatrix4fv(_programDepth->uniform("mvp"), 1, GL_FALSE, &lightMVP[0][0]);
-		object.drawGeometry();
+		object.drawGeometry(object.levelOfDetail(_mvp));
 	}
 	glUseProgram(0);
 	
@@ -105,7 +106,7 @@ void SpotLight::drawShadow(const std::vector<Object> & objects) const {
 
 void SpotLight::drawDebug(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) const {
 	
-	const std::shared_ptr<ProgramInfos> debugProgram = Resources::manager().getProgram("light_debug", "object_basic", "light_debug");
+	const ProgramInfos * debugProgram = Resources::manager().resolve(_debugProgram);
 	
 	// Compute the model matrix to scale the cone based on the outer angle and the radius.
 	const float width = 2.0f*std::tan(_outerHalfAngle);
@@ -117,9 +118,9 @@ void SpotLight::drawDebug(const glm::mat4& viewMatrix, const glm::mat4& projecti
 	glUniformMatrix4fv(debugProgram->uniform("mvp"), 1, GL_FALSE, &mvp[0][0]);
 	glUniform3fv(debugProgram->uniform("lightColor"), 1,  &colorLow[0]);
 	
-	glBindVertexArray(_cone.vId);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _cone.eId);
-	glDrawElements(GL_TRIANGLES, _cone.count, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(_cone->vId);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _cone->eId);
+	glDrawElements(GL_TRIANGLES, _cone->count, GL_UNSIGNED_INT, (void*)0);
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
@@ -147,5 +148,6 @@ void SpotLight::update(const glm::vec3 & newPosition, const glm::vec3 & newDirec
 void SpotLight::clean() const {
 	_blur->clean();
 	_shadowPass->clean();
+	Resources::manager().release(_debugProgram);
 }
 
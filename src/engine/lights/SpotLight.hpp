@@ -85,7 +85,7 @@ private:
 	float _outerHalfAngle; ///< The outer cone attenuation angle.
 	float _radius; ///< The attenuation radius.
 	
-	MeshInfos _cone; ///< The supporting geometry.
+	std::shared_ptr<MeshInfos> _cone; ///< The supporting geometry.
 	std::shared_ptr<ProgramInfos> _program; ///< Light rendering program.
 	std::shared_ptr<ProgramInfos> _programDepth; ///< Shadow map program.
 	std::vector<GLuint> _textureIds; ///< The G-buffer textures.
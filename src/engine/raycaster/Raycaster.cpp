@@ -0,0 +1,801 @@
+#include "Raycaster.hpp"
+#include "../helpers/ThreadUtilities.hpp"
+#include <cmath>
+#include <cfloat>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+/// SSE instructions are available.
+#define RAYCASTER_SSE
+#endif
+
+// Hierarchy construction.
+
+/// Number of bins used to evaluate the surface area heuristic along each axis.
+#define RAYCASTER_BIN_COUNT 16
+/// Maximum number of triangles in a leaf, unless they can't be separated.
+#define RAYCASTER_MAX_LEAF_SIZE 8
+/// Cost of intersecting a triangle, relative to a traversal step.
+#define RAYCASTER_TRIANGLE_COST 0.5f
+/// Nodes with more triangles are binned and partitioned using all threads, smaller nodes are processed in parallel with each other.
+#define RAYCASTER_PARALLEL_NODE_SIZE 65536
+/// Maximum depth of the traversal stack.
+#define RAYCASTER_STACK_SIZE 64
+
+/** \brief Axis aligned box used during construction, initially empty.
+ \ingroup Raycaster
+ */
+struct BuildBox {
+	glm::vec3 minis = glm::vec3(FLT_MAX); ///< Lower corner.
+	glm::vec3 maxis = glm::vec3(-FLT_MAX); ///< Upper corner.
+	
+	/** Extend the box to contain a point.
+	 \param p the point to include
+	 */
+	void extend(const glm::vec3 & p){
+		minis = glm::min(minis, p);
+		maxis = glm::max(maxis, p);
+	}
+	
+	/** Extend the box to contain another box.
+	 \param box the box to include
+	 */
+	void merge(const BuildBox & box){
+		minis = glm::min(minis, box.minis);
+		maxis = glm::max(maxis, box.maxis);
+	}
+	
+	/** Compute half of the box surface area.
+	 \return the half area, or 0 for an empty box
+	 */
+	float halfArea() const {
+		const glm::vec3 size = maxis - minis;
+		if(size.x < 0.0f || size.y < 0.0f || size.z < 0.0f){
+			return 0.0f;
+		}
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+};
+
+/** \brief A bin of triangles along an axis, used to evaluate the surface area heuristic.
+ \ingroup Raycaster
+ */
+struct BuildBin {
+	BuildBox bounds; ///< Bounds of the triangles.
+	BuildBox centroids; ///< Bounds of the triangles centroids.
+	uint32_t count = 0; ///< Number of triangles.
+	
+	/** Accumulate another bin.
+	 \param bin the bin to add
+	 */
+	void merge(const BuildBin & bin){
+		bounds.merge(bin.bounds);
+		centroids.merge(bin.centroids);
+		count += bin.count;
+	}
+};
+
+/** \brief The split decision for a node.
+ \ingroup Raycaster
+ */
+struct BuildSplit {
+	bool leaf = true; ///< Should the node be a leaf.
+	BuildBin left; ///< Triangles going to the first child.
+	BuildBin right; ///< Triangles going to the second child.
+};
+
+/** \brief The triangles data used during construction.
+ \ingroup Raycaster
+ */
+struct BuildData {
+	std::vector<BuildBox> bounds; ///< Bounds of each triangle.
+	std::vector<glm::vec3> centroids; ///< Centroid of each triangle bounds.
+	std::vector<uint32_t> ids; ///< Triangles indices, partitioned in the nodes ranges.
+	std::vector<BuildBox> nodeCentroids; ///< Bounds of the triangles centroids for each node.
+};
+
+/** Compute the bin of a triangle along an axis.
+ \param centroid the triangle centroid
+ \param axis the axis
+ \param origin the lower corner of the node centroids bounds
+ \param scale the number of bins per unit along each axis
+ \return the bin index
+ */
+inline int binIndex(const glm::vec3 & centroid, const int axis, const glm::vec3 & origin, const glm::vec3 & scale){
+	const int bin = int((centroid[axis] - origin[axis]) * scale[axis]);
+	return glm::clamp(bin, 0, RAYCASTER_BIN_COUNT - 1);
+}
+
+/** Bin the triangles of a node along the three axis.
+ \param data the construction data
+ \param first the first triangle of the node
+ \param count the number of triangles in the node
+ \param origin the lower corner of the node centroids bounds
+ \param scale the number of bins per unit along each axis
+ \param threadCount the number of threads to use
+ \param bins will contain the bins for each axis, axis after axis
+ */
+void binTriangles(const BuildData & data, const size_t first, const size_t count, const glm::vec3 & origin, const glm::vec3 & scale, const unsigned int threadCount, std::vector<BuildBin> & bins){
+	const size_t binsPerRange = 3 * RAYCASTER_BIN_COUNT;
+	const unsigned int rangeCount = (std::max)(1u, threadCount);
+	std::vector<BuildBin> rangeBins(binsPerRange * rangeCount);
+	ThreadUtilities::parallelFor(count, [&](size_t begin, size_t end, unsigned int rid){
+		BuildBin * localBins = &rangeBins[rid * binsPerRange];
+		for(size_t i = first + begin; i < first + end; ++i){
+			const uint32_t id = data.ids[i];
+			const glm::vec3 & centroid = data.centroids[id];
+			for(int axis = 0; axis < 3; ++axis){
+				BuildBin & bin = localBins[axis * RAYCASTER_BIN_COUNT + binIndex(centroid, axis, origin, scale)];
+				bin.bounds.merge(data.bounds[id]);
+				bin.centroids.extend(centroid);
+				++bin.count;
+			}
+		}
+	}, threadCount);
+	// Merge the ranges bins. Min/max and counts don't depend on the order.
+	bins.assign(rangeBins.begin(), rangeBins.begin() + binsPerRange);
+	for(unsigned int rid = 1; rid < rangeCount; ++rid){
+		for(size_t bid = 0; bid < binsPerRange; ++bid){
+			bins[bid].merge(rangeBins[rid * binsPerRange + bid]);
+		}
+	}
+}
+
+/** Partition the triangles of a node between its two children, preserving their relative order.
+ \param data the construction data
+ \param first the first triangle of the node
+ \param count the number of triangles in the node
+ \param goesLeft the predicate indicating if a triangle belongs to the first child
+ \param threadCount the number of threads to use
+ */
+template<typename Predicate>
+void partitionTriangles(BuildData & data, const size_t first, const size_t count, const Predicate & goesLeft, const unsigned int threadCount){
+	const unsigned int rangeCount = (std::max)(1u, threadCount);
+	std::vector<size_t> leftCounts(rangeCount + 1, 0);
+	std::vector<size_t> rightCounts(rangeCount + 1, 0);
+	ThreadUtilities::parallelFor(count, [&](size_t begin, size_t end, unsigned int rid){
+		size_t leftCount = 0;
+		for(size_t i = first + begin; i < first + end; ++i){
+			leftCount += goesLeft(data.ids[i]) ? 1 : 0;
+		}
+		leftCounts[rid + 1] = leftCount;
+		rightCounts[rid + 1] = (end - begin) - leftCount;
+	}, threadCount);
+	// Each range writes its triangles after the ones of the previous ranges.
+	for(unsigned int rid = 0; rid < rangeCount; ++rid){
+		leftCounts[rid + 1] += leftCounts[rid];
+		rightCounts[rid + 1] += rightCounts[rid];
+	}
+	const size_t totalLeft = leftCounts[rangeCount];
+	std::vector<uint32_t> partitioned(count);
+	ThreadUtilities::parallelFor(count, [&](size_t begin, size_t end, unsigned int rid){
+		size_t left = leftCounts[rid];
+		size_t right = totalLeft + rightCounts[rid];
+		for(size_t i = first + begin; i < first + end; ++i){
+			const uint32_t id = data.ids[i];
+			partitioned[goesLeft(id) ? left++ : right++] = id;
+		}
+	}, threadCount);
+	std::copy(partitioned.begin(), partitioned.end(), data.ids.begin() + first);
+}
+
+/** Decide how to split a node using the binned surface area heuristic, and partition its triangles accordingly.
+ \param data the construction data
+ \param nodeId the node index
+ \param first the first triangle of the node
+ \param count the number of triangles in the node
+ \param threadCount the number of threads to use
+ \return the split decision
+ */
+BuildSplit splitNode(BuildData & data, const size_t nodeId, const size_t first, const size_t count, const unsigned int threadCount){
+	BuildSplit split;
+	if(count <= 1){
+		return split;
+	}
+	const BuildBox & centroids = data.nodeCentroids[nodeId];
+	const glm::vec3 extent = centroids.maxis - centroids.minis;
+	const float maxExtent = (std::max)(extent.x, (std::max)(extent.y, extent.z));
+	
+	if(maxExtent <= 0.0f){
+		// All centroids are at the same position, triangles can't be separated by binning.
+		if(count <= RAYCASTER_MAX_LEAF_SIZE){
+			return split;
+		}
+		// Split the list in half.
+		split.leaf = false;
+		for(size_t i = 0; i < count; ++i){
+			const uint32_t id = data.ids[first + i];
+			BuildBin & bin = i < count / 2 ? split.left : split.right;
+			bin.bounds.merge(data.bounds[id]);
+			bin.centroids.extend(data.centroids[id]);
+			++bin.count;
+		}
+		return split;
+	}
+	
+	// Bins slightly shrinked so that the maximal centroid falls in the last bin.
+	const glm::vec3 scale = glm::vec3(
+		extent.x > 0.0f ? float(RAYCASTER_BIN_COUNT) * (1.0f - 1e-5f) / extent.x : 0.0f,
+		extent.y > 0.0f ? float(RAYCASTER_BIN_COUNT) * (1.0f - 1e-5f) / extent.y : 0.0f,
+		extent.z > 0.0f ? float(RAYCASTER_BIN_COUNT) * (1.0f - 1e-5f) / extent.z : 0.0f);
+	std::vector<BuildBin> bins;
+	binTriangles(data, first, count, centroids.minis, scale, threadCount, bins);
+	
+	// Sweep the bins along each axis, and evaluate the cost of each split position.
+	// The cost is expressed relative to a traversal step. Triangles are tested four at a time, so intersecting one costs less.
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestBin = 0;
+	float parentArea = 0.0f;
+	{
+		BuildBox parentBounds;
+		for(int bid = 0; bid < RAYCASTER_BIN_COUNT; ++bid){
+			parentBounds.merge(bins[bid].bounds);
+		}
+		parentArea = parentBounds.halfArea();
+	}
+	for(int axis = 0; axis < 3; ++axis){
+		if(extent[axis] <= 0.0f){
+			continue;
+		}
+		const BuildBin * axisBins = &bins[axis * RAYCASTER_BIN_COUNT];
+		float rightCosts[RAYCASTER_BIN_COUNT];
+		BuildBox rightBounds;
+		uint32_t rightCount = 0;
+		for(int bid = RAYCASTER_BIN_COUNT - 1; bid > 0; --bid){
+			rightBounds.merge(axisBins[bid].bounds);
+			rightCount += axisBins[bid].count;
+			rightCosts[bid] = rightBounds.halfArea() * float(rightCount);
+		}
+		BuildBox leftBounds;
+		uint32_t leftCount = 0;
+		for(int bid = 1; bid < RAYCASTER_BIN_COUNT; ++bid){
+			leftBounds.merge(axisBins[bid - 1].bounds);
+			leftCount += axisBins[bid - 1].count;
+			if(leftCount == 0 || leftCount == count){
+				continue;
+			}
+			const float cost = 1.0f + RAYCASTER_TRIANGLE_COST * (leftBounds.halfArea() * float(leftCount) + rightCosts[bid]) / (std::max)(parentArea, FLT_MIN);
+			if(cost < bestCost){
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = bid;
+			}
+		}
+	}
+	if(bestAxis < 0 || (count <= RAYCASTER_MAX_LEAF_SIZE && RAYCASTER_TRIANGLE_COST * float(count) <= bestCost)){
+		return split;
+	}
+	
+	split.leaf = false;
+	for(int bid = 0; bid < RAYCASTER_BIN_COUNT; ++bid){
+		(bid < bestBin ? split.left : split.right).merge(bins[bestAxis * RAYCASTER_BIN_COUNT + bid]);
+	}
+	const glm::vec3 origin = centroids.minis;
+	auto goesLeft = [&data, bestAxis, bestBin, &origin, &scale](uint32_t id){
+		return binIndex(data.centroids[id], bestAxis, origin, scale) < bestBin;
+	};
+	if(count >= RAYCASTER_PARALLEL_NODE_SIZE){
+		partitionTriangles(data, first, count, goesLeft, threadCount);
+	} else {
+		std::stable_partition(data.ids.begin() + first, data.ids.begin() + first + count, goesLeft);
+	}
+	return split;
+}
+
+unsigned int Raycaster::addMesh(const Mesh & mesh){
+	const unsigned int meshId = (unsigned int)_vertexOffsets.size();
+	const unsigned int vertexOffset = (unsigned int)_positions.size();
+	_vertexOffsets.push_back(vertexOffset);
+	_positions.insert(_positions.end(), mesh.positions.begin(), mesh.positions.end());
+	
+	// Only the faces of the most detailed level.
+	const size_t firstIndex = mesh.levels.empty() ? 0 : mesh.levels[0].firstIndex;
+	const size_t indexCount = mesh.levels.empty() ? mesh.indices.size() : mesh.levels[0].indexCount;
+	_sourceTriangles.reserve(_sourceTriangles.size() + indexCount / 3);
+	for(size_t iid = 0; iid + 2 < indexCount; iid += 3){
+		const unsigned int * face = &mesh.indices[firstIndex + iid];
+		_sourceTriangles.push_back({ face[0], face[1], face[2], (unsigned int)(iid / 3), meshId });
+	}
+	return meshId;
+}
+
+void Raycaster::updateHierarchy(unsigned int threadCount){
+	if(threadCount == 0){
+		threadCount = ThreadUtilities::threadCount();
+	}
+	_nodes.clear();
+	_triangles.clear();
+	for(std::vector<float> * array : { &_v0x, &_v0y, &_v0z, &_e1x, &_e1y, &_e1z, &_e2x, &_e2y, &_e2z }){
+		array->clear();
+	}
+	const size_t count = _sourceTriangles.size();
+	if(count == 0){
+		return;
+	}
+	
+	// Bounds and centroids of each triangle.
+	BuildData data;
+	data.bounds.resize(count);
+	data.centroids.resize(count);
+	data.ids.resize(count);
+	std::iota(data.ids.begin(), data.ids.end(), 0);
+	const unsigned int rangeCount = (std::max)(1u, threadCount);
+	std::vector<BuildBin> rootBins(rangeCount);
+	ThreadUtilities::parallelFor(count, [&](size_t begin, size_t end, unsigned int rid){
+		for(size_t tid = begin; tid < end; ++tid){
+			const Triangle & triangle = _sourceTriangles[tid];
+			const unsigned int offset = _vertexOffsets[triangle.meshId];
+			BuildBox & box = data.bounds[tid];
+			box.extend(_positions[offset + triangle.v0]);
+			box.extend(_positions[offset + triangle.v1]);
+			box.extend(_positions[offset + triangle.v2]);
+			data.centroids[tid] = 0.5f * (box.minis + box.maxis);
+			rootBins[rid].bounds.merge(box);
+			rootBins[rid].centroids.extend(data.centroids[tid]);
+		}
+	}, threadCount);
+	BuildBin root;
+	for(const BuildBin & bin : rootBins){
+		root.merge(bin);
+	}
+	
+	// Build the hierarchy level by level. During construction, all nodes store the range of their triangles.
+	_nodes.push_back({ root.bounds.minis, 0, root.bounds.maxis, uint32_t(count) });
+	data.nodeCentroids.push_back(root.centroids);
+	std::vector<uint32_t> level = { 0 };
+	std::vector<BuildSplit> splits;
+	std::vector<size_t> smallNodes;
+	// The depth is limited so that traversals never overflow their stack, deeper nodes become leaves.
+	for(int depth = 0; !level.empty() && depth < RAYCASTER_STACK_SIZE - 2; ++depth){
+		splits.assign(level.size(), BuildSplit());
+		smallNodes.clear();
+		// Large nodes use all threads for binning and partitioning, smaller nodes are processed in parallel with each other.
+		for(size_t lid = 0; lid < level.size(); ++lid){
+			const Node & node = _nodes[level[lid]];
+			if(node.count >= RAYCASTER_PARALLEL_NODE_SIZE){
+				splits[lid] = splitNode(data, level[lid], node.first, node.count, threadCount);
+			} else {
+				smallNodes.push_back(lid);
+			}
+		}
+		ThreadUtilities::parallelFor(smallNodes.size(), [&](size_t begin, size_t end, unsigned int){
+			for(size_t sid = begin; sid < end; ++sid){
+				const size_t lid = smallNodes[sid];
+				const Node & node = _nodes[level[lid]];
+				splits[lid] = splitNode(data, level[lid], node.first, node.count, 1);
+			}
+		}, threadCount);
+		
+		// Create the children of split nodes, in a deterministic order.
+		std::vector<uint32_t> nextLevel;
+		for(size_t lid = 0; lid < level.size(); ++lid){
+			const BuildSplit & split = splits[lid];
+			if(split.leaf){
+				continue;
+			}
+			const uint32_t childId = uint32_t(_nodes.size());
+			const uint32_t first = _nodes[level[lid]].first;
+			_nodes.push_back({ split.left.bounds.minis, first, split.left.bounds.maxis, split.left.count });
+			_nodes.push_back({ split.right.bounds.minis, first + split.left.count, split.right.bounds.maxis, split.right.count });
+			data.nodeCentroids.push_back(split.left.centroids);
+			data.nodeCentroids.push_back(split.right.centroids);
+			_nodes[level[lid]].first = childId;
+			_nodes[level[lid]].count = 0;
+			nextLevel.push_back(childId);
+			nextLevel.push_back(childId + 1);
+		}
+		std::swap(level, nextLevel);
+	}
+	
+	// Store the triangles of each leaf contiguously, padded to a multiple of four with degenerate triangles.
+	for(Node & node : _nodes){
+		if(node.count == 0){
+			continue;
+		}
+		const uint32_t first = node.first;
+		node.first = uint32_t(_triangles.size());
+		const uint32_t paddedCount = (node.count + 3) & ~3u;
+		for(uint32_t i = 0; i < paddedCount; ++i){
+			const bool padding = i >= node.count;
+			const Triangle & triangle = _sourceTriangles[data.ids[first + (padding ? 0 : i)]];
+			const unsigned int offset = _vertexOffsets[triangle.meshId];
+			const glm::vec3 & v0 = _positions[offset + triangle.v0];
+			const glm::vec3 e1 = padding ? glm::vec3(0.0f) : _positions[offset + triangle.v1] - v0;
+			const glm::vec3 e2 = padding ? glm::vec3(0.0f) : _positions[offset + triangle.v2] - v0;
+			_triangles.push_back(triangle);
+			_v0x.push_back(v0.x); _v0y.push_back(v0.y); _v0z.push_back(v0.z);
+			_e1x.push_back(e1.x); _e1y.push_back(e1.y); _e1z.push_back(e1.z);
+			_e2x.push_back(e2.x); _e2y.push_back(e2.y); _e2z.push_back(e2.z);
+		}
+	}
+	Log::Verbose() << Log::Utilities << "Raycaster: hierarchy with " << _nodes.size() << " nodes over " << count << " triangles." << std::endl;
+}
+
+// Queries.
+
+/** \brief Ray data precomputed for box intersections.
+ \ingroup Raycaster
+ */
+struct RayBoxData {
+#ifdef RAYCASTER_SSE
+	__m128 origin; ///< Ray origin.
+	__m128 invDir; ///< Inverse of the ray direction.
+#else
+	glm::vec3 origin; ///< Ray origin.
+	glm::vec3 invDir; ///< Inverse of the ray direction.
+#endif
+
+	/** Constructor.
+	 \param o the ray origin
+	 \param d the ray direction
+	 */
+	RayBoxData(const glm::vec3 & o, const glm::vec3 & d){
+		// Avoid infinite values, that would produce NaNs when the origin is on a box plane.
+		glm::vec3 inv;
+		for(int i = 0; i < 3; ++i){
+			const float di = std::abs(d[i]) < 1e-20f ? (d[i] < 0.0f ? -1e-20f : 1e-20f) : d[i];
+			inv[i] = 1.0f / di;
+		}
+#ifdef RAYCASTER_SSE
+		origin = _mm_setr_ps(o.x, o.y, o.z, 0.0f);
+		invDir = _mm_setr_ps(inv.x, inv.y, inv.z, 0.0f);
+#else
+		origin = o;
+		invDir = inv;
+#endif
+	}
+};
+
+/** Intersect a ray with a node bounding box.
+ \param minis the lower corner of the box, followed by a 32 bits value
+ \param maxis the upper corner of the box, followed by a 32 bits value
+ \param ray the ray data
+ \param mini the minimal distance along the ray
+ \param maxi the maximal distance along the ray
+ \param dist will contain the entry distance in the box
+ \return true if the ray intersects the box
+ */
+inline bool intersectsBox(const glm::vec3 & minis, const glm::vec3 & maxis, const RayBoxData & ray, const float mini, const float maxi, float & dist){
+#ifdef RAYCASTER_SSE
+	// The fourth lane contains the node index or count. It is cleared, as integers would be interpreted as denormals, which are very slow to process.
+	const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_and_ps(_mm_loadu_ps(&minis[0]), mask), ray.origin), ray.invDir);
+	const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_and_ps(_mm_loadu_ps(&maxis[0]), mask), ray.origin), ray.invDir);
+	const __m128 tmin = _mm_min_ps(t0, t1);
+	const __m128 tmax = _mm_max_ps(t0, t1);
+	__m128 tnear = _mm_max_ss(tmin, _mm_shuffle_ps(tmin, tmin, _MM_SHUFFLE(1, 1, 1, 1)));
+	tnear = _mm_max_ss(tnear, _mm_shuffle_ps(tmin, tmin, _MM_SHUFFLE(2, 2, 2, 2)));
+	tnear = _mm_max_ss(tnear, _mm_set_ss(mini));
+	__m128 tfar = _mm_min_ss(tmax, _mm_shuffle_ps(tmax, tmax, _MM_SHUFFLE(1, 1, 1, 1)));
+	tfar = _mm_min_ss(tfar, _mm_shuffle_ps(tmax, tmax, _MM_SHUFFLE(2, 2, 2, 2)));
+	tfar = _mm_min_ss(tfar, _mm_set_ss(maxi));
+	dist = _mm_cvtss_f32(tnear);
+	return _mm_comile_ss(tnear, tfar) != 0;
+#else
+	const glm::vec3 t0 = (minis - ray.origin) * ray.invDir;
+	const glm::vec3 t1 = (maxis - ray.origin) * ray.invDir;
+	const glm::vec3 tmin = glm::min(t0, t1);
+	const glm::vec3 tmax = glm::max(t0, t1);
+	const float tnear = (std::max)((std::max)(tmin.x, tmin.y), (std::max)(tmin.z, mini));
+	const float tfar = (std::min)((std::min)(tmax.x, tmax.y), (std::min)(tmax.z, maxi));
+	dist = tnear;
+	return tnear <= tfar;
+#endif
+}
+
+template<typename Hit>
+void Raycaster::fillHit(const uint32_t triangleId, Hit & hit) const {
+	const Triangle & triangle = _triangles[triangleId];
+	hit.meshId = triangle.meshId;
+	hit.localId = triangle.localId;
+	hit.v0 = triangle.v0;
+	hit.v1 = triangle.v1;
+	hit.v2 = triangle.v2;
+}
+
+bool Raycaster::intersectsLeaf(const Node & node, const glm::vec3 & origin, const glm::vec3 & direction, const float mini, RayHit & hit) const {
+	bool found = false;
+	uint32_t bestId = 0;
+	const uint32_t end = node.first + node.count;
+#ifdef RAYCASTER_SSE
+	// Möller-Trumbore test, on four triangles at once.
+	const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+	const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 epsilon = _mm_set1_ps(1e-12f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 tmin = _mm_set1_ps(mini);
+	for(uint32_t tid = node.first; tid < end; tid += 4){
+		const __m128 e1x = _mm_loadu_ps(&_e1x[tid]), e1y = _mm_loadu_ps(&_e1y[tid]), e1z = _mm_loadu_ps(&_e1z[tid]);
+		const __m128 e2x = _mm_loadu_ps(&_e2x[tid]), e2y = _mm_loadu_ps(&_e2y[tid]), e2z = _mm_loadu_ps(&_e2z[tid]);
+		// p = d x e2
+		const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+		const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+		const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+		const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		const __m128 invDet = _mm_div_ps(one, det);
+		// s = o - v0
+		const __m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(&_v0x[tid]));
+		const __m128 sy = _mm_sub_ps(oy, _mm_loadu_ps(&_v0y[tid]));
+		const __m128 sz = _mm_sub_ps(oz, _mm_loadu_ps(&_v0z[tid]));
+		const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+		// q = s x e1
+		const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+		const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+		const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+		const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+		const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+		// Degenerate triangles (including padding) give a null determinant and are rejected. NaNs fail all comparisons.
+		__m128 valid = _mm_cmpgt_ps(_mm_andnot_ps(signMask, det), epsilon);
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+		valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(t, tmin));
+		valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(hit.dist)));
+		int mask = _mm_movemask_ps(valid);
+		if(mask == 0){
+			continue;
+		}
+		float ts[4], us[4], vs[4];
+		_mm_storeu_ps(ts, t);
+		_mm_storeu_ps(us, u);
+		_mm_storeu_ps(vs, v);
+		for(int lane = 0; lane < 4; ++lane){
+			if((mask & (1 << lane)) && ts[lane] < hit.dist){
+				hit.dist = ts[lane];
+				hit.u = us[lane];
+				hit.v = vs[lane];
+				bestId = tid + lane;
+				found = true;
+			}
+		}
+	}
+#else
+	for(uint32_t tid = node.first; tid < end; ++tid){
+		const glm::vec3 e1(_e1x[tid], _e1y[tid], _e1z[tid]);
+		const glm::vec3 e2(_e2x[tid], _e2y[tid], _e2z[tid]);
+		const glm::vec3 p = glm::cross(direction, e2);
+		const float det = glm::dot(e1, p);
+		if(std::abs(det) <= 1e-12f){
+			continue;
+		}
+		const float invDet = 1.0f / det;
+		const glm::vec3 s = origin - glm::vec3(_v0x[tid], _v0y[tid], _v0z[tid]);
+		const float u = glm::dot(s, p) * invDet;
+		if(u < 0.0f || u > 1.0f){
+			continue;
+		}
+		const glm::vec3 q = glm::cross(s, e1);
+		const float v = glm::dot(direction, q) * invDet;
+		if(v < 0.0f || u + v > 1.0f){
+			continue;
+		}
+		const float t = glm::dot(e2, q) * invDet;
+		if(t >= mini && t < hit.dist){
+			hit.dist = t;
+			hit.u = u;
+			hit.v = v;
+			bestId = tid;
+			found = true;
+		}
+	}
+#endif
+	if(found){
+		hit.hit = true;
+		fillHit(bestId, hit);
+	}
+	return found;
+}
+
+Raycaster::RayHit Raycaster::intersects(const glm::vec3 & origin, const glm::vec3 & direction, float mini, float maxi) const {
+	RayHit hit;
+	hit.dist = maxi;
+	if(_nodes.empty()){
+		return hit;
+	}
+	const RayBoxData ray(origin, direction);
+	// Stack of nodes to visit, with their entry distance.
+	std::pair<uint32_t, float> stack[RAYCASTER_STACK_SIZE];
+	int stackSize = 0;
+	float dist;
+	if(!intersectsBox(_nodes[0].minis, _nodes[0].maxis, ray, mini, maxi, dist)){
+		return hit;
+	}
+	stack[stackSize++] = std::make_pair(0u, dist);
+	
+	while(stackSize > 0){
+		const std::pair<uint32_t, float> current = stack[--stackSize];
+		// Skip nodes that are further than the closest hit found since they were pushed.
+		if(current.second > hit.dist){
+			continue;
+		}
+		const Node & node = _nodes[current.first];
+		if(node.count > 0){
+			intersectsLeaf(node, origin, direction, mini, hit);
+			continue;
+		}
+		const Node & left = _nodes[node.first];
+		const Node & right = _nodes[node.first + 1];
+		float distLeft, distRight;
+		const bool hitLeft = intersectsBox(left.minis, left.maxis, ray, mini, hit.dist, distLeft);
+		const bool hitRight = intersectsBox(right.minis, right.maxis, ray, mini, hit.dist, distRight);
+		// Visit the closest child first.
+		if(hitLeft && hitRight){
+			if(distLeft < distRight){
+				stack[stackSize++] = std::make_pair(node.first + 1, distRight);
+				stack[stackSize++] = std::make_pair(node.first, distLeft);
+			} else {
+				stack[stackSize++] = std::make_pair(node.first, distLeft);
+				stack[stackSize++] = std::make_pair(node.first + 1, distRight);
+			}
+		} else if(hitLeft){
+			stack[stackSize++] = std::make_pair(node.first, distLeft);
+		} else if(hitRight){
+			stack[stackSize++] = std::make_pair(node.first + 1, distRight);
+		}
+	}
+	return hit;
+}
+
+bool Raycaster::intersectsAny(const glm::vec3 & origin, const glm::vec3 & direction, float mini, float maxi) const {
+	if(_nodes.empty()){
+		return false;
+	}
+	const RayBoxData ray(origin, direction);
+	uint32_t stack[RAYCASTER_STACK_SIZE];
+	int stackSize = 0;
+	float dist;
+	if(!intersectsBox(_nodes[0].minis, _nodes[0].maxis, ray, mini, maxi, dist)){
+		return false;
+	}
+	stack[stackSize++] = 0;
+	RayHit hit;
+	hit.dist = maxi;
+	
+	while(stackSize > 0){
+		const Node & node = _nodes[stack[--stackSize]];
+		if(node.count > 0){
+			if(intersectsLeaf(node, origin, direction, mini, hit)){
+				return true;
+			}
+			continue;
+		}
+		const Node & left = _nodes[node.first];
+		const Node & right = _nodes[node.first + 1];
+		if(intersectsBox(left.minis, left.maxis, ray, mini, maxi, dist)){
+			stack[stackSize++] = node.first;
+		}
+		if(intersectsBox(right.minis, right.maxis, ray, mini, maxi, dist)){
+			stack[stackSize++] = node.first + 1;
+		}
+	}
+	return false;
+}
+
+/** Compute the point of a triangle closest to a given position (from Real-Time Collision Detection, C. Ericson).
+ \param p the query position
+ \param a the first vertex
+ \param ab the first edge
+ \param ac the second edge
+ \param u will contain the weight of the second vertex
+ \param v will contain the weight of the third vertex
+ \return the closest point
+ */
+glm::vec3 closestPointOnTriangle(const glm::vec3 & p, const glm::vec3 & a, const glm::vec3 & ab, const glm::vec3 & ac, float & u, float & v){
+	const glm::vec3 ap = p - a;
+	const float d1 = glm::dot(ab, ap);
+	const float d2 = glm::dot(ac, ap);
+	// Vertex A region.
+	if(d1 <= 0.0f && d2 <= 0.0f){
+		u = 0.0f; v = 0.0f;
+		return a;
+	}
+	const glm::vec3 bp = ap - ab;
+	const float d3 = glm::dot(ab, bp);
+	const float d4 = glm::dot(ac, bp);
+	// Vertex B region.
+	if(d3 >= 0.0f && d4 <= d3){
+		u = 1.0f; v = 0.0f;
+		return a + ab;
+	}
+	// Edge AB region.
+	const float vc = d1 * d4 - d3 * d2;
+	if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f){
+		u = d1 / (d1 - d3); v = 0.0f;
+		return a + u * ab;
+	}
+	const glm::vec3 cp = ap - ac;
+	const float d5 = glm::dot(ab, cp);
+	const float d6 = glm::dot(ac, cp);
+	// Vertex C region.
+	if(d6 >= 0.0f && d5 <= d6){
+		u = 0.0f; v = 1.0f;
+		return a + ac;
+	}
+	// Edge AC region.
+	const float vb = d5 * d2 - d1 * d6;
+	if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f){
+		u = 0.0f; v = d2 / (d2 - d6);
+		return a + v * ac;
+	}
+	// Edge BC region.
+	const float va = d3 * d6 - d5 * d4;
+	if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f){
+		const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		u = 1.0f - w; v = w;
+		return a + ab + w * (ac - ab);
+	}
+	// Face region.
+	const float denom = 1.0f / (va + vb + vc);
+	u = vb * denom;
+	v = vc * denom;
+	return a + u * ab + v * ac;
+}
+
+/** Compute the squared distance from a point to a box.
+ \param p the point
+ \param minis the lower corner of the box
+ \param maxis the upper corner of the box
+ \return the squared distance, 0 if the point is inside the box
+ */
+inline float distanceToBox2(const glm::vec3 & p, const glm::vec3 & minis, const glm::vec3 & maxis){
+	const glm::vec3 delta = glm::max(glm::max(minis - p, p - maxis), glm::vec3(0.0f));
+	return glm::dot(delta, delta);
+}
+
+Raycaster::PointHit Raycaster::closestPoint(const glm::vec3 & position, float maxi) const {
+	PointHit hit;
+	if(_nodes.empty()){
+		return hit;
+	}
+	float bestDist2 = maxi < std::sqrt(FLT_MAX) ? maxi * maxi : FLT_MAX;
+	uint32_t bestId = 0;
+	std::pair<uint32_t, float> stack[RAYCASTER_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = std::make_pair(0u, distanceToBox2(position, _nodes[0].minis, _nodes[0].maxis));
+	
+	while(stackSize > 0){
+		const std::pair<uint32_t, float> current = stack[--stackSize];
+		if(current.second > bestDist2){
+			continue;
+		}
+		const Node & node = _nodes[current.first];
+		if(node.count > 0){
+			for(uint32_t tid = node.first; tid < node.first + node.count; ++tid){
+				const glm::vec3 v0(_v0x[tid], _v0y[tid], _v0z[tid]);
+				const glm::vec3 e1(_e1x[tid], _e1y[tid], _e1z[tid]);
+				const glm::vec3 e2(_e2x[tid], _e2y[tid], _e2z[tid]);
+				float u, v;
+				const glm::vec3 point = closestPointOnTriangle(position, v0, e1, e2, u, v);
+				const float dist2 = glm::dot(point - position, point - position);
+				if(dist2 <= bestDist2){
+					bestDist2 = dist2;
+					bestId = tid;
+					hit.hit = true;
+					hit.position = point;
+					hit.u = u;
+					hit.v = v;
+				}
+			}
+			continue;
+		}
+		const float distLeft = distanceToBox2(position, _nodes[node.first].minis, _nodes[node.first].maxis);
+		const float distRight = distanceToBox2(position, _nodes[node.first + 1].minis, _nodes[node.first + 1].maxis);
+		// Visit the closest child first.
+		if(distLeft < distRight){
+			stack[stackSize++] = std::make_pair(node.first + 1, distRight);
+			stack[stackSize++] = std::make_pair(node.first, distLeft);
+		} else {
+			stack[stackSize++] = std::make_pair(node.first, distLeft);
+			stack[stackSize++] = std::make_pair(node.first + 1, distRight);
+		}
+	}
+	if(hit.hit){
+		hit.dist = std::sqrt(bestDist2);
+		fillHit(bestId, hit);
+	}
+	return hit;
+}
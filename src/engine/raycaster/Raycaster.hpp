@@ -0,0 +1,147 @@
+#ifndef Raycaster_h
+#define Raycaster_h
+
+#include "../resources/MeshUtilities.hpp"
+#include "../Common.hpp"
+#include <cstdint>
+#include <limits>
+
+/**
+ \brief Bounding volume hierarchy over the triangles of one or several meshes, for CPU ray and proximity queries.
+ \details The hierarchy is built with a binned surface area heuristic, level by level, on multiple threads. Nodes are 32 bytes, and the triangles of each leaf are stored as structure of arrays so that they can be tested four at a time.
+ \ingroup Raycaster
+ */
+class Raycaster {
+	
+public:
+	
+	/// \brief Result of a ray query.
+	struct RayHit {
+		bool hit = false; ///< Was an intersection found.
+		float dist = std::numeric_limits<float>::max(); ///< Distance along the ray, in units of the direction length.
+		float u = 0.0f; ///< First barycentric coordinate, weight of the second vertex.
+		float v = 0.0f; ///< Second barycentric coordinate, weight of the third vertex.
+		unsigned int meshId = 0; ///< Index of the mesh containing the hit triangle.
+		unsigned int localId = 0; ///< Index of the hit triangle in its mesh.
+		unsigned int v0 = 0; ///< Index of the first vertex of the triangle in its mesh.
+		unsigned int v1 = 0; ///< Index of the second vertex of the triangle in its mesh.
+		unsigned int v2 = 0; ///< Index of the third vertex of the triangle in its mesh.
+	};
+	
+	/// \brief Result of a nearest point query.
+	struct PointHit {
+		bool hit = false; ///< Was a triangle found in the query radius.
+		glm::vec3 position = glm::vec3(0.0f); ///< The nearest point on the surface.
+		float dist = std::numeric_limits<float>::max(); ///< Distance to the nearest point.
+		float u = 0.0f; ///< First barycentric coordinate of the nearest point, weight of the second vertex.
+		float v = 0.0f; ///< Second barycentric coordinate of the nearest point, weight of the third vertex.
+		unsigned int meshId = 0; ///< Index of the mesh containing the nearest triangle.
+		unsigned int localId = 0; ///< Index of the nearest triangle in its mesh.
+		unsigned int v0 = 0; ///< Index of the first vertex of the triangle in its mesh.
+		unsigned int v1 = 0; ///< Index of the second vertex of the triangle in its mesh.
+		unsigned int v2 = 0; ///< Index of the third vertex of the triangle in its mesh.
+	};
+	
+	/** Add the triangles of a mesh. The hierarchy has to be rebuilt afterwards.
+	 \param mesh the mesh to add, with indexed triangles
+	 \return the index of the mesh, reported in query results
+	 \note Only the faces of the most detailed level of the mesh are added.
+	 */
+	unsigned int addMesh(const Mesh & mesh);
+	
+	/** Build the hierarchy over all added meshes.
+	 \param threadCount the number of threads to use (0 to use all available hardware threads)
+	 \note The result doesn't depend on the number of threads.
+	 */
+	void updateHierarchy(unsigned int threadCount = 0);
+	
+	/** Find the closest intersection of a ray with the triangles.
+	 \param origin the ray origin
+	 \param direction the ray direction
+	 \param mini the minimal distance along the ray
+	 \param maxi the maximal distance along the ray
+	 \return the hit informations
+	 */
+	RayHit intersects(const glm::vec3 & origin, const glm::vec3 & direction, float mini = 0.0f, float maxi = std::numeric_limits<float>::max()) const;
+	
+	/** Test if a ray intersects any triangle, stopping at the first intersection found.
+	 \param origin the ray origin
+	 \param direction the ray direction
+	 \param mini the minimal distance along the ray
+	 \param maxi the maximal distance along the ray
+	 \return true if there is an intersection
+	 */
+	bool intersectsAny(const glm::vec3 & origin, const glm::vec3 & direction, float mini = 0.0f, float maxi = std::numeric_limits<float>::max()) const;
+	
+	/** Find the point of the triangles closest to a given position.
+	 \param position the query position
+	 \param maxi the maximal search distance
+	 \return the nearest point informations
+	 */
+	PointHit closestPoint(const glm::vec3 & position, float maxi = std::numeric_limits<float>::max()) const;
+	
+	/** Query the number of triangles in the hierarchy.
+	 \return the triangle count
+	 */
+	size_t triangleCount() const { return _sourceTriangles.size(); }
+	
+	/** Query the number of nodes in the hierarchy.
+	 \return the node count
+	 */
+	size_t nodeCount() const { return _nodes.size(); }
+	
+private:
+	
+	/// \brief Hierarchy node, 32 bytes.
+	struct Node {
+		glm::vec3 minis; ///< Lower corner of the node bounding box.
+		uint32_t first; ///< Index of the first child for an internal node (the second child follows it), or of the first triangle for a leaf.
+		glm::vec3 maxis; ///< Upper corner of the node bounding box.
+		uint32_t count; ///< Number of triangles for a leaf, 0 for an internal node.
+	};
+	
+	/// \brief Source triangle informations.
+	struct Triangle {
+		unsigned int v0; ///< Index of the first vertex in its mesh.
+		unsigned int v1; ///< Index of the second vertex in its mesh.
+		unsigned int v2; ///< Index of the third vertex in its mesh.
+		unsigned int localId; ///< Index of the triangle in its mesh.
+		unsigned int meshId; ///< Index of the mesh.
+	};
+	
+	/** Test a leaf of the hierarchy against a ray.
+	 \param node the leaf to test
+	 \param origin the ray origin
+	 \param direction the ray direction
+	 \param mini the minimal distance along the ray
+	 \param hit the closest hit so far, updated if a closer intersection is found
+	 \return true if an intersection closer than the current hit was found
+	 */
+	bool intersectsLeaf(const Node & node, const glm::vec3 & origin, const glm::vec3 & direction, const float mini, RayHit & hit) const;
+	
+	/** Fill the hit vertex informations from a triangle.
+	 \param triangleId the triangle index in the leaves storage
+	 \param hit the hit to update
+	 */
+	template<typename Hit>
+	void fillHit(const uint32_t triangleId, Hit & hit) const;
+	
+	std::vector<glm::vec3> _positions; ///< Positions of all meshes, used during construction.
+	std::vector<Triangle> _sourceTriangles; ///< All triangles added, used during construction.
+	std::vector<unsigned int> _vertexOffsets; ///< Index of the first vertex of each mesh in the positions list.
+	
+	std::vector<Node> _nodes; ///< The hierarchy nodes, the root is the first one.
+	std::vector<Triangle> _triangles; ///< Triangles informations, in leaves order (including padding).
+	std::vector<float> _v0x; ///< First vertex x coordinate, in leaves order.
+	std::vector<float> _v0y; ///< First vertex y coordinate, in leaves order.
+	std::vector<float> _v0z; ///< First vertex z coordinate, in leaves order.
+	std::vector<float> _e1x; ///< First edge x coordinate, in leaves order.
+	std::vector<float> _e1y; ///< First edge y coordinate, in leaves order.
+	std::vector<float> _e1z; ///< First edge z coordinate, in leaves order.
+	std::vector<float> _e2x; ///< Second edge x coordinate, in leaves order.
+	std::vector<float> _e2y; ///< Second edge y coordinate, in leaves order.
+	std::vector<float> _e2z; ///< Second edge z coordinate, in leaves order.
+
+};
+
+#endif
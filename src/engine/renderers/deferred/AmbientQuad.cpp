@@ -9,7 +9,7 @@ void AmbientQuad::init(const GLuint texAlbedo, const GLuint texNormals, const GL
 	
 	_program = Resources::manager().getProgram2D("ambient");
 	// Load texture.
-	_textureBrdf = Resources::manager().getTexture("brdf-precomputed", false).id;
+	_textureBrdf = Resources::manager().getTexture("brdf-precomputed", false);
 	
 	// Ambient pass: needs the albedo, the normals, the depth, the effects and the AO result
 	_textures = { texAlbedo, texNormals, texEffects, texDepth, texSSAO };
@@ -24,7 +24,7 @@ void AmbientQuad::init(const GLuint texAlbedo, const GLuint texNormals, const GL
 	checkGLError();
 }
 
-void AmbientQuad::setSceneParameters(const GLuint reflectionMap, const std::vector<glm::vec3> & irradiance){
+void AmbientQuad::setSceneParameters(const std::shared_ptr<TextureInfos> & reflectionMap, const std::vector<glm::vec3> & irradiance){
 	_textureEnv = reflectionMap;
 	_program->cacheUniformArray("shCoeffs", irradiance);
 }
@@ -81,9 +81,9 @@ void AmbientQuad::draw(const glm::mat4& viewMatrix, const glm::mat4& projectionM
 	glUniform4fv(_program->uniform("projectionMatrix"), 1, &(projectionVector[0]));
 	// Cubemaps.
 	glActiveTexture(GL_TEXTURE0 + (unsigned int)_textures.size());
-	glBindTexture(GL_TEXTURE_CUBE_MAP, _textureEnv);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, _textureEnv->id);
 	glActiveTexture(GL_TEXTURE0 + (unsigned int)_textures.size() + 1);
-	glBindTexture(GL_TEXTURE_2D, _textureBrdf);
+	glBindTexture(GL_TEXTURE_2D, _textureBrdf->id);
 	
 	ScreenQuad::draw(_textures);
 	checkGLError();
@@ -27,10 +27,10 @@ public:
 	void init(const GLuint texAlbedo, const GLuint texNormals, const GLuint texEffects, const GLuint texDepth, const GLuint texSSAO);
 	
 	/** Register the scene-specific lighting informations.
-	 \param reflectionMap the ID of the background cubemap, containing radiance convolved with increasing roughness lobes in the mipmap levels
+	 \param reflectionMap the background cubemap, containing radiance convolved with increasing roughness lobes in the mipmap levels
 	 \param irradiance the SH coefficients of the background irradiance
 	 */
-	void setSceneParameters(const GLuint reflectionMap, const std::vector<glm::vec3> & irradiance);
+	void setSceneParameters(const std::shared_ptr<TextureInfos> & reflectionMap, const std::vector<glm::vec3> & irradiance);
 	
 	/** Draw the ambient lighting contribution to the scene.
 	 \param viewMatrix the current camera view matrix
@@ -56,8 +56,8 @@ private:
 	std::shared_ptr<ProgramInfos> _programSSAO; ///< The SSAO program.
 
 	std::vector<GLuint> _textures; ///< The input textures for the ambient pass.
-	GLuint _textureEnv; ///< The environment radiance cubemap.
-	GLuint _textureBrdf; ///< The linearized approximate BRDF components. \see BRDFEstimator
+	std::shared_ptr<TextureInfos> _textureEnv; ///< The environment radiance cubemap, possibly still loading.
+	std::shared_ptr<TextureInfos> _textureBrdf; ///< The linearized approximate BRDF components. \see BRDFEstimator
 	std::vector<GLuint> _texturesSSAO; ///< The input textures required for SSAO.
 	std::vector<glm::vec3> _samples; ///< The noise samples for SSAO.
 	
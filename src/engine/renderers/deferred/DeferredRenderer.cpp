@@ -62,11 +62,23 @@ DeferredRenderer::DeferredRenderer(RenderingConfig & config) : Renderer(config)
 }
 
 void DeferredRenderer::setScene(std::shared_ptr<Scene> scene){
+	// Release the resources of the previous scene, they stay cached until evicted.
+	if(_scene && _scene != scene){
+		_scene->clean();
+	}
 	_scene = scene;
 	if(!scene){
 		return;
 	}
+	// Prefetch the assets loaded by the scene during the previous run, and record the current ones.
+	const bool recordAssets = !_scene->name().empty();
+	if(recordAssets){
+		Resources::manager().beginManifest(_scene->name());
+	}
 	_scene->init();
+	if(recordAssets){
+		Resources::manager().endManifest();
+	}
 	
 	_ambientScreen.setSceneParameters(_scene->backgroundReflection, _scene->backgroundIrradiance);
 	
@@ -27,6 +27,21 @@ void RendererCube::draw() {
 }
 
 void RendererCube::drawCube(const unsigned int localWidth, const unsigned int localHeight, const std::string & localOutputPath) {
+	drawFaces(localWidth, localHeight, [this, localWidth, localHeight, &localOutputPath](size_t, const std::string & suffix){
+		const std::string outputPathComplete = localOutputPath + "-" + suffix;
+		GLUtilities::saveFramebuffer(_resultFramebuffer, localWidth, localHeight, outputPathComplete, false);
+	});
+}
+
+void RendererCube::drawCube(const unsigned int localWidth, const unsigned int localHeight, std::vector<DecodedImage> & faces) {
+	faces.resize(6);
+	// Faces are read back bottom row first, as they would be loaded from the images saved above.
+	drawFaces(localWidth, localHeight, [this, localWidth, localHeight, &faces](size_t face, const std::string &){
+		GLUtilities::readFramebuffer(_resultFramebuffer, localWidth, localHeight, faces[face]);
+	});
+}
+
+void RendererCube::drawFaces(const unsigned int localWidth, const unsigned int localHeight, const std::function<void(size_t, const std::string &)> & output) {
 	glDisable(GL_DEPTH_TEST);
 	
 	_resultFramebuffer->bind();
@@ -37,6 +52,7 @@ void RendererCube::drawCube(const unsigned int localWidth, const unsigned int lo
 	const glm::vec3 ups[6] = { glm::vec3(0.0,-1.0,0.0), glm::vec3(0.0,-1.0,0.0),glm::vec3(0.0,-1.0,0.0), glm::vec3(0.0,-1.0,0.0), glm::vec3(0.0,0.0,1.0), glm::vec3(0.0,0.0,-1.0) };
 	const glm::vec3 centers[6] = { glm::vec3(1.0,0.0,0.0), glm::vec3(-1.0,0.0,0.0), glm::vec3(0.0,0.0,1.0), glm::vec3(0.0,0.0,-1.0), glm::vec3(0.0,1.0,0.0), glm::vec3(0.0,-1.0,0.0) };
 	const std::string suffixes[6] = { "px", "nx", "pz", "nz", "py", "ny"};
+	const size_t faceIds[6] = { 0, 1, 4, 5, 2, 3 };
 
 	// Loop over the faces. Instead we could use a geometry shader and multiple output layers, one for each face with the corresponding view transformation.
 	
@@ -50,8 +66,7 @@ void RendererCube::drawCube(const unsigned int localWidth, const unsigned int lo
 		glFlush();
 		glFinish();
 		
-		const std::string outputPathComplete = localOutputPath + "-" + suffixes[i];
-		GLUtilities::saveFramebuffer(_resultFramebuffer, localWidth, localHeight, outputPathComplete, false);
+		output(faceIds[i], suffixes[i]);
 		
 	}
 	
@@ -73,8 +88,7 @@ void RendererCube::physics(double fullTime, double frameTime){
 
 void RendererCube::clean() const {
 	Renderer::clean();
-	// Clean objects.
-	_cubemap.clean();
+	// The cubemap object resources are released with the object.
 	_resultFramebuffer->clean();
 	
 }
@@ -6,6 +6,8 @@
 #include "../../Object.hpp"
 #include "../Renderer.hpp"
 
+#include <functional>
+
 /**
  \brief Renders each face of a cubemap with a given shader, for preprocessing.
  \ingroup Renderers
@@ -34,6 +36,13 @@ public:
 	 */
 	void drawCube(const unsigned int localWidth, const unsigned int localHeight, const std::string & localOutputPath);
 	
+	/** Render and process each face of the cubemap, and read them back.
+	 \param localWidth the width of the output images
+	 \param localHeight the height of the output images
+	 \param faces will contain the six faces, in the order expected by OpenGL (px, nx, py, ny, pz, nz)
+	 */
+	void drawCube(const unsigned int localWidth, const unsigned int localHeight, std::vector<DecodedImage> & faces);
+	
 	/** Perform once-per-frame update (buttons, GUI,...) */
 	void update();
 	
@@ -56,6 +65,13 @@ public:
 	
 private:
 	
+	/** Render and process each face of the cubemap.
+	 \param localWidth the width of the output image
+	 \param localHeight the height of the output image
+	 \param output called once each face has been rendered in the internal framebuffer, with the face index in the (px, nx, py, ny, pz, nz) order and the face suffix
+	 */
+	void drawFaces(const unsigned int localWidth, const unsigned int localHeight, const std::function<void(size_t, const std::string &)> & output);
+	
 	std::shared_ptr<Framebuffer> _resultFramebuffer; ///< The internal render framebuffer.
 	std::shared_ptr<ProgramInfos> _program; ///< The rendering program to use for each face.
 	Object _cubemap; ///< The cubemap object to render for processing.
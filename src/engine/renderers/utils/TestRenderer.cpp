@@ -29,7 +29,7 @@ void TestRenderer::draw() {
 	glDisable(GL_DEPTH_TEST);
 	_framebuffer->setViewport();
 	glUseProgram(_program->id());
-	ScreenQuad::draw(Resources::manager().getTexture("desk_albedo").id);
+	ScreenQuad::draw(Resources::manager().getTexture("desk_albedo")->id);
 	_framebuffer->unbind();
 	
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -0,0 +1,259 @@
+#include "ArtifactCache.hpp"
+#include "ResourcesManager.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+std::string ArtifactCache::directory = "";
+
+uint64_t ArtifactCache::budget = 1024ull * 1024ull * 1024ull;
+
+/// \brief Header of an artifact file.
+struct ArtifactHeader {
+	char magic[4]; ///< Should be "ARTF".
+	uint32_t version; ///< The format version.
+	uint64_t size; ///< Size of the content in bytes.
+	char checksum[32]; ///< Key of the content, to detect corrupted artifacts.
+};
+
+/// Size of the cache directory measured by the last trim, plus the artifacts stored since then by this process.
+std::atomic<uint64_t> artifactTrackedSize(0);
+
+/// Has the cache directory been scanned by this process.
+std::atomic<bool> artifactScanned(false);
+
+/** Rotate the bits of a 64-bits word.
+ \param x the word
+ \param r the number of bits to rotate by
+ \return the rotated word
+ */
+inline uint64_t rotateLeft(const uint64_t x, const int r){
+	return (x << r) | (x >> (64 - r));
+}
+
+/** Scramble the bits of a 64-bits word, so that each input bit affects all output bits.
+ \param h the word
+ \return the scrambled word
+ */
+inline uint64_t avalanche(uint64_t h){
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+const uint64_t artifactPrime1 = 0x9E3779B185EBCA87ull;
+const uint64_t artifactPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+ArtifactCache::Key::Key(const std::string & tool, const uint32_t version){
+	_hashes[0] = 0x243F6A8885A308D3ull;
+	_hashes[1] = 0x13198A2E03707344ull;
+	add(tool);
+	add(uint64_t(version));
+}
+
+ArtifactCache::Key & ArtifactCache::Key::add(const char * data, const size_t size){
+	// Process 8 bytes at a time, the last partial word is padded with zeros.
+	for(size_t offset = 0; offset < size; offset += 8){
+		uint64_t word = 0;
+		std::memcpy(&word, data + offset, (std::min)(size_t(8), size - offset));
+		_hashes[0] = rotateLeft(_hashes[0] ^ (word * artifactPrime2), 31) * artifactPrime1;
+		_hashes[1] = rotateLeft(_hashes[1] + (word * artifactPrime1), 29) * artifactPrime2 + _hashes[0];
+	}
+	// Hash the size too, so that consecutive inputs can't be confused.
+	_hashes[0] = rotateLeft(_hashes[0] ^ (uint64_t(size) * artifactPrime2), 31) * artifactPrime1;
+	_hashes[1] = rotateLeft(_hashes[1] + (uint64_t(size) * artifactPrime1), 29) * artifactPrime2 + _hashes[0];
+	_size += size;
+	return *this;
+}
+
+ArtifactCache::Key & ArtifactCache::Key::add(const std::string & str){
+	return add(str.c_str(), str.size());
+}
+
+ArtifactCache::Key & ArtifactCache::Key::add(const uint64_t value){
+	char bytes[8];
+	for(int i = 0; i < 8; ++i){
+		bytes[i] = char((value >> (8 * i)) & 0xFF);
+	}
+	return add(bytes, 8);
+}
+
+std::string ArtifactCache::Key::str() const {
+	std::stringstream res;
+	res << std::hex << std::setfill('0') << std::setw(16) << avalanche(_hashes[0] ^ _size) << std::setw(16) << avalanche(_hashes[1] + _size);
+	return res.str();
+}
+
+/** Create a directory and its parents if they don't exist.
+ \param path the directory path
+ */
+void createDirectories(const std::string & path){
+	for(size_t pos = path.find_first_of("/\\", 1); ; pos = path.find_first_of("/\\", pos + 1)){
+		const std::string subPath = path.substr(0, pos);
+#ifdef _WIN32
+		_mkdir(subPath.c_str());
+#else
+		mkdir(subPath.c_str(), 0755);
+#endif
+		if(pos == std::string::npos){
+			break;
+		}
+	}
+}
+
+bool ArtifactCache::fetch(const Key & key, std::vector<char> & data){
+	if(!enabled()){
+		return false;
+	}
+	const std::string path = directory + "/" + key.str() + ".artifact";
+	std::ifstream file(path, std::ios::binary);
+	if(!file.is_open()){
+		return false;
+	}
+	ArtifactHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(ArtifactHeader));
+	if(!file || std::strncmp(header.magic, "ARTF", 4) != 0 || header.version != 1){
+		return false;
+	}
+	// Reject truncated artifacts or corrupted sizes before allocating.
+	const std::streamoff contentStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	const std::streamoff contentSize = file.tellg() - contentStart;
+	file.seekg(contentStart);
+	if(!file || contentSize < 0 || uint64_t(contentSize) != header.size){
+		Log::Warning() << Log::Resources << "Corrupted artifact at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	data.resize(size_t(header.size));
+	file.read(data.data(), std::streamsize(header.size));
+	if(!file){
+		data.clear();
+		return false;
+	}
+	file.close();
+	// Check the content integrity.
+	const std::string checksum = Key("content", 1).add(data.data(), data.size()).str();
+	if(checksum.compare(0, 32, header.checksum, 32) != 0){
+		Log::Warning() << Log::Resources << "Corrupted artifact at path \"" << path << "\"." << std::endl;
+		data.clear();
+		return false;
+	}
+	// Mark the artifact as recently used.
+#ifdef _WIN32
+	_utime(path.c_str(), NULL);
+#else
+	utime(path.c_str(), NULL);
+#endif
+	return true;
+}
+
+bool ArtifactCache::store(const Key & key, const char * data, const size_t size){
+	if(!enabled()){
+		return false;
+	}
+	createDirectories(directory);
+	const std::string path = directory + "/" + key.str() + ".artifact";
+	// Write to a temporary file unique to this process and thread, then move it in place.
+	static std::atomic<uint64_t> counter(0);
+#ifdef _WIN32
+	const int pid = _getpid();
+#else
+	const int pid = int(getpid());
+#endif
+	const std::string tempPath = path + "." + std::to_string(pid) + "-" + std::to_string(counter++) + ".tmp";
+	
+	ArtifactHeader header;
+	std::memcpy(header.magic, "ARTF", 4);
+	header.version = 1;
+	header.size = uint64_t(size);
+	const std::string checksum = Key("content", 1).add(data, size).str();
+	std::memcpy(header.checksum, checksum.c_str(), 32);
+	
+	std::ofstream file(tempPath, std::ios::binary);
+	if(!file.is_open()){
+		Log::Error() << Log::Resources << "Unable to write artifact at path \"" << tempPath << "\"." << std::endl;
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(ArtifactHeader));
+	file.write(data, std::streamsize(size));
+	file.close();
+	if(!file){
+		std::remove(tempPath.c_str());
+		return false;
+	}
+#ifdef _WIN32
+	const bool moved = MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	const bool moved = std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+	if(!moved){
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	// Only rescan the directory once per process, or when the tracked size exceeds the budget.
+	artifactTrackedSize += uint64_t(sizeof(ArtifactHeader)) + uint64_t(size);
+	if(!artifactScanned || artifactTrackedSize > budget){
+		trim();
+	}
+	return true;
+}
+
+void ArtifactCache::trim(){
+	struct stat infos;
+	if(!enabled() || stat(directory.c_str(), &infos) != 0){
+		return;
+	}
+	std::vector<std::string> names;
+	Resources::getExternalFiles(directory, names);
+	// Collect the artifacts with their last use time.
+	std::vector<std::pair<uint64_t, std::string>> artifacts;
+	uint64_t totalSize = 0;
+	const std::string extension = ".artifact";
+	for(const std::string & name : names){
+		if(name.size() < extension.size() || name.compare(name.size() - extension.size(), extension.size(), extension) != 0){
+			continue;
+		}
+		const std::string path = directory + "/" + name;
+		uint64_t size = 0;
+		uint64_t time = 0;
+		if(Resources::getExternalFileInfos(path, size, time)){
+			artifacts.emplace_back(time, path);
+			totalSize += size;
+		}
+	}
+	artifactScanned = true;
+	if(totalSize <= budget){
+		artifactTrackedSize = totalSize;
+		return;
+	}
+	// Remove the least recently used first. Another process might have removed some already.
+	std::sort(artifacts.begin(), artifacts.end());
+	for(const auto & artifact : artifacts){
+		if(totalSize <= budget){
+			break;
+		}
+		uint64_t size = 0;
+		uint64_t time = 0;
+		if(Resources::getExternalFileInfos(artifact.second, size, time) && std::remove(artifact.second.c_str()) == 0){
+			totalSize -= (std::min)(size, totalSize);
+		}
+	}
+	artifactTrackedSize = totalSize;
+}
@@ -0,0 +1,92 @@
+#ifndef ArtifactCache_h
+#define ArtifactCache_h
+
+#include "../Common.hpp"
+#include <cstdint>
+
+/**
+ \brief On-disk cache of derived artifacts (preprocessed meshes, filtered images, SH coefficients,...), identified by a hash of their source data, processing parameters and tool version.
+ \details Artifacts are written to a temporary file then renamed in place, so that multiple processes can share the same cache directory: readers either see a complete artifact or none. Each artifact stores a checksum of its content, verified when fetching. When the cache grows over its budget, the least recently used artifacts are removed. The cache is disabled while its directory is empty.
+ \ingroup Resources
+ */
+class ArtifactCache {
+
+public:
+
+	/**
+	 \brief Identify an artifact by hashing everything it is generated from. Keys are 128-bits hashes.
+	 */
+	class Key {
+	public:
+	
+		/** Constructor.
+		 \param tool name of the processing step generating the artifact
+		 \param version version of the processing step, to increment when its output changes
+		 */
+		Key(const std::string & tool, const uint32_t version);
+		
+		/** Hash source data.
+		 \param data the data
+		 \param size the size of the data in bytes
+		 \return the key itself
+		 */
+		Key & add(const char * data, const size_t size);
+		
+		/** Hash a string parameter.
+		 \param str the string
+		 \return the key itself
+		 */
+		Key & add(const std::string & str);
+		
+		/** Hash an integer parameter.
+		 \param value the value
+		 \return the key itself
+		 */
+		Key & add(const uint64_t value);
+		
+		/** Query the hexadecimal representation of the key, used as the artifact file name.
+		 \return the key string
+		 */
+		std::string str() const;
+	
+	private:
+	
+		uint64_t _hashes[2]; ///< The two halves of the hash.
+		uint64_t _size = 0; ///< Number of hashed bytes.
+	};
+	
+	/** Fetch an artifact from the cache.
+	 \param key the artifact key
+	 \param data will contain the artifact content
+	 \return true if the artifact was found and valid
+	 */
+	static bool fetch(const Key & key, std::vector<char> & data);
+	
+	/** Store an artifact in the cache, replacing any previous version. Least recently used artifacts are evicted if the cache is over budget, the directory being scanned on the first store of the process and then only when the size of the stored artifacts exceeds the budget.
+	 \param key the artifact key
+	 \param data the artifact content
+	 \param size the size of the content in bytes
+	 \return true if the artifact was stored
+	 */
+	static bool store(const Key & key, const char * data, const size_t size);
+	
+	/** Remove the least recently used artifacts until the cache size is below the budget.
+	 */
+	static void trim();
+	
+	/** Query if the cache is enabled.
+	 \return true if a cache directory is set
+	 */
+	static bool enabled(){ return !directory.empty(); }
+	
+	/** Cache directory on disk, shared by all processes. The cache is disabled if empty.
+	 */
+	static std::string directory;
+	
+	/** Maximum size of all artifacts in the cache, in bytes.
+	 */
+	static uint64_t budget;
+
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "FileWatcher.hpp"
+#include "ResourcesManager.hpp"
+#include <set>
+
+#ifdef __linux__
+#include <tinydir/tinydir.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+double FileWatcher::pollingInterval = 1.0;
+
+FileWatcher::FileWatcher() : _lastPoll(std::chrono::steady_clock::now()) {
+#ifdef __linux__
+	_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(_inotify < 0){
+		Log::Warning() << Log::Resources << "Unable to initialize inotify, files will be polled." << std::endl;
+	}
+#endif
+}
+
+void FileWatcher::watch(const std::string & directoryPath){
+	_directories.push_back(directoryPath);
+#ifdef __linux__
+	if(_inotify >= 0){
+		watchDirectory(directoryPath);
+		return;
+	}
+#endif
+	// Register the initial state of the files.
+	std::vector<std::string> files;
+	pollDirectory(directoryPath, files);
+}
+
+void FileWatcher::changes(std::vector<std::string> & files){
+	files.clear();
+#ifdef __linux__
+	if(_inotify >= 0){
+		// Read all pending events, the descriptor is non-blocking.
+		std::set<std::string> names;
+		char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)] __attribute__ ((aligned(__alignof__(inotify_event))));
+		ssize_t length = read(_inotify, buffer, sizeof(buffer));
+		while(length > 0){
+			for(ssize_t offset = 0; offset < length;){
+				const inotify_event * event = reinterpret_cast<const inotify_event *>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+				if(event->len == 0){
+					continue;
+				}
+				const std::string name(event->name);
+				if(event->mask & IN_ISDIR){
+					// Watch new subdirectories.
+					if(_watches.count(event->wd) > 0 && name.at(0) != '.'){
+						watchDirectory(_watches[event->wd] + "/" + name);
+					}
+				} else if((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && name.at(0) != '.'){
+					// Files are only reported once completely written.
+					names.insert(name);
+				}
+			}
+			length = read(_inotify, buffer, sizeof(buffer));
+		}
+		files.assign(names.begin(), names.end());
+		return;
+	}
+#endif
+	// Poll the files at a limited rate.
+	const auto now = std::chrono::steady_clock::now();
+	if(std::chrono::duration<double>(now - _lastPoll).count() < FileWatcher::pollingInterval){
+		return;
+	}
+	_lastPoll = now;
+	for(const std::string & directory : _directories){
+		pollDirectory(directory, files);
+	}
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+}
+
+void FileWatcher::pollDirectory(const std::string & directoryPath, std::vector<std::string> & files){
+	std::vector<std::string> paths;
+	Resources::getExternalFiles(directoryPath, paths);
+	for(const std::string & path : paths){
+		const std::string fullPath = directoryPath + "/" + path;
+		uint64_t size = 0;
+		uint64_t time = 0;
+		if(!Resources::getExternalFileInfos(fullPath, size, time)){
+			continue;
+		}
+		const auto state = _states.find(fullPath);
+		if(state == _states.end() || state->second.first != size || state->second.second != time){
+			_states[fullPath] = std::make_pair(size, time);
+			files.push_back(path.substr(path.find_last_of("/\\") + 1));
+		}
+	}
+}
+
+#ifdef __linux__
+void FileWatcher::watchDirectory(const std::string & directoryPath){
+	const int watch = inotify_add_watch(_inotify, directoryPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if(watch < 0){
+		Log::Error() << Log::Resources << "Unable to watch directory at path \"" << directoryPath << "\"." << std::endl;
+		return;
+	}
+	_watches[watch] = directoryPath;
+	// inotify is not recursive, watch each subdirectory.
+	tinydir_dir dir;
+	if(tinydir_open(&dir, directoryPath.c_str()) == -1){
+		tinydir_close(&dir);
+		return;
+	}
+	while (dir.has_next) {
+		tinydir_file file;
+		if(tinydir_readfile(&dir, &file) != -1 && file.is_dir){
+			const std::string name(file.name);
+			if(name.size() > 0 && name.at(0) != '.'){
+				watchDirectory(directoryPath + "/" + name);
+			}
+		}
+		if (tinydir_next(&dir) == -1){
+			break;
+		}
+	}
+	tinydir_close(&dir);
+}
+#endif
+
+FileWatcher::~FileWatcher(){
+#ifdef __linux__
+	if(_inotify >= 0){
+		close(_inotify);
+	}
+#endif
+}
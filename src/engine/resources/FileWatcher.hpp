@@ -0,0 +1,66 @@
+#ifndef FileWatcher_h
+#define FileWatcher_h
+
+#include "../Common.hpp"
+#include <chrono>
+#include <map>
+
+/**
+ \brief Watch directories on disk (and their subdirectories) for modified files.
+ \details On Linux, inotify is used to be notified of closed written files and files moved in place (as most editors save by renaming a temporary file). Elsewhere, or if inotify is unavailable, the size and modification time of all files are polled at a fixed interval.
+ \ingroup Resources
+ */
+class FileWatcher {
+
+public:
+
+	/** Constructor. */
+	FileWatcher();
+	
+	/** Start watching a directory and its subdirectories.
+	 \param directoryPath the path to the directory on disk
+	 */
+	void watch(const std::string & directoryPath);
+	
+	/** Query the files modified since the last call. This doesn't block.
+	 \param files will contain the name (with extension) of each modified file, without duplicates
+	 */
+	void changes(std::vector<std::string> & files);
+	
+	/** Destructor. Stop watching. */
+	~FileWatcher();
+	
+	/** Assignment operator (disabled). */
+	FileWatcher& operator= (const FileWatcher&) = delete;
+	
+	/** Copy constructor (disabled). */
+	FileWatcher (const FileWatcher&) = delete;
+	
+	/** Minimal delay between two polls of the watched directories, in seconds, when inotify is unavailable. */
+	static double pollingInterval;
+
+private:
+
+	/** Register the current size and modification time of all files in a directory, for polling.
+	 \param directoryPath the path to the directory on disk
+	 \param files will contain the files that are new or modified since the last registration
+	 */
+	void pollDirectory(const std::string & directoryPath, std::vector<std::string> & files);
+
+#ifdef __linux__
+	/** Add an inotify watch on a directory and all its subdirectories.
+	 \param directoryPath the path to the directory on disk
+	 */
+	void watchDirectory(const std::string & directoryPath);
+	
+	int _inotify; ///< The inotify instance, or -1 when polling.
+	std::map<int, std::string> _watches; ///< The path of each watched directory, identified by watch descriptor.
+#endif
+
+	std::vector<std::string> _directories; ///< The watched root directories.
+	std::map<std::string, std::pair<uint64_t, uint64_t>> _states; ///< Size and modification time of each polled file, identified by path.
+	std::chrono::steady_clock::time_point _lastPoll; ///< Time of the last poll.
+
+};
+
+#endif
@@ -1,5 +1,16 @@
 #include "ImageUtilities.hpp"
 #include "ResourcesManager.hpp"
+#include "../helpers/ThreadUtilities.hpp"
+#include "../helpers/HalfFloat.hpp"
+#include "../helpers/Telemetry.hpp"
+#include <cstring>
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+/// SSE instructions are available.
+#define IMAGE_UTILITIES_SSE
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
@@ -17,6 +28,241 @@
 #define TINYEXR_IMPLEMENTATION
 #include <tinyexr/tinyexr.h>
 
+/// \brief Layout of the RGB channels in an EXR file, and of the blocks storing them.
+struct EXRSource {
+	std::vector<EXRChannelInfo> infos; ///< All channels of the file.
+	int channels[3] = { -1, -1, -1 }; ///< Index of the R,G,B channels.
+	int types[3] = { 0, 0, 0 }; ///< Pixel type of the R,G,B channels.
+	size_t offsets[3] = { 0, 0, 0 }; ///< Offset of the R,G,B channels in a pixel, in bytes.
+	size_t pixelSize = 0; ///< Size of a pixel with all channels, in bytes.
+	int compression = 0; ///< Compression type.
+	int width = 0; ///< Image width.
+	int height = 0; ///< Image height.
+	int minY = 0; ///< First line of the data window.
+	int linesPerBlock = 1; ///< Number of lines in a scanline block.
+	int tileWidth = 0; ///< Tile width, 0 for scanline images.
+	int tileHeight = 0; ///< Tile height, 0 for scanline images.
+	bool half = false; ///< Should the RGB channels be kept as half floats.
+};
+
+/** Query the number of lines stored in each block of a scanline EXR file.
+ \param compression the compression type
+ \return the number of lines per block
+ */
+int exrLinesPerBlock(const int compression){
+	if(compression == TINYEXR_COMPRESSIONTYPE_ZIP || compression == TINYEXR_COMPRESSIONTYPE_ZFP){
+		return 16;
+	}
+	if(compression == TINYEXR_COMPRESSIONTYPE_PIZ){
+		return 32;
+	}
+	return 1;
+}
+
+/** Convert a line of EXR samples to floats.
+ \param src the samples, can be unaligned
+ \param type the sample type
+ \param count the number of samples
+ \param dst the destination floats
+ */
+void convertEXRLine(const unsigned char * src, const int type, const size_t count, float * dst){
+	if(type == TINYEXR_PIXELTYPE_FLOAT){
+		std::memcpy(dst, src, count * sizeof(float));
+		return;
+	}
+	if(type == TINYEXR_PIXELTYPE_UINT){
+		for(size_t x = 0; x < count; ++x){
+			unsigned int value;
+			std::memcpy(&value, src + 4 * x, 4);
+			dst[x] = float(value);
+		}
+		return;
+	}
+	HalfFloat::toFloats(reinterpret_cast<const uint16_t*>(src), count, dst);
+}
+
+/** Interleave three lines of floats in a RGB line.
+ \param r the red line
+ \param g the green line
+ \param b the blue line
+ \param count the number of pixels
+ \param dst the destination RGB line
+ */
+void interleaveRGBLine(const float * r, const float * g, const float * b, const size_t count, float * dst){
+	size_t x = 0;
+#ifdef IMAGE_UTILITIES_SSE
+	for(; x + 4 <= count; x += 4){
+		const __m128 rs = _mm_loadu_ps(r + x);
+		const __m128 gs = _mm_loadu_ps(g + x);
+		const __m128 bs = _mm_loadu_ps(b + x);
+		// r0 g0 r1 g1, r2 g2 r3 g3, g0 b0 g1 b1, g2 b2 g3 b3, b0 r0 b1 r1, b2 r2 b3 r3
+		const __m128 rgLow = _mm_unpacklo_ps(rs, gs);
+		const __m128 rgHigh = _mm_unpackhi_ps(rs, gs);
+		const __m128 gbLow = _mm_unpacklo_ps(gs, bs);
+		const __m128 gbHigh = _mm_unpackhi_ps(gs, bs);
+		const __m128 brLow = _mm_unpacklo_ps(bs, rs);
+		const __m128 brHigh = _mm_unpackhi_ps(bs, rs);
+		float * out = dst + 3 * x;
+		_mm_storeu_ps(out, _mm_shuffle_ps(rgLow, brLow, _MM_SHUFFLE(3, 0, 1, 0)));
+		_mm_storeu_ps(out + 4, _mm_shuffle_ps(gbLow, rgHigh, _MM_SHUFFLE(1, 0, 3, 2)));
+		_mm_storeu_ps(out + 8, _mm_shuffle_ps(brHigh, gbHigh, _MM_SHUFFLE(3, 2, 3, 0)));
+	}
+#endif
+	for(; x < count; ++x){
+		dst[3 * x + 0] = r[x];
+		dst[3 * x + 1] = g[x];
+		dst[3 * x + 2] = b[x];
+	}
+}
+
+/** Interleave three lines of half floats in a RGB line.
+ \param r the red line, can be unaligned
+ \param g the green line, can be unaligned
+ \param b the blue line, can be unaligned
+ \param count the number of pixels
+ \param dst the destination RGB line
+ */
+void interleaveRGBHalfLine(const unsigned char * r, const unsigned char * g, const unsigned char * b, const size_t count, uint16_t * dst){
+	for(size_t x = 0; x < count; ++x){
+		std::memcpy(dst + 3 * x + 0, r + 2 * x, 2);
+		std::memcpy(dst + 3 * x + 1, g + 2 * x, 2);
+		std::memcpy(dst + 3 * x + 2, b + 2 * x, 2);
+	}
+}
+
+/** Decompress a RLE block of an EXR file, checking that the compressed data fills exactly the block.
+ \param src the compressed data
+ \param srcSize the size of the compressed data
+ \param dst the destination buffer
+ \param dstSize the size of the decompressed block
+ \return true if the data was valid
+ \note Equivalent to tinyexr::DecompressRle, which doesn't report errors.
+ */
+bool decompressEXRRle(const unsigned char * src, const size_t srcSize, unsigned char * dst, const size_t dstSize){
+	thread_local std::vector<unsigned char> buffer;
+	buffer.resize(dstSize);
+	// Runs: a negative count is followed by as many literal bytes, a positive count by a byte repeated count+1 times.
+	size_t in = 0;
+	size_t out = 0;
+	while(in < srcSize){
+		const int count = int(static_cast<signed char>(src[in++]));
+		if(count < 0){
+			const size_t length = size_t(-count);
+			if(in + length > srcSize || out + length > dstSize){
+				return false;
+			}
+			std::memcpy(&buffer[out], src + in, length);
+			in += length;
+			out += length;
+		} else {
+			const size_t length = size_t(count) + 1;
+			if(in >= srcSize || out + length > dstSize){
+				return false;
+			}
+			std::memset(&buffer[out], src[in++], length);
+			out += length;
+		}
+	}
+	if(out != dstSize){
+		return false;
+	}
+	// Undo the predictor.
+	for(size_t i = 1; i < dstSize; ++i){
+		buffer[i] = static_cast<unsigned char>(int(buffer[i - 1]) + int(buffer[i]) - 128);
+	}
+	// Interleave the two halves of the block.
+	const size_t half = (dstSize + 1) / 2;
+	for(size_t i = 0; i < dstSize; ++i){
+		dst[i] = buffer[(i % 2 == 0) ? (i / 2) : (half + i / 2)];
+	}
+	return true;
+}
+
+/** Decode a scanline block or a tile of an EXR file, writing its RGB lines directly in the destination image.
+ \param source the file layout
+ \param block the block data, starting with its header
+ \param size the size of the data available after the block start
+ \param image the destination RGB image, floats or half floats
+ \param flip should the image be vertically flipped
+ \param scratch buffer for the decompressed block, reused between blocks
+ \param lines buffer for the converted channel lines, reused between blocks
+ \return true if the block was valid
+ */
+bool decodeEXRBlock(const EXRSource & source, const unsigned char * block, const size_t size, void * image, const bool flip, std::vector<unsigned char> & scratch, std::vector<float> & lines){
+	// Block header: line index or tile coordinates, then the data size.
+	const size_t headerSize = source.tileWidth > 0 ? 20 : 8;
+	if(size < headerSize){
+		return false;
+	}
+	int header[5];
+	std::memcpy(header, block, headerSize);
+	int firstX = 0;
+	int firstY = 0;
+	int lineWidth = source.width;
+	int lineCount = 0;
+	if(source.tileWidth > 0){
+		// Only the first level of mipmapped files is loaded.
+		if(header[2] != 0 || header[3] != 0){
+			return false;
+		}
+		firstX = header[0] * source.tileWidth;
+		firstY = header[1] * source.tileHeight;
+		lineWidth = (std::min)(source.tileWidth, source.width - firstX);
+		lineCount = (std::min)(source.tileHeight, source.height - firstY);
+	} else {
+		firstY = header[0] - source.minY;
+		lineCount = (std::min)(source.linesPerBlock, source.height - firstY);
+	}
+	const int dataSize = header[headerSize / 4 - 1];
+	if(firstX < 0 || firstY < 0 || lineWidth <= 0 || lineCount <= 0 || dataSize < 0 || size_t(dataSize) > size - headerSize){
+		return false;
+	}
+	const unsigned char * data = block + headerSize;
+	
+	// Decompress the whole block, uncompressed blocks are read in place.
+	const size_t lineSize = size_t(lineWidth) * source.pixelSize;
+	const size_t blockSize = lineSize * size_t(lineCount);
+	const unsigned char * samples = data;
+	if(size_t(dataSize) != blockSize){
+		if(source.compression == TINYEXR_COMPRESSIONTYPE_NONE || size_t(dataSize) > blockSize){
+			return false;
+		}
+		scratch.resize(blockSize);
+		if(source.compression == TINYEXR_COMPRESSIONTYPE_RLE){
+			if(!decompressEXRRle(data, size_t(dataSize), &scratch[0], blockSize)){
+				return false;
+			}
+		} else if(source.compression == TINYEXR_COMPRESSIONTYPE_PIZ){
+			if(!tinyexr::DecompressPiz(&scratch[0], data, blockSize, size_t(dataSize), int(source.infos.size()), &source.infos[0], lineWidth, lineCount)){
+				return false;
+			}
+		} else {
+			unsigned long decompressedSize = (unsigned long)(blockSize);
+			if(!tinyexr::DecompressZip(&scratch[0], &decompressedSize, data, (unsigned long)(dataSize)) || decompressedSize != blockSize){
+				return false;
+			}
+		}
+		samples = &scratch[0];
+	}
+	
+	// Each decompressed line stores all samples of the first channel, then the second,...
+	lines.resize(3 * size_t(lineWidth));
+	for(int y = 0; y < lineCount; ++y){
+		const unsigned char * line = samples + size_t(y) * lineSize;
+		const int row = flip ? (source.height - 1 - firstY - y) : (firstY + y);
+		const size_t dstOffset = 3 * (size_t(row) * size_t(source.width) + size_t(firstX));
+		if(source.half){
+			interleaveRGBHalfLine(line + source.offsets[0] * size_t(lineWidth), line + source.offsets[1] * size_t(lineWidth), line + source.offsets[2] * size_t(lineWidth), size_t(lineWidth), static_cast<uint16_t *>(image) + dstOffset);
+			continue;
+		}
+		for(int i = 0; i < 3; ++i){
+			convertEXRLine(line + source.offsets[i] * size_t(lineWidth), source.types[i], size_t(lineWidth), &lines[i * size_t(lineWidth)]);
+		}
+		interleaveRGBLine(&lines[0], &lines[size_t(lineWidth)], &lines[2 * size_t(lineWidth)], size_t(lineWidth), static_cast<float *>(image) + dstOffset);
+	}
+	return true;
+}
+
 bool ImageUtilities::isHDR(const std::string & path){
 	return path.substr(path.size()-4,4) == ".exr";
 }
@@ -24,35 +270,46 @@ bool ImageUtilities::isHDR(const std::string & path){
 int ImageUtilities::loadImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, const bool flip, const bool externalFile){
 	int ret = 0;
 	if(isHDR(path)){
-		ret = ImageUtilities::loadHDRImage(path, width, height, channels, (float**)data, flip, externalFile);
+		bool half = false;
+		ret = ImageUtilities::loadHDRImage(path, width, height, channels, data, half, flip, externalFile, false, 0);
 	} else {
 		ret = ImageUtilities::loadLDRImage(path, width, height, channels, (unsigned char**)data, flip, externalFile);
 	}
 	return ret;
 }
 
+int ImageUtilities::loadNativeImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, bool & half, const bool flip, const bool externalFile, const unsigned int threads){
+	half = false;
+	if(isHDR(path)){
+		return ImageUtilities::loadHDRImage(path, width, height, channels, data, half, flip, externalFile, true, threads);
+	}
+	return ImageUtilities::loadLDRImage(path, width, height, channels, (unsigned char**)data, flip, externalFile);
+}
+
 int ImageUtilities::loadLDRImage(const std::string &path, unsigned int & width, unsigned int & height, unsigned int & channels, unsigned char **data, const bool flip, const bool externalFile){
 	
-	size_t rawSize = 0;
-	unsigned char * rawData;
+	ResourceData content;
 	if(externalFile){
-		rawData = (unsigned char*)(Resources::loadRawDataFromExternalFile(path, rawSize));
+		size_t rawSize = 0;
+		char * rawData = Resources::loadRawDataFromExternalFile(path, rawSize);
+		content = ResourceData(rawData, rawSize, true);
 	} else {
-		rawData = (unsigned char*)(Resources::manager().getRawData(path, rawSize));
+		content = Resources::manager().getData(path);
 	}
 	
-	if(rawData == NULL || rawSize == 0){
+	if(content.empty()){
 		return 1;
 	}
-	
-	stbi_set_flip_vertically_on_load(flip);
+	const unsigned char * rawData = (const unsigned char*)content.data();
+	const size_t rawSize = content.size();
+	Telemetry::Scope scope(Telemetry::Decode, path);
+	scope.setBytes(rawSize);
 	
 	channels = 4;
 	int localWidth = 0;
 	int localHeight = 0;
 	// Beware: the size has to be cast to int, imposing a limit on big file sizes.
 	*data = stbi_load_from_memory(rawData, (int)rawSize, &localWidth, &localHeight, NULL, channels);
-	free(rawData);
 	
 	if(*data == NULL){
 		return 1;
@@ -61,29 +318,44 @@ int ImageUtilities::loadLDRImage(const std::string &path, unsigned int & width,
 	width = (unsigned int)localWidth;
 	height = (unsigned int)localHeight;
 	
+	// Flip the rows ourselves, as the stb_image setting is global and images can be decoded on multiple threads.
+	if(flip){
+		const size_t rowSize = size_t(width) * channels;
+		std::vector<unsigned char> row(rowSize);
+		for(unsigned int y = 0; y < height / 2; ++y){
+			unsigned char * top = *data + size_t(y) * rowSize;
+			unsigned char * bottom = *data + size_t(height - 1 - y) * rowSize;
+			std::memcpy(&row[0], top, rowSize);
+			std::memcpy(top, bottom, rowSize);
+			std::memcpy(bottom, &row[0], rowSize);
+		}
+	}
+	
 	return 0;
 }
 
-int ImageUtilities::loadHDRImage(const std::string &path, unsigned int & width, unsigned int & height, unsigned int & channels, float **data, const bool flip, const bool externalFile){
+int ImageUtilities::loadHDRImage(const std::string &path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, bool & half, const bool flip, const bool externalFile, const bool keepHalf, const unsigned int threads){
 	
-	// Code adapted from tinyEXR deprecated loadEXR.
 	EXRVersion exr_version;
-	EXRImage exr_image;
 	EXRHeader exr_header;
 	InitEXRHeader(&exr_header);
-	InitEXRImage(&exr_image);
 	
-	size_t rawSize = 0;
-	unsigned char * rawData;
+	ResourceData content;
 	if(externalFile){
-		rawData = (unsigned char*)(Resources::loadRawDataFromExternalFile(path, rawSize));
+		size_t rawSize = 0;
+		char * rawData = Resources::loadRawDataFromExternalFile(path, rawSize);
+		content = ResourceData(rawData, rawSize, true);
 	} else {
-		rawData = (unsigned char*)(Resources::manager().getRawData(path, rawSize));
+		content = Resources::manager().getData(path);
 	}
 	
-	if(rawData == NULL || rawSize == 0){
+	if(content.empty()){
 		return 1;
 	}
+	const unsigned char * rawData = (const unsigned char*)content.data();
+	const size_t rawSize = content.size();
+	Telemetry::Scope scope(Telemetry::Decode, path);
+	scope.setBytes(rawSize);
 	
 	{
 		int ret = ParseEXRVersionFromMemory(&exr_version, rawData, tinyexr::kEXRVersionSize);
@@ -102,66 +374,92 @@ int ImageUtilities::loadHDRImage(const std::string &path, unsigned int & width,
 		}
 	}
 	
-	// Read HALF channel as FLOAT.
-	for (int i = 0; i < exr_header.num_channels; i++) {
-		if (exr_header.pixel_types[i] == TINYEXR_PIXELTYPE_HALF) {
-			exr_header.requested_pixel_types[i] = TINYEXR_PIXELTYPE_FLOAT;
+	// Only decode the RGB channels, alpha and any other channel are ignored.
+	EXRSource source;
+	source.compression = exr_header.compression_type;
+	source.tileWidth = exr_header.tiled ? exr_header.tile_size_x : 0;
+	source.tileHeight = exr_header.tiled ? exr_header.tile_size_y : 0;
+	source.width = exr_header.data_window[2] - exr_header.data_window[0] + 1;
+	source.height = exr_header.data_window[3] - exr_header.data_window[1] + 1;
+	source.minY = exr_header.data_window[1];
+	const char * names[3] = { "R", "G", "B" };
+	source.infos.assign(exr_header.channels, exr_header.channels + exr_header.num_channels);
+	int pixelSize = 0;
+	for (int c = 0; c < exr_header.num_channels; c++) {
+		for(int i = 0; i < 3; ++i){
+			if (strcmp(exr_header.channels[c].name, names[i]) == 0) {
+				source.channels[i] = c;
+				source.types[i] = exr_header.channels[c].pixel_type;
+				source.offsets[i] = pixelSize;
+			}
 		}
+		pixelSize += exr_header.channels[c].pixel_type == TINYEXR_PIXELTYPE_HALF ? 2 : 4;
 	}
-	{
-		int ret = LoadEXRImageFromMemory(&exr_image, &exr_header, rawData, rawSize, NULL);
-		if (ret != TINYEXR_SUCCESS) {
-			FreeEXRHeader(&exr_header);
-			return ret;
-		}
+	source.pixelSize = size_t(pixelSize);
+	// Half float channels can be kept as is, avoiding a conversion and halving the memory used.
+	source.half = keepHalf && source.types[0] == TINYEXR_PIXELTYPE_HALF && source.types[1] == TINYEXR_PIXELTYPE_HALF && source.types[2] == TINYEXR_PIXELTYPE_HALF;
+	source.linesPerBlock = exrLinesPerBlock(source.compression);
+	
+	const bool supported = source.compression == TINYEXR_COMPRESSIONTYPE_NONE || source.compression == TINYEXR_COMPRESSIONTYPE_RLE || source.compression == TINYEXR_COMPRESSIONTYPE_ZIPS || source.compression == TINYEXR_COMPRESSIONTYPE_ZIP || source.compression == TINYEXR_COMPRESSIONTYPE_PIZ;
+	const bool validChannels = source.channels[0] != -1 && source.channels[1] != -1 && source.channels[2] != -1;
+	const bool validSize = source.width > 0 && source.height > 0 && (!exr_header.tiled || (source.tileWidth > 0 && source.tileHeight > 0));
+	if(!validChannels || !validSize || !supported){
+		FreeEXRHeader(&exr_header);
+		return supported ? TINYEXR_ERROR_INVALID_DATA : TINYEXR_ERROR_UNSUPPORTED_FEATURE;
 	}
-	free(rawData);
 	
-	// RGBA
-	int idxR = -1;
-	int idxG = -1;
-	int idxB = -1;
-	int idxA = -1;
-	for (int c = 0; c < exr_header.num_channels; c++) {
-		if (strcmp(exr_header.channels[c].name, "R") == 0) {
-			idxR = c;
-		} else if (strcmp(exr_header.channels[c].name, "G") == 0) {
-			idxG = c;
-		} else if (strcmp(exr_header.channels[c].name, "B") == 0) {
-			idxB = c;
-		} else if (strcmp(exr_header.channels[c].name, "A") == 0) {
-			idxA = c;
-		}
+	// Read the blocks offset table, just after the header.
+	size_t blockCount = 0;
+	if(exr_header.tiled){
+		blockCount = size_t((source.width + source.tileWidth - 1) / source.tileWidth) * size_t((source.height + source.tileHeight - 1) / source.tileHeight);
+	} else {
+		blockCount = size_t((source.height + source.linesPerBlock - 1) / source.linesPerBlock);
 	}
-	
-	if (idxR == -1 || idxG == -1 || idxB == -1) {
+	const size_t tableOffset = size_t(exr_header.header_len) + tinyexr::kEXRVersionSize;
+	if(tableOffset + blockCount * sizeof(tinyexr::tinyexr_uint64) >= rawSize){
 		FreeEXRHeader(&exr_header);
-		FreeEXRImage(&exr_image);
 		return TINYEXR_ERROR_INVALID_DATA;
 	}
-	
-	width = (unsigned int)exr_image.width;
-	height = (unsigned int)exr_image.height;
-	channels = 3;
-	
-	*data = reinterpret_cast<float *>(malloc(channels * sizeof(float) * static_cast<size_t>(width) *
-												  static_cast<size_t>(height)));
-	
-	for(int y = 0; y < exr_image.height; ++y){
-		for (int x = 0; x < exr_image.width; ++x){
-			const int destIndex = y * (int)width + x;
-			const int sourceIndex = flip ? (((int)height-1-y)*(int)width+x) : destIndex;
-			
-			(*data)[channels * destIndex + 0] = reinterpret_cast<float **>(exr_image.images)[idxR][sourceIndex];
-			(*data)[channels * destIndex + 1] = reinterpret_cast<float **>(exr_image.images)[idxG][sourceIndex];
-			(*data)[channels * destIndex + 2] = reinterpret_cast<float **>(exr_image.images)[idxB][sourceIndex];
-			// Ignore alpha.
+	std::vector<tinyexr::tinyexr_uint64> offsets(blockCount);
+	std::memcpy(&offsets[0], rawData + tableOffset, blockCount * sizeof(tinyexr::tinyexr_uint64));
+	for(size_t bid = 0; bid < blockCount; ++bid){
+		// Incomplete files have null offsets, rebuild the table by walking the scanline blocks.
+		if(offsets[bid] == 0 && !exr_header.tiled){
+			if(!tinyexr::ReconstructLineOffsets(&offsets, blockCount, rawData, rawData + tableOffset + blockCount * sizeof(tinyexr::tinyexr_uint64), rawSize)){
+				FreeEXRHeader(&exr_header);
+				return TINYEXR_ERROR_INVALID_DATA;
+			}
+			break;
 		}
 	}
-	
 	FreeEXRHeader(&exr_header);
-	FreeEXRImage(&exr_image);
 	
+	width = (unsigned int)source.width;
+	height = (unsigned int)source.height;
+	channels = 3;
+	half = source.half;
+	
+	*data = malloc(channels * (half ? sizeof(uint16_t) : sizeof(float)) * static_cast<size_t>(width) * static_cast<size_t>(height));
+	
+	// Blocks are independent: decompress them in parallel, writing each line directly at its final place.
+	std::atomic<bool> valid(true);
+	const std::string assetName = Telemetry::currentAsset();
+	ThreadUtilities::parallelFor(blockCount, [&](size_t begin, size_t end, unsigned int){
+		Telemetry::Asset asset(assetName);
+		std::vector<unsigned char> scratch;
+		std::vector<float> rows;
+		for(size_t bid = begin; bid < end && valid; ++bid){
+			if(offsets[bid] >= rawSize || !decodeEXRBlock(source, rawData + offsets[bid], rawSize - size_t(offsets[bid]), *data, flip, scratch, rows)){
+				valid = false;
+			}
+		}
+	}, threads);
+			
+	if(!valid){
+		free(*data);
+		*data = NULL;
+		return TINYEXR_ERROR_INVALID_DATA;
+	}
 	return 0;
 }
 
@@ -199,9 +497,8 @@ int ImageUtilities::saveLDRImage(const std::string &path, const unsigned int wid
 
 int ImageUtilities::saveHDRImage(const std::string &path, const unsigned int width, const unsigned int height, const unsigned int channels, const float *data, const bool flip, const bool ignoreAlpha){
 	
-	// Assume at least 16x16 pixels.
-	if (width < 16) return TINYEXR_ERROR_INVALID_ARGUMENT;
-	if (height < 16) return TINYEXR_ERROR_INVALID_ARGUMENT;
+	// Small images, such as the last mipmap levels, are supported.
+	if (width == 0 || height == 0) return TINYEXR_ERROR_INVALID_ARGUMENT;
 	
 	EXRHeader header;
 	InitEXRHeader(&header);
@@ -29,6 +29,20 @@ public:
 	 */
 	static int loadImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, const bool flip, const bool externalFile = false);
 	
+	/** Load an image from disk, keeping HDR images stored as half floats in their native precision.
+	 \param path the path to the image
+	 \param width will contain the width of the loaded image
+	 \param height will contain the height of the loaded image
+	 \param channels will contain the number of channels of the loaded image
+	 \param data will contain the image raw data (unsigned char for LDR, uint16_t half floats or float for HDR)
+	 \param half will denote if the HDR data is stored as half floats
+	 \param flip should the image be vertically flipped
+	 \param externalFile if true, skip the resources manager and load directly from disk
+	 \param threads the number of threads decompressing HDR blocks (0 to use the default thread count)
+	 \return a success/error flag
+	 */
+	static int loadNativeImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, bool & half, const bool flip, const bool externalFile = false, const unsigned int threads = 0);
+	
 	/** Save a LDR image to disk using stb_image.
 	 \param path the path to the image
 	 \param width the width of the image
@@ -67,17 +81,20 @@ private:
 	 */
 	static int loadLDRImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, unsigned char **data, const bool flip, const bool externalFile);
 	
-	/** Load a HDR image from disk using tiny_exr.
+	/** Load a HDR image from disk using tiny_exr. Blocks are decompressed in parallel and only the RGB channels are decoded.
 	 \param path the path to the image
 	 \param width will contain the width of the loaded image
 	 \param height will contain the height of the loaded image
 	 \param channels will contain the number of channels of the loaded image
 	 \param data will contain the image raw data
+	 \param half will denote if the data is stored as half floats
 	 \param flip should the image be vertically flipped
 	 \param externalFile if true, skip the resources manager and load directly from disk
+	 \param keepHalf if true and the RGB channels are half floats, don't convert them to floats
+	 \param threads the number of threads decompressing blocks (0 to use the default thread count)
 	 \return a success/error flag
 	 */
-	static int loadHDRImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, float **data, const bool flip, const bool externalFile);
+	static int loadHDRImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, bool & half, const bool flip, const bool externalFile, const bool keepHalf, const unsigned int threads);
 	
 };
 
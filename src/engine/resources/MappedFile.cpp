@@ -0,0 +1,106 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : _data(NULL), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(NULL) {
+}
+
+bool MappedFile::open(const std::string & path){
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE){
+		Log::Error() << Log::Resources << "Unable to open file at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0){
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(mapping == NULL){
+		Log::Error() << Log::Resources << "Unable to map file at path \"" << path << "\"." << std::endl;
+		CloseHandle(file);
+		return false;
+	}
+	void * data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(data == NULL){
+		Log::Error() << Log::Resources << "Unable to map file at path \"" << path << "\"." << std::endl;
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	_file = file;
+	_mapping = mapping;
+	_data = (const char*)data;
+	_size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close(){
+	if(_data != NULL){
+		UnmapViewOfFile(_data);
+	}
+	if(_mapping != NULL){
+		CloseHandle((HANDLE)_mapping);
+	}
+	if(_file != INVALID_HANDLE_VALUE){
+		CloseHandle((HANDLE)_file);
+	}
+	_data = NULL;
+	_size = 0;
+	_file = INVALID_HANDLE_VALUE;
+	_mapping = NULL;
+}
+
+#else
+
+MappedFile::MappedFile() : _data(NULL), _size(0) {
+}
+
+bool MappedFile::open(const std::string & path){
+	close();
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if(file < 0){
+		Log::Error() << Log::Resources << "Unable to open file at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	struct stat infos;
+	if(fstat(file, &infos) != 0 || infos.st_size == 0){
+		::close(file);
+		return false;
+	}
+	void * data = mmap(NULL, (size_t)infos.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping stays valid once the descriptor is closed.
+	::close(file);
+	if(data == MAP_FAILED){
+		Log::Error() << Log::Resources << "Unable to map file at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	_data = (const char*)data;
+	_size = (size_t)infos.st_size;
+	return true;
+}
+
+void MappedFile::close(){
+	if(_data != NULL){
+		munmap((void*)_data, _size);
+	}
+	_data = NULL;
+	_size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile(){
+	close();
+}
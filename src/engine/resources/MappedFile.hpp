@@ -0,0 +1,58 @@
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include "../Common.hpp"
+
+/**
+ \brief Read-only view of a file on disk mapped in memory. The content is paged in by the system on access, without any copy.
+ \ingroup Resources
+ */
+class MappedFile {
+	
+public:
+	
+	/** Default constructor, no file is mapped. */
+	MappedFile();
+	
+	/** Map a file in memory.
+	 \param path the path to the file on disk
+	 \return true if the file was successfully mapped
+	 \note Any previously mapped file will be unmapped.
+	 */
+	bool open(const std::string & path);
+	
+	/** Unmap the current file, if any. Pointers to its content become invalid. */
+	void close();
+	
+	/** Query the mapped content.
+	 \return a pointer to the first byte of the file, or NULL if no file is mapped
+	 */
+	const char * data() const { return _data; }
+	
+	/** Query the size of the mapped content.
+	 \return the size of the file in bytes
+	 */
+	size_t size() const { return _size; }
+	
+	/** Destructor. Unmap the file. */
+	~MappedFile();
+	
+	/** Assignment operator (disabled). */
+	MappedFile& operator= (const MappedFile&) = delete;
+	
+	/** Copy constructor (disabled). */
+	MappedFile (const MappedFile&) = delete;
+	
+private:
+	
+	const char * _data; ///< The mapped content.
+	size_t _size; ///< The mapped content size.
+	
+#ifdef _WIN32
+	void * _file; ///< The file handle.
+	void * _mapping; ///< The file mapping handle.
+#endif
+	
+};
+
+#endif
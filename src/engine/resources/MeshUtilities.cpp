@@ -1,188 +1,723 @@
 #include "MeshUtilities.hpp"
-#include <sstream>
+#include "../helpers/ThreadUtilities.hpp"
+#include "../helpers/Telemetry.hpp"
 #include <cstddef>
-#include <map>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+/// SSE instructions are available.
+#define MESH_UTILITIES_SSE
+#endif
 
 using namespace std;
 
-void MeshUtilities::loadObj( std::istream & in, Mesh & mesh, MeshUtilities::LoadMode mode){
+// OBJ parsing helpers.
+// The parser works in place on the file content, without splitting it in per-line strings and tokens.
+
+/** Check if a character is a separator inside an OBJ line.
+ \param c the character to test
+ \return true if the character is a space-like separator
+ */
+inline bool objIsSpace(const char c){
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/** Skip separators on the current line.
+ \param ptr the current position, will be moved to the next non-separator character
+ \param end the end of the buffer
+ */
+inline void objSkipSpaces(const char *& ptr, const char * end){
+	while(ptr < end && objIsSpace(*ptr)){
+		++ptr;
+	}
+}
+
+/** Move to the beginning of the next line.
+ \param ptr the current position, will be moved past the next end of line
+ \param end the end of the buffer
+ */
+inline void objSkipLine(const char *& ptr, const char * end){
+	const char * eol = static_cast<const char *>(memchr(ptr, '\n', end - ptr));
+	ptr = eol ? (eol + 1) : end;
+}
+
+/** Parse a signed integer.
+ \param ptr the current position, will be moved past the integer
+ \param end the end of the buffer
+ \param value will contain the parsed integer
+ \return true if at least one digit was read
+ */
+inline bool objParseInt(const char *& ptr, const char * end, long & value){
+	bool negative = false;
+	if(ptr < end && (*ptr == '-' || *ptr == '+')){
+		negative = (*ptr == '-');
+		++ptr;
+	}
+	const char * start = ptr;
+	long result = 0;
+	while(ptr < end && (unsigned char)(*ptr - '0') < 10){
+		result = result * 10 + (*ptr - '0');
+		++ptr;
+	}
+	value = negative ? -result : result;
+	return ptr != start;
+}
+
+/** Parse a floating point number. Common decimal notations are handled directly, other cases (very long mantissas, hexadecimal, inf/nan) fall back to strtof. In all cases the result is the same as the one of std::stof.
+ \param ptr the current position, will be moved past the number
+ \param end the end of the buffer
+ \param value will contain the parsed number
+ \return true if a number was read
+ */
+bool objParseFloat(const char *& ptr, const char * end, float & value){
+	// Exact powers of ten in double precision.
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
 	
-	//Init the mesh.
-	mesh.indices.clear();
-	mesh.positions.clear();
-	mesh.normals.clear();
-	mesh.texcoords.clear();
+	const char * start = ptr;
+	const char * cur = ptr;
+	bool negative = false;
+	if(cur < end && (*cur == '-' || *cur == '+')){
+		negative = (*cur == '-');
+		++cur;
+	}
+	// Accumulate the significant digits, keeping track of the decimal point position.
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool exact = true;
+	bool hasDigits = false;
+	while(cur < end && (unsigned char)(*cur - '0') < 10){
+		hasDigits = true;
+		if(mantissa != 0 || *cur != '0'){
+			if(digits < 19){
+				mantissa = mantissa * 10 + (unsigned long long)(*cur - '0');
+				++digits;
+			} else {
+				++exponent;
+				exact = false;
+			}
+		}
+		++cur;
+	}
+	if(cur < end && *cur == '.'){
+		++cur;
+		while(cur < end && (unsigned char)(*cur - '0') < 10){
+			hasDigits = true;
+			if(mantissa != 0 || *cur != '0'){
+				if(digits < 19){
+					mantissa = mantissa * 10 + (unsigned long long)(*cur - '0');
+					++digits;
+					--exponent;
+				} else {
+					exact = false;
+				}
+			} else {
+				--exponent;
+			}
+			++cur;
+		}
+	}
+	if(hasDigits && cur < end && (*cur == 'e' || *cur == 'E')){
+		const char * expStart = cur + 1;
+		long expValue = 0;
+		if(objParseInt(expStart, end, expValue)){
+			exponent += (int)(std::max)(-1000l, (std::min)(1000l, expValue));
+			cur = expStart;
+		}
+	}
 	
-	// Init temporary vectors.
-	vector<glm::vec3> positions_temp;
-	vector<glm::vec3> normals_temp;
-	vector<glm::vec2> texcoords_temp;
-	vector<string> faces_temp;
-
-	string res;
+	// Fast path: the mantissa and the power of ten are exactly representable as doubles,
+	// so the double result is correctly rounded. We only have to avoid the case where it lies
+	// exactly halfway between two floats, as rounding twice could then differ from std::stof.
+	if(hasDigits && exact && digits <= 15 && exponent >= -22 && exponent <= 22){
+		const double result = exponent < 0 ? double(mantissa) / powers[-exponent] : double(mantissa) * powers[exponent];
+		unsigned long long bits;
+		memcpy(&bits, &result, sizeof(double));
+		const bool isFloatMidpoint = (bits & 0x1FFFFFFFull) == 0x10000000ull;
+		const bool isFloatSubnormal = result != 0.0 && result < 1.2e-38;
+		if(!isFloatMidpoint && !isFloatSubnormal){
+			value = float(negative ? -result : result);
+			ptr = cur;
+			return true;
+		}
+	}
+	
+	// Slow path: copy the token to a null-terminated stack buffer and let strtof handle it.
+	const char * tokenEnd = start;
+	while(tokenEnd < end && !objIsSpace(*tokenEnd) && *tokenEnd != '\n'){
+		++tokenEnd;
+	}
+	char buffer[128];
+	const size_t tokenSize = (std::min)(size_t(tokenEnd - start), sizeof(buffer) - 1);
+	memcpy(buffer, start, tokenSize);
+	buffer[tokenSize] = '\0';
+	char * bufferEnd = buffer;
+	value = strtof(buffer, &bufferEnd);
+	if(bufferEnd == buffer){
+		return false;
+	}
+	ptr = start + (bufferEnd - buffer);
+	return true;
+}
 
-	// Iterate over the lines of the file.
-	while(!in.eof()){
-		getline(in,res);
+/** Parse a list of float values on the current line.
+ \param ptr the current position, will be moved past the parsed values
+ \param end the end of the buffer
+ \param values will contain the values
+ \param count the number of values to read
+ \return true if all values were read
+ */
+inline bool objParseFloats(const char *& ptr, const char * end, float * values, const int count){
+	for(int i = 0; i < count; ++i){
+		objSkipSpaces(ptr, end);
+		if(!objParseFloat(ptr, end, values[i])){
+			return false;
+		}
+	}
+	return true;
+}
 
-		// Ignore the line if it is too short or a comment.
-		if(res.empty() || res[0] == '#' || res.size()<2){
-			continue;
+/** Parse a face corner in the p, p/t, p//n or p/t/n format. Indices are converted to 0-based indices, relative (negative) indices are resolved using the current attributes counts. Missing indices reuse the last index read on the corner.
+ \param ptr the current position, will be moved past the corner
+ \param end the end of the buffer
+ \param counts the current number of positions, texture coordinates and normals
+ \param corner will contain the position, texture coordinates and normal indices
+ \param relativeTo for each index, will contain the attribute (0,1,2) whose count was used to resolve it, or -1 for absolute indices
+ \return true if the corner was read
+ */
+bool objParseCorner(const char *& ptr, const char * end, const long counts[3], long corner[3], int relativeTo[3]){
+	long last = 0;
+	int lastRelativeTo = -1;
+	for(int i = 0; i < 3; ++i){
+		long index = 0;
+		if(objParseInt(ptr, end, index)){
+			last = index < 0 ? (counts[i] + index + 1) : index;
+			lastRelativeTo = index < 0 ? i : -1;
+		} else if(i == 0){
+			return false;
 		}
-		//We want to split the content of the line at spaces, use a stringstream directly
-		stringstream ss(res);
-		vector<string> tokens;
-		string token;
-		while(ss >> token){
-			tokens.push_back(token);
+		corner[i] = last - 1;
+		relativeTo[i] = lastRelativeTo;
+		if(ptr < end && *ptr == '/'){
+			++ptr;
+		} else {
+			// Fill the remaining indices.
+			for(int j = i + 1; j < 3; ++j){
+				corner[j] = last - 1;
+				relativeTo[j] = lastRelativeTo;
+			}
+			break;
 		}
-		if(tokens.size() < 1){
-			continue;
+	}
+	// Skip the remaining of the corner token.
+	while(ptr < end && !objIsSpace(*ptr) && *ptr != '\n'){
+		++ptr;
+	}
+	return true;
+}
+
+/** \brief Index of a face corner that was resolved relatively to the attributes parsed before it.
+ \details When parsing a chunk of the file, the attributes of the previous chunks are unknown, so the chunk offsets have to be added afterwards.
+ \ingroup Resources
+ */
+struct ObjRelativeIndex {
+	size_t corner; ///< The face corner.
+	int attribute; ///< The corner index to fix (position, uv or normal).
+	int relativeTo; ///< The attribute whose count was used to resolve the index.
+};
+
+/** \brief Raw OBJ content, before conversion to a mesh.
+ \ingroup Resources
+ */
+struct ObjContent {
+	std::vector<glm::vec3> positions; ///< The positions.
+	std::vector<glm::vec3> normals; ///< The normals.
+	std::vector<glm::vec2> texcoords; ///< The texture coordinates.
+	std::vector<glm::ivec3> corners; ///< The (position, uv, normal) 0-based indices of each face corner, three per triangle.
+	std::vector<ObjRelativeIndex> relativeIndices; ///< Corner indices resolved relatively to the content start.
+};
+
+/** Parse OBJ text in place.
+ \param begin the beginning of the text
+ \param end the end of the text
+ \param obj will be populated with the attributes and faces
+ */
+void parseObj(const char * begin, const char * end, ObjContent & obj){
+	const char * ptr = begin;
+	while(ptr < end){
+		objSkipSpaces(ptr, end);
+		if(ptr >= end){
+			break;
 		}
-		// Check what kind of element the line represent.
-		if (tokens[0] == "v") { // Vertex position
-			// We need 3 coordinates.
-			if(tokens.size() < 4){
-				continue;
+		// Determine the keyword, ignoring comments and empty lines.
+		const char * keyword = ptr;
+		while(ptr < end && !objIsSpace(*ptr) && *ptr != '\n'){
+			++ptr;
+		}
+		const size_t keywordSize = ptr - keyword;
+		
+		if(keywordSize == 1 && keyword[0] == 'v'){ // Vertex position
+			glm::vec3 pos;
+			if(objParseFloats(ptr, end, &pos[0], 3)){
+				obj.positions.push_back(pos);
 			}
-			glm::vec3 pos = glm::vec3(stof(tokens[1],NULL),stof(tokens[2],NULL),stof(tokens[3],NULL));
-			positions_temp.push_back(pos);
 			
-		} else if (tokens[0] == "vn"){ // Vertex normal
-			// We need 3 coordinates.
-			if(tokens.size() < 4){
-				continue;
+		} else if(keywordSize == 2 && keyword[0] == 'v' && keyword[1] == 'n'){ // Vertex normal
+			glm::vec3 nor;
+			if(objParseFloats(ptr, end, &nor[0], 3)){
+				obj.normals.push_back(nor);
 			}
-			glm::vec3 nor = glm::vec3(stof(tokens[1],NULL),stof(tokens[2],NULL),stof(tokens[3],NULL));
-			normals_temp.push_back(nor);
 			
-		} else if (tokens[0] == "vt") { // Vertex UV
-			// We need 2 coordinates.
-			if(tokens.size() < 3){
-				continue;
+		} else if(keywordSize == 2 && keyword[0] == 'v' && keyword[1] == 't'){ // Vertex UV
+			glm::vec2 uv;
+			if(objParseFloats(ptr, end, &uv[0], 2)){
+				obj.texcoords.push_back(uv);
 			}
-			glm::vec2 uv = glm::vec2(stof(tokens[1],NULL),stof(tokens[2],NULL));
-			texcoords_temp.push_back(uv);
 			
-		} else if (tokens[0] == "f") { // Face indices.
+		} else if(keywordSize == 1 && keyword[0] == 'f'){ // Face indices.
 			// We need 3 elements, each containing at most three indices.
-			if(tokens.size() < 4){
-				continue;
+			const long counts[3] = { (long)obj.positions.size(), (long)obj.texcoords.size(), (long)obj.normals.size() };
+			long corners[3][3];
+			int relativeTo[3][3];
+			bool valid = true;
+			for(int i = 0; i < 3 && valid; ++i){
+				objSkipSpaces(ptr, end);
+				valid = objParseCorner(ptr, end, counts, corners[i], relativeTo[i]);
 			}
-			faces_temp.push_back(tokens[1]);
-			faces_temp.push_back(tokens[2]);
-			faces_temp.push_back(tokens[3]);
+			if(valid){
+				for(int i = 0; i < 3; ++i){
+					for(int j = 0; j < 3; ++j){
+						if(relativeTo[i][j] >= 0){
+							obj.relativeIndices.push_back({ obj.corners.size(), j, relativeTo[i][j] });
+						}
+					}
+					obj.corners.emplace_back(int(corners[i][0]), int(corners[i][1]), int(corners[i][2]));
+				}
+			}
+		}
+		// Ignore s, l, g, matl, comments or others.
+		objSkipLine(ptr, end);
+	}
+}
 
-		} else { // Ignore s, l, g, matl or others
-			continue;
+/** Check that all face corners reference existing attributes.
+ \param obj the OBJ content
+ \param hasUV should the texture coordinates indices be checked
+ \param hasNormals should the normals indices be checked
+ \return true if all indices are valid
+ */
+bool objValidateCorners(const ObjContent & obj, const bool hasUV, const bool hasNormals){
+	const int positionsCount = int(obj.positions.size());
+	const int texcoordsCount = int(obj.texcoords.size());
+	const int normalsCount = int(obj.normals.size());
+	for(const glm::ivec3 & corner : obj.corners){
+		if(corner[0] < 0 || corner[0] >= positionsCount){
+			return false;
+		}
+		if(hasUV && (corner[1] < 0 || corner[1] >= texcoordsCount)){
+			return false;
+		}
+		if(hasNormals && (corner[2] < 0 || corner[2] >= normalsCount)){
+			return false;
 		}
 	}
+	return true;
+}
 
+/** Convert parsed OBJ content to a mesh, following the given mode.
+ \param obj the OBJ content
+ \param mesh will be populated with the geometry
+ \param mode the preprocessing mode
+ */
+void buildObjMesh(const ObjContent & obj, Mesh & mesh, const MeshUtilities::LoadMode mode){
 	// If no vertices, end.
-	if(positions_temp.size() == 0){
-			return;
+	if(obj.positions.empty()){
+		return;
 	}
-
+	
 	// Does the mesh have UV or normal coordinates ?
-	bool hasUV = texcoords_temp.size()>0;
-	bool hasNormals = normals_temp.size()>0;
-
+	const bool hasUV = !obj.texcoords.empty();
+	const bool hasNormals = !obj.normals.empty();
+	
+	if(mode != MeshUtilities::Points && !objValidateCorners(obj, hasUV, hasNormals)){
+		Log::Error() << Log::Resources << "Mesh faces reference missing attributes." << std::endl;
+		return;
+	}
+	
 	// Depending on the chosen extraction mode, we fill the mesh arrays accordingly.
 	if (mode == MeshUtilities::Points){
 		// Mode: Points
 		// In this mode, we don't care about faces. We simply associate each vertex/normal/uv in the same order.
 		
-		mesh.positions = positions_temp;
+		mesh.positions = obj.positions;
 		if(hasNormals){
-			mesh.normals = normals_temp;
+			mesh.normals = obj.normals;
 		}
 		if(hasUV){
-			mesh.texcoords = texcoords_temp;
+			mesh.texcoords = obj.texcoords;
 		}
-
+		
 	} else if(mode == MeshUtilities::Expanded){
 		// Mode: Expanded
 		// In this mode, vertices are all duplicated. Each face has its set of 3 vertices, not shared with any other face.
+		const size_t cornersCount = obj.corners.size();
+		mesh.positions.resize(cornersCount);
+		mesh.texcoords.resize(hasUV ? cornersCount : 0);
+		mesh.normals.resize(hasNormals ? cornersCount : 0);
+		mesh.indices.resize(cornersCount);
 		
 		// For each face, query the needed positions, normals and uvs, and add them to the mesh structure.
-		for(size_t i = 0; i < faces_temp.size(); i++){
-			string str = faces_temp[i];
-			size_t foundF = str.find_first_of("/");
-			size_t foundL = str.find_last_of("/");
-			
+		for(size_t i = 0; i < cornersCount; i++){
+			const glm::ivec3 & corner = obj.corners[i];
 			// Positions (we are sure they exist).
-			long ind1 = stol(str.substr(0,foundF))-1;
-			mesh.positions.push_back(positions_temp[ind1]);
-
+			mesh.positions[i] = obj.positions[corner[0]];
 			// UVs (second index).
 			if(hasUV){
-				long ind2 = stol(str.substr(foundF+1,foundL))-1;
-				mesh.texcoords.push_back(texcoords_temp[ind2]);
+				mesh.texcoords[i] = obj.texcoords[corner[1]];
 			}
-
 			// Normals (third index, in all cases).
 			if(hasNormals){
-				long ind3 = stol(str.substr(foundL+1))-1;
-				mesh.normals.push_back(normals_temp[ind3]);
+				mesh.normals[i] = obj.normals[corner[2]];
 			}
-			
 			//Indices (simply a vector of increasing integers).
-			mesh.indices.push_back((unsigned int)i);
+			mesh.indices[i] = (unsigned int)i;
 		}
-
+		
 	} else if (mode == MeshUtilities::Indexed){
 		// Mode: Indexed
 		// In this mode, vertices are only duplicated if they were already used in a previous face with a different set of uv/normal coordinates.
 		
 		// Keep track of previously encountered (position,uv,normal).
-		map<string,unsigned int> indices_used;
-
-		//Positions
-		unsigned int maxInd = 0;
-		for(size_t i = 0; i < faces_temp.size(); i++){
-			
-			string str = faces_temp[i];
+		std::vector<glm::ivec3> uniqueCorners;
+		MeshUtilities::deduplicateCorners(obj.corners, mesh.indices, uniqueCorners);
+		
+		// Query the associated position/uv/normal of each unique vertex.
+		const size_t verticesCount = uniqueCorners.size();
+		mesh.positions.resize(verticesCount);
+		mesh.texcoords.resize(hasUV ? verticesCount : 0);
+		mesh.normals.resize(hasNormals ? verticesCount : 0);
+		for(size_t vid = 0; vid < verticesCount; ++vid){
+			const glm::ivec3 & corner = uniqueCorners[vid];
+			mesh.positions[vid] = obj.positions[corner[0]];
+			if(hasUV){
+				mesh.texcoords[vid] = obj.texcoords[corner[1]];
+			}
+			if(hasNormals){
+				mesh.normals[vid] = obj.normals[corner[2]];
+			}
+		}
+	}
+}
 
-			//Does the association of attributs already exists ?
-			if(indices_used.count(str)>0){
-				// Just store the index in the indices vector.
-				mesh.indices.push_back(indices_used[str]);
-				// Go to next face.
-				continue;
+/** Parse OBJ text by splitting it in line-aligned chunks processed in parallel, and merge the chunks content.
+ \param begin the beginning of the text
+ \param end the end of the text
+ \param obj will be populated with the attributes and faces
+ \param threadCount the number of chunks to use
+ */
+void parseObjParallel(const char * begin, const char * end, ObjContent & obj, const unsigned int threadCount){
+	// Split the text in chunks, each one ending at the end of a line.
+	const size_t size = end - begin;
+	std::vector<const char *> bounds(threadCount + 1, end);
+	bounds[0] = begin;
+	for(unsigned int cid = 1; cid < threadCount; ++cid){
+		const char * bound = (std::max)(bounds[cid - 1], begin + size * cid / threadCount);
+		objSkipLine(bound, end);
+		bounds[cid] = bound;
+	}
+	
+	// Parse each chunk independently.
+	std::vector<ObjContent> chunks(threadCount);
+	ThreadUtilities::parallelFor(threadCount, [&bounds, &chunks](size_t first, size_t last, unsigned int){
+		for(size_t cid = first; cid < last; ++cid){
+			parseObj(bounds[cid], bounds[cid + 1], chunks[cid]);
+		}
+	}, threadCount);
+	
+	// Prefix sums of the chunks sizes give the location of each chunk in the merged arrays.
+	// They are also the offsets to apply to indices resolved relatively to each chunk start.
+	std::vector<size_t> positionsOffsets(threadCount + 1, 0);
+	std::vector<size_t> texcoordsOffsets(threadCount + 1, 0);
+	std::vector<size_t> normalsOffsets(threadCount + 1, 0);
+	std::vector<size_t> cornersOffsets(threadCount + 1, 0);
+	for(unsigned int cid = 0; cid < threadCount; ++cid){
+		positionsOffsets[cid + 1] = positionsOffsets[cid] + chunks[cid].positions.size();
+		texcoordsOffsets[cid + 1] = texcoordsOffsets[cid] + chunks[cid].texcoords.size();
+		normalsOffsets[cid + 1] = normalsOffsets[cid] + chunks[cid].normals.size();
+		cornersOffsets[cid + 1] = cornersOffsets[cid] + chunks[cid].corners.size();
+	}
+	obj.positions.resize(positionsOffsets[threadCount]);
+	obj.texcoords.resize(texcoordsOffsets[threadCount]);
+	obj.normals.resize(normalsOffsets[threadCount]);
+	obj.corners.resize(cornersOffsets[threadCount]);
+	
+	// Copy each chunk at its location, and fix relative indices.
+	ThreadUtilities::parallelFor(threadCount, [&](size_t first, size_t last, unsigned int){
+		for(size_t cid = first; cid < last; ++cid){
+			ObjContent & chunk = chunks[cid];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), obj.positions.begin() + positionsOffsets[cid]);
+			std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), obj.texcoords.begin() + texcoordsOffsets[cid]);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), obj.normals.begin() + normalsOffsets[cid]);
+			const int offsets[3] = { int(positionsOffsets[cid]), int(texcoordsOffsets[cid]), int(normalsOffsets[cid]) };
+			for(const ObjRelativeIndex & relative : chunk.relativeIndices){
+				chunk.corners[relative.corner][relative.attribute] += offsets[relative.relativeTo];
 			}
+			std::copy(chunk.corners.begin(), chunk.corners.end(), obj.corners.begin() + cornersOffsets[cid]);
+			// Release the chunk memory early.
+			chunk = ObjContent();
+		}
+	}, threadCount);
+}
 
-			// else, query the associated position/uv/normal, store it, update the indices vector and the list of used elements.
-			size_t foundF = str.find_first_of("/");
-			size_t foundL = str.find_last_of("/");
-			
-			//Positions (we are sure they exist)
-			unsigned int ind1 = stoi(str.substr(0,foundF))-1;
-			mesh.positions.push_back(positions_temp[ind1]);
+void MeshUtilities::loadObj( std::istream & in, Mesh & mesh, MeshUtilities::LoadMode mode){
+	// Read the whole stream and parse it in place.
+	const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	MeshUtilities::loadObj(content.c_str(), content.size(), mesh, mode);
+}
 
-			//UVs (second index)
-			if(hasUV){
-				unsigned int ind2 = stoi(str.substr(foundF+1,foundL))-1;
-				mesh.texcoords.push_back(texcoords_temp[ind2]);
+void MeshUtilities::loadObj(const char * data, const size_t size, Mesh & mesh, MeshUtilities::LoadMode mode, const std::string & name){
+	
+	//Init the mesh.
+	mesh.indices.clear();
+	mesh.positions.clear();
+	mesh.normals.clear();
+	mesh.texcoords.clear();
+	
+	if(data == NULL || size == 0){
+		return;
+	}
+	Telemetry::Scope scope(Telemetry::Parse, name);
+	scope.setBytes(size);
+	
+	ObjContent obj;
+	parseObj(data, data + size, obj);
+	buildObjMesh(obj, mesh, mode);
+	
+	Log::Verbose() << Log::Resources << "Mesh loaded with " << mesh.indices.size()/3 << " faces, " << mesh.positions.size() << " vertices, " << mesh.normals.size() << " normals, " << mesh.texcoords.size() << " texcoords." << std::endl;
+
+}
+
+void MeshUtilities::loadObjParallel(const char * data, const size_t size, Mesh & mesh, MeshUtilities::LoadMode mode, unsigned int threadCount, const std::string & name){
+	
+	//Init the mesh.
+	mesh.indices.clear();
+	mesh.positions.clear();
+	mesh.normals.clear();
+	mesh.texcoords.clear();
+	
+	if(data == NULL || size == 0){
+		return;
+	}
+	if(threadCount == 0){
+		threadCount = ThreadUtilities::threadCount();
+	}
+	Telemetry::Scope scope(Telemetry::Parse, name);
+	scope.setBytes(size);
+	
+	ObjContent obj;
+	parseObjParallel(data, data + size, obj, threadCount);
+	buildObjMesh(obj, mesh, mode);
+	
+	Log::Verbose() << Log::Resources << "Mesh loaded on " << threadCount << " threads with " << mesh.indices.size()/3 << " faces, " << mesh.positions.size() << " vertices, " << mesh.normals.size() << " normals, " << mesh.texcoords.size() << " texcoords." << std::endl;
+}
+
+/** \brief Open-addressing hash table associating (position, uv, normal) indices triplets to vertex indices.
+ \details The table uses linear probing over a flat array of entries. Its capacity is set at creation and never grows, so it has to be sized for the maximum number of distinct keys.
+ \ingroup Resources
+ */
+class CornerTable {
+public:
+	
+	/** Constructor.
+	 \param maxCount the maximum number of distinct keys that will be inserted
+	 */
+	CornerTable(const size_t maxCount){
+		// Keep the load factor under 0.5.
+		size_t capacity = 16;
+		while(capacity < 2 * maxCount){
+			capacity *= 2;
+		}
+		_mask = capacity - 1;
+		_entries.resize(capacity);
+	}
+	
+	/** Find the value associated to a key, or insert it with the given value if the key is not present.
+	 \param key the indices triplet
+	 \param value the value to insert if the key is not present
+	 \return the value associated to the key
+	 */
+	unsigned int findOrInsert(const glm::ivec3 & key, const unsigned int value){
+		size_t slot = hash(key) & _mask;
+		while(true){
+			Entry & entry = _entries[slot];
+			if(entry.value == Entry::empty){
+				entry.key = key;
+				entry.value = value;
+				return value;
 			}
-			//Normals (third index, in all cases)
-			if(hasNormals){
-				unsigned int ind3 = stoi(str.substr(foundL+1))-1;
-				mesh.normals.push_back(normals_temp[ind3]);
+			if(entry.key == key){
+				return entry.value;
 			}
+			slot = (slot + 1) & _mask;
+		}
+	}
+	
+private:
+	
+	/** Hash a triplet of indices.
+	 \param key the triplet
+	 \return the hash value
+	 */
+	static size_t hash(const glm::ivec3 & key){
+		unsigned long long h = (unsigned long long)(unsigned int)key[0] * 0x9E3779B97F4A7C15ull;
+		h ^= (unsigned long long)(unsigned int)key[1] * 0xC2B2AE3D27D4EB4Full;
+		h ^= (unsigned long long)(unsigned int)key[2] * 0x165667B19E3779F9ull;
+		h ^= h >> 29;
+		return size_t(h);
+	}
+	
+	/** \brief A table entry, 16 bytes. */
+	struct Entry {
+		static const unsigned int empty = 0xFFFFFFFF; ///< Value denoting an unused entry.
+		glm::ivec3 key; ///< The indices triplet.
+		unsigned int value = empty; ///< The associated value.
+	};
+	
+	std::vector<Entry> _entries; ///< The table entries.
+	size_t _mask; ///< Capacity minus one, the capacity being a power of two.
+};
 
-			mesh.indices.push_back(maxInd);
-			indices_used[str] = maxInd;
-			maxInd++;
+void MeshUtilities::deduplicateCorners(const std::vector<glm::ivec3> & corners, std::vector<unsigned int> & indices, std::vector<glm::ivec3> & uniqueCorners){
+	indices.resize(corners.size());
+	uniqueCorners.clear();
+	// There are at most as many distinct vertices as face corners.
+	CornerTable table(corners.size());
+	unsigned int maxInd = 0;
+	for(size_t cid = 0; cid < corners.size(); ++cid){
+		const glm::ivec3 & corner = corners[cid];
+		const unsigned int index = table.findOrInsert(corner, maxInd);
+		indices[cid] = index;
+		// If the corner was not encountered before, it is a new vertex.
+		if(index == maxInd){
+			uniqueCorners.push_back(corner);
+			++maxInd;
 		}
-		indices_used.clear();
 	}
+}
 
-	positions_temp.clear();
-	normals_temp.clear();
-	texcoords_temp.clear();
-	faces_temp.clear();
-	Log::Verbose() << Log::Resources << "Mesh loaded with " << mesh.indices.size()/3 << " faces, " << mesh.positions.size() << " vertices, " << mesh.normals.size() << " normals, " << mesh.texcoords.size() << " texcoords." << std::endl;
+MeshView::MeshView(const Mesh & mesh){
+	vertexCount = mesh.positions.size();
+	indexCount = mesh.indices.size();
+	positions = mesh.positions.empty() ? nullptr : &mesh.positions[0];
+	normals = mesh.normals.empty() ? nullptr : &mesh.normals[0];
+	tangents = mesh.tangents.empty() ? nullptr : &mesh.tangents[0];
+	binormals = mesh.binormals.empty() ? nullptr : &mesh.binormals[0];
+	texcoords = mesh.texcoords.empty() ? nullptr : &mesh.texcoords[0];
+	indices = mesh.indices.empty() ? nullptr : &mesh.indices[0];
+	levelCount = mesh.levels.size();
+	levels = mesh.levels.empty() ? nullptr : &mesh.levels[0];
+}
 
+// Binary mesh blobs.
+
+/** Alignment of each stream in a mesh blob, in bytes. */
+static const size_t meshBlobAlignment = 16;
+
+bool MeshUtilities::saveMeshBlob(const Mesh & mesh, const BoundingBox & bbox, const uint64_t sourceSize, const uint64_t sourceTime, std::vector<char> & data){
+	const size_t vertexCount = mesh.positions.size();
+	// Streams, in the order of the header offsets.
+	const void * streams[7] = { mesh.positions.data(), mesh.normals.data(), mesh.texcoords.data(), mesh.tangents.data(), mesh.binormals.data(), mesh.indices.data(), mesh.levels.data() };
+	const size_t counts[7] = { mesh.positions.size(), mesh.normals.size(), mesh.texcoords.size(), mesh.tangents.size(), mesh.binormals.size(), mesh.indices.size(), mesh.levels.size() };
+	const size_t sizes[7] = { sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec2), sizeof(glm::vec3), sizeof(glm::vec3), sizeof(unsigned int), sizeof(MeshLevel) };
+	for(size_t sid = 1; sid < 5; ++sid){
+		if(counts[sid] != 0 && counts[sid] != vertexCount){
+			Log::Error() << Log::Resources << "Mesh attributes have different sizes, unable to save the mesh blob." << std::endl;
+			return false;
+		}
+	}
+	
+	MeshBlobHeader header;
+	std::memset(&header, 0, sizeof(MeshBlobHeader));
+	std::memcpy(header.magic, "MESH", 4);
+	header.version = MeshBlobHeader::currentVersion;
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.vertexCount = (uint32_t)vertexCount;
+	header.indexCount = (uint32_t)mesh.indices.size();
+	header.levelCount = (uint32_t)mesh.levels.size();
+	for(int i = 0; i < 3; ++i){
+		header.bboxMin[i] = bbox.minis[i];
+		header.bboxMax[i] = bbox.maxis[i];
+	}
+	// Place each stream at an aligned offset.
+	size_t totalSize = sizeof(MeshBlobHeader);
+	for(size_t sid = 0; sid < 7; ++sid){
+		if(counts[sid] == 0){
+			continue;
+		}
+		totalSize = (totalSize + meshBlobAlignment - 1) / meshBlobAlignment * meshBlobAlignment;
+		header.offsets[sid] = totalSize;
+		totalSize += counts[sid] * sizes[sid];
+	}
+	
+	data.assign(totalSize, 0);
+	std::memcpy(&data[0], &header, sizeof(MeshBlobHeader));
+	for(size_t sid = 0; sid < 7; ++sid){
+		if(counts[sid] != 0){
+			std::memcpy(&data[header.offsets[sid]], streams[sid], counts[sid] * sizes[sid]);
+		}
+	}
+	return true;
+}
+
+bool MeshUtilities::loadMeshBlob(const char * data, const size_t size, MeshView & view, MeshBlobHeader & header){
+	if(data == NULL || size < sizeof(MeshBlobHeader)){
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(MeshBlobHeader));
+	if(std::memcmp(header.magic, "MESH", 4) != 0 || header.version != MeshBlobHeader::currentVersion){
+		return false;
+	}
+	const size_t counts[7] = { header.vertexCount, header.vertexCount, header.vertexCount, header.vertexCount, header.vertexCount, header.indexCount, header.levelCount };
+	const size_t sizes[7] = { sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec2), sizeof(glm::vec3), sizeof(glm::vec3), sizeof(unsigned int), sizeof(MeshLevel) };
+	const void * streams[7] = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+	for(size_t sid = 0; sid < 7; ++sid){
+		const uint64_t offset = header.offsets[sid];
+		if(offset == 0){
+			continue;
+		}
+		// Check that the stream is aligned and fits in the blob.
+		if(offset % meshBlobAlignment != 0 || offset > size || uint64_t(counts[sid]) * sizes[sid] > size - offset){
+			return false;
+		}
+		streams[sid] = data + offset;
+	}
+	// Check that levels of detail reference valid indices.
+	const MeshLevel * levels = (const MeshLevel*)streams[6];
+	for(size_t lid = 0; lid < header.levelCount && levels != nullptr; ++lid){
+		if(uint64_t(levels[lid].firstIndex) + levels[lid].indexCount > header.indexCount){
+			return false;
+		}
+	}
+	view = MeshView();
+	view.vertexCount = header.vertexCount;
+	view.indexCount = header.indexCount;
+	view.positions = (const glm::vec3*)streams[0];
+	view.normals = (const glm::vec3*)streams[1];
+	view.texcoords = (const glm::vec2*)streams[2];
+	view.tangents = (const glm::vec3*)streams[3];
+	view.binormals = (const glm::vec3*)streams[4];
+	view.indices = (const unsigned int*)streams[5];
+	view.levelCount = header.levelCount;
+	view.levels = (const MeshLevel*)streams[6];
+	return true;
 }
 
 BoundingBox MeshUtilities::computeBoundingBox(Mesh & mesh){
@@ -224,57 +759,868 @@ void MeshUtilities::centerAndUnitMesh(Mesh & mesh){
 	}
 }
 
-void MeshUtilities::computeTangentsAndBinormals(Mesh & mesh){
-	if(mesh.indices.size() * mesh.positions.size() * mesh.texcoords.size() == 0){
-		// Missing data, or not the right mode (Points).
-		return;
-	}
-	// Start by filling everything with 0 (as we want to accumulate tangents and binormals coming from different faces for each vertex).
-	for(size_t pid = 0; pid < mesh.positions.size(); ++pid){
-		mesh.tangents.push_back(glm::vec3(0.0f));
-		mesh.binormals.push_back(glm::vec3(0.0f));
-	}
-	// Then, compute both vectors for each face and accumulate them.
-	for(size_t fid = 0; fid < mesh.indices.size(); fid += 3){
+// Tangent frames computation.
 
-		// Get the vertices of the face.
-		glm::vec3 & v0 = mesh.positions[mesh.indices[fid]];
-		glm::vec3 & v1 = mesh.positions[mesh.indices[fid+1]];
-		glm::vec3 & v2 = mesh.positions[mesh.indices[fid+2]];
-		// Get the uvs of the face.
-		glm::vec2 & uv0 = mesh.texcoords[mesh.indices[fid]];
-		glm::vec2 & uv1 = mesh.texcoords[mesh.indices[fid+1]];
-		glm::vec2 & uv2 = mesh.texcoords[mesh.indices[fid+2]];
+/** \brief Per-face tangents and binormals, stored as structure of arrays.
+ \ingroup Resources
+ */
+struct FaceTangents {
+	float * tx; ///< Tangents x coordinates.
+	float * ty; ///< Tangents y coordinates.
+	float * tz; ///< Tangents z coordinates.
+	float * bx; ///< Binormals x coordinates.
+	float * by; ///< Binormals y coordinates.
+	float * bz; ///< Binormals z coordinates.
+};
 
+/** Compute the unnormalized tangent and binormal of a range of faces, from their positions and texture coordinates.
+ \param positions the mesh positions
+ \param texcoords the mesh texture coordinates
+ \param faces the faces indices
+ \param begin the first face to process
+ \param end the face after the last one to process
+ \param out will contain the tangents and binormals
+ \note Four faces are processed at once with SSE instructions when available. The operations are the same as in the scalar path, so both give the same results.
+ */
+void computeFaceTangents(const glm::vec3 * positions, const glm::vec2 * texcoords, const unsigned int * faces, const size_t begin, const size_t end, const FaceTangents & out){
+	size_t fid = begin;
+#ifdef MESH_UTILITIES_SSE
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 threshold = _mm_set1_ps(0.001f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	for(; fid + 4 <= end; fid += 4){
+		const unsigned int * f = &faces[3 * fid];
+		// Gather the vertices of the four faces, one component per register.
+#define GATHER(array, corner, comp) _mm_setr_ps(array[f[corner]].comp, array[f[3 + corner]].comp, array[f[6 + corner]].comp, array[f[9 + corner]].comp)
+		const __m128 p0x = GATHER(positions, 0, x), p0y = GATHER(positions, 0, y), p0z = GATHER(positions, 0, z);
+		const __m128 dp1x = _mm_sub_ps(GATHER(positions, 1, x), p0x);
+		const __m128 dp1y = _mm_sub_ps(GATHER(positions, 1, y), p0y);
+		const __m128 dp1z = _mm_sub_ps(GATHER(positions, 1, z), p0z);
+		const __m128 dp2x = _mm_sub_ps(GATHER(positions, 2, x), p0x);
+		const __m128 dp2y = _mm_sub_ps(GATHER(positions, 2, y), p0y);
+		const __m128 dp2z = _mm_sub_ps(GATHER(positions, 2, z), p0z);
+		const __m128 uv0x = GATHER(texcoords, 0, x), uv0y = GATHER(texcoords, 0, y);
+		const __m128 du1x = _mm_sub_ps(GATHER(texcoords, 1, x), uv0x);
+		const __m128 du1y = _mm_sub_ps(GATHER(texcoords, 1, y), uv0y);
+		const __m128 du2x = _mm_sub_ps(GATHER(texcoords, 2, x), uv0x);
+		const __m128 du2y = _mm_sub_ps(GATHER(texcoords, 2, y), uv0y);
+#undef GATHER
+		// Avoid divide-by-zero if same UVs.
+		const __m128 denom = _mm_sub_ps(_mm_mul_ps(du1x, du2y), _mm_mul_ps(du1y, du2x));
+		const __m128 degenerate = _mm_cmplt_ps(_mm_andnot_ps(signMask, denom), threshold);
+		const __m128 det = _mm_or_ps(_mm_and_ps(degenerate, one), _mm_andnot_ps(degenerate, _mm_div_ps(one, denom)));
+		
+		_mm_storeu_ps(out.tx + fid, _mm_mul_ps(det, _mm_sub_ps(_mm_mul_ps(dp1x, du2y), _mm_mul_ps(dp2x, du1y))));
+		_mm_storeu_ps(out.ty + fid, _mm_mul_ps(det, _mm_sub_ps(_mm_mul_ps(dp1y, du2y), _mm_mul_ps(dp2y, du1y))));
+		_mm_storeu_ps(out.tz + fid, _mm_mul_ps(det, _mm_sub_ps(_mm_mul_ps(dp1z, du2y), _mm_mul_ps(dp2z, du1y))));
+		_mm_storeu_ps(out.bx + fid, _mm_mul_ps(det, _mm_sub_ps(_mm_mul_ps(dp2x, du1x), _mm_mul_ps(dp1x, du2x))));
+		_mm_storeu_ps(out.by + fid, _mm_mul_ps(det, _mm_sub_ps(_mm_mul_ps(dp2y, du1x), _mm_mul_ps(dp1y, du2x))));
+		_mm_storeu_ps(out.bz + fid, _mm_mul_ps(det, _mm_sub_ps(_mm_mul_ps(dp2z, du1x), _mm_mul_ps(dp1z, du2x))));
+	}
+#endif
+	for(; fid < end; ++fid){
+		const unsigned int * f = &faces[3 * fid];
 		// Delta positions and uvs.
-		glm::vec3 deltaPosition1 = v1 - v0;
-		glm::vec3 deltaPosition2 = v2 - v0;
-		glm::vec2 deltaUv1 = uv1 - uv0;
-		glm::vec2 deltaUv2 = uv2 - uv0;
-
+		const glm::vec3 deltaPosition1 = positions[f[1]] - positions[f[0]];
+		const glm::vec3 deltaPosition2 = positions[f[2]] - positions[f[0]];
+		const glm::vec2 deltaUv1 = texcoords[f[1]] - texcoords[f[0]];
+		const glm::vec2 deltaUv2 = texcoords[f[2]] - texcoords[f[0]];
 		// Compute tangent and binormal for the face.
 		const float denom = deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x;
 		// Avoid divide-by-zero if same UVs.
-		float det = (abs(denom) < 0.001f) ? 1.0f : (1.0f / denom);
-    	glm::vec3 tangent = det * (deltaPosition1 * deltaUv2.y   - deltaPosition2 * deltaUv1.y);
-    	glm::vec3 binormal = det * (deltaPosition2 * deltaUv1.x   - deltaPosition1 * deltaUv2.x);
-
-    	// Accumulate them. We don't normalize to get a free weighting based on the size of the face.
-    	mesh.tangents[mesh.indices[fid]] += tangent;
-    	mesh.tangents[mesh.indices[fid+1]] += tangent;
-    	mesh.tangents[mesh.indices[fid+2]] += tangent;
-
-    	mesh.binormals[mesh.indices[fid]] += binormal;
-    	mesh.binormals[mesh.indices[fid+1]] += binormal;
-    	mesh.binormals[mesh.indices[fid+2]] += binormal;
-	}
-	// Finally, enforce orthogonality and good orientation of the basis.
-	for(size_t tid = 0; tid < mesh.tangents.size(); ++tid){
-		mesh.tangents[tid] = normalize(mesh.tangents[tid] - mesh.normals[tid] * dot(mesh.normals[tid], mesh.tangents[tid]));
-		if(dot(cross(mesh.normals[tid], mesh.tangents[tid]), mesh.binormals[tid]) < 0.0f){
-			mesh.tangents[tid] *= -1.0f;
- 		}
+		const float det = (abs(denom) < 0.001f) ? 1.0f : (1.0f / denom);
+		const glm::vec3 tangent = det * (deltaPosition1 * deltaUv2.y - deltaPosition2 * deltaUv1.y);
+		const glm::vec3 binormal = det * (deltaPosition2 * deltaUv1.x - deltaPosition1 * deltaUv2.x);
+		out.tx[fid] = tangent.x; out.ty[fid] = tangent.y; out.tz[fid] = tangent.z;
+		out.bx[fid] = binormal.x; out.by[fid] = binormal.y; out.bz[fid] = binormal.z;
 	}
+}
+
+/** Compute the angle of a face at one of its corners.
+ \param positions the mesh positions
+ \param face the face indices
+ \param corner the corner index in the face
+ \return the angle in radians
+ */
+float cornerAngle(const std::vector<glm::vec3> & positions, const unsigned int * face, const size_t corner){
+	const glm::vec3 & p = positions[face[corner]];
+	const glm::vec3 e1 = positions[face[(corner + 1) % 3]] - p;
+	const glm::vec3 e2 = positions[face[(corner + 2) % 3]] - p;
+	const float l1 = glm::length(e1);
+	const float l2 = glm::length(e2);
+	if(l1 == 0.0f || l2 == 0.0f){
+		return 0.0f;
+	}
+	return std::acos(glm::clamp(glm::dot(e1, e2) / (l1 * l2), -1.0f, 1.0f));
+}
+
+void MeshUtilities::computeTangentsAndBinormals(Mesh & mesh, const TangentMode mode, unsigned int threadCount, const std::string & name){
+	const size_t vertexCount = mesh.positions.size();
+	if(mesh.indices.empty() || vertexCount == 0 || mesh.texcoords.size() != vertexCount || mesh.normals.size() != vertexCount){
+		// Missing data, or not the right mode (Points).
+		return;
+	}
+	if(threadCount == 0){
+		threadCount = ThreadUtilities::threadCount();
+	}
+	Telemetry::Scope scope(Telemetry::Tangents, name);
+	scope.setBytes(2 * vertexCount * sizeof(glm::vec3));
+	// Only the faces of the most detailed level contribute.
+	const size_t firstIndex = mesh.levels.empty() ? 0 : mesh.levels[0].firstIndex;
+	const size_t faceCount = (mesh.levels.empty() ? mesh.indices.size() : mesh.levels[0].indexCount) / 3;
+	const unsigned int * faces = &mesh.indices[firstIndex];
+	
+	// Each thread owns a range of vertices, and accumulates the contributions of the faces to them in the same order as a serial loop would.
+	// No synchronization is needed, and the result doesn't depend on the number of threads.
+	mesh.tangents.resize(vertexCount);
+	mesh.binormals.resize(vertexCount);
+	ThreadUtilities::parallelFor(vertexCount, [&](size_t begin, size_t end, unsigned int){
+		std::fill(mesh.tangents.begin() + begin, mesh.tangents.begin() + end, glm::vec3(0.0f));
+		std::fill(mesh.binormals.begin() + begin, mesh.binormals.begin() + end, glm::vec3(0.0f));
+		// Faces are processed by blocks small enough to stay in cache. Blocks that don't reference any owned vertex are skipped.
+		const size_t blockSize = 256;
+		std::vector<float> blockData(6 * blockSize);
+		const FaceTangents faceTangents = { &blockData[0], &blockData[blockSize], &blockData[2 * blockSize], &blockData[3 * blockSize], &blockData[4 * blockSize], &blockData[5 * blockSize] };
+		
+		for(size_t blockBegin = 0; blockBegin < faceCount; blockBegin += blockSize){
+			const size_t blockCount = (std::min)(blockSize, faceCount - blockBegin);
+			const unsigned int * blockFaces = &faces[3 * blockBegin];
+			bool owned = false;
+			for(size_t iid = 0; iid < 3 * blockCount && !owned; ++iid){
+				owned = blockFaces[iid] >= begin && blockFaces[iid] < end;
+			}
+			if(!owned){
+				continue;
+			}
+			computeFaceTangents(&mesh.positions[0], &mesh.texcoords[0], blockFaces, 0, blockCount, faceTangents);
+			
+			for(size_t fid = 0; fid < blockCount; ++fid){
+				const unsigned int * face = &blockFaces[3 * fid];
+				for(size_t corner = 0; corner < 3; ++corner){
+					const unsigned int vid = face[corner];
+					if(vid < begin || vid >= end){
+						continue;
+					}
+					const glm::vec3 faceTangent(faceTangents.tx[fid], faceTangents.ty[fid], faceTangents.tz[fid]);
+					const glm::vec3 faceBinormal(faceTangents.bx[fid], faceTangents.by[fid], faceTangents.bz[fid]);
+					if(mode == Accumulated){
+						// We don't normalize to get a free weighting based on the size of the face.
+						mesh.tangents[vid] += faceTangent;
+						mesh.binormals[vid] += faceBinormal;
+						continue;
+					}
+					// Project the face vectors in the tangent plane of the vertex, and weight them by the angle of the face at the vertex.
+					const glm::vec3 & n = mesh.normals[vid];
+					const float angle = cornerAngle(mesh.positions, face, corner);
+					const glm::vec3 projTangent = faceTangent - n * dot(n, faceTangent);
+					const glm::vec3 projBinormal = faceBinormal - n * dot(n, faceBinormal);
+					const float lengthTangent = length(projTangent);
+					const float lengthBinormal = length(projBinormal);
+					mesh.tangents[vid] += lengthTangent > 0.0f ? (angle / lengthTangent) * projTangent : glm::vec3(0.0f);
+					mesh.binormals[vid] += lengthBinormal > 0.0f ? (angle / lengthBinormal) * projBinormal : glm::vec3(0.0f);
+				}
+			}
+		}
+		
+		// Enforce orthogonality and good orientation of the basis.
+		for(size_t vid = begin; vid < end; ++vid){
+			const glm::vec3 & n = mesh.normals[vid];
+			const glm::vec3 & binormal = mesh.binormals[vid];
+			glm::vec3 & tangent = mesh.tangents[vid];
+			tangent = normalize(tangent - n * dot(n, tangent));
+			const float orientation = dot(cross(n, tangent), binormal) < 0.0f ? -1.0f : 1.0f;
+			if(mode == Accumulated){
+				tangent *= orientation;
+			} else {
+				// The binormal is derived from the normal and tangent, with the orientation given by the texture coordinates.
+				mesh.binormals[vid] = orientation * cross(n, tangent);
+			}
+		}
+	}, threadCount);
 	Log::Verbose() << Log::Resources << "Mesh: " << mesh.tangents.size() << " tangents and binormals computed." << std::endl;
 }
 
+// Levels of detail generation.
+
+/** \brief Symmetric 4x4 matrix representing the sum of squared distances to a set of planes, and the total weight of the planes.
+ \ingroup Resources
+ */
+struct Quadric {
+	double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0; ///< First row.
+	double b2 = 0.0, bc = 0.0, bd = 0.0; ///< Second row.
+	double c2 = 0.0, cd = 0.0; ///< Third row.
+	double d2 = 0.0; ///< Fourth row.
+	double weight = 0.0; ///< Sum of the planes weights.
+	
+	/** Add a weighted plane to the quadric.
+	 \param n the plane unit normal
+	 \param d the plane offset
+	 \param w the plane weight
+	 */
+	void addPlane(const glm::dvec3 & n, const double d, const double w){
+		a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+		b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+		c2 += w * n.z * n.z; cd += w * n.z * d;
+		d2 += w * d * d;
+		weight += w;
+	}
+	
+	/** Accumulate another quadric.
+	 \param q the quadric to add
+	 */
+	void add(const Quadric & q){
+		a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+		b2 += q.b2; bc += q.bc; bd += q.bd;
+		c2 += q.c2; cd += q.cd;
+		d2 += q.d2;
+		weight += q.weight;
+	}
+	
+	/** Evaluate the mean squared distance of a point to the planes.
+	 \param p the point
+	 \return the weighted mean squared distance
+	 */
+	double evaluate(const glm::vec3 & p) const {
+		const double x = p.x, y = p.y, z = p.z;
+		const double e = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+			+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+			+ c2 * z * z + 2.0 * cd * z + d2;
+		return weight > 0.0 ? std::abs(e) / weight : 0.0;
+	}
+};
+
+/** \brief A candidate edge collapse, moving a vertex onto another one.
+ \ingroup Resources
+ */
+struct Collapse {
+	double cost; ///< The error of the collapse.
+	unsigned int from; ///< The vertex that will be removed.
+	unsigned int to; ///< The vertex that will be kept.
+	
+	/** Order collapses by decreasing cost, for use in a priority queue.
+	 \param other the collapse to compare to
+	 \return true if this collapse is more expensive
+	 */
+	bool operator<(const Collapse & other) const {
+		return cost > other.cost;
+	}
+};
+
+/** Simplify a triangle mesh by collapsing edges onto existing vertices, until a target triangle count or a maximum error is reached.
+ \param positions the mesh vertices positions
+ \param indices the triangles indices
+ \param targetCount the target number of triangles
+ \param maxError the maximum squared error of a collapse, in squared mesh units
+ \param result will contain the simplified triangles indices
+ \return the maximum squared error of the performed collapses
+ */
+double simplifyIndices(const std::vector<glm::vec3> & positions, const std::vector<unsigned int> & indices, const size_t targetCount, const double maxError, std::vector<unsigned int> & result){
+	const size_t vertexCount = positions.size();
+	const size_t triangleCount = indices.size() / 3;
+	std::vector<unsigned int> triangles(indices.begin(), indices.begin() + 3 * triangleCount);
+	std::vector<bool> alive(triangleCount, true);
+	
+	// Vertex to triangles adjacency. Lists are extended when collapses occur, and can contain removed triangles.
+	std::vector<std::vector<unsigned int>> adjacency(vertexCount);
+	for(size_t tid = 0; tid < triangleCount; ++tid){
+		for(size_t k = 0; k < 3; ++k){
+			adjacency[triangles[3 * tid + k]].push_back((unsigned int)tid);
+		}
+	}
+	
+	// Lock vertices on borders and non-manifold edges, this includes attribute seams where vertices are duplicated.
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, unsigned int> edges;
+		edges.reserve(3 * triangleCount);
+		for(size_t tid = 0; tid < triangleCount; ++tid){
+			for(size_t k = 0; k < 3; ++k){
+				const uint64_t v0 = triangles[3 * tid + k];
+				const uint64_t v1 = triangles[3 * tid + (k + 1) % 3];
+				++edges[(std::min)(v0, v1) << 32 | (std::max)(v0, v1)];
+			}
+		}
+		for(const auto & edge : edges){
+			if(edge.second != 2){
+				locked[edge.first >> 32] = true;
+				locked[edge.first & 0xFFFFFFFF] = true;
+			}
+		}
+	}
+	
+	// Accumulate the planes of adjacent triangles, weighted by their area.
+	std::vector<Quadric> quadrics(vertexCount);
+	for(size_t tid = 0; tid < triangleCount; ++tid){
+		const glm::dvec3 p0(positions[triangles[3 * tid]]);
+		const glm::dvec3 p1(positions[triangles[3 * tid + 1]]);
+		const glm::dvec3 p2(positions[triangles[3 * tid + 2]]);
+		const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const double area = glm::length(normal);
+		if(area == 0.0){
+			continue;
+		}
+		const glm::dvec3 n = normal / area;
+		const double d = -glm::dot(n, p0);
+		for(size_t k = 0; k < 3; ++k){
+			quadrics[triangles[3 * tid + k]].addPlane(n, d, area);
+		}
+	}
+	
+	// Candidate collapses, along each triangle edge in both directions.
+	auto collapseCost = [&quadrics, &positions](const unsigned int from, const unsigned int to){
+		Quadric q = quadrics[from];
+		q.add(quadrics[to]);
+		return q.evaluate(positions[to]);
+	};
+	std::priority_queue<Collapse> queue;
+	auto pushCollapses = [&](const unsigned int vid){
+		for(const unsigned int tid : adjacency[vid]){
+			if(!alive[tid]){
+				continue;
+			}
+			for(size_t k = 0; k < 3; ++k){
+				const unsigned int other = triangles[3 * tid + k];
+				if(other == vid){
+					continue;
+				}
+				if(!locked[vid]){
+					queue.push({ collapseCost(vid, other), vid, other });
+				}
+				if(!locked[other]){
+					queue.push({ collapseCost(other, vid), other, vid });
+				}
+			}
+		}
+	};
+	for(size_t tid = 0; tid < triangleCount; ++tid){
+		for(size_t k = 0; k < 3; ++k){
+			const unsigned int from = triangles[3 * tid + k];
+			const unsigned int to = triangles[3 * tid + (k + 1) % 3];
+			if(!locked[from]){
+				queue.push({ collapseCost(from, to), from, to });
+			}
+			if(!locked[to]){
+				queue.push({ collapseCost(to, from), to, from });
+			}
+		}
+	}
+	
+	std::vector<bool> removed(vertexCount, false);
+	std::vector<unsigned int> neighbours;
+	size_t aliveCount = triangleCount;
+	double reachedError = 0.0;
+	
+	while(aliveCount > targetCount && !queue.empty()){
+		const Collapse collapse = queue.top();
+		queue.pop();
+		if(collapse.cost > maxError){
+			break;
+		}
+		const unsigned int from = collapse.from;
+		const unsigned int to = collapse.to;
+		if(removed[from] || removed[to]){
+			continue;
+		}
+		// Skip outdated entries, the up-to-date ones have been pushed after the last modification.
+		if(std::abs(collapseCost(from, to) - collapse.cost) > 1e-6 * (collapse.cost + 1e-12)){
+			continue;
+		}
+		
+		// Check that the two vertices are still connected, and that they only share the neighbours of their common triangles, to preserve the topology.
+		size_t sharedTriangles = 0;
+		neighbours.clear();
+		for(const unsigned int tid : adjacency[from]){
+			if(!alive[tid]){
+				continue;
+			}
+			bool hasTo = false;
+			for(size_t k = 0; k < 3; ++k){
+				const unsigned int vid = triangles[3 * tid + k];
+				hasTo = hasTo || (vid == to);
+				if(vid != from){
+					neighbours.push_back(vid);
+				}
+			}
+			sharedTriangles += hasTo ? 1 : 0;
+		}
+		if(sharedTriangles == 0){
+			continue;
+		}
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		size_t sharedNeighbours = 0;
+		for(const unsigned int tid : adjacency[to]){
+			if(!alive[tid]){
+				continue;
+			}
+			for(size_t k = 0; k < 3; ++k){
+				const unsigned int vid = triangles[3 * tid + k];
+				if(vid != to && vid != from && std::binary_search(neighbours.begin(), neighbours.end(), vid)){
+					++sharedNeighbours;
+					// Mark the neighbour as counted.
+					neighbours.erase(std::lower_bound(neighbours.begin(), neighbours.end(), vid));
+				}
+			}
+		}
+		if(sharedNeighbours != sharedTriangles){
+			continue;
+		}
+		
+		// Reject collapses that would flip or degenerate the remaining triangles around the removed vertex.
+		bool valid = true;
+		for(const unsigned int tid : adjacency[from]){
+			if(!alive[tid]){
+				continue;
+			}
+			const unsigned int * tri = &triangles[3 * tid];
+			if(tri[0] == to || tri[1] == to || tri[2] == to){
+				continue;
+			}
+			glm::vec3 p[3];
+			glm::vec3 q[3];
+			for(size_t k = 0; k < 3; ++k){
+				p[k] = positions[tri[k]];
+				q[k] = tri[k] == from ? positions[to] : p[k];
+			}
+			const glm::vec3 n0 = glm::cross(p[1] - p[0], p[2] - p[0]);
+			const glm::vec3 n1 = glm::cross(q[1] - q[0], q[2] - q[0]);
+			if(glm::dot(n0, n1) <= 0.25f * glm::length(n0) * glm::length(n1)){
+				valid = false;
+				break;
+			}
+		}
+		if(!valid){
+			continue;
+		}
+		
+		// Perform the collapse.
+		for(const unsigned int tid : adjacency[from]){
+			if(!alive[tid]){
+				continue;
+			}
+			unsigned int * tri = &triangles[3 * tid];
+			if(tri[0] == to || tri[1] == to || tri[2] == to){
+				alive[tid] = false;
+				--aliveCount;
+				continue;
+			}
+			for(size_t k = 0; k < 3; ++k){
+				if(tri[k] == from){
+					tri[k] = to;
+				}
+			}
+			adjacency[to].push_back(tid);
+		}
+		adjacency[from].clear();
+		removed[from] = true;
+		quadrics[to].add(quadrics[from]);
+		reachedError = (std::max)(reachedError, collapse.cost);
+		// Update the costs around the kept vertex.
+		pushCollapses(to);
+	}
+	
+	result.clear();
+	result.reserve(3 * aliveCount);
+	for(size_t tid = 0; tid < triangleCount; ++tid){
+		if(alive[tid]){
+			result.insert(result.end(), triangles.begin() + 3 * tid, triangles.begin() + 3 * tid + 3);
+		}
+	}
+	return reachedError;
+}
+
+void MeshUtilities::generateLevels(Mesh & mesh, const unsigned int levelCount, const float maxError){
+	if(mesh.indices.empty() || mesh.positions.empty()){
+		return;
+	}
+	// The original triangles form the first level.
+	if(mesh.levels.empty()){
+		mesh.levels.push_back({ 0, (uint32_t)mesh.indices.size(), 0.0f });
+	}
+	const std::vector<unsigned int> original(mesh.indices.begin() + mesh.levels[0].firstIndex, mesh.indices.begin() + mesh.levels[0].firstIndex + mesh.levels[0].indexCount);
+	const BoundingBox bbox = MeshUtilities::computeBoundingBox(mesh);
+	const double scale = (std::max)(double(glm::length(bbox.maxis - bbox.minis)), 1e-12);
+	const double maxSquaredError = double(maxError) * double(maxError) * scale * scale;
+	
+	std::vector<unsigned int> simplified;
+	while(mesh.levels.size() < levelCount){
+		// Each level is simplified from the original triangles, targeting half the triangles of the previous level.
+		const size_t previousCount = mesh.levels.back().indexCount / 3;
+		const double error = simplifyIndices(mesh.positions, original, previousCount / 2, maxSquaredError, simplified);
+		// Stop if the error limit prevents any significant simplification.
+		if(simplified.empty() || simplified.size() / 3 > (previousCount * 9) / 10){
+			break;
+		}
+		mesh.levels.push_back({ (uint32_t)mesh.indices.size(), (uint32_t)simplified.size(), float(std::sqrt(error) / scale) });
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+	}
+	for(size_t lid = 0; lid < mesh.levels.size(); ++lid){
+		Log::Verbose() << Log::Resources << "Mesh: level " << lid << ", " << mesh.levels[lid].indexCount / 3 << " triangles, error " << mesh.levels[lid].error << "." << std::endl;
+	}
+}
+
+// Vertex cache, overdraw and vertex fetch optimizations.
+
+/** Index ranges of each level of detail of a mesh.
+ \param mesh the mesh
+ \return the first index and index count of each level
+ */
+std::vector<std::pair<size_t, size_t>> meshLevelRanges(const Mesh & mesh){
+	std::vector<std::pair<size_t, size_t>> ranges;
+	if(mesh.levels.empty()){
+		ranges.emplace_back(0, mesh.indices.size());
+	}
+	for(const MeshLevel & level : mesh.levels){
+		ranges.emplace_back(level.firstIndex, level.indexCount);
+	}
+	return ranges;
+}
+
+void MeshUtilities::analyzeVertexCache(const Mesh & mesh, const unsigned int cacheSize, float & acmr, float & atvr){
+	acmr = atvr = 0.0f;
+	const size_t vertexCount = mesh.positions.size();
+	// Only the most detailed level is analyzed.
+	const std::pair<size_t, size_t> range = meshLevelRanges(mesh)[0];
+	if(range.second == 0 || vertexCount == 0){
+		return;
+	}
+	// Simulate a FIFO cache, storing for each vertex the time at which it entered the cache.
+	std::vector<size_t> insertionTime(vertexCount, 0);
+	size_t time = cacheSize + 1;
+	size_t misses = 0;
+	std::vector<bool> used(vertexCount, false);
+	for(size_t iid = range.first; iid < range.first + range.second; ++iid){
+		const unsigned int index = mesh.indices[iid];
+		if(time - insertionTime[index] > cacheSize){
+			insertionTime[index] = time;
+			++time;
+			++misses;
+		}
+		used[index] = true;
+	}
+	const size_t usedCount = size_t(std::count(used.begin(), used.end(), true));
+	acmr = float(misses) / float(range.second / 3);
+	atvr = float(misses) / float(usedCount);
+}
+
+/** \brief Compute the score of vertices for the vertex cache optimization, following T. Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006.
+ \ingroup Resources
+ */
+class ForsythScore {
+public:
+	
+	/** Constructor.
+	 \param cacheSize the size of the simulated LRU cache
+	 */
+	ForsythScore(const unsigned int cacheSize) : _cacheSize(cacheSize) {
+		_cacheScores.resize(cacheSize);
+		for(unsigned int i = 0; i < cacheSize; ++i){
+			if(i < 3){
+				// Vertices of the last triangle get a fixed score, to avoid favoring the same triangle strip direction.
+				_cacheScores[i] = 0.75f;
+			} else {
+				const float scaler = 1.0f / float(cacheSize - 3);
+				_cacheScores[i] = std::pow(1.0f - float(i - 3) * scaler, 1.5f);
+			}
+		}
+		for(unsigned int i = 0; i < 32; ++i){
+			_valenceScores[i] = 2.0f * std::pow(float(i), -0.5f);
+		}
+	}
+	
+	/** Compute the score of a vertex.
+	 \param cachePosition the position of the vertex in the cache (or -1 if not cached)
+	 \param remainingValence the number of triangles not yet added that use the vertex
+	 \return the vertex score
+	 */
+	float operator()(const int cachePosition, const unsigned int remainingValence) const {
+		if(remainingValence == 0){
+			return -1.0f;
+		}
+		const float cacheScore = cachePosition >= 0 && cachePosition < int(_cacheSize) ? _cacheScores[cachePosition] : 0.0f;
+		// Favor vertices with few remaining triangles, to avoid leaving isolated ones.
+		const float valenceScore = remainingValence < 32 ? _valenceScores[remainingValence] : 2.0f * std::pow(float(remainingValence), -0.5f);
+		return cacheScore + valenceScore;
+	}
+	
+private:
+	
+	const unsigned int _cacheSize; ///< The cache size.
+	std::vector<float> _cacheScores; ///< Scores based on the position in the cache.
+	float _valenceScores[32]; ///< Scores based on the remaining valence, for small valences.
+};
+
+/** Reorder a list of triangles to improve the vertex cache locality.
+ \param indices the triangles indices, will be reordered
+ \param vertexCount the number of vertices of the mesh
+ \param cacheSize the number of vertices in the simulated LRU cache
+ */
+void optimizeVertexCacheIndices(std::vector<unsigned int> & indices, const size_t vertexCount, const unsigned int cacheSize){
+	const size_t triangleCount = indices.size() / 3;
+	if(triangleCount == 0 || vertexCount == 0 || cacheSize < 4){
+		return;
+	}
+	
+	// Build the vertex to triangles adjacency, in compressed form.
+	std::vector<unsigned int> valences(vertexCount, 0);
+	for(const unsigned int index : indices){
+		++valences[index];
+	}
+	std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+	for(size_t vid = 0; vid < vertexCount; ++vid){
+		adjacencyOffsets[vid + 1] = adjacencyOffsets[vid] + valences[vid];
+	}
+	std::vector<unsigned int> adjacency(indices.size());
+	{
+		std::vector<size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for(size_t tid = 0; tid < triangleCount; ++tid){
+			for(size_t k = 0; k < 3; ++k){
+				adjacency[fill[indices[3 * tid + k]]++] = (unsigned int)tid;
+			}
+		}
+	}
+	
+	// Initial scores.
+	const ForsythScore score(cacheSize);
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for(size_t vid = 0; vid < vertexCount; ++vid){
+		vertexScores[vid] = score(-1, valences[vid]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	for(size_t tid = 0; tid < triangleCount; ++tid){
+		triangleScores[tid] = vertexScores[indices[3 * tid]] + vertexScores[indices[3 * tid + 1]] + vertexScores[indices[3 * tid + 2]];
+	}
+	std::vector<bool> emitted(triangleCount, false);
+	
+	// The cache is slightly larger, to hold the vertices of the new triangle before trimming.
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	cache.reserve(cacheSize + 3);
+	newCache.reserve(cacheSize + 3);
+	
+	std::vector<unsigned int> newIndices;
+	newIndices.reserve(indices.size());
+	size_t nextCandidate = 0;
+	
+	for(size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount){
+		// Find the best triangle among the ones adjacent to cached vertices.
+		int bestTriangle = -1;
+		float bestScore = -1.0f;
+		for(const unsigned int vid : cache){
+			for(size_t aid = adjacencyOffsets[vid]; aid < adjacencyOffsets[vid + 1]; ++aid){
+				const unsigned int tid = adjacency[aid];
+				if(!emitted[tid] && triangleScores[tid] > bestScore){
+					bestScore = triangleScores[tid];
+					bestTriangle = int(tid);
+				}
+			}
+		}
+		// Else, restart from the next triangle in input order.
+		if(bestTriangle < 0){
+			while(emitted[nextCandidate]){
+				++nextCandidate;
+			}
+			bestTriangle = int(nextCandidate);
+		}
+		
+		// Emit the triangle and update the valences.
+		emitted[bestTriangle] = true;
+		const unsigned int * triangle = &indices[3 * bestTriangle];
+		for(size_t k = 0; k < 3; ++k){
+			const unsigned int vid = triangle[k];
+			newIndices.push_back(vid);
+			--valences[vid];
+		}
+		
+		// Move the triangle vertices at the front of the cache.
+		newCache.clear();
+		newCache.insert(newCache.end(), triangle, triangle + 3);
+		for(const unsigned int vid : cache){
+			if(vid != triangle[0] && vid != triangle[1] && vid != triangle[2]){
+				newCache.push_back(vid);
+			}
+		}
+		std::swap(cache, newCache);
+		
+		// Update the scores of cached and evicted vertices, and of their triangles.
+		for(size_t cid = 0; cid < cache.size(); ++cid){
+			const unsigned int vid = cache[cid];
+			cachePositions[vid] = cid < cacheSize ? int(cid) : -1;
+			vertexScores[vid] = score(cachePositions[vid], valences[vid]);
+		}
+		for(const unsigned int vid : cache){
+			for(size_t aid = adjacencyOffsets[vid]; aid < adjacencyOffsets[vid + 1]; ++aid){
+				const unsigned int tid = adjacency[aid];
+				if(!emitted[tid]){
+					triangleScores[tid] = vertexScores[indices[3 * tid]] + vertexScores[indices[3 * tid + 1]] + vertexScores[indices[3 * tid + 2]];
+				}
+			}
+		}
+		if(cache.size() > cacheSize){
+			cache.resize(cacheSize);
+		}
+	}
+	indices.swap(newIndices);
+}
+
+void MeshUtilities::optimizeVertexCache(Mesh & mesh, const unsigned int cacheSize){
+	// Each level of detail is processed independently.
+	for(const auto & range : meshLevelRanges(mesh)){
+		std::vector<unsigned int> indices(mesh.indices.begin() + range.first, mesh.indices.begin() + range.first + range.second);
+		optimizeVertexCacheIndices(indices, mesh.positions.size(), cacheSize);
+		std::copy(indices.begin(), indices.end(), mesh.indices.begin() + range.first);
+	}
+}
+
+/** Reorder clusters of triangles to reduce overdraw.
+ \param indices the triangles indices, will be reordered
+ \param positions the mesh vertices positions
+ \param cacheSize the number of vertices in the simulated FIFO cache
+ \return the number of clusters
+ */
+size_t optimizeOverdrawIndices(std::vector<unsigned int> & indices, const std::vector<glm::vec3> & positions, const unsigned int cacheSize){
+	const size_t vertexCount = positions.size();
+	const size_t triangleCount = indices.size() / 3;
+	if(triangleCount == 0 || vertexCount == 0){
+		return 0;
+	}
+	
+	// Split the triangles in clusters, at each point where the vertex cache is fully flushed (all three vertices of a triangle are misses).
+	// Reordering clusters only loses the vertex reuse carried across their boundaries. As the first triangle of each cluster already misses all its vertices, the degradation is bounded by this threshold, to a few misses per cluster.
+	std::vector<size_t> clusters;
+	std::vector<size_t> insertionTime(vertexCount, 0);
+	size_t time = cacheSize + 1;
+	for(size_t tid = 0; tid < triangleCount; ++tid){
+		int misses = 0;
+		for(size_t k = 0; k < 3; ++k){
+			const unsigned int vid = indices[3 * tid + k];
+			if(time - insertionTime[vid] > cacheSize){
+				insertionTime[vid] = time;
+				++time;
+				++misses;
+			}
+		}
+		if(misses == 3 || tid == 0){
+			clusters.push_back(tid);
+		}
+	}
+	const size_t clusterCount = clusters.size();
+	clusters.push_back(triangleCount);
+	
+	// Mesh centroid.
+	glm::vec3 meshCenter(0.0f);
+	for(const glm::vec3 & position : positions){
+		meshCenter += position;
+	}
+	meshCenter /= float(vertexCount);
+	
+	// Clusters facing away from the center of the mesh should be drawn first, as they are more likely to occlude others.
+	std::vector<float> sortKeys(clusterCount);
+	for(size_t cid = 0; cid < clusterCount; ++cid){
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for(size_t tid = clusters[cid]; tid < clusters[cid + 1]; ++tid){
+			const glm::vec3 & p0 = positions[indices[3 * tid]];
+			const glm::vec3 & p1 = positions[indices[3 * tid + 1]];
+			const glm::vec3 & p2 = positions[indices[3 * tid + 2]];
+			const glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+			const float triangleArea = glm::length(areaNormal);
+			center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += areaNormal;
+			area += triangleArea;
+		}
+		center = area > 0.0f ? center / area : positions[indices[3 * clusters[cid]]];
+		const float normalLength = glm::length(normal);
+		sortKeys[cid] = normalLength > 0.0f ? glm::dot(center - meshCenter, normal / normalLength) : 0.0f;
+	}
+	std::vector<size_t> order(clusterCount);
+	for(size_t cid = 0; cid < clusterCount; ++cid){
+		order[cid] = cid;
+	}
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](const size_t a, const size_t b){
+		return sortKeys[a] > sortKeys[b];
+	});
+	
+	std::vector<unsigned int> newIndices;
+	newIndices.reserve(indices.size());
+	for(const size_t cid : order){
+		newIndices.insert(newIndices.end(), indices.begin() + 3 * clusters[cid], indices.begin() + 3 * clusters[cid + 1]);
+	}
+	indices.swap(newIndices);
+	return clusterCount;
+}
+
+void MeshUtilities::optimizeOverdraw(Mesh & mesh, const unsigned int cacheSize){
+	size_t clusterCount = 0;
+	for(const auto & range : meshLevelRanges(mesh)){
+		std::vector<unsigned int> indices(mesh.indices.begin() + range.first, mesh.indices.begin() + range.first + range.second);
+		clusterCount += optimizeOverdrawIndices(indices, mesh.positions, cacheSize);
+		std::copy(indices.begin(), indices.end(), mesh.indices.begin() + range.first);
+	}
+	Log::Verbose() << Log::Resources << "Mesh: " << clusterCount << " clusters sorted for overdraw." << std::endl;
+}
+
+/** Reorder the elements of an attribute array.
+ \param attribute the attribute values to reorder
+ \param remap the new index of each element
+ \param count the number of elements
+ */
+template<typename T>
+void remapAttribute(std::vector<T> & attribute, const std::vector<unsigned int> & remap, const size_t count){
+	if(attribute.size() != count){
+		return;
+	}
+	std::vector<T> newAttribute(count);
+	for(size_t vid = 0; vid < count; ++vid){
+		newAttribute[remap[vid]] = attribute[vid];
+	}
+	attribute.swap(newAttribute);
+}
+
+void MeshUtilities::optimizeVertexFetch(Mesh & mesh){
+	const size_t vertexCount = mesh.positions.size();
+	if(mesh.indices.empty() || vertexCount == 0){
+		return;
+	}
+	// Number vertices in order of first use. Unused vertices are kept at the end.
+	const unsigned int unassigned = 0xFFFFFFFF;
+	std::vector<unsigned int> remap(vertexCount, unassigned);
+	unsigned int nextIndex = 0;
+	for(unsigned int & index : mesh.indices){
+		if(remap[index] == unassigned){
+			remap[index] = nextIndex++;
+		}
+		index = remap[index];
+	}
+	for(size_t vid = 0; vid < vertexCount; ++vid){
+		if(remap[vid] == unassigned){
+			remap[vid] = nextIndex++;
+		}
+	}
+	remapAttribute(mesh.positions, remap, vertexCount);
+	remapAttribute(mesh.normals, remap, vertexCount);
+	remapAttribute(mesh.texcoords, remap, vertexCount);
+	remapAttribute(mesh.tangents, remap, vertexCount);
+	remapAttribute(mesh.binormals, remap, vertexCount);
+}
+
+void MeshUtilities::optimizeMesh(Mesh & mesh, const bool reduceOverdraw){
+	if(mesh.indices.empty()){
+		return;
+	}
+	// Statistics are measured on a FIFO cache similar to the post-transform cache of GPUs.
+	const unsigned int analysisCacheSize = 16;
+	float acmrBefore, atvrBefore, acmrAfter, atvrAfter;
+	MeshUtilities::analyzeVertexCache(mesh, analysisCacheSize, acmrBefore, atvrBefore);
+	
+	MeshUtilities::optimizeVertexCache(mesh);
+	if(reduceOverdraw){
+		MeshUtilities::optimizeOverdraw(mesh, analysisCacheSize);
+	}
+	MeshUtilities::optimizeVertexFetch(mesh);
+	
+	MeshUtilities::analyzeVertexCache(mesh, analysisCacheSize, acmrAfter, atvrAfter);
+	Log::Verbose() << Log::Resources << "Mesh: vertex cache optimized, ACMR " << acmrBefore << " -> " << acmrAfter << ", ATVR " << atvrBefore << " -> " << atvrAfter << "." << std::endl;
+}
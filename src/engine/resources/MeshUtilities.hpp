@@ -2,6 +2,7 @@
 #define MeshUtilities_h
 
 #include "../Common.hpp"
+#include <cstdint>
 
 /**
  \brief Represent the sphere of smallest radius containing a given object or region of space.
@@ -91,6 +92,16 @@ struct BoundingBox {
 	}
 };
 
+/**
+ \brief A level of detail of a mesh, as a range of its indices. All levels share the same vertices.
+ \ingroup Resources
+ */
+struct MeshLevel {
+	uint32_t firstIndex; ///< The first index of the level.
+	uint32_t indexCount; ///< The number of indices of the level.
+	float error; ///< The geometric error introduced by the simplification, relative to the mesh size.
+};
+
 /**
  \brief Represents a geometric mesh composed of vertices and triangles. For now, material information and elements/groups are not represented.
  \ingroup Resources
@@ -102,8 +113,53 @@ struct Mesh {
 	std::vector<glm::vec3> binormals;  ///< The surface binormals.
 	std::vector<glm::vec2> texcoords;  ///< The texture coordinates.
 	std::vector<unsigned int> indices; ///< The triangular faces indices.
+	std::vector<MeshLevel> levels; ///< The levels of detail, from the most detailed one. If empty, all indices form a single level.
 };
 
+/**
+ \brief Non-owning view on the attribute streams of a mesh, for instance stored in a memory-mapped file. All non-null attribute streams contain vertexCount elements.
+ \ingroup Resources
+ */
+struct MeshView {
+	const glm::vec3 * positions = nullptr; ///< The 3D positions.
+	const glm::vec3 * normals = nullptr; ///< The surface normals.
+	const glm::vec3 * tangents = nullptr; ///< The surface tangents.
+	const glm::vec3 * binormals = nullptr; ///< The surface binormals.
+	const glm::vec2 * texcoords = nullptr; ///< The texture coordinates.
+	const unsigned int * indices = nullptr; ///< The triangular faces indices.
+	const MeshLevel * levels = nullptr; ///< The levels of detail.
+	size_t vertexCount = 0; ///< The number of vertices.
+	size_t indexCount = 0; ///< The number of indices.
+	size_t levelCount = 0; ///< The number of levels of detail.
+	
+	/** Default constructor. */
+	MeshView() {}
+	
+	/** Create a view on the content of a mesh.
+	 \param mesh the mesh to reference, should outlive the view
+	 */
+	MeshView(const Mesh & mesh);
+};
+
+/**
+ \brief Header of a preprocessed binary mesh (.mesh file). It is followed by the attribute streams, each aligned on 16 bytes, in the order: positions, normals, texcoords, tangents, binormals, indices, levels of detail. Values are stored in little-endian order.
+ \ingroup Resources
+ */
+struct MeshBlobHeader {
+	char magic[4]; ///< Should be "MESH".
+	uint32_t version; ///< The format version.
+	uint64_t sourceSize; ///< Size of the source file the blob was generated from.
+	uint64_t sourceTime; ///< Modification time of the source file the blob was generated from.
+	uint32_t vertexCount; ///< The number of vertices.
+	uint32_t indexCount; ///< The number of indices.
+	uint32_t levelCount; ///< The number of levels of detail.
+	uint32_t reserved; ///< Unused.
+	uint64_t offsets[7]; ///< Offset of each stream from the beginning of the blob, 0 if absent.
+	float bboxMin[3]; ///< Lower corner of the bounding box.
+	float bboxMax[3]; ///< Upper corner of the bounding box.
+	
+	static const uint32_t currentVersion = 3; ///< The version written by this code.
+};
 
 /**
  \brief Provides utilities to load and process geometric meshes.
@@ -127,6 +183,52 @@ public:
 	 */
 	static void loadObj(std::istream & in, Mesh & mesh, LoadMode mode);
 	
+	/** Load .obj data from a memory buffer into a mesh structure. The text is parsed in place, without any per-line allocation.
+	 \param data the .obj text content (does not have to be null-terminated)
+	 \param size the size of the content in bytes
+	 \param mesh will be populated with the loaded geometry
+	 \param mode the preprocessing mode
+	 \param name the mesh name, used by telemetry if no asset is loaded on this thread
+	 */
+	static void loadObj(const char * data, const size_t size, Mesh & mesh, LoadMode mode, const std::string & name = "mesh");
+	
+	/** Load .obj data from a memory buffer into a mesh structure, splitting the text in line-aligned chunks parsed on multiple threads. The result is identical to the one of the serial version.
+	 \param data the .obj text content (does not have to be null-terminated)
+	 \param size the size of the content in bytes
+	 \param mesh will be populated with the loaded geometry
+	 \param mode the preprocessing mode
+	 \param threadCount the number of threads to use (0 to use all available hardware threads)
+	 \param name the mesh name, used by telemetry if no asset is loaded on this thread
+	 */
+	static void loadObjParallel(const char * data, const size_t size, Mesh & mesh, LoadMode mode, unsigned int threadCount = 0, const std::string & name = "mesh");
+	
+	/** Find the distinct (position, uv, normal) indices triplets among a list of face corners. Distinct triplets are numbered in order of first appearance.
+	 \param corners the (position, uv, normal) indices of each face corner
+	 \param indices will contain the index of the distinct triplet used by each corner
+	 \param uniqueCorners will contain the distinct triplets
+	 \note Lookups use an open-addressing hash table sized from the number of corners.
+	 */
+	static void deduplicateCorners(const std::vector<glm::ivec3> & corners, std::vector<unsigned int> & indices, std::vector<glm::ivec3> & uniqueCorners);
+	
+	/** Serialize a processed mesh and its bounding box in the binary .mesh format.
+	 \param mesh the mesh to serialize
+	 \param bbox the mesh bounding box
+	 \param sourceSize size of the source file, used to detect outdated blobs
+	 \param sourceTime modification time of the source file, used to detect outdated blobs
+	 \param data will contain the blob content
+	 \return false if the mesh attributes don't all have the same number of elements
+	 */
+	static bool saveMeshBlob(const Mesh & mesh, const BoundingBox & bbox, const uint64_t sourceSize, const uint64_t sourceTime, std::vector<char> & data);
+	
+	/** Reference the content of a binary .mesh blob, without any copy. The blob has to outlive the view.
+	 \param data the blob content, aligned on at least 16 bytes
+	 \param size the size of the content in bytes
+	 \param view will point to the attribute streams
+	 \param header will contain the blob header
+	 \return false if the blob is invalid, truncated or from another format version
+	 */
+	static bool loadMeshBlob(const char * data, const size_t size, MeshView & view, MeshBlobHeader & header);
+	
 	/** Compute the axi-aligned bounding box of a mesh.
 	 \param mesh the mesh
 	 \return the bounding box
@@ -138,10 +240,60 @@ public:
 	 */
 	static void centerAndUnitMesh(Mesh & mesh);
 
-	/** Compute the tangent and binormal vectors for each vertex of a mesh.
+	/// \brief The tangent frames computation method.
+	enum TangentMode {
+		Accumulated, ///< Sum the unnormalized tangents of adjacent faces, implicitly weighted by their size.
+		MikkTSpace ///< Average the normalized tangents of adjacent faces projected on the normal plane, weighted by corner angles, as in MikkTSpace. The binormal is the cross product of the normal and tangent.
+	};
+	
+	/** Compute the tangent and binormal vectors for each vertex of a mesh. Vertices are split in ranges processed in parallel, each accumulating the contributions of its faces in a deterministic order.
+	 \param mesh the mesh to process
+	 \param mode the computation method
+	 \param threadCount the number of threads to use (0 to use all available hardware threads)
+	 \param name the mesh name, used by telemetry if no asset is loaded on this thread
+	 */
+	static void computeTangentsAndBinormals(Mesh & mesh, const TangentMode mode = Accumulated, unsigned int threadCount = 0, const std::string & name = "mesh");
+	
+	/** Generate simplified levels of detail of a mesh, using quadric error metrics edge collapses. Each level targets half the triangles of the previous one. The new levels are appended to the mesh indices, and reuse its vertices.
+	 \param mesh the mesh to process
+	 \param levelCount the maximum number of levels, including the original one
+	 \param maxError the maximum geometric error of a level, relative to the mesh bounding box diagonal
+	 \note Vertices on borders and attribute seams are locked. Based on M. Garland and P. Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997.
+	 */
+	static void generateLevels(Mesh & mesh, const unsigned int levelCount, const float maxError);
+	
+	/** Measure the efficiency of the post-transform vertex cache when rendering the most detailed level of a mesh, simulating a FIFO cache.
+	 \param mesh the mesh to analyze
+	 \param cacheSize the number of vertices in the simulated cache
+	 \param acmr will contain the average cache miss ratio (transformed vertices per triangle, between 0.5 and 3)
+	 \param atvr will contain the average transformed vertex ratio (transformed vertices per vertex, 1 is optimal)
+	 */
+	static void analyzeVertexCache(const Mesh & mesh, const unsigned int cacheSize, float & acmr, float & atvr);
+	
+	/** Reorder the triangles of each level of a mesh to improve the post-transform vertex cache locality.
+	 \param mesh the mesh to process
+	 \param cacheSize the number of vertices in the simulated LRU cache
+	 \note Based on T. Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006.
+	 */
+	static void optimizeVertexCache(Mesh & mesh, const unsigned int cacheSize = 32);
+	
+	/** Reorder clusters of triangles so that triangles facing outward are drawn first, to reduce overdraw. Clusters are delimited by vertex cache flushes, so the cache efficiency is preserved.
+	 \param mesh the mesh to process, should already be optimized for the vertex cache
+	 \param cacheSize the number of vertices in the simulated FIFO cache
+	 \note Based on P. Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007.
+	 */
+	static void optimizeOverdraw(Mesh & mesh, const unsigned int cacheSize = 16);
+	
+	/** Reorder the vertices of a mesh in order of first use by the triangles, so that vertex buffers are accessed in increasing order.
+	 \param mesh the mesh to process
+	 */
+	static void optimizeVertexFetch(Mesh & mesh);
+	
+	/** Run the vertex cache, overdraw and vertex fetch optimizations on a mesh, and log the cache statistics before and after.
 	 \param mesh the mesh to process
+	 \param reduceOverdraw should triangles clusters be sorted to reduce overdraw
 	 */
-	static void computeTangentsAndBinormals(Mesh & mesh);
+	static void optimizeMesh(Mesh & mesh, const bool reduceOverdraw = true);
 	
 };
 
@@ -0,0 +1,524 @@
+#include "MipmapUtilities.hpp"
+#include "../helpers/ThreadUtilities.hpp"
+#include "../helpers/HalfFloat.hpp"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+/// SSE instructions are available.
+#define MIPMAP_UTILITIES_SSE
+#endif
+
+/// Alpha value used as the alpha test reference when preserving coverage.
+const float mipmapCoverageReference = 0.5f;
+
+/// \brief Filter taps along one axis: each destination texel is a weighted sum of consecutive source texels.
+struct MipmapAxis {
+	std::vector<int> firsts; ///< First source texel of each destination texel.
+	std::vector<float> weights; ///< Weights of the source texels, stride values per destination texel.
+	int stride = 0; ///< Maximum number of taps per destination texel.
+	int padding = 0; ///< Number of texels read outside the source on each side.
+};
+
+/** Normalized sinc function.
+ \param x the position
+ \return the sinc value
+ */
+float mipmapSinc(const float x){
+	if(std::abs(x) < 1e-5f){
+		return 1.0f;
+	}
+	const float px = float(M_PI) * x;
+	return std::sin(px) / px;
+}
+
+/** Modified Bessel function of the first kind of order 0.
+ \param x the position
+ \return the function value
+ */
+float mipmapBessel0(const float x){
+	float sum = 1.0f;
+	float term = 1.0f;
+	for(int k = 1; k < 32; ++k){
+		const float factor = x / (2.0f * float(k));
+		term *= factor * factor;
+		sum += term;
+		if(term < 1e-7f * sum){
+			break;
+		}
+	}
+	return sum;
+}
+
+/** Query the support radius of a kernel.
+ \param filter the kernel
+ \return the radius in destination texels
+ */
+float mipmapRadius(const MipmapUtilities::Filter filter){
+	return filter == MipmapUtilities::Box ? 0.5f : 3.0f;
+}
+
+/** Evaluate a kernel.
+ \param filter the kernel
+ \param t the distance to the kernel center, in destination texels
+ \return the kernel weight
+ */
+float mipmapKernel(const MipmapUtilities::Filter filter, const float t){
+	const float radius = mipmapRadius(filter);
+	const float at = std::abs(t);
+	if(filter == MipmapUtilities::Box){
+		return at <= radius ? 1.0f : 0.0f;
+	}
+	if(at >= radius){
+		return 0.0f;
+	}
+	if(filter == MipmapUtilities::Lanczos){
+		return mipmapSinc(t) * mipmapSinc(t / radius);
+	}
+	// Kaiser window, with alpha = 4.
+	const float alpha = 4.0f;
+	const float ratio = t / radius;
+	return mipmapSinc(t) * mipmapBessel0(alpha * std::sqrt(1.0f - ratio * ratio)) / mipmapBessel0(alpha);
+}
+
+/** Compute the filter taps to downsample along one axis.
+ \param srcSize the source size
+ \param dstSize the destination size
+ \param filter the kernel
+ \param axis will contain the taps
+ */
+void computeMipmapAxis(const unsigned int srcSize, const unsigned int dstSize, const MipmapUtilities::Filter filter, MipmapAxis & axis){
+	const float scale = float(srcSize) / float(dstSize);
+	const float support = mipmapRadius(filter) * scale;
+	axis.stride = int(std::ceil(2.0f * support)) + 2;
+	axis.firsts.resize(dstSize);
+	axis.weights.assign(size_t(dstSize) * size_t(axis.stride), 0.0f);
+	axis.padding = 0;
+	for(unsigned int x = 0; x < dstSize; ++x){
+		const float center = (float(x) + 0.5f) * scale;
+		const int first = int(std::floor(center - support));
+		float * weights = &axis.weights[size_t(x) * size_t(axis.stride)];
+		float total = 0.0f;
+		int last = first;
+		for(int k = 0; k < axis.stride; ++k){
+			const float w = mipmapKernel(filter, (float(first + k) + 0.5f - center) / scale);
+			weights[k] = w;
+			total += w;
+			if(w != 0.0f){
+				last = first + k;
+			}
+		}
+		if(total == 0.0f){
+			// Degenerate case, use the nearest texel.
+			weights[int(center) - first] = total = 1.0f;
+		}
+		for(int k = 0; k < axis.stride; ++k){
+			weights[k] /= total;
+		}
+		axis.firsts[x] = first;
+		axis.padding = (std::max)(axis.padding, (std::max)(-first, last - int(srcSize) + 1));
+	}
+}
+
+/** Access the sRGB to linear conversion table.
+ \return the linear value of each 8-bits sRGB value
+ */
+const std::vector<float> & srgbToLinearTable(){
+	static std::vector<float> table;
+	static std::once_flag flag;
+	std::call_once(flag, [](){
+		table.resize(256);
+		for(int i = 0; i < 256; ++i){
+			const float c = float(i) / 255.0f;
+			table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+	});
+	return table;
+}
+
+/** Access the linear to sRGB conversion thresholds.
+ \return the linear value halfway between each pair of consecutive 8-bits sRGB values
+ */
+const std::vector<float> & linearToSRGBThresholds(){
+	static std::vector<float> thresholds;
+	static std::once_flag flag;
+	std::call_once(flag, [](){
+		thresholds.resize(255);
+		for(int i = 0; i < 255; ++i){
+			const float c = (float(i) + 0.5f) / 255.0f;
+			thresholds[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+	});
+	return thresholds;
+}
+
+/** Convert pixels of an image to linear RGBA floats.
+ \param image the image
+ \param offset the index of the first pixel
+ \param count the number of pixels
+ \param sRGB is the LDR image gamma encoded
+ \param dst the destination RGBA floats
+ */
+void convertToLinear(const DecodedImage & image, const size_t offset, const size_t count, const bool sRGB, float * dst){
+	const unsigned int channels = image.channels;
+	if(!image.hdr){
+		const std::vector<float> & table = srgbToLinearTable();
+		const unsigned char * src = static_cast<const unsigned char *>(image.data) + offset * channels;
+		for(size_t i = 0; i < count; ++i){
+			for(unsigned int c = 0; c < 3; ++c){
+				const unsigned char value = src[i * channels + (std::min)(c, channels - 1)];
+				dst[4 * i + c] = sRGB ? table[value] : float(value) / 255.0f;
+			}
+			dst[4 * i + 3] = channels == 4 ? float(src[i * channels + 3]) / 255.0f : 1.0f;
+		}
+		return;
+	}
+	// Convert half floats by chunks, then expand to RGBA.
+	const size_t chunk = 64;
+	float values[4 * chunk];
+	for(size_t start = 0; start < count; start += chunk){
+		const size_t chunkCount = (std::min)(chunk, count - start);
+		const float * src = values;
+		if(image.half){
+			HalfFloat::toFloats(static_cast<const uint16_t *>(image.data) + (offset + start) * channels, chunkCount * channels, values);
+		} else {
+			src = static_cast<const float *>(image.data) + (offset + start) * channels;
+		}
+		for(size_t i = 0; i < chunkCount; ++i){
+			float * out = dst + 4 * (start + i);
+			for(unsigned int c = 0; c < 3; ++c){
+				out[c] = src[i * channels + (std::min)(c, channels - 1)];
+			}
+			out[3] = channels == 4 ? src[i * channels + 3] : 1.0f;
+		}
+	}
+}
+
+/** Convert linear RGBA floats to pixels of an image.
+ \param src the RGBA floats
+ \param count the number of pixels
+ \param sRGB should the LDR image be gamma encoded
+ \param image the image
+ \param offset the index of the first pixel
+ */
+void convertFromLinear(const float * src, const size_t count, const bool sRGB, DecodedImage & image, const size_t offset){
+	const unsigned int channels = image.channels;
+	if(!image.hdr){
+		const std::vector<float> & thresholds = linearToSRGBThresholds();
+		unsigned char * dst = static_cast<unsigned char *>(image.data) + offset * channels;
+		for(size_t i = 0; i < count; ++i){
+			for(unsigned int c = 0; c < (std::min)(channels, 3u); ++c){
+				const float value = src[4 * i + c];
+				if(sRGB){
+					// Exact rounding: count the thresholds below the value.
+					dst[i * channels + c] = (unsigned char)(std::upper_bound(thresholds.begin(), thresholds.end(), value) - thresholds.begin());
+				} else {
+					dst[i * channels + c] = (unsigned char)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+				}
+			}
+			if(channels == 4){
+				dst[i * channels + 3] = (unsigned char)(glm::clamp(src[4 * i + 3], 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+		}
+		return;
+	}
+	// Negative values due to ringing are removed.
+	const size_t chunk = 64;
+	float values[4 * chunk];
+	for(size_t start = 0; start < count; start += chunk){
+		const size_t chunkCount = (std::min)(chunk, count - start);
+		float * dst = image.half ? values : static_cast<float *>(image.data) + (offset + start) * channels;
+		for(size_t i = 0; i < chunkCount; ++i){
+			for(unsigned int c = 0; c < channels; ++c){
+				dst[i * channels + c] = (std::max)(src[4 * (start + i) + c], 0.0f);
+			}
+		}
+		if(image.half){
+			HalfFloat::fromFloats(values, chunkCount * channels, static_cast<uint16_t *>(image.data) + (offset + start) * channels);
+		}
+	}
+}
+
+/** Find the texel of a cubemap corresponding to a position outside of a face, by extending the face plane.
+ \param face the face index, in the +X,-X,+Y,-Y,+Z,-Z order
+ \param x the horizontal texel position, can be outside the face
+ \param y the vertical texel position, can be outside the face
+ \param size the size of the faces
+ \param pixel will contain the face index and the texel index in this face
+ */
+void cubemapTexel(const int face, const int x, const int y, const int size, std::pair<int, size_t> & pixel){
+	const float u = 2.0f * (float(x) + 0.5f) / float(size) - 1.0f;
+	const float v = 2.0f * (float(y) + 0.5f) / float(size) - 1.0f;
+	// Direction of the texel, following the OpenGL cubemap layout.
+	static const glm::vec3 axesU[6] = { {0,0,-1}, {0,0,1}, {1,0,0}, {1,0,0}, {1,0,0}, {-1,0,0} };
+	static const glm::vec3 axesV[6] = { {0,-1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}, {0,-1,0}, {0,-1,0} };
+	static const glm::vec3 normals[6] = { {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+	const glm::vec3 dir = normals[face] + u * axesU[face] + v * axesV[face];
+	// Find the face the direction points to.
+	const glm::vec3 absDir = glm::abs(dir);
+	int newFace = 0;
+	if(absDir.x >= absDir.y && absDir.x >= absDir.z){
+		newFace = dir.x > 0.0f ? 0 : 1;
+	} else if(absDir.y >= absDir.z){
+		newFace = dir.y > 0.0f ? 2 : 3;
+	} else {
+		newFace = dir.z > 0.0f ? 4 : 5;
+	}
+	const float major = glm::dot(dir, normals[newFace]);
+	const float s = 0.5f * (glm::dot(dir, axesU[newFace]) / major + 1.0f);
+	const float t = 0.5f * (glm::dot(dir, axesV[newFace]) / major + 1.0f);
+	const int nx = glm::clamp(int(std::floor(s * float(size))), 0, size - 1);
+	const int ny = glm::clamp(int(std::floor(t * float(size))), 0, size - 1);
+	pixel.first = newFace;
+	pixel.second = size_t(ny) * size_t(size) + size_t(nx);
+}
+
+/** Filter a source row horizontally.
+ \param row the padded source row, in linear RGBA
+ \param axis the horizontal taps
+ \param count the number of destination texels
+ \param dst the destination row, in linear RGBA
+ */
+void filterMipmapRow(const float * row, const MipmapAxis & axis, const size_t count, float * dst){
+	for(size_t x = 0; x < count; ++x){
+		const float * weights = &axis.weights[x * size_t(axis.stride)];
+		const float * src = row + 4 * size_t(axis.firsts[x] + axis.padding);
+#ifdef MIPMAP_UTILITIES_SSE
+		__m128 sum = _mm_setzero_ps();
+		for(int k = 0; k < axis.stride; ++k){
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(src + 4 * k)));
+		}
+		_mm_storeu_ps(dst + 4 * x, sum);
+#else
+		float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for(int k = 0; k < axis.stride; ++k){
+			for(int c = 0; c < 4; ++c){
+				sum[c] += weights[k] * src[4 * k + c];
+			}
+		}
+		std::memcpy(dst + 4 * x, sum, sizeof(sum));
+#endif
+	}
+}
+
+/** Accumulate a weighted row.
+ \param src the row to add
+ \param weight the row weight
+ \param count the number of floats
+ \param dst the accumulated row
+ */
+void accumulateMipmapRow(const float * src, const float weight, const size_t count, float * dst){
+	size_t i = 0;
+#ifdef MIPMAP_UTILITIES_SSE
+	const __m128 w = _mm_set1_ps(weight);
+	for(; i + 4 <= count; i += 4){
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+	}
+#endif
+	for(; i < count; ++i){
+		dst[i] += weight * src[i];
+	}
+}
+
+/** Compute the alpha histogram of a LDR RGBA image.
+ \param image the image
+ \param histogram will contain the number of texels for each alpha value
+ */
+void alphaHistogram(const DecodedImage & image, std::vector<size_t> & histogram){
+	histogram.assign(256, 0);
+	const unsigned char * data = static_cast<const unsigned char *>(image.data);
+	const size_t count = size_t(image.width) * size_t(image.height);
+	for(size_t i = 0; i < count; ++i){
+		++histogram[data[4 * i + 3]];
+	}
+}
+
+/** Compute the fraction of texels passing the alpha test once their alpha is scaled.
+ \param histogram the alpha histogram
+ \param scale the alpha scale
+ \return the alpha coverage
+ */
+float alphaCoverage(const std::vector<size_t> & histogram, const float scale){
+	size_t passed = 0;
+	size_t total = 0;
+	for(size_t a = 0; a < histogram.size(); ++a){
+		total += histogram[a];
+		if(float(a) / 255.0f * scale > mipmapCoverageReference){
+			passed += histogram[a];
+		}
+	}
+	return total == 0 ? 0.0f : float(passed) / float(total);
+}
+
+void MipmapUtilities::levelSizes(const unsigned int width, const unsigned int height, std::vector<glm::uvec2> & sizes){
+	sizes.clear();
+	glm::uvec2 size(width, height);
+	sizes.push_back(size);
+	while(size.x > 1 || size.y > 1){
+		size = glm::max(size / 2u, glm::uvec2(1));
+		sizes.push_back(size);
+	}
+}
+
+bool MipmapUtilities::parseFilter(const std::string & name, Filter & filter){
+	if(name == "box"){
+		filter = Box;
+	} else if(name == "kaiser"){
+		filter = Kaiser;
+	} else if(name == "lanczos"){
+		filter = Lanczos;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool MipmapUtilities::generate(std::vector<DecodedImage> & images, const bool cubemap, const bool sRGB, const Filter filter, const bool preserveCoverage){
+	const size_t faceCount = cubemap ? 6 : 1;
+	if(images.size() != faceCount){
+		return false;
+	}
+	for(const DecodedImage & image : images){
+		if(image.data == NULL || image.status != 0 || image.width != images[0].width || image.height != images[0].height || image.hdr != images[0].hdr || image.half != images[0].half || image.channels != images[0].channels || image.channels == 0 || image.channels > 4){
+			return false;
+		}
+	}
+	if(cubemap && images[0].width != images[0].height){
+		return false;
+	}
+	std::vector<glm::uvec2> sizes;
+	levelSizes(images[0].width, images[0].height, sizes);
+	images.reserve(faceCount * sizes.size());
+	// Linear LDR images and HDR images are not gamma encoded.
+	const bool gamma = sRGB && !images[0].hdr;
+	
+	// Alpha coverage of the first level, for cutout textures.
+	std::vector<float> coverages(faceCount, 0.0f);
+	const bool checkCoverage = preserveCoverage && !images[0].hdr && images[0].channels == 4;
+	if(checkCoverage){
+		std::vector<size_t> histogram;
+		for(size_t fid = 0; fid < faceCount; ++fid){
+			alphaHistogram(images[fid], histogram);
+			coverages[fid] = alphaCoverage(histogram, 1.0f);
+		}
+	}
+	
+	for(size_t lid = 1; lid < sizes.size(); ++lid){
+		const size_t srcFirst = (lid - 1) * faceCount;
+		const unsigned int srcWidth = sizes[lid - 1].x;
+		const unsigned int srcHeight = sizes[lid - 1].y;
+		const unsigned int dstWidth = sizes[lid].x;
+		const unsigned int dstHeight = sizes[lid].y;
+		for(size_t fid = 0; fid < faceCount; ++fid){
+			DecodedImage level = images[srcFirst];
+			level.width = dstWidth;
+			level.height = dstHeight;
+			level.data = malloc(level.size());
+			images.push_back(level);
+		}
+		MipmapAxis axisX;
+		MipmapAxis axisY;
+		computeMipmapAxis(srcWidth, dstWidth, filter, axisX);
+		computeMipmapAxis(srcHeight, dstHeight, filter, axisY);
+		
+		// Each thread processes consecutive destination rows, keeping the horizontally filtered source rows in a window.
+		ThreadUtilities::parallelFor(faceCount * dstHeight, [&](size_t begin, size_t end, unsigned int){
+			const int padding = axisX.padding;
+			const int windowSize = axisY.stride;
+			std::vector<float> padded(4 * (size_t(srcWidth) + 2 * size_t(padding)));
+			std::vector<float> window(4 * size_t(dstWidth) * size_t(windowSize));
+			std::vector<int> windowRows(windowSize);
+			std::vector<float> accumulated(4 * size_t(dstWidth));
+			size_t currentFace = faceCount;
+			std::pair<int, size_t> texel;
+			
+			// Fill the padded row with the linear texels of a source row, then filter it horizontally.
+			const auto computeRow = [&](const size_t fid, const int y, float * dst){
+				const DecodedImage & src = images[srcFirst + fid];
+				const bool inside = y >= 0 && y < int(srcHeight);
+				float * row = &padded[4 * size_t(padding)];
+				if(!cubemap){
+					const int clampedY = glm::clamp(y, 0, int(srcHeight) - 1);
+					convertToLinear(src, size_t(clampedY) * srcWidth, srcWidth, gamma, row);
+					for(int x = 1; x <= padding; ++x){
+						std::memcpy(row - 4 * x, row, 4 * sizeof(float));
+						std::memcpy(row + 4 * (int(srcWidth) - 1 + x), row + 4 * (int(srcWidth) - 1), 4 * sizeof(float));
+					}
+				} else {
+					if(inside){
+						convertToLinear(src, size_t(y) * srcWidth, srcWidth, gamma, row);
+					}
+					// Texels outside the face are fetched from its neighbours.
+					for(int x = -padding; x < int(srcWidth) + padding; ++x){
+						if(inside && x >= 0 && x < int(srcWidth)){
+							continue;
+						}
+						cubemapTexel(int(fid), x, y, int(srcWidth), texel);
+						convertToLinear(images[srcFirst + size_t(texel.first)], texel.second, 1, gamma, row + 4 * x);
+					}
+				}
+				filterMipmapRow(&padded[0], axisX, dstWidth, dst);
+			};
+			
+			for(size_t rid = begin; rid < end; ++rid){
+				const size_t fid = rid / dstHeight;
+				const unsigned int y = (unsigned int)(rid % dstHeight);
+				if(fid != currentFace){
+					std::fill(windowRows.begin(), windowRows.end(), std::numeric_limits<int>::min());
+					currentFace = fid;
+				}
+				std::fill(accumulated.begin(), accumulated.end(), 0.0f);
+				const float * weights = &axisY.weights[size_t(y) * size_t(axisY.stride)];
+				for(int k = 0; k < axisY.stride; ++k){
+					if(weights[k] == 0.0f){
+						continue;
+					}
+					const int srcY = axisY.firsts[y] + k;
+					const int slot = ((srcY % windowSize) + windowSize) % windowSize;
+					float * windowRow = &window[4 * size_t(dstWidth) * size_t(slot)];
+					if(windowRows[slot] != srcY){
+						computeRow(fid, srcY, windowRow);
+						windowRows[slot] = srcY;
+					}
+					accumulateMipmapRow(windowRow, weights[k], 4 * size_t(dstWidth), &accumulated[0]);
+				}
+				convertFromLinear(&accumulated[0], dstWidth, gamma, images[srcFirst + faceCount + fid], size_t(y) * dstWidth);
+			}
+		});
+		
+		if(!checkCoverage){
+			continue;
+		}
+		// Scale the alpha of the new level so that the same fraction of texels passes the alpha test.
+		std::vector<size_t> histogram;
+		for(size_t fid = 0; fid < faceCount; ++fid){
+			if(coverages[fid] <= 0.0f || coverages[fid] >= 1.0f){
+				continue;
+			}
+			DecodedImage & level = images[srcFirst + faceCount + fid];
+			alphaHistogram(level, histogram);
+			float low = 0.0f;
+			float high = 4.0f;
+			for(int i = 0; i < 20; ++i){
+				const float middle = 0.5f * (low + high);
+				if(alphaCoverage(histogram, middle) < coverages[fid]){
+					low = middle;
+				} else {
+					high = middle;
+				}
+			}
+			// Texels often share the same alpha, round up so that cutouts don't vanish in small levels.
+			const float scale = high;
+			unsigned char * data = static_cast<unsigned char *>(level.data);
+			const size_t count = size_t(level.width) * size_t(level.height);
+			for(size_t i = 0; i < count; ++i){
+				data[4 * i + 3] = (unsigned char)((std::min)(float(data[4 * i + 3]) * scale + 0.5f, 255.0f));
+			}
+		}
+	}
+	return true;
+}
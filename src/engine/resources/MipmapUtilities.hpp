@@ -0,0 +1,49 @@
+#ifndef MipmapUtilities_h
+#define MipmapUtilities_h
+
+#include "../Common.hpp"
+#include "../graphics/GLUtilities.hpp"
+
+/**
+ \brief Generate mipmap levels of decoded images on the CPU, filtering in linear space.
+ \details Each level is filtered from the previous one with a separable kernel, on multiple threads. sRGB images are converted to linear before filtering. Cubemap faces are filtered across their edges, by fetching the texels outside a face from its neighbours. The alpha coverage of cutout textures can be preserved from one level to the next.
+ \ingroup Resources
+ */
+class MipmapUtilities {
+
+public:
+
+	/// \brief Downsampling kernel.
+	enum Filter {
+		Box = 0, ///< Average of the covered texels, the fastest.
+		Kaiser, ///< Kaiser-windowed sinc over three texels, sharp with limited ringing.
+		Lanczos ///< Lanczos-windowed sinc over three texels, the sharpest.
+	};
+	
+	/** Generate all missing mipmap levels of a 2D texture or a cubemap, down to 1x1.
+	 \param images the decoded images: one for a 2D texture, six faces for a cubemap. The new levels are appended, six faces per level for a cubemap.
+	 \param cubemap are the images cubemap faces
+	 \param sRGB are the LDR images gamma encoded
+	 \param filter the downsampling kernel
+	 \param preserveCoverage should the alpha coverage of the first level be preserved in the others, only for alpha-tested textures
+	 \return true if the levels were generated
+	 */
+	static bool generate(std::vector<DecodedImage> & images, const bool cubemap, const bool sRGB, const Filter filter, const bool preserveCoverage = false);
+	
+	/** Query the dimensions of the mipmap levels of an image, down to 1x1.
+	 \param width the width of the first level
+	 \param height the height of the first level
+	 \param sizes will contain the width and height of each level, including the first one
+	 */
+	static void levelSizes(const unsigned int width, const unsigned int height, std::vector<glm::uvec2> & sizes);
+	
+	/** Parse a filter name.
+	 \param name the filter name: box, kaiser or lanczos
+	 \param filter will contain the filter
+	 \return true if the name is valid
+	 */
+	static bool parseFilter(const std::string & name, Filter & filter);
+
+};
+
+#endif
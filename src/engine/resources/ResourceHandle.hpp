@@ -0,0 +1,101 @@
+#ifndef ResourceHandle_h
+#define ResourceHandle_h
+
+#include "../Common.hpp"
+#include <cstdint>
+
+/**
+ \brief Compact reference to a resource owned by the resources manager: an index in a table of slots, and the generation of the slot when the handle was issued. Once released, the slot generation changes and the handle resolves to nothing.
+ \ingroup Resources
+ */
+template<typename T>
+struct ResourceHandle {
+
+	uint32_t index = 0xFFFFFFFF; ///< Index of the slot in the handles table.
+	uint32_t generation = 0; ///< Generation of the slot.
+	
+	/** Has the handle been issued.
+	 \return true if the handle references a slot
+	 */
+	bool valid() const { return index != 0xFFFFFFFF; }
+};
+
+class ProgramInfos;
+struct MeshInfos;
+struct TextureInfos;
+
+typedef ResourceHandle<ProgramInfos> ProgramHandle; ///< Handle to a shader program.
+typedef ResourceHandle<MeshInfos> MeshHandle; ///< Handle to a mesh.
+typedef ResourceHandle<TextureInfos> TextureHandle; ///< Handle to a texture.
+
+/**
+ \brief Flat table of resources referenced by handles. Each slot keeps its resource alive until the handle is released, and resolving a handle is a single indexed access.
+ \ingroup Resources
+ */
+template<typename T>
+class HandleTable {
+
+public:
+
+	/** Issue a handle to a resource, reusing a released slot if possible.
+	 \param resource the resource to reference
+	 \return the new handle
+	 */
+	ResourceHandle<T> insert(const std::shared_ptr<T> & resource){
+		ResourceHandle<T> handle;
+		if(_free.empty()){
+			handle.index = uint32_t(_slots.size());
+			_slots.emplace_back();
+		} else {
+			handle.index = _free.back();
+			_free.pop_back();
+		}
+		Slot & slot = _slots[handle.index];
+		slot.resource = resource;
+		handle.generation = slot.generation;
+		return handle;
+	}
+	
+	/** Resolve a handle.
+	 \param handle the handle
+	 \return the resource, or null if the handle is invalid or has been released
+	 */
+	T * resolve(const ResourceHandle<T> & handle) const {
+		if(handle.index >= _slots.size() || _slots[handle.index].generation != handle.generation){
+			return nullptr;
+		}
+		return _slots[handle.index].resource.get();
+	}
+	
+	/** Release a handle, the resource is not referenced by the table anymore. Releasing a stale handle has no effect.
+	 \param handle the handle to release
+	 */
+	void remove(const ResourceHandle<T> & handle){
+		if(resolve(handle) == nullptr){
+			return;
+		}
+		Slot & slot = _slots[handle.index];
+		slot.resource.reset();
+		++slot.generation;
+		_free.push_back(handle.index);
+	}
+	
+	/** Query the number of live handles.
+	 \return the handle count
+	 */
+	size_t size() const { return _slots.size() - _free.size(); }
+
+private:
+
+	/// \brief A table slot.
+	struct Slot {
+		std::shared_ptr<T> resource; ///< The referenced resource.
+		uint32_t generation = 0; ///< Incremented each time the slot is released.
+	};
+	
+	std::vector<Slot> _slots; ///< The table slots.
+	std::vector<uint32_t> _free; ///< Indices of released slots.
+
+};
+
+#endif
@@ -0,0 +1,371 @@
+#include "ResourcePack.hpp"
+#include "ResourcesManager.hpp"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/// Alignment of the payloads in the pack, a memory page.
+#define PACK_ALIGNMENT 4096
+/// Number of bits used to index the LZ4 compressor hash table.
+#define LZ4_HASH_BITS 14
+/// Minimal LZ4 match length.
+#define LZ4_MIN_MATCH 4
+/// LZ4 blocks always end with at least this number of literals.
+#define LZ4_LAST_LITERALS 5
+/// A LZ4 match can't start in the last bytes of a block.
+#define LZ4_MATCH_LIMIT 12
+
+ResourcePack::ResourcePack() : _header(NULL), _entries(NULL), _table(NULL), _names(NULL) {
+}
+
+bool ResourcePack::open(const std::string & path){
+	_header = NULL;
+	if(!_file.open(path)){
+		return false;
+	}
+	const char * data = _file.data();
+	const size_t size = _file.size();
+	const PackHeader * header = reinterpret_cast<const PackHeader *>(data);
+	if(size < sizeof(PackHeader) || std::strncmp(header->magic, "PACK", 4) != 0 || header->version != PackHeader::currentVersion){
+		Log::Error() << Log::Resources << "Invalid resource pack at path \"" << path << "\"." << std::endl;
+		_file.close();
+		return false;
+	}
+	// Check that the table of contents is complete.
+	const uint64_t entriesEnd = header->entriesOffset + uint64_t(header->entryCount) * sizeof(PackEntry);
+	const uint64_t tableEnd = header->tableOffset + uint64_t(header->slotCount) * sizeof(uint32_t);
+	const bool validSlots = header->slotCount > 0 && (header->slotCount & (header->slotCount - 1)) == 0 && header->slotCount > header->entryCount;
+	if(!validSlots || entriesEnd > size || tableEnd > size || header->namesOffset + header->namesSize > size
+	   || header->entriesOffset % alignof(PackEntry) != 0 || header->tableOffset % alignof(uint32_t) != 0){
+		Log::Error() << Log::Resources << "Truncated resource pack at path \"" << path << "\"." << std::endl;
+		_file.close();
+		return false;
+	}
+	const PackEntry * entries = reinterpret_cast<const PackEntry *>(data + header->entriesOffset);
+	for(uint32_t eid = 0; eid < header->entryCount; ++eid){
+		const PackEntry & entry = entries[eid];
+		if(entry.offset + entry.size > size || uint64_t(entry.nameOffset) + entry.nameSize > header->namesSize
+		   || (entry.compression == PackEntry::None && entry.size != entry.rawSize) || entry.compression > PackEntry::LZ4){
+			Log::Error() << Log::Resources << "Invalid entry in resource pack at path \"" << path << "\"." << std::endl;
+			_file.close();
+			return false;
+		}
+	}
+	_header = header;
+	_entries = entries;
+	_table = reinterpret_cast<const uint32_t *>(data + header->tableOffset);
+	_names = data + header->namesOffset;
+	return true;
+}
+
+std::string ResourcePack::name(const PackEntry & entry) const {
+	return std::string(_names + entry.nameOffset, entry.nameSize);
+}
+
+const PackEntry * ResourcePack::find(const std::string & name) const {
+	if(_header == NULL){
+		return NULL;
+	}
+	const uint64_t nameHash = hash(name);
+	const uint32_t mask = _header->slotCount - 1;
+	// Linear probing, the table always has empty slots. Bound the probes in case it is corrupted.
+	uint32_t slot = uint32_t(nameHash) & mask;
+	for(uint32_t probe = 0; probe < _header->slotCount && _table[slot] != 0xFFFFFFFF; ++probe, slot = (slot + 1) & mask){
+		const uint32_t eid = _table[slot];
+		if(eid >= _header->entryCount){
+			return NULL;
+		}
+		const PackEntry & entry = _entries[eid];
+		if(entry.hash == nameHash && entry.nameSize == name.size() && std::memcmp(_names + entry.nameOffset, name.c_str(), name.size()) == 0){
+			return &entry;
+		}
+	}
+	return NULL;
+}
+
+bool ResourcePack::extract(const PackEntry & entry, char * data) const {
+	if(entry.compression == PackEntry::None){
+		std::memcpy(data, payload(entry), size_t(entry.size));
+		return true;
+	}
+	return decompress(payload(entry), size_t(entry.size), data, size_t(entry.rawSize));
+}
+
+uint64_t ResourcePack::hash(const std::string & name){
+	uint64_t result = 14695981039346656037ull;
+	for(const char c : name){
+		result ^= uint64_t((unsigned char)c);
+		result *= 1099511628211ull;
+	}
+	return result;
+}
+
+/** Read four bytes from an unaligned address.
+ \param data the address to read from
+ \return the four bytes value
+ */
+inline uint32_t readUnaligned32(const char * data){
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(uint32_t));
+	return value;
+}
+
+/** Append a LZ4 length continuation (the part that doesn't fit in the token).
+ \param length the remaining length, after removing the token part
+ \param compressed the block to append to
+ */
+inline void writeLZ4Length(size_t length, std::vector<char> & compressed){
+	while(length >= 255){
+		compressed.push_back(char(255));
+		length -= 255;
+	}
+	compressed.push_back(char(length));
+}
+
+/** Read a LZ4 length continuation, checking that the block is long enough.
+ \param compressed the block to read from
+ \param size the size of the block
+ \param position the current position in the block, updated
+ \param length the length to increment
+ \return false if the block ends early
+ */
+inline bool readLZ4Length(const char * compressed, const size_t size, size_t & position, size_t & length){
+	unsigned char byte = 255;
+	while(byte == 255){
+		if(position >= size){
+			return false;
+		}
+		byte = (unsigned char)compressed[position++];
+		length += byte;
+	}
+	return true;
+}
+
+/** Append a LZ4 sequence: a run of literals followed by an optional match.
+ \param literals the literals
+ \param literalCount the number of literals
+ \param offset the match distance, 0 for the last sequence of the block
+ \param matchLength the match length, at least LZ4_MIN_MATCH
+ \param compressed the block to append to
+ */
+void writeLZ4Sequence(const char * literals, const size_t literalCount, const size_t offset, const size_t matchLength, std::vector<char> & compressed){
+	const size_t tokenPos = compressed.size();
+	compressed.push_back(0);
+	unsigned char token = (unsigned char)((std::min)(literalCount, size_t(15)) << 4);
+	if(literalCount >= 15){
+		writeLZ4Length(literalCount - 15, compressed);
+	}
+	compressed.insert(compressed.end(), literals, literals + literalCount);
+	if(offset != 0){
+		compressed.push_back(char(offset & 0xFF));
+		compressed.push_back(char((offset >> 8) & 0xFF));
+		const size_t length = matchLength - LZ4_MIN_MATCH;
+		token |= (unsigned char)(std::min)(length, size_t(15));
+		if(length >= 15){
+			writeLZ4Length(length - 15, compressed);
+		}
+	}
+	compressed[tokenPos] = char(token);
+}
+
+void ResourcePack::compress(const char * data, const size_t size, std::vector<char> & compressed){
+	compressed.clear();
+	compressed.reserve(size + size / 255 + 16);
+	// Last position seen for each hashed 4-bytes sequence, shifted by one so that 0 is empty.
+	std::vector<size_t> positions(size_t(1) << LZ4_HASH_BITS, 0);
+	const size_t matchStartLimit = size > LZ4_MATCH_LIMIT ? size - LZ4_MATCH_LIMIT : 0;
+	const size_t matchEndLimit = size > LZ4_LAST_LITERALS ? size - LZ4_LAST_LITERALS : 0;
+	size_t anchor = 0;
+	size_t current = 0;
+	while(current < matchStartLimit){
+		const uint32_t sequence = readUnaligned32(data + current);
+		const size_t slot = size_t((sequence * 2654435761u) >> (32 - LZ4_HASH_BITS));
+		const size_t candidate = positions[slot];
+		positions[slot] = current + 1;
+		if(candidate == 0 || current - (candidate - 1) > 65535 || readUnaligned32(data + candidate - 1) != sequence){
+			++current;
+			continue;
+		}
+		size_t reference = candidate - 1;
+		// Extend the match forward, then backward over the pending literals.
+		size_t length = LZ4_MIN_MATCH;
+		while(current + length < matchEndLimit && data[reference + length] == data[current + length]){
+			++length;
+		}
+		while(current > anchor && reference > 0 && data[current - 1] == data[reference - 1]){
+			--current;
+			--reference;
+			++length;
+		}
+		writeLZ4Sequence(data + anchor, current - anchor, current - reference, length, compressed);
+		current += length;
+		anchor = current;
+	}
+	// The block ends with literals only.
+	writeLZ4Sequence(data + anchor, size - anchor, 0, 0, compressed);
+}
+
+bool ResourcePack::decompress(const char * compressed, const size_t compressedSize, char * data, const size_t size){
+	size_t src = 0;
+	size_t dst = 0;
+	while(src < compressedSize){
+		const unsigned char token = (unsigned char)compressed[src++];
+		// Literals.
+		size_t literalCount = token >> 4;
+		if(literalCount == 15 && !readLZ4Length(compressed, compressedSize, src, literalCount)){
+			return false;
+		}
+		if(literalCount > compressedSize - src || literalCount > size - dst){
+			return false;
+		}
+		std::memcpy(data + dst, compressed + src, literalCount);
+		src += literalCount;
+		dst += literalCount;
+		// The last sequence has no match.
+		if(src == compressedSize){
+			break;
+		}
+		// Match.
+		if(compressedSize - src < 2){
+			return false;
+		}
+		const size_t offset = size_t((unsigned char)compressed[src]) | (size_t((unsigned char)compressed[src + 1]) << 8);
+		src += 2;
+		size_t length = token & 0xF;
+		if(length == 15 && !readLZ4Length(compressed, compressedSize, src, length)){
+			return false;
+		}
+		length += LZ4_MIN_MATCH;
+		if(offset == 0 || offset > dst || length > size - dst){
+			return false;
+		}
+		if(offset >= length){
+			std::memcpy(data + dst, data + dst - offset, length);
+		} else {
+			// Overlapping match, repeating the last bytes.
+			for(size_t i = 0; i < length; ++i){
+				data[dst + i] = data[dst + i - offset];
+			}
+		}
+		dst += length;
+	}
+	return dst == size;
+}
+
+/** Round an offset up to the next multiple of an alignment.
+ \param offset the offset to align
+ \param alignment the alignment
+ \return the aligned offset
+ */
+inline uint64_t alignOffset(const uint64_t offset, const uint64_t alignment){
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+bool ResourcePack::save(const std::string & path, const std::map<std::string, std::string> & files, const bool compress){
+	// Layout of the table of contents.
+	PackHeader header;
+	std::memcpy(header.magic, "PACK", 4);
+	header.version = PackHeader::currentVersion;
+	header.entryCount = uint32_t(files.size());
+	// Keep the load factor below one half.
+	header.slotCount = 1;
+	while(header.slotCount <= 2 * header.entryCount){
+		header.slotCount *= 2;
+	}
+	header.entriesOffset = alignOffset(sizeof(PackHeader), 16);
+	header.tableOffset = header.entriesOffset + uint64_t(header.entryCount) * sizeof(PackEntry);
+	header.namesOffset = header.tableOffset + uint64_t(header.slotCount) * sizeof(uint32_t);
+	header.namesSize = 0;
+	
+	std::vector<PackEntry> entries;
+	std::vector<uint32_t> table(header.slotCount, 0xFFFFFFFF);
+	std::string names;
+	for(const auto & file : files){
+		PackEntry entry;
+		std::memset(&entry, 0, sizeof(PackEntry));
+		entry.hash = hash(file.first);
+		entry.nameOffset = uint32_t(names.size());
+		entry.nameSize = uint32_t(file.first.size());
+		names += file.first;
+		// Insert in the hash table.
+		uint32_t slot = uint32_t(entry.hash) & (header.slotCount - 1);
+		while(table[slot] != 0xFFFFFFFF){
+			slot = (slot + 1) & (header.slotCount - 1);
+		}
+		table[slot] = uint32_t(entries.size());
+		entries.push_back(entry);
+	}
+	header.namesSize = names.size();
+	
+	// Write to a temporary file, moved to the final path once complete, to never leave a truncated pack.
+	const std::string tempPath = path + ".tmp";
+	std::ofstream outputFile(tempPath, std::ios::binary);
+	if(!outputFile.is_open()){
+		Log::Error() << Log::Resources << "Unable to save resource pack to path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	// Write the payloads first, the table of contents is written once their sizes are known.
+	uint64_t offset = alignOffset(header.namesOffset + header.namesSize, PACK_ALIGNMENT);
+	std::vector<char> compressed;
+	size_t eid = 0;
+	for(const auto & file : files){
+		PackEntry & entry = entries[eid++];
+		size_t rawSize = 0;
+		char * rawContent = Resources::loadRawDataFromExternalFile(file.second, rawSize);
+		if(rawContent == NULL){
+			outputFile.close();
+			std::remove(tempPath.c_str());
+			return false;
+		}
+		entry.offset = offset;
+		entry.rawSize = rawSize;
+		entry.size = rawSize;
+		entry.compression = PackEntry::None;
+		const char * content = rawContent;
+		if(compress && rawSize > 0){
+			ResourcePack::compress(rawContent, rawSize, compressed);
+			// Only keep the compressed version if it saves at least an eighth of the size.
+			if(compressed.size() < rawSize - rawSize / 8){
+				entry.size = compressed.size();
+				entry.compression = PackEntry::LZ4;
+				content = &compressed[0];
+			}
+		}
+		outputFile.seekp(std::streamoff(offset));
+		outputFile.write(content, std::streamsize(entry.size));
+		free(rawContent);
+		offset = alignOffset(offset + entry.size, PACK_ALIGNMENT);
+	}
+	// Pad the last payload so that the whole pack can be mapped by pages.
+	if(offset > 0){
+		outputFile.seekp(std::streamoff(offset - 1));
+		outputFile.put(0);
+	}
+	
+	outputFile.seekp(0);
+	outputFile.write(reinterpret_cast<const char *>(&header), sizeof(PackHeader));
+	outputFile.seekp(std::streamoff(header.entriesOffset));
+	if(!entries.empty()){
+		outputFile.write(reinterpret_cast<const char *>(&entries[0]), std::streamsize(entries.size() * sizeof(PackEntry)));
+	}
+	outputFile.write(reinterpret_cast<const char *>(&table[0]), std::streamsize(table.size() * sizeof(uint32_t)));
+	outputFile.write(names.c_str(), std::streamsize(names.size()));
+	outputFile.close();
+	bool success = bool(outputFile);
+	if(success){
+#ifdef _WIN32
+		success = MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		success = std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+	}
+	if(!success){
+		std::remove(tempPath.c_str());
+		Log::Error() << Log::Resources << "Unable to save resource pack to path \"" << path << "\"." << std::endl;
+	}
+	return success;
+}
@@ -0,0 +1,148 @@
+#ifndef ResourcePack_h
+#define ResourcePack_h
+
+#include "MappedFile.hpp"
+#include "../Common.hpp"
+#include <cstdint>
+#include <map>
+
+/**
+ \brief Header of a resource pack (.pack file). It is followed by the entries table, the hash table (one entry index per slot, 0xFFFFFFFF for empty slots), the names block, and the entries payloads, each aligned on 4096 bytes. Values are stored in little-endian order.
+ \ingroup Resources
+ */
+struct PackHeader {
+	char magic[4]; ///< Should be "PACK".
+	uint32_t version; ///< The format version.
+	uint32_t entryCount; ///< The number of entries.
+	uint32_t slotCount; ///< The number of slots in the hash table, a power of two.
+	uint64_t entriesOffset; ///< Offset of the entries table from the beginning of the pack.
+	uint64_t tableOffset; ///< Offset of the hash table from the beginning of the pack.
+	uint64_t namesOffset; ///< Offset of the names block from the beginning of the pack.
+	uint64_t namesSize; ///< Size of the names block in bytes.
+	
+	static const uint32_t currentVersion = 1; ///< The version written by this code.
+};
+
+/**
+ \brief Description of a file stored in a resource pack.
+ \ingroup Resources
+ */
+struct PackEntry {
+
+	/// \brief Payload compression.
+	enum Compression : uint32_t {
+		None = 0, ///< The payload is the file content.
+		LZ4 = 1 ///< The payload is a LZ4 block.
+	};
+	
+	uint64_t hash; ///< Hash of the entry name.
+	uint64_t offset; ///< Offset of the payload from the beginning of the pack.
+	uint64_t size; ///< Size of the payload in bytes.
+	uint64_t rawSize; ///< Size of the file content once decompressed.
+	uint32_t nameOffset; ///< Offset of the name in the names block.
+	uint32_t nameSize; ///< Length of the name.
+	uint32_t compression; ///< The payload compression.
+	uint32_t reserved; ///< Unused.
+};
+
+/**
+ \brief Read-only resource pack, mapped in memory. Uncompressed entries can be referenced in place, without any copy.
+ \details Entries are found using a hash table of their names (usually relative paths). Payloads are aligned on page boundaries so that they can be referenced directly from the mapped file.
+ \ingroup Resources
+ */
+class ResourcePack {
+
+public:
+
+	/** Default constructor, no pack is mounted. */
+	ResourcePack();
+	
+	/** Map a pack file and validate its table of contents.
+	 \param path the path to the pack on disk
+	 \return true if the pack was successfully mounted
+	 */
+	bool open(const std::string & path);
+	
+	/** Query the number of entries in the pack.
+	 \return the entry count
+	 */
+	size_t entryCount() const { return _header ? _header->entryCount : 0; }
+	
+	/** Access an entry of the pack.
+	 \param index the entry index
+	 \return the entry description
+	 */
+	const PackEntry & entry(const size_t index) const { return _entries[index]; }
+	
+	/** Query the name of an entry.
+	 \param entry the entry
+	 \return the entry name
+	 */
+	std::string name(const PackEntry & entry) const;
+	
+	/** Find an entry by name.
+	 \param name the entry name
+	 \return the entry, or NULL if the pack doesn't contain it
+	 */
+	const PackEntry * find(const std::string & name) const;
+	
+	/** Reference the payload of an entry in the mapped pack. It is only the file content for uncompressed entries.
+	 \param entry the entry
+	 \return a pointer to the first byte of the payload
+	 */
+	const char * payload(const PackEntry & entry) const { return _file.data() + entry.offset; }
+	
+	/** Decompress the payload of an entry.
+	 \param entry the entry
+	 \param data destination buffer, at least entry.rawSize bytes large
+	 \return false if the payload is corrupted
+	 */
+	bool extract(const PackEntry & entry, char * data) const;
+	
+	/** Hash an entry name.
+	 \param name the name to hash
+	 \return the 64-bits FNV-1a hash of the name
+	 */
+	static uint64_t hash(const std::string & name);
+	
+	/** Compress data as a LZ4 block. This favors speed over compression ratio.
+	 \param data the data to compress
+	 \param size the size of the data in bytes
+	 \param compressed will contain the LZ4 block
+	 */
+	static void compress(const char * data, const size_t size, std::vector<char> & compressed);
+	
+	/** Decompress a LZ4 block, checking that all reads and writes stay in bounds.
+	 \param compressed the LZ4 block
+	 \param compressedSize the size of the block in bytes
+	 \param data destination buffer
+	 \param size the expected decompressed size
+	 \return false if the block is corrupted or doesn't decompress to exactly size bytes
+	 */
+	static bool decompress(const char * compressed, const size_t compressedSize, char * data, const size_t size);
+	
+	/** Build a pack from files on disk.
+	 \param path the pack output path
+	 \param files the name of each entry in the pack and the path of the corresponding file on disk
+	 \param compress should entries be compressed when it reduces their size significantly
+	 \return false if a file couldn't be read or the pack written
+	 */
+	static bool save(const std::string & path, const std::map<std::string, std::string> & files, const bool compress);
+	
+	/** Assignment operator (disabled). */
+	ResourcePack& operator= (const ResourcePack&) = delete;
+	
+	/** Copy constructor (disabled). */
+	ResourcePack (const ResourcePack&) = delete;
+
+private:
+
+	MappedFile _file; ///< The pack content.
+	const PackHeader * _header; ///< The pack header, in the mapped content.
+	const PackEntry * _entries; ///< The entries table, in the mapped content.
+	const uint32_t * _table; ///< The hash table, in the mapped content.
+	const char * _names; ///< The names block, in the mapped content.
+
+};
+
+#endif
@@ -1,11 +1,20 @@
 #include "ResourcesManager.hpp"
 #include "MeshUtilities.hpp"
+#include "ImageUtilities.hpp"
+#include "MappedFile.hpp"
+#include "ResourcePack.hpp"
+#include "FileWatcher.hpp"
+#include "ArtifactCache.hpp"
+#include "TextureContainer.hpp"
+#include "../helpers/Telemetry.hpp"
 #include <fstream>
 #include <sstream>
+#include <cstring>
 #include <tinydir/tinydir.h>
 #include <miniz/miniz.h>
+#include <sys/stat.h>
 
-/** By enabling RESOURCES_PACKAGED, the resources will be loaded from a zip archive
+/** By enabling RESOURCES_PACKAGED, the resources will be loaded from a resource pack or a zip archive
  instead of the resources directory. Basic text files can still be read from disk
  (for configuration, settings,...) by using Resources::loadStringFromExternalFile. */
 //#define RESOURCES_PACKAGED
@@ -41,6 +50,71 @@ std::string narrow(char * str) {
 
 std::string Resources::defaultPath = "../../../resources/common/";
 
+size_t Resources::parallelMeshLoadingThreshold = 8 * 1024 * 1024;
+
+bool Resources::cacheMeshBlobs = true;
+
+GLUtilities::VertexLayout Resources::meshVertexLayout = GLUtilities::Packed;
+
+unsigned int Resources::meshLevelCount = 4;
+
+float Resources::meshLevelMaxError = 0.02f;
+
+bool Resources::generateMipmaps = true;
+
+MipmapUtilities::Filter Resources::mipmapFilter = MipmapUtilities::Kaiser;
+
+bool Resources::compressTextures = true;
+
+TextureCompression::Quality Resources::compressionQuality = TextureCompression::Normal;
+
+size_t Resources::uploadBudget = 32 * 1024 * 1024;
+
+size_t Resources::cacheBudget = 512 * 1024 * 1024;
+
+ResourceData::ResourceData() : _data(NULL), _size(0), _owned(false) {
+}
+
+ResourceData::ResourceData(const char * data, const size_t size, const bool owned) : _data(data), _size(size), _owned(owned) {
+}
+
+ResourceData::ResourceData(std::unique_ptr<MappedFile> && file) : _data(file->data()), _size(file->size()), _owned(false), _file(std::move(file)) {
+}
+
+ResourceData::ResourceData(ResourceData && other) : _data(other._data), _size(other._size), _owned(other._owned), _file(std::move(other._file)) {
+	other._data = NULL;
+	other._size = 0;
+	other._owned = false;
+}
+
+ResourceData & ResourceData::operator= (ResourceData && other){
+	if(this != &other){
+		clean();
+		_data = other._data;
+		_size = other._size;
+		_owned = other._owned;
+		_file = std::move(other._file);
+		other._data = NULL;
+		other._size = 0;
+		other._owned = false;
+	}
+	return *this;
+}
+
+ResourceData::~ResourceData(){
+	clean();
+}
+
+void ResourceData::clean(){
+	if(_owned){
+		free((void*)_data);
+	}
+	_file.reset();
+	_data = NULL;
+	_size = 0;
+	_owned = false;
+}
+
 // Singleton.
 Resources& Resources::manager(){
 	static Resources* res = new Resources(Resources::defaultPath);
@@ -51,27 +125,102 @@ Resources::Resources(const std::string & root) {
 	addResources(root);
 }
 
-#ifdef RESOURCES_PACKAGED
-void Resources::addResources(const std::string & path){
-	Log::Info() << Log::Resources << "Loading resources from archive (" << path + ".zip" << ")." << std::endl;
-	parseArchive(path + ".zip");
+/** Check if a path ends with a given extension.
+ \param path the path to test
+ \param extension the extension, including the point
+ \return true if the path has the extension
+ */
+bool hasExtension(const std::string & path, const std::string & extension){
+	return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
 }
-#else
 
 void Resources::addResources(const std::string & path){
+	if(hasExtension(path, ".pack")){
+		Log::Info() << Log::Resources << "Loading resources from pack (" << path << ")." << std::endl;
+		parsePack(path);
+		return;
+	}
+	if(hasExtension(path, ".zip")){
+		Log::Info() << Log::Resources << "Loading resources from archive (" << path << ")." << std::endl;
+		parseArchive(path);
+		return;
+	}
+#ifdef RESOURCES_PACKAGED
+	// Prefer a resource pack, else fallback to a zip archive.
+	std::string basePath = path;
+	while(!basePath.empty() && (basePath.back() == '/' || basePath.back() == '\\')){
+		basePath.pop_back();
+	}
+	uint64_t packSize = 0;
+	uint64_t packTime = 0;
+	if(getExternalFileInfos(basePath + ".pack", packSize, packTime)){
+		Log::Info() << Log::Resources << "Loading resources from pack (" << basePath + ".pack" << ")." << std::endl;
+		parsePack(basePath + ".pack");
+	} else {
+		Log::Info() << Log::Resources << "Loading resources from archive (" << basePath + ".zip" << ")." << std::endl;
+		parseArchive(basePath + ".zip");
+	}
+#else
 	Log::Info() << Log::Resources << "Loading resources from disk (" << path << ")." << std::endl;
 	parseDirectory(path);
-}
+	_directories.push_back(path);
+	if(_watcher){
+		_watcher->watch(path);
+	}
 #endif
+}
 
+void Resources::parsePack(const std::string & packPath){
+	std::shared_ptr<ResourcePack> pack(new ResourcePack());
+	if(!pack->open(packPath)){
+		Log::Error() << Log::Resources << "Unable to mount resource pack \"" << packPath << "\"." << std::endl;
+		return;
+	}
+	_packs[packPath] = pack;
+	for(size_t eid = 0; eid < pack->entryCount(); ++eid){
+		const std::string filePath = pack->name(pack->entry(eid));
+		const std::string fileNameWithExt = filePath.substr(filePath.find_last_of("/\\") + 1);
+		// Filter empty files and system files.
+		if(fileNameWithExt.size() > 0 && fileNameWithExt.at(0) != '.' ){
+			registerFile(fileNameWithExt, packPath + "/" + filePath);
+		}
+	}
+}
+
+/** \brief Archive mapped in memory. Entries can be extracted concurrently from a memory archive, as miniz only reads from the mapped content.
+ */
+struct Resources::Archive {
+	
+	MappedFile file; ///< The archive content.
+	mz_zip_archive zip; ///< The miniz archive state.
+	bool valid = false; ///< Was the archive successfully opened.
+	
+	/** Destructor. Close the archive. */
+	~Archive(){
+		if(valid){
+			mz_zip_reader_end(&zip);
+		}
+	}
+};
 
 void Resources::parseArchive(const std::string & archivePath){
 	
-	mz_zip_archive zip_archive = {0};
-	int status = mz_zip_reader_init_file(&zip_archive, archivePath.c_str(), 0);
+	std::shared_ptr<Archive> archive(new Archive());
+	mz_zip_zero_struct(&archive->zip);
+	if(!archive->file.open(archivePath)){
+		Log::Error() << Log::Resources << "Unable to open zip file \"" << archivePath << "\"." << std::endl;
+		return;
+	}
+	// The central directory is parsed once, and the archive kept open.
+	int status = mz_zip_reader_init_mem(&archive->zip, archive->file.data(), archive->file.size(), 0);
 	if (!status){
-		Log::Error() << Log::Resources << "Unable to load zip file \"" << archivePath << "\" (" << mz_zip_get_error_string(mz_zip_get_last_error(&zip_archive)) << ")." << std::endl;
+		Log::Error() << Log::Resources << "Unable to load zip file \"" << archivePath << "\" (" << mz_zip_get_error_string(mz_zip_get_last_error(&archive->zip)) << ")." << std::endl;
+		return;
 	}
+	archive->valid = true;
+	const size_t archiveId = _archives.size();
+	_archives.push_back(archive);
+	mz_zip_archive & zip_archive = archive->zip;
 	
 	// Get and print information about each file in the archive.
 	for (unsigned int i = 0; i < (unsigned int)mz_zip_reader_get_num_files(&zip_archive); ++i){
@@ -79,7 +228,7 @@ void Resources::parseArchive(const std::string & archivePath){
 		
 		if (!mz_zip_reader_file_stat(&zip_archive, i, &file_stat)){
 			Log::Error() << Log::Resources << "Error reading file infos." << std::endl;
-			mz_zip_reader_end(&zip_archive);
+			continue;
 		}
 		
 		if(mz_zip_reader_is_file_a_directory(&zip_archive, i)){
@@ -90,25 +239,31 @@ void Resources::parseArchive(const std::string & archivePath){
 		const std::string fileNameWithExt = filePath.substr(filePath.find_last_of("/\\") + 1);
 		// Filter empty files and system files.
 		if(fileNameWithExt.size() > 0 && fileNameWithExt.at(0) != '.' ){
-			if(_files.count(fileNameWithExt) == 0){
-				_files[fileNameWithExt] = archivePath + "/" + filePath;
-			} else {
-				// If the file already exists somewhere else in the hierarchy, warn about this.
-				Log::Error() << Log::Resources << "Error: asset named \"" << fileNameWithExt << "\" alread exists." << std::endl;
-			}
+			const std::string fullPath = archivePath + "/" + filePath;
+			// Remember where to find the file for extraction.
+			_archiveEntries[fullPath] = std::make_pair(archiveId, i);
+			registerFile(fileNameWithExt, fullPath);
 		}
 	}
-	mz_zip_reader_end(&zip_archive);
 }
 
-void Resources::parseDirectory(const std::string & directoryPath){
+/** List the files in a directory and its subdirectories, in traversal order.
+ \param directoryPath the path to the directory
+ \param files will contain the name (with extension) and path of each file
+ \param parallel should the subdirectories be listed on separate threads
+ */
+void listDirectory(const std::string & directoryPath, std::vector<std::pair<std::string, std::string>> & files, const bool parallel){
 	// Open directory.
 	tinydir_dir dir;
 	auto * widenedPath = widen(directoryPath);
 	if(tinydir_open(&dir, widenedPath) == -1){
 		tinydir_close(&dir);
 		Log::Error() << Log::Resources << "Unable to open resources directory at path \"" << directoryPath << "\"" << std::endl;
+		return;
 	}
+	// Files of this directory, and placeholders for the subdirectories content, to preserve the traversal order.
+	std::vector<std::pair<std::string, std::string>> entries;
+	std::vector<std::string> subdirectories;
 	// For each file in dir.
 	while (dir.has_next) {
 		tinydir_file file;
@@ -117,11 +272,12 @@ void Resources::parseDirectory(const std::string & directoryPath){
 			Log::Error() << Log::Resources << "Error getting file in directory \"" << narrow(dir.path) << "\"" << std::endl;
 			
 		} else if(file.is_dir){
-			// Extract subdirectory name, check that it isn't a special dir, and recursively aprse it.
+			// Extract subdirectory name, check that it isn't a special dir, and list it later.
 			const std::string dirName = narrow(file.name);
 			if(dirName.size() > 0 && dirName != "." && dirName != ".."){
 				// @CHECK: "/" separator on Windows.
-				parseDirectory(directoryPath + "/" + dirName);
+				entries.emplace_back("", directoryPath + "/" + dirName);
+				subdirectories.push_back(directoryPath + "/" + dirName);
 			}
 			
 		} else {
@@ -129,15 +285,8 @@ void Resources::parseDirectory(const std::string & directoryPath){
 			const std::string fileNameWithExt = narrow(file.name);
 			// Filter empty files and system files.
 			if(fileNameWithExt.size() > 0 && fileNameWithExt.at(0) != '.' ){
-				if(_files.count(fileNameWithExt) == 0){
-					// Store the file and its path.
-					// @CHECK: "/" separator on Windows.
-					_files[fileNameWithExt] = narrow(dir.path) + "/" + fileNameWithExt;
-					
-				} else {
-					// If the file already exists somewhere else in the hierarchy, warn about this.
-					Log::Error() << Log::Resources << "Error: asset named \"" << fileNameWithExt << "\" alread exists." << std::endl;
-				}
+				// @CHECK: "/" separator on Windows.
+				entries.emplace_back(fileNameWithExt, narrow(dir.path) + "/" + fileNameWithExt);
 			}
 		}
 		// Get to next file.
@@ -148,81 +297,188 @@ void Resources::parseDirectory(const std::string & directoryPath){
 		
 	}
 	tinydir_close(&dir);
+	
+	// Recursively list the subdirectories, each on its own thread if requested.
+	std::vector<std::vector<std::pair<std::string, std::string>>> subfiles(subdirectories.size());
+	if(parallel && subdirectories.size() > 1){
+		ThreadUtilities::parallelFor(subdirectories.size(), [&subdirectories, &subfiles](size_t begin, size_t end, size_t){
+			for(size_t did = begin; did < end; ++did){
+				listDirectory(subdirectories[did], subfiles[did], false);
+			}
+		});
+	} else {
+		for(size_t did = 0; did < subdirectories.size(); ++did){
+			listDirectory(subdirectories[did], subfiles[did], false);
+		}
+	}
+	// Merge in traversal order.
+	size_t did = 0;
+	for(auto & entry : entries){
+		if(!entry.first.empty()){
+			files.push_back(std::move(entry));
+			continue;
+		}
+		for(auto & file : subfiles[did]){
+			files.push_back(std::move(file));
+		}
+		++did;
+	}
+}
+
+void Resources::parseDirectory(const std::string & directoryPath){
+	// The directory hierarchy is listed first, then each file registered in order, so that duplicates are handled consistently.
+	std::vector<std::pair<std::string, std::string>> files;
+	listDirectory(directoryPath, files, true);
+	for(const auto & file : files){
+		registerFile(file.first, file.second);
+	}
+}
+
+/** Rank of an image extension, lower is preferred.
+ \param path the file name or path
+ \return the rank, or -1 if this is not an image
+ */
+int imageExtensionRank(const std::string & path){
+	static const std::vector<std::string> extensions = { ".ktx2", ".png", ".jpg", ".jpeg", ".bmp", ".tga", ".exr" };
+	for(size_t eid = 0; eid < extensions.size(); ++eid){
+		if(hasExtension(path, extensions[eid])){
+			return int(eid);
+		}
+	}
+	return -1;
+}
+
+/** Store an image path in an index slot, unless the slot already references an image with a preferred extension.
+ \param slot the index slot
+ \param path the image path
+ */
+void setImageVariant(std::string & slot, const std::string & path){
+	if(slot.empty() || imageExtensionRank(path) < imageExtensionRank(slot)){
+		slot = path;
+	}
+}
+
+void Resources::registerFile(const std::string & fileName, const std::string & path){
+	if(_files.count(fileName) > 0){
+		// If the file already exists somewhere else in the hierarchy, warn about this.
+		Log::Error() << Log::Resources << "Error: asset named \"" << fileName << "\" alread exists." << std::endl;
+		return;
+	}
+	// Store the file and its path.
+	_files[fileName] = path;
+	if(imageExtensionRank(fileName) < 0){
+		return;
+	}
+	// Index the image under its name, and as a variant of its base name if it has a mipmap level or cubemap face suffix.
+	const std::string name = fileName.substr(0, fileName.find_last_of("."));
+	setImageVariant(_images[name].path, path);
+	const size_t separator = name.find_last_of("_");
+	if(separator == std::string::npos){
+		return;
+	}
+	const std::string baseName = name.substr(0, separator);
+	const std::string suffix = name.substr(separator + 1);
+	static const std::vector<std::string> faces = { "px", "nx", "py", "ny", "pz", "nz" };
+	for(size_t fid = 0; fid < faces.size(); ++fid){
+		if(suffix == faces[fid]){
+			setImageVariant(_images[baseName].faces[fid], path);
+			return;
+		}
+	}
+	// Only canonical level numbers are looked up (name_1, not name_01).
+	if(suffix.empty() || suffix.size() > 3 || suffix.find_first_not_of("0123456789") != std::string::npos){
+		return;
+	}
+	const size_t level = std::stoul(suffix);
+	if(std::to_string(level) != suffix){
+		return;
+	}
+	std::vector<std::string> & levels = _images[baseName].levels;
+	if(levels.size() <= level){
+		levels.resize(level + 1);
+	}
+	setImageVariant(levels[level], path);
 }
 
 
 // Image path utilities.
 
 const std::vector<std::string> Resources::getCubemapPaths(const std::string & name){
-	const std::vector<std::string> names { name + "_px", name + "_nx", name + "_py", name + "_ny", name + "_pz", name + "_nz" };
-	std::vector<std::string> paths;
-	paths.reserve(6);
-	for(auto & faceName : names){
-		const std::string filePath = getImagePath(faceName);
-		// If a face is missing, cancel the whole loading.
-		if(filePath.empty()){
+	const auto image = _images.find(name);
+	if(image == _images.end()){
+		return std::vector<std::string>();
+	}
+	const std::string * faces = image->second.faces;
+	// If a face is missing, cancel the whole loading.
+	for(size_t fid = 0; fid < 6; ++fid){
+		if(faces[fid].empty()){
 			return std::vector<std::string>();
 		}
-		// Else append the path.
-		paths.push_back(filePath);
 	}
-	return paths;
+	return std::vector<std::string>(faces, faces + 6);
 }
 
 const std::string Resources::getImagePath(const std::string & name){
-	std::string path = "";
-	// Check if the file exists with an image extension.
-	if(_files.count(name + ".png") > 0){
-		path = _files[name + ".png"];
-	} else if(_files.count(name + ".jpg") > 0){
-		path = _files[name + ".jpg"];
-	} else if(_files.count(name + ".jpeg") > 0){
-		path = _files[name + ".jpeg"];
-	} else if(_files.count(name + ".bmp") > 0){
-		path = _files[name + ".bmp"];
-	} else if(_files.count(name + ".tga") > 0){
-		path = _files[name + ".tga"];
-	} else if(_files.count(name + ".exr") > 0){
-		path = _files[name + ".exr"];
-	}
-	return path;
+	// The preferred extension has been selected when indexing.
+	const auto image = _images.find(name);
+	return image != _images.end() ? image->second.path : "";
 }
 
 
 // Base methods.
 
-#ifdef RESOURCES_PACKAGED
-
-char * Resources::getRawData(const std::string & path, size_t & size) {
-	char * rawContent;
-	mz_zip_archive zip_archive = {0};
-	// Extract the archive path and the file internal path.
-	const auto extensionPos = path.find(".zip/");
-	if(extensionPos == std::string::npos){
-		Log::Error() << Log::Resources << "Unable to find archive for path \"" << path << "\"." << std::endl;
-		return NULL;
+ResourceData Resources::getData(const std::string & path) {
+	// Files in resource packs, found using the pack hash table.
+	const auto packPos = path.find(".pack/");
+	if(packPos != std::string::npos){
+		const auto pack = _packs.find(path.substr(0, packPos + 5));
+		if(pack != _packs.end()){
+			const PackEntry * entry = pack->second->find(path.substr(packPos + 6));
+			if(entry == NULL){
+				Log::Error() << Log::Resources << "Unable to find file at path \"" << path << "\"." << std::endl;
+				return ResourceData();
+			}
+			// Uncompressed payloads are referenced directly in the mapped pack.
+			if(entry->compression == PackEntry::None){
+				Telemetry::Scope scope(Telemetry::Read, path);
+				scope.setBytes(size_t(entry->size));
+				return ResourceData(pack->second->payload(*entry), size_t(entry->size), false);
+			}
+			Telemetry::Scope scope(Telemetry::Inflate, path);
+			scope.setBytes(size_t(entry->rawSize));
+			char * rawContent = (char*)malloc((std::max)(size_t(entry->rawSize), size_t(1)));
+			if(!pack->second->extract(*entry, rawContent)){
+				Log::Error() << Log::Resources << "Unable to extract file at path \"" << path << "\"." << std::endl;
+				free(rawContent);
+				return ResourceData();
+			}
+			return ResourceData(rawContent, size_t(entry->rawSize), true);
+		}
 	}
-	const std::string archivePath = path.substr(0, extensionPos + 4);
-	const std::string filePath = path.substr(extensionPos + 5);
-	
-	int status = mz_zip_reader_init_file(&zip_archive, archivePath.c_str(), 0);
-	if (!status){
-		Log::Error() << Log::Resources << "Unable to load zip file at path \"" << archivePath << "\" (" << mz_zip_get_error_string(mz_zip_get_last_error(&zip_archive)) << ")." << std::endl;
-		return NULL;
+	// Files in zip archives.
+	const auto entry = _archiveEntries.find(path);
+	if(entry != _archiveEntries.end()){
+		// Extracting by index from a memory archive doesn't modify the shared state.
+		mz_zip_archive & zip_archive = _archives[entry->second.first]->zip;
+		Telemetry::Scope scope(Telemetry::Inflate, path);
+		size_t size = 0;
+		char * rawContent = (char*)mz_zip_reader_extract_to_heap(&zip_archive, entry->second.second, &size, 0);
+		if(rawContent == NULL){
+			Log::Error() << Log::Resources << "Unable to extract file at path \"" << path << "\"." << std::endl;
+			return ResourceData();
+		}
+		scope.setBytes(size);
+		return ResourceData(rawContent, size, true);
 	}
-	rawContent = (char*)mz_zip_reader_extract_file_to_heap(&zip_archive, filePath.c_str(), &size, 0);
-	mz_zip_reader_end(&zip_archive);
-	return rawContent;
-}
-
-#else
-	
-char * Resources::getRawData(const std::string & path, size_t & size) {
-	return Resources::loadRawDataFromExternalFile(path, size);
+	// Files on disk are mapped.
+	Telemetry::Scope scope(Telemetry::Read, path);
+	std::unique_ptr<MappedFile> file(new MappedFile());
+	if(!file->open(path)){
+		return ResourceData();
+	}
+	scope.setBytes(file->size());
+	return ResourceData(std::move(file));
 }
-	
-#endif
-	
 
 const std::string Resources::getString(const std::string & filename){
 	std::string path = "";
@@ -235,106 +491,700 @@ const std::string Resources::getString(const std::string & filename){
 		return "";
 	}
 	
-	size_t rawSize = 0;
-	char* rawContent = Resources::manager().getRawData(path, rawSize);
-	const std::string content(rawContent, rawSize);
-	free(rawContent);
-	return content;
+	const ResourceData content = getData(path);
+	if(content.empty()){
+		return "";
+	}
+	return std::string(content.data(), content.size());
 }
 
-// Mesh method.
+// Background loading.
 
-const MeshInfos Resources::getMesh(const std::string & name){
-	if(_meshes.count(name) > 0){
-		return _meshes[name];
+struct Resources::MeshData {
+	Mesh mesh; ///< The mesh parsed from the source file, if the binary version couldn't be used.
+	ResourceData blob; ///< The binary mesh content, if valid.
+	MeshView view; ///< View on the mesh attributes, either in the blob or in the parsed mesh.
+	BoundingBox bbox; ///< The mesh bounding box.
+	std::string blobPath; ///< Path to the regenerated binary mesh, if any.
+};
+
+/** Report the GPU memory saved by a texture stored as half floats or compressed blocks.
+ \param name the texture name
+ \param infos the texture infos
+ */
+void logSavedTexture(const std::string & name, const TextureInfos & infos){
+	if(infos.savedSize > 0){
+		Log::Verbose() << Log::Resources << "Texture \"" << name << "\" stored as " << (infos.compressed ? "compressed blocks" : "half floats") << ": " << infos.size / 1024 << " KB, " << infos.savedSize / 1024 << " KB saved." << std::endl;
 	}
+}
 
-	MeshInfos infos;
-	std::string completeName;
+/** Generate the missing mipmap levels of decoded images on the CPU, or fetch them from the artifact cache.
+ \param images the decoded images, the new levels are appended
+ \param cubemap are the images cubemap faces
+ \param srgb are the images gamma encoded
+ \note Textures with pre-baked levels are left untouched. Without an artifact cache, or if levels can't be generated, they will be by the driver.
+ */
+void completeMipmaps(std::vector<DecodedImage> & images, const bool cubemap, const bool srgb){
+	const size_t faceCount = cubemap ? 6 : 1;
+	// Filtering on each launch would be slower than letting the driver do it, only generate levels that can be reused.
+	if(!Resources::generateMipmaps || !ArtifactCache::enabled() || images.size() != faceCount || images[0].compressedFormat != 0 || (images[0].width == 1 && images[0].height == 1)){
+		return;
+	}
+	Telemetry::Scope scope(Telemetry::Mipmaps);
+	const DecodedImage & first = images[0];
+	ArtifactCache::Key key("mipmaps", 2);
+	key.add(uint64_t(Resources::mipmapFilter)).add(uint64_t(srgb)).add(uint64_t(cubemap));
+	key.add(uint64_t(first.width)).add(uint64_t(first.height)).add(uint64_t(first.channels)).add(uint64_t(first.hdr)).add(uint64_t(first.half));
+	for(const DecodedImage & image : images){
+		key.add(static_cast<const char *>(image.data), image.size());
+	}
+	// The artifact contains all new levels, one after the other.
+	std::vector<char> artifact;
+	std::vector<glm::uvec2> sizes;
+	MipmapUtilities::levelSizes(first.width, first.height, sizes);
+	size_t expectedSize = 0;
+	for(size_t lid = 1; lid < sizes.size(); ++lid){
+		DecodedImage level = first;
+		level.width = sizes[lid].x;
+		level.height = sizes[lid].y;
+		expectedSize += faceCount * level.size();
+	}
+	if(ArtifactCache::fetch(key, artifact) && artifact.size() == expectedSize){
+		size_t offset = 0;
+		for(size_t lid = 1; lid < sizes.size(); ++lid){
+			for(size_t fid = 0; fid < faceCount; ++fid){
+				DecodedImage level = images[0];
+				level.width = sizes[lid].x;
+				level.height = sizes[lid].y;
+				level.data = malloc(level.size());
+				std::memcpy(level.data, &artifact[offset], level.size());
+				offset += level.size();
+				images.push_back(level);
+			}
+		}
+		scope.setBytes(artifact.size());
+		return;
+	}
+	// Materials don't flag alpha-tested textures, the coverage is only preserved by the offline tool.
+	if(!MipmapUtilities::generate(images, cubemap, srgb, Resources::mipmapFilter, false)){
+		return;
+	}
+	artifact.clear();
+	for(size_t iid = faceCount; iid < images.size(); ++iid){
+		const char * data = static_cast<const char *>(images[iid].data);
+		artifact.insert(artifact.end(), data, data + images[iid].size());
+	}
+	ArtifactCache::store(key, artifact.data(), artifact.size());
+}
+
+/** Pick the block compression format of a texture from its name and content type.
+ \param name the texture name
+ \param path the path of the first image of the texture
+ \param cubemap is the texture a cubemap
+ \param srgb should the texture be gamma corrected
+ \return the compression format, or None if the texture should stay uncompressed
+ \note Containers are uploaded as stored. Without an artifact cache, textures are uploaded uncompressed rather than encoded on each launch.
+ \warning Should be called on the main thread, to check the support of the format.
+ */
+TextureCompression::Format textureCompressionFormat(const std::string & name, const std::string & path, const bool cubemap, const bool srgb){
+	if(!Resources::compressTextures || !ArtifactCache::enabled() || TextureContainer::isContainer(path)){
+		return TextureCompression::None;
+	}
+	const bool hdr = ImageUtilities::isHDR(path);
+	const auto endsWith = [&name](const std::string & suffix){
+		return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+	};
+	const TextureCompression::Quality quality = Resources::compressionQuality;
+	TextureCompression::Format format = TextureCompression::BC7;
+	if(hdr){
+		// HDR 2D textures are precomputed tables, keep them exact.
+		format = cubemap ? TextureCompression::BC6H : TextureCompression::None;
+	} else if(endsWith("_normal")){
+		format = TextureCompression::BC5;
+	} else if(endsWith("_depth")){
+		format = TextureCompression::BC4;
+	} else if(endsWith("_rough_met_ao")){
+		format = quality == TextureCompression::High ? TextureCompression::BC7 : TextureCompression::BC1;
+	} else if(quality == TextureCompression::Fast){
+		format = TextureCompression::BC1;
+	}
+	// Fallback to BC1 when BC7 is not available.
+	if(format == TextureCompression::BC7 && !TextureCompression::isSupported(format, srgb)){
+		format = TextureCompression::BC1;
+	}
+	if(format != TextureCompression::None && !TextureCompression::isSupported(format, srgb)){
+		return TextureCompression::None;
+	}
+	return format;
+}
+
+/** Compress decoded images into GPU blocks on the CPU, or fetch them from the artifact cache.
+ \param images the decoded images, compressed in place
+ \param format the compression format
+ \param cubemap are the images cubemap faces
+ \param srgb should the images be gamma corrected when sampled
+ \note Images missing mipmap levels are left uncompressed so that the driver can generate them. BC1 is replaced by BC3 for images with transparent pixels.
+ */
+void compressBlocks(std::vector<DecodedImage> & images, TextureCompression::Format format, const bool cubemap, const bool srgb){
+	const size_t faceCount = cubemap ? 6 : 1;
+	if(format == TextureCompression::None || images.size() < faceCount){
+		return;
+	}
+	const DecodedImage & first = images[0];
+	if(images.size() == faceCount && (first.width > 1 || first.height > 1)){
+		return;
+	}
+	// Levels can't be partially compressed.
+	for(const DecodedImage & image : images){
+		if(image.data == NULL || image.compressedFormat != 0 || image.hdr != (format == TextureCompression::BC6H)){
+			return;
+		}
+	}
+	if(format == TextureCompression::BC1 && !first.hdr && first.channels == 4){
+		const unsigned char * data = static_cast<const unsigned char *>(first.data);
+		const size_t count = size_t(first.width) * size_t(first.height);
+		for(size_t pid = 0; pid < count; ++pid){
+			if(data[4 * pid + 3] != 255){
+				format = TextureCompression::BC3;
+				break;
+			}
+		}
+	}
+	Telemetry::Scope scope(Telemetry::Compress);
+	ArtifactCache::Key key("blocks", 1);
+	if(ArtifactCache::enabled()){
+		key.add(uint64_t(format)).add(uint64_t(Resources::compressionQuality));
+		for(const DecodedImage & image : images){
+			key.add(uint64_t(image.width)).add(uint64_t(image.height)).add(uint64_t(image.channels)).add(uint64_t(image.hdr)).add(uint64_t(image.half));
+			key.add(static_cast<const char *>(image.data), image.size());
+		}
+		// The artifact contains the blocks of all images, one after the other.
+		std::vector<char> artifact;
+		const unsigned int blockSize = TextureCompression::blockSize(format);
+		size_t expectedSize = 0;
+		for(const DecodedImage & image : images){
+			expectedSize += size_t((image.width + 3) / 4) * size_t((image.height + 3) / 4) * blockSize;
+		}
+		if(ArtifactCache::fetch(key, artifact) && artifact.size() == expectedSize){
+			size_t offset = 0;
+			for(DecodedImage & image : images){
+				free(image.data);
+				image.compressedFormat = TextureCompression::glFormat(format, srgb);
+				image.blockSize = blockSize;
+				image.data = malloc(image.size());
+				std::memcpy(image.data, &artifact[offset], image.size());
+				offset += image.size();
+			}
+			scope.setBytes(artifact.size());
+			return;
+		}
+	}
+	for(DecodedImage & image : images){
+		TextureCompression::encode(image, format, Resources::compressionQuality, srgb);
+	}
+	if(ArtifactCache::enabled()){
+		std::vector<char> artifact;
+		for(const DecodedImage & image : images){
+			const char * data = static_cast<const char *>(image.data);
+			artifact.insert(artifact.end(), data, data + image.size());
+		}
+		ArtifactCache::store(key, artifact.data(), artifact.size());
+	}
+}
+
+struct Resources::Request {
 	
-	// Load geometry. For now we only support OBJs.
-	Mesh mesh;
-	const std::string meshText = getString(name + ".obj");
-	if(!meshText.empty()){
-		std::stringstream meshStream(meshText);
+	/// \brief Type of resource.
+	enum Type {
+		Texture, Cubemap, Geometry
+	};
 	
-		MeshUtilities::loadObj(meshStream, mesh, MeshUtilities::Indexed);
-		// If uv or positions are missing, tangent/binormals won't be computed.
-		MeshUtilities::computeTangentsAndBinormals(mesh);
-		
+	Type type; ///< The resource type.
+	std::string name; ///< The resource name.
+	bool srgb; ///< Should the texture be gamma corrected.
+	TextureCompression::Format compression; ///< The texture compression format, picked on the main thread.
+	std::vector<std::string> paths; ///< The images paths, or the mesh source and binary paths.
+	std::vector<DecodedImage> images; ///< The decoded images.
+	MeshData mesh; ///< The mesh data.
+	bool reload; ///< Should the content of the existing texture be replaced.
+	bool success; ///< Was the resource successfully loaded.
+	bool decoded; ///< Is the request waiting to be uploaded, protected by the manager mutex.
+	
+	/** Constructor.
+	 \param atype the resource type
+	 \param aname the resource name
+	 */
+	Request(const Type atype, const std::string & aname) : type(atype), name(aname), srgb(true), compression(TextureCompression::None), reload(false), success(false), decoded(false) {}
+};
+
+void Resources::startRequest(const std::shared_ptr<Request> & request){
+	if(!_loader){
+		_loader.reset(new ThreadPool());
+	}
+	_loader->push([this, request](){
+		Telemetry::Asset asset(request->name);
+		if(request->type == Request::Geometry){
+			request->success = loadMeshData(request->paths[0], request->paths[1], request->mesh);
+		} else {
+			// 2D LDR images are flipped, as when loading synchronously.
+			const bool flip = request->type == Request::Texture && !ImageUtilities::isHDR(request->paths[0]);
+			request->success = GLUtilities::decodeImages(request->paths, flip, request->type == Request::Cubemap, request->images);
+			if(request->success){
+				const bool cubemap = request->type == Request::Cubemap;
+				completeMipmaps(request->images, cubemap, request->srgb);
+				compressBlocks(request->images, request->compression, cubemap, request->srgb);
+			}
+		}
+		std::lock_guard<std::mutex> lock(_decodedMutex);
+		request->decoded = true;
+		_decoded.push_back(request);
+		_decodedCondition.notify_all();
+	});
+}
+
+void Resources::recordRequest(const std::string & type, const std::string & name, const bool srgb){
+	if(_manifestName.empty()){
+		return;
+	}
+	const std::string entry = type + " " + (srgb ? "1" : "0") + " " + name;
+	if(std::find(_manifest.begin(), _manifest.end(), entry) == _manifest.end()){
+		_manifest.push_back(entry);
+	}
+}
+
+size_t Resources::finishRequest(Request & request){
+	Telemetry::Asset asset(request.name);
+	size_t size = 0;
+	// The handles were registered when the requests were submitted, and are updated in place.
+	if(request.type == Request::Geometry){
+		if(request.success){
+			size = finishMesh(request.name, request.mesh)->size;
+		} else {
+			Log::Error() << Log::Resources << "Unable to load mesh named " << request.name << "." << std::endl;
+			// A mesh that failed to reload keeps its previous version.
+			if(_meshes.count(request.name) > 0 && _meshes[request.name].handle->vId == 0){
+				_meshes.erase(request.name);
+			}
+		}
+		_pendingMeshes.erase(request.name);
+		return size;
+	}
+	
+	if(request.success){
+		Entry<TextureInfos> & entry = _textures[request.name];
+		// When reloading, the existing texture is filled again.
+		const GLuint textureId = request.reload ? entry.handle->id : 0;
+		const TextureInfos infos = request.type == Request::Cubemap ? GLUtilities::uploadTextureCubemap(request.images, request.srgb, textureId) : GLUtilities::uploadTexture(request.images, request.srgb, textureId);
+		*(entry.handle) = infos;
+		entry.lastUse = _frame;
+		size = infos.size;
+		logSavedTexture(request.name, infos);
+	} else if(!request.reload){
+		_textures.erase(request.name);
+	}
+	_pendingTextures.erase(request.name);
+	return size;
+}
+
+void Resources::waitRequest(const std::shared_ptr<Request> & request){
+	{
+		std::unique_lock<std::mutex> lock(_decodedMutex);
+		_decodedCondition.wait(lock, [&request](){ return request->decoded; });
+		_decoded.erase(std::find(_decoded.begin(), _decoded.end(), request));
+	}
+	finishRequest(*request);
+}
+
+void Resources::update(){
+	if(_watcher){
+		reloadChanges();
+	}
+	size_t uploaded = 0;
+	while(uploaded == 0 || uploaded < Resources::uploadBudget){
+		std::shared_ptr<Request> request;
+		{
+			std::lock_guard<std::mutex> lock(_decodedMutex);
+			if(_decoded.empty()){
+				break;
+			}
+			request = _decoded.front();
+			_decoded.pop_front();
+		}
+		// Empty resources still count, to guarantee progress.
+		uploaded += (std::max)(finishRequest(*request), size_t(1));
+	}
+	trimCache();
+}
+
+size_t Resources::pendingCount() const {
+	return _pendingTextures.size() + _pendingMeshes.size();
+}
+
+
+// Cache methods.
+
+void Resources::trimCache(){
+	++_frame;
+	// Resources referenced outside of the cache are in use this frame.
+	size_t totalSize = 0;
+	for(auto & texture : _textures){
+		if(texture.second.handle.use_count() > 1){
+			texture.second.lastUse = _frame;
+		}
+		totalSize += texture.second.handle->size;
+	}
+	for(auto & mesh : _meshes){
+		if(mesh.second.handle.use_count() > 1){
+			mesh.second.lastUse = _frame;
+		}
+		totalSize += mesh.second.handle->size;
+	}
+	if(totalSize <= Resources::cacheBudget){
+		return;
+	}
+	
+	// Gather unreferenced resources, resources still loading are kept.
+	struct Candidate {
+		uint64_t lastUse;
+		ResourceType type;
+		std::string name;
+	};
+	std::vector<Candidate> candidates;
+	for(const auto & texture : _textures){
+		if(texture.second.handle.use_count() == 1 && _pendingTextures.count(texture.first) == 0){
+			candidates.push_back({texture.second.lastUse, Textures, texture.first});
+		}
+	}
+	for(const auto & mesh : _meshes){
+		if(mesh.second.handle.use_count() == 1 && _pendingMeshes.count(mesh.first) == 0){
+			candidates.push_back({mesh.second.lastUse, Meshes, mesh.first});
+		}
+	}
+	// Least recently used first.
+	std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate & a, const Candidate & b){
+		return a.lastUse < b.lastUse;
+	});
+	for(const Candidate & candidate : candidates){
+		if(totalSize <= Resources::cacheBudget){
+			break;
+		}
+		if(candidate.type == Textures){
+			TextureInfos & infos = *(_textures[candidate.name].handle);
+			totalSize -= infos.size;
+			GLUtilities::deleteTexture(infos);
+			_textures.erase(candidate.name);
+		} else {
+			MeshInfos & infos = *(_meshes[candidate.name].handle);
+			totalSize -= infos.size;
+			GLUtilities::deleteMesh(infos);
+			_meshes.erase(candidate.name);
+		}
+		Log::Verbose() << Log::Resources << "Evicted " << (candidate.type == Textures ? "texture" : "mesh") << " named \"" << candidate.name << "\"." << std::endl;
+	}
+}
+
+void Resources::beginManifest(const std::string & name){
+	_manifest.clear();
+	_previousManifest.clear();
+	// Manifests recorded on this machine are kept in the artifacts cache, else use the one shipped with the resources.
+	std::string manifest;
+	std::vector<char> cached;
+	if(ArtifactCache::fetch(ArtifactCache::Key("manifest", 1).add(name), cached)){
+		manifest.assign(cached.begin(), cached.end());
+	} else if(_files.count(name + ".manifest") > 0){
+		manifest = getString(name + ".manifest");
+	}
+	// Prefetch the assets recorded during a previous run, they are decoded in parallel by the loading threads.
+	if(!manifest.empty()){
+		std::stringstream content(manifest);
+		std::string line;
+		while(std::getline(content, line)){
+			line = Resources::trim(line, " \t\r");
+			std::stringstream entry(line);
+			std::string type;
+			int srgb = 0;
+			std::string assetName;
+			entry >> type >> srgb;
+			std::getline(entry, assetName);
+			assetName = Resources::trim(assetName, " \t");
+			if(assetName.empty()){
+				continue;
+			}
+			if(type == "texture"){
+				getTextureAsync(assetName, srgb != 0);
+			} else if(type == "cubemap"){
+				getCubemapAsync(assetName, srgb != 0);
+			} else if(type == "mesh"){
+				getMeshAsync(assetName);
+			} else {
+				continue;
+			}
+			_previousManifest.push_back(line);
+		}
+		Log::Info() << Log::Resources << "Prefetching " << _previousManifest.size() << " assets for \"" << name << "\"." << std::endl;
+	}
+	_manifestName = name;
+}
+
+void Resources::endManifest(){
+	const std::string name = _manifestName;
+	_manifestName = "";
+	// The resources directories are left untouched, manifests are only saved when the cache is enabled.
+	if(name.empty() || _manifest.empty() || _manifest == _previousManifest || !ArtifactCache::enabled()){
+		return;
+	}
+	std::string content;
+	for(const std::string & entry : _manifest){
+		content.append(entry + "\n");
+	}
+	ArtifactCache::store(ArtifactCache::Key("manifest", 1).add(name), content.c_str(), content.size());
+	Log::Info() << Log::Resources << "Saved manifest of " << _manifest.size() << " assets for \"" << name << "\"." << std::endl;
+}
+
+const Resources::Statistics Resources::getStatistics(const ResourceType type) const {
+	Statistics stats;
+	if(type == Textures){
+		for(const auto & texture : _textures){
+			stats.count += 1;
+			stats.size += texture.second.handle->size;
+			stats.savedSize += texture.second.handle->savedSize;
+			if(texture.second.handle.use_count() == 1){
+				stats.unusedCount += 1;
+				stats.unusedSize += texture.second.handle->size;
+			}
+		}
+	} else if(type == Meshes){
+		for(const auto & mesh : _meshes){
+			stats.count += 1;
+			stats.size += mesh.second.handle->size;
+			if(mesh.second.handle.use_count() == 1){
+				stats.unusedCount += 1;
+				stats.unusedSize += mesh.second.handle->size;
+			}
+		}
 	} else {
+		for(const auto & program : _programs){
+			stats.count += 1;
+			stats.unusedCount += (program.second.use_count() == 1) ? 1 : 0;
+		}
+	}
+	return stats;
+}
+
+const TextureInfos & Resources::getPlaceholder(const bool cubemap, const bool srgb){
+	TextureInfos & placeholder = _placeholders[cubemap ? 2 : (srgb ? 0 : 1)];
+	if(placeholder.id != 0){
+		return placeholder;
+	}
+	// Mid-grey color, or flat normal for linear 2D textures.
+	std::vector<DecodedImage> images(cubemap ? 6 : 1);
+	for(DecodedImage & image : images){
+		unsigned char * pixel = (unsigned char *)malloc(4);
+		pixel[0] = pixel[1] = 128;
+		pixel[2] = (cubemap || srgb) ? 128 : 255;
+		pixel[3] = 255;
+		image.data = pixel;
+		image.width = image.height = 1;
+		image.status = 0;
+	}
+	placeholder = cubemap ? GLUtilities::uploadTextureCubemap(images, srgb) : GLUtilities::uploadTexture(images, srgb);
+	return placeholder;
+}
+
+
+// Mesh method.
+
+const std::shared_ptr<MeshInfos> Resources::getMesh(const std::string & name){
+	recordRequest("mesh", name, false);
+	// If the mesh is loading in the background, finish it now.
+	if(_pendingMeshes.count(name) > 0){
+		const std::shared_ptr<Request> request = _pendingMeshes[name];
+		waitRequest(request);
+		return _meshes.count(name) > 0 ? _meshes[name].handle : std::make_shared<MeshInfos>();
+	}
+	Telemetry::cacheAccess(name, _meshes.count(name) > 0);
+	if(_meshes.count(name) > 0){
+		return _meshes[name].handle;
+	}
+	Telemetry::Asset asset(name);
+	
+	const std::string sourcePath = _files.count(name + ".obj") > 0 ? _files[name + ".obj"] : "";
+	const std::string blobPath = _files.count(name + ".mesh") > 0 ? _files[name + ".mesh"] : "";
+	MeshData data;
+	if(!loadMeshData(sourcePath, blobPath, data)){
 		Log::Error() << Log::Resources << "Unable to load mesh named " << name << "." << std::endl;
-		return infos;
+		return std::make_shared<MeshInfos>();
+	}
+	return finishMesh(name, data);
+}
+
+const std::shared_ptr<MeshInfos> Resources::getMeshAsync(const std::string & name){
+	recordRequest("mesh", name, false);
+	Telemetry::cacheAccess(name, _meshes.count(name) > 0);
+	if(_meshes.count(name) > 0){
+		return _meshes[name].handle;
+	}
+	Entry<MeshInfos> & entry = _meshes[name];
+	entry.handle = std::make_shared<MeshInfos>();
+	entry.lastUse = _frame;
+	// Paths are resolved here, the files listing is only accessed on the main thread.
+	const std::shared_ptr<Request> request = std::make_shared<Request>(Request::Geometry, name);
+	request->paths.push_back(_files.count(name + ".obj") > 0 ? _files[name + ".obj"] : "");
+	request->paths.push_back(_files.count(name + ".mesh") > 0 ? _files[name + ".mesh"] : "");
+	_pendingMeshes[name] = request;
+	startRequest(request);
+	return entry.handle;
+}
+
+bool Resources::loadMeshData(const std::string & sourcePath, const std::string & blobPath, MeshData & data){
+	
+	// Prefer the preprocessed binary mesh if it is up to date.
+	// Blobs on disk are mapped, blobs in a resource pack are referenced in place.
+	if(!blobPath.empty()){
+		data.blob = getData(blobPath);
+		MeshBlobHeader header;
+		uint64_t sourceSize = 0;
+		uint64_t sourceTime = 0;
+		if(!MeshUtilities::loadMeshBlob(data.blob.data(), data.blob.size(), data.view, header)){
+			Log::Warning() << Log::Resources << "Invalid mesh blob at path \"" << blobPath << "\", it will be regenerated." << std::endl;
+		} else if(!sourcePath.empty() && getExternalFileInfos(sourcePath, sourceSize, sourceTime)
+				  && (sourceSize != header.sourceSize || sourceTime != header.sourceTime)){
+			// If the source is available on disk, check that the blob was generated from its current version.
+			// Blobs stored in a pack or an archive are always considered up to date.
+			Log::Info() << Log::Resources << "Mesh blob at path \"" << blobPath << "\" is outdated, it will be regenerated." << std::endl;
+		} else {
+			// The GPU buffers will be filled directly from the blob content.
+			data.bbox.minis = glm::vec3(header.bboxMin[0], header.bboxMin[1], header.bboxMin[2]);
+			data.bbox.maxis = glm::vec3(header.bboxMax[0], header.bboxMax[1], header.bboxMax[2]);
+			return true;
+		}
+		data.blob = ResourceData();
+		data.view = MeshView();
 	}
 	
-	// Setup GL buffers and attributes.
-	infos = GLUtilities::setupBuffers(mesh);
+	// Load geometry. For now we only support OBJs.
+	ResourceData content;
+	if(!sourcePath.empty()){
+		content = getData(sourcePath);
+	}
+	if(content.empty()){
+		return false;
+	}
+	// The preprocessed mesh will be saved next to the source, for the next runs.
+	uint64_t sourceSize = 0;
+	uint64_t sourceTime = 0;
+#ifndef RESOURCES_PACKAGED
+	const bool saveBlob = Resources::cacheMeshBlobs && getExternalFileInfos(sourcePath, sourceSize, sourceTime);
+#else
+	const bool saveBlob = false;
+#endif
+	const std::string localBlobPath = sourcePath.substr(0, sourcePath.size() - 4) + ".mesh";
+	// Preprocessed meshes can also be shared between runs and processes through the artifacts cache.
+	ArtifactCache::Key key("mesh", MeshBlobHeader::currentVersion);
+	if(ArtifactCache::enabled()){
+		key.add(content.data(), content.size()).add(uint64_t(Resources::meshLevelCount)).add(std::to_string(Resources::meshLevelMaxError)).add(uint64_t(Resources::meshVertexLayout));
+		std::vector<char> artifact;
+		if(ArtifactCache::fetch(key, artifact)){
+			char * rawContent = (char*)malloc((std::max)(artifact.size(), size_t(1)));
+			std::memcpy(rawContent, artifact.data(), artifact.size());
+			data.blob = ResourceData(rawContent, artifact.size(), true);
+			MeshBlobHeader header;
+			if(MeshUtilities::loadMeshBlob(data.blob.data(), data.blob.size(), data.view, header)){
+				data.bbox.minis = glm::vec3(header.bboxMin[0], header.bboxMin[1], header.bboxMin[2]);
+				data.bbox.maxis = glm::vec3(header.bboxMax[0], header.bboxMax[1], header.bboxMax[2]);
+				// Replace the missing or outdated local blob, stamped with the current source.
+				if(saveBlob){
+					header.sourceSize = sourceSize;
+					header.sourceTime = sourceTime;
+					std::memcpy(rawContent, &header, sizeof(MeshBlobHeader));
+					data.blobPath = localBlobPath;
+					Resources::saveRawDataToExternalFile(data.blobPath, rawContent, artifact.size());
+				}
+				return true;
+			}
+			data.blob = ResourceData();
+			data.view = MeshView();
+		}
+	}
+	Mesh & mesh = data.mesh;
+	// Parse the file content in place, on multiple threads for large files.
+	if(content.size() > Resources::parallelMeshLoadingThreshold){
+		MeshUtilities::loadObjParallel(content.data(), content.size(), mesh, MeshUtilities::Indexed, 0, sourcePath);
+	} else {
+		MeshUtilities::loadObj(content.data(), content.size(), mesh, MeshUtilities::Indexed, sourcePath);
+	}
+	// Generate simplified levels of detail, sharing the same vertices.
+	MeshUtilities::generateLevels(mesh, Resources::meshLevelCount, Resources::meshLevelMaxError);
+	// Reorder triangles and vertices for the GPU caches.
+	MeshUtilities::optimizeMesh(mesh);
+	// If uv or positions are missing, tangent/binormals won't be computed.
+	MeshUtilities::computeTangentsAndBinormals(mesh, MeshUtilities::Accumulated, 0, sourcePath);
 	// Compute bounding box.
-	infos.bbox = MeshUtilities::computeBoundingBox(mesh);
-	_meshes[name] = infos;
-	return infos;
+	data.bbox = MeshUtilities::computeBoundingBox(mesh);
+	data.view = MeshView(mesh);
+	
+	// Save the preprocessed mesh next to the source and in the artifacts cache.
+	std::vector<char> blob;
+	if((saveBlob || ArtifactCache::enabled()) && MeshUtilities::saveMeshBlob(mesh, data.bbox, sourceSize, sourceTime, blob)){
+		ArtifactCache::store(key, &blob[0], blob.size());
+		if(saveBlob){
+			data.blobPath = localBlobPath;
+			Resources::saveRawDataToExternalFile(data.blobPath, &blob[0], blob.size());
+		}
+	}
+	return true;
+}
+
+const std::shared_ptr<MeshInfos> Resources::finishMesh(const std::string & name, MeshData & data){
+	Entry<MeshInfos> & entry = _meshes[name];
+	if(!entry.handle){
+		entry.handle = std::make_shared<MeshInfos>();
+	}
+	entry.lastUse = _frame;
+	// Setup GL buffers and attributes, reusing the existing ones when reloading.
+	MeshInfos & infos = *(entry.handle);
+	infos = GLUtilities::setupBuffers(data.view, Resources::meshVertexLayout, &infos);
+	infos.bbox = data.bbox;
+	if(!data.blobPath.empty()){
+		_files[name + ".mesh"] = data.blobPath;
+	}
+	return entry.handle;
 }
 
 
 // Texture methods.
 
-const TextureInfos Resources::getTexture(const std::string & name, bool srgb){
-	
-	// If texture already loaded, return it.
-	if(_textures.count(name) > 0){
-		return _textures[name];
+const std::vector<std::string> Resources::getTexturePaths(const std::string & name){
+	const auto image = _images.find(name);
+	if(image == _images.end()){
+		return std::vector<std::string>();
 	}
-	// Else, find the corresponding file.
-	TextureInfos infos;
-	std::string path = getImagePath(name);
-	
-	if(!path.empty()){
-		// Else, load it and store the infos.
-		infos = GLUtilities::loadTexture({path}, srgb);
-		_textures[name] = infos;
-		return infos;
+	if(!image->second.path.empty()){
+		return {image->second.path};
 	}
 	// Else, maybe there are custom mipmap levels.
 	// In this case the true name is name_mipmaplevel.
 	
 	// How many mipmap levels can we accumulate?
 	std::vector<std::string> paths;
-	unsigned int lastMipmap = 0;
-	std::string mipmapPath = getImagePath(name + "_" + std::to_string(lastMipmap));
-	while(!mipmapPath.empty()) {
-		// Transfer them to the final paths vector.
+	for(const std::string & mipmapPath : image->second.levels){
+		if(mipmapPath.empty()){
+			break;
+		}
 		paths.push_back(mipmapPath);
-		++lastMipmap;
-		mipmapPath = getImagePath(name + "_" + std::to_string(lastMipmap));
-	}
-	if(!paths.empty()){
-		// We found the texture files.
-		// Load them and store the infos.
-		infos = GLUtilities::loadTexture(paths, srgb);
-		_textures[name] = infos;
-		return infos;
 	}
-	
-	// If couldn't file the image, return empty texture infos.
-	Log::Error() << Log::Resources << "Unable to find texture named \"" << name << "\"." << std::endl;
-	return infos;
+	return paths;
 }
 
-
-const TextureInfos Resources::getCubemap(const std::string & name, bool srgb){
-	// If texture already loaded, return it.
-	if(_textures.count(name) > 0){
-		return _textures[name];
+const std::vector<std::vector<std::string>> Resources::getCubemapLevelsPaths(const std::string & name){
+	// A container holds all faces and levels.
+	const std::string containerPath = getImagePath(name);
+	if(TextureContainer::isContainer(containerPath)){
+		return {{containerPath}};
 	}
-	// Else, find the corresponding files.
-	TextureInfos infos;
-	std::vector<std::string> paths = getCubemapPaths(name);
+	const std::vector<std::string> paths = getCubemapPaths(name);
 	if(!paths.empty()){
-		// We found the texture files.
-		// Load them and store the infos.
-		infos = GLUtilities::loadTextureCubemap({paths}, srgb);
-		_textures[name] = infos;
-		return infos;
+		return {paths};
 	}
 	// Else, maybe there are custom mipmap levels.
 	// In this case the true name is name_mipmaplevel.
@@ -349,16 +1199,138 @@ const TextureInfos Resources::getCubemap(const std::string & name, bool srgb){
 		++lastMipmap;
 		mipmapPaths = getCubemapPaths(name + "_" + std::to_string(lastMipmap));
 	}
-	if(!allPaths.empty()){
-		// We found the texture files.
-		// Load them and store the infos.
-		infos = GLUtilities::loadTextureCubemap(allPaths, srgb);
-		_textures[name] = infos;
-		return infos;
+	return allPaths;
+}
+
+const std::shared_ptr<TextureInfos> Resources::getTexture(const std::string & name, bool srgb){
+	recordRequest("texture", name, srgb);
+	// If the texture is loading in the background, finish it now.
+	if(_pendingTextures.count(name) > 0){
+		const std::shared_ptr<Request> request = _pendingTextures[name];
+		waitRequest(request);
+		return _textures.count(name) > 0 ? _textures[name].handle : std::make_shared<TextureInfos>();
+	}
+	// If texture already loaded, return it.
+	Telemetry::cacheAccess(name, _textures.count(name) > 0);
+	if(_textures.count(name) > 0){
+		return _textures[name].handle;
 	}
-	Log::Error() << Log::Resources << "Unable to find cubemap named \"" << name << "\"." << std::endl;
-	// Nothing found, return empty texture.
-	return infos;
+	Telemetry::Asset asset(name);
+	// Else, find the corresponding files.
+	const std::vector<std::string> paths = getTexturePaths(name);
+	if(paths.empty()){
+		Log::Error() << Log::Resources << "Unable to find texture named \"" << name << "\"." << std::endl;
+		// Nothing found, return empty texture.
+		return std::make_shared<TextureInfos>();
+	}
+	// We found the texture files.
+	// Load them and store the infos.
+	// Decode all levels at once, 2D LDR images are flipped.
+	std::vector<DecodedImage> images;
+	TextureInfos infos;
+	infos.cubemap = false;
+	infos.hdr = ImageUtilities::isHDR(paths[0]);
+	if(GLUtilities::decodeImages(paths, !infos.hdr, false, images)){
+		completeMipmaps(images, false, srgb);
+		compressBlocks(images, textureCompressionFormat(name, paths[0], false, srgb), false, srgb);
+		infos = GLUtilities::uploadTexture(images, srgb);
+	}
+	Entry<TextureInfos> & entry = _textures[name];
+	entry.handle = std::make_shared<TextureInfos>(infos);
+	entry.lastUse = _frame;
+	logSavedTexture(name, *entry.handle);
+	return entry.handle;
+}
+
+const std::shared_ptr<TextureInfos> Resources::getTextureAsync(const std::string & name, bool srgb){
+	recordRequest("texture", name, srgb);
+	Telemetry::cacheAccess(name, _textures.count(name) > 0);
+	if(_textures.count(name) > 0){
+		return _textures[name].handle;
+	}
+	const std::shared_ptr<Request> request = std::make_shared<Request>(Request::Texture, name);
+	request->srgb = srgb;
+	request->paths = getTexturePaths(name);
+	if(request->paths.empty()){
+		Log::Error() << Log::Resources << "Unable to find texture named \"" << name << "\"." << std::endl;
+		return std::make_shared<TextureInfos>(getPlaceholder(false, srgb));
+	}
+	request->compression = textureCompressionFormat(name, request->paths[0], false, srgb);
+	Entry<TextureInfos> & entry = _textures[name];
+	entry.handle = std::make_shared<TextureInfos>(getPlaceholder(false, srgb));
+	entry.lastUse = _frame;
+	_pendingTextures[name] = request;
+	startRequest(request);
+	return entry.handle;
+}
+
+const std::shared_ptr<TextureInfos> Resources::getCubemap(const std::string & name, bool srgb){
+	recordRequest("cubemap", name, srgb);
+	// If the texture is loading in the background, finish it now.
+	if(_pendingTextures.count(name) > 0){
+		const std::shared_ptr<Request> request = _pendingTextures[name];
+		waitRequest(request);
+		return _textures.count(name) > 0 ? _textures[name].handle : std::make_shared<TextureInfos>();
+	}
+	// If texture already loaded, return it.
+	Telemetry::cacheAccess(name, _textures.count(name) > 0);
+	if(_textures.count(name) > 0){
+		return _textures[name].handle;
+	}
+	Telemetry::Asset asset(name);
+	// Else, find the corresponding files.
+	const std::vector<std::vector<std::string>> paths = getCubemapLevelsPaths(name);
+	if(paths.empty()){
+		Log::Error() << Log::Resources << "Unable to find cubemap named \"" << name << "\"." << std::endl;
+		// Nothing found, return empty texture.
+		return std::make_shared<TextureInfos>();
+	}
+	// We found the texture files.
+	// Load them and store the infos.
+	// Decode all levels and sides at once, without flipping them.
+	std::vector<std::string> allPaths;
+	for(const auto & levelPaths : paths){
+		allPaths.insert(allPaths.end(), levelPaths.begin(), levelPaths.end());
+	}
+	std::vector<DecodedImage> images;
+	TextureInfos infos;
+	infos.cubemap = true;
+	infos.hdr = ImageUtilities::isHDR(allPaths[0]);
+	if(GLUtilities::decodeImages(allPaths, false, true, images)){
+		completeMipmaps(images, true, srgb);
+		compressBlocks(images, textureCompressionFormat(name, allPaths[0], true, srgb), true, srgb);
+		infos = GLUtilities::uploadTextureCubemap(images, srgb);
+	}
+	Entry<TextureInfos> & entry = _textures[name];
+	entry.handle = std::make_shared<TextureInfos>(infos);
+	entry.lastUse = _frame;
+	logSavedTexture(name, *entry.handle);
+	return entry.handle;
+}
+
+const std::shared_ptr<TextureInfos> Resources::getCubemapAsync(const std::string & name, bool srgb){
+	recordRequest("cubemap", name, srgb);
+	Telemetry::cacheAccess(name, _textures.count(name) > 0);
+	if(_textures.count(name) > 0){
+		return _textures[name].handle;
+	}
+	const std::vector<std::vector<std::string>> allPaths = getCubemapLevelsPaths(name);
+	if(allPaths.empty()){
+		Log::Error() << Log::Resources << "Unable to find cubemap named \"" << name << "\"." << std::endl;
+		return std::make_shared<TextureInfos>(getPlaceholder(true, srgb));
+	}
+	const std::shared_ptr<Request> request = std::make_shared<Request>(Request::Cubemap, name);
+	request->srgb = srgb;
+	for(const auto & levelPaths : allPaths){
+		request->paths.insert(request->paths.end(), levelPaths.begin(), levelPaths.end());
+	}
+	request->compression = textureCompressionFormat(name, request->paths[0], true, srgb);
+	Entry<TextureInfos> & entry = _textures[name];
+	entry.handle = std::make_shared<TextureInfos>(getPlaceholder(true, srgb));
+	entry.lastUse = _frame;
+	_pendingTextures[name] = request;
+	startRequest(request);
+	return entry.handle;
 }
 
 // Program/shaders methods.
@@ -381,6 +1353,7 @@ const std::shared_ptr<ProgramInfos> Resources::getProgram(const std::string & na
 }
 
 const std::shared_ptr<ProgramInfos> Resources::getProgram(const std::string & name, const std::string & vertexName, const std::string & fragmentName, const std::string & geometryName) {
+	Telemetry::cacheAccess(name, _programs.count(name) > 0);
 	if (_programs.count(name) > 0) {
 		return _programs[name];
 	}
@@ -397,6 +1370,30 @@ const std::shared_ptr<ProgramInfos> Resources::getProgram2D(const std::string &
 	return getProgram(name, "passthrough", name);
 }
 
+ProgramHandle Resources::getProgramHandle(const std::string & name, const std::string & vertexName, const std::string & fragmentName, const std::string & geometryName){
+	return _programHandles.insert(getProgram(name, vertexName, fragmentName, geometryName));
+}
+
+MeshHandle Resources::getMeshHandle(const std::string & name){
+	return _meshHandles.insert(getMesh(name));
+}
+
+TextureHandle Resources::getTextureHandle(const std::string & name, bool srgb){
+	return _textureHandles.insert(getTexture(name, srgb));
+}
+
+void Resources::release(const ProgramHandle & handle){
+	_programHandles.remove(handle);
+}
+
+void Resources::release(const MeshHandle & handle){
+	_meshHandles.remove(handle);
+}
+
+void Resources::release(const TextureHandle & handle){
+	_textureHandles.remove(handle);
+}
+
 void Resources::reload() {
 	for (auto & prog : _programs) {
 		prog.second->reload();
@@ -404,6 +1401,84 @@ void Resources::reload() {
 	Log::Info() << Log::Resources << "Shader programs reloaded." << std::endl;
 }
 
+void Resources::watchFiles(const bool enable){
+	if(!enable){
+		_watcher.reset();
+		return;
+	}
+	if(_watcher){
+		return;
+	}
+	_watcher = std::make_shared<FileWatcher>();
+	for(const std::string & directory : _directories){
+		_watcher->watch(directory);
+	}
+}
+
+void Resources::reloadChanges(){
+	std::vector<std::string> changes;
+	_watcher->changes(changes);
+	for(const std::string & fileName : changes){
+		// Only reload files known to the manager.
+		if(_files.count(fileName) == 0){
+			continue;
+		}
+		const std::string & path = _files[fileName];
+		const std::string::size_type extensionPos = fileName.find_last_of(".");
+		const std::string extension = extensionPos == std::string::npos ? "" : fileName.substr(extensionPos + 1);
+		const std::string name = fileName.substr(0, extensionPos);
+		
+		// Rebuild the programs using a modified shader.
+		if(extension == "vert" || extension == "frag" || extension == "geom"){
+			for(auto & program : _programs){
+				if(program.second->dependsOn(fileName)){
+					program.second->reload();
+					Log::Info() << Log::Resources << "Program \"" << program.first << "\" reloaded." << std::endl;
+				}
+			}
+			continue;
+		}
+		// Binary meshes are derived from the OBJ files, they are regenerated when needed.
+		if(extension == "obj"){
+			if(_meshes.count(name) > 0 && _pendingMeshes.count(name) == 0){
+				const std::shared_ptr<Request> request = std::make_shared<Request>(Request::Geometry, name);
+				request->paths.push_back(path);
+				request->paths.push_back(_files.count(name + ".mesh") > 0 ? _files[name + ".mesh"] : "");
+				_pendingMeshes[name] = request;
+				startRequest(request);
+				Log::Info() << Log::Resources << "Reloading mesh \"" << name << "\"." << std::endl;
+			}
+			continue;
+		}
+		// Textures using the modified image, either as a level or as a cubemap face.
+		for(const auto & texture : _textures){
+			if(_pendingTextures.count(texture.first) > 0){
+				continue;
+			}
+			const TextureInfos & infos = *(texture.second.handle);
+			std::vector<std::string> paths;
+			if(infos.cubemap){
+				for(const auto & levelPaths : getCubemapLevelsPaths(texture.first)){
+					paths.insert(paths.end(), levelPaths.begin(), levelPaths.end());
+				}
+			} else {
+				paths = getTexturePaths(texture.first);
+			}
+			if(std::find(paths.begin(), paths.end(), path) == paths.end()){
+				continue;
+			}
+			const std::shared_ptr<Request> request = std::make_shared<Request>(infos.cubemap ? Request::Cubemap : Request::Texture, texture.first);
+			request->srgb = infos.sRGB;
+			request->reload = true;
+			request->paths = paths;
+			request->compression = textureCompressionFormat(texture.first, paths[0], infos.cubemap, infos.sRGB);
+			_pendingTextures[texture.first] = request;
+			startRequest(request);
+			Log::Info() << Log::Resources << "Reloading texture \"" << texture.first << "\"." << std::endl;
+		}
+	}
+}
+
 void Resources::getFiles(const std::string & extension, std::map<std::string, std::string> & files) const {
 	files.clear();
 	for(const auto & file : _files){
@@ -434,7 +1509,8 @@ char * Resources::loadRawDataFromExternalFile(const std::string & path, size_t &
 		return NULL;
 	}
 	std::ifstream::pos_type fileSize = inputFile.tellg();
-	rawContent = new char[fileSize];
+	// Allocate with malloc, as all callers release the data with free.
+	rawContent = (char*)malloc((size_t)fileSize);
 	inputFile.seekg(0, std::ios::beg);
 	inputFile.read(&rawContent[0], fileSize);
 	inputFile.close();
@@ -442,6 +1518,47 @@ char * Resources::loadRawDataFromExternalFile(const std::string & path, size_t &
 	return rawContent;
 }
 
+bool Resources::getExternalFileInfos(const std::string & path, uint64_t & size, uint64_t & time){
+	struct stat infos;
+	if(stat(path.c_str(), &infos) != 0){
+		return false;
+	}
+	size = (uint64_t)infos.st_size;
+	time = (uint64_t)infos.st_mtime;
+	return true;
+}
+
+void Resources::getExternalFiles(const std::string & directoryPath, std::vector<std::string> & files){
+	tinydir_dir dir;
+	if(tinydir_open(&dir, widen(directoryPath)) == -1){
+		tinydir_close(&dir);
+		Log::Error() << Log::Resources << "Unable to open directory at path \"" << directoryPath << "\"" << std::endl;
+		return;
+	}
+	while (dir.has_next) {
+		tinydir_file file;
+		if(tinydir_readfile(&dir, &file) != -1){
+			const std::string name = narrow(file.name);
+			// Skip special directories and system files.
+			if(name.size() > 0 && name.at(0) != '.'){
+				if(file.is_dir){
+					std::vector<std::string> subFiles;
+					getExternalFiles(directoryPath + "/" + name, subFiles);
+					for(const std::string & subFile : subFiles){
+						files.push_back(name + "/" + subFile);
+					}
+				} else {
+					files.push_back(name);
+				}
+			}
+		}
+		if (tinydir_next(&dir) == -1){
+			break;
+		}
+	}
+	tinydir_close(&dir);
+}
+
 std::string Resources::loadStringFromExternalFile(const std::string & path) {
 	std::ifstream inputFile(widen(path));
 	if (inputFile.bad() || inputFile.fail()){
@@ -457,14 +1574,19 @@ std::string Resources::loadStringFromExternalFile(const std::string & path) {
 	return line;
 }
 
-void Resources::saveRawDataToExternalFile(const std::string & path, char * rawContent, const size_t size) {
+bool Resources::saveRawDataToExternalFile(const std::string & path, char * rawContent, const size_t size) {
 	std::ofstream outputFile(widen(path), std::ios::binary);
 	if (outputFile.bad() || outputFile.fail()){
 		Log::Error() << Log::Resources << "Unable to save file at path \"" << path << "\"." << std::endl;
-		return;
+		return false;
 	}
 	outputFile.write(rawContent, size);
 	outputFile.close();
+	if(!outputFile){
+		Log::Error() << Log::Resources << "Unable to write file at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	return true;
 }
 
 void Resources::saveStringToExternalFile(const std::string & path, const std::string & content) {
@@ -3,16 +3,96 @@
 #include "../Common.hpp"
 #include "../graphics/GLUtilities.hpp"
 #include "../graphics/ProgramInfos.hpp"
+#include "../helpers/ThreadUtilities.hpp"
+#include "ResourceHandle.hpp"
+#include "MipmapUtilities.hpp"
+#include "TextureCompression.hpp"
+#include <unordered_map>
+
+class MappedFile;
+class ResourcePack;
+class FileWatcher;
+
+/**
+ \brief Read-only content of a resource file. Depending on where the file is stored, this is a view into a mounted resource pack (valid as long as the resources manager), a mapped file on disk, or a heap copy released with the object.
+ \ingroup Resources
+ */
+class ResourceData {
+	
+public:
+	
+	/** Default constructor, empty content. */
+	ResourceData();
+	
+	/** Reference existing content.
+	 \param data the content
+	 \param size the size of the content in bytes
+	 \param owned should the content be released with free when the object is destroyed
+	 */
+	ResourceData(const char * data, const size_t size, const bool owned);
+	
+	/** Reference the content of a mapped file.
+	 \param file the mapped file, released when the object is destroyed
+	 */
+	ResourceData(std::unique_ptr<MappedFile> && file);
+	
+	/** Move constructor.
+	 \param other the content to move
+	 */
+	ResourceData(ResourceData && other);
+	
+	/** Move assignment operator.
+	 \param other the content to move
+	 \return a reference to the object
+	 */
+	ResourceData & operator= (ResourceData && other);
+	
+	/** Query the content.
+	 \return a pointer to the first byte, or NULL if there is no content
+	 */
+	const char * data() const { return _data; }
+	
+	/** Query the content size.
+	 \return the size in bytes
+	 */
+	size_t size() const { return _size; }
+	
+	/** Query if there is any content.
+	 \return true if the content is empty
+	 */
+	bool empty() const { return _data == NULL || _size == 0; }
+	
+	/** Destructor. Release the content if owned. */
+	~ResourceData();
+	
+	/** Assignment operator (disabled). */
+	ResourceData& operator= (const ResourceData&) = delete;
+	
+	/** Copy constructor (disabled). */
+	ResourceData (const ResourceData&) = delete;
+	
+private:
+	
+	/** Release the content if owned. */
+	void clean();
+	
+	const char * _data; ///< The content.
+	size_t _size; ///< The content size.
+	bool _owned; ///< Should the content be released with free.
+	std::unique_ptr<MappedFile> _file; ///< The mapped file, if any.
+	
+};
 
 /**
  \brief The Resources manager is responsible for all resources loading and setup.
- \details It provides an abstraction over the file system: resources can be loaded directly from files on disk, or from a zip archive.
+ \details It provides an abstraction over the file system: resources can be loaded directly from files on disk, from a zip archive, or from a memory-mapped resource pack.
+ Textures and meshes can also be loaded in the background: files are read and decoded by worker threads, and the GPU objects are created on the main thread by update(), under a per-frame budget.
+ Textures and meshes are shared through reference-counted handles. Once a resource isn't referenced anymore, it stays resident until the cache budget is exceeded, and is then evicted in least recently used order.
+ Resources directories on disk can be watched for changes, to reload the modified shaders, textures and meshes while keeping their OpenGL IDs.
  \ingroup Resources
  */
 class Resources {
 	
-	friend class ImageUtilities;
-	
 public:
 	
 	/// \brief Shader types
@@ -20,6 +100,20 @@ public:
 		Vertex, Fragment, Geometry
 	};
 	
+	/// \brief Types of shared resources
+	enum ResourceType {
+		Textures, Meshes, Programs
+	};
+	
+	/// \brief Memory statistics of a type of resources.
+	struct Statistics {
+		size_t count = 0; ///< Number of resident resources.
+		size_t size = 0; ///< GPU memory used by the resident resources, in bytes.
+		size_t unusedCount = 0; ///< Number of resident resources not referenced anymore.
+		size_t unusedSize = 0; ///< GPU memory used by the resources not referenced anymore, in bytes.
+		size_t savedSize = 0; ///< GPU memory saved by storing HDR textures as half floats and compressing textures, in bytes.
+	};
+	
 	/** Singleton accessor.
 	 \return the resources manager singleton
 	 */
@@ -29,50 +123,194 @@ public:
 	 */
 	static std::string defaultPath;
 	
+	/** Size in bytes above which mesh files are parsed on multiple threads.
+	 */
+	static size_t parallelMeshLoadingThreshold;
+	
+	/** Should preprocessed binary meshes (.mesh) be saved next to the OBJ files they are generated from.
+	 */
+	static bool cacheMeshBlobs;
+	
+	/** Storage layout of the mesh vertex attributes on the GPU.
+	 */
+	static GLUtilities::VertexLayout meshVertexLayout;
+	
+	/** Maximum number of levels of detail generated for each mesh, including the original one.
+	 */
+	static unsigned int meshLevelCount;
+	
+	/** Maximum geometric error of generated levels of detail, relative to the mesh bounding box diagonal.
+	 */
+	static float meshLevelMaxError;
+	
+	/** Should missing texture mipmap levels be generated on the CPU in linear space, with the results stored in the artifact cache. Only applied when the cache is enabled, else or if false, they are generated by the driver.
+	 */
+	static bool generateMipmaps;
+	
+	/** Kernel used to generate texture mipmap levels on the CPU.
+	 */
+	static MipmapUtilities::Filter mipmapFilter;
+	
+	/** Should textures with all their mipmap levels be block-compressed on the CPU when supported, with the results stored in the artifact cache. Only applied when the cache is enabled, textures are else uploaded uncompressed. The format is picked from the texture name: BC5 for normal maps (_normal), BC4 for depth maps (_depth), BC1 or BC7 for material maps (_rough_met_ao) and colors, BC6H for HDR cubemaps. HDR 2D textures are kept uncompressed. KTX2 containers are uploaded as stored.
+	 */
+	static bool compressTextures;
+	
+	/** Quality of the texture block compression. The high quality also picks BC7 for material maps, the fast quality BC1 or BC3 for colors.
+	 */
+	static TextureCompression::Quality compressionQuality;
+	
+	/** Maximum number of bytes sent to the GPU by update() each frame. At least one resource is uploaded each frame.
+	 */
+	static size_t uploadBudget;
+	
+	/** Maximum GPU memory used by the textures and meshes in the cache, in bytes. When exceeded, resources not referenced anymore are evicted by update(), least recently used first.
+	 */
+	static size_t cacheBudget;
+	
 private:
 	
+	/// \brief The images available for a base name, indexed when parsing the resources.
+	struct ImageVariants {
+		std::string path; ///< Path of the image with this exact name, if any.
+		std::vector<std::string> levels; ///< Paths of the custom mipmap levels (name_0, name_1,...), empty for missing levels.
+		std::string faces[6]; ///< Paths of the cubemap faces (name_px, name_nx, name_py, name_ny, name_pz, name_nz), empty for missing faces.
+	};
+	
+	/// \brief A resource in the cache.
+	template<typename T>
+	struct Entry {
+		std::shared_ptr<T> handle; ///< The resource, shared with its users.
+		uint64_t lastUse = 0; ///< Last frame where the resource was referenced outside of the cache.
+	};
+	
 	/** Constructor. Parse the directory or archive structure at the given path.
 	 \param root the resources root path
 	 */
 	Resources(const std::string & root);
 	
-	/** Parse the archive at the given path (using miniz), listing all files it contains.
+	/// \brief A zip archive, kept open and mapped in memory for the lifetime of the manager.
+	struct Archive;
+	
+	/** Parse the archive at the given path (using miniz), listing all files it contains. The archive is kept open, and the index of each file is recorded for extraction.
 	 \param archivePath the path to the archive
 	 */
 	void parseArchive(const std::string & archivePath);
 	
-	/** Parse the directory at the given path (using tinydir), listing all files it contains.
+	/** Mount the resource pack at the given path, listing all files it contains. The pack is kept mapped in memory.
+	 \param packPath the path to the pack
+	 */
+	void parsePack(const std::string & packPath);
+	
+	/** Parse the directory at the given path (using tinydir), listing all files it contains. Subdirectories are listed in parallel.
 	 \param directoryPath the path to the directory
 	 */
 	void parseDirectory(const std::string & directoryPath);
 	
-	/** Expand an image name in its path, testing all possibles extensions.
+	/** Register a resource file, and index it if it is an image. Duplicate file names are rejected.
+	 \param fileName the file name, with extension
+	 \param path the file path
+	 */
+	void registerFile(const std::string & fileName, const std::string & path);
+	
+	/** Expand an image name in its path, using the images index.
 	 \param name the name of the image
 	 \return the image path
 	 */
 	const std::string getImagePath(const std::string & name);
 	
-	/** Expand a cubemap base name in its faces paths, testing all possibles extensions.
+	/** Expand a cubemap base name in its faces paths, using the images index.
 	 \param name the base name of the cubemap
 	 \return a list of each face path
 	 */
 	const std::vector<std::string> getCubemapPaths(const std::string & name);
 	
-	/** Load raw binary data from a resource file
-	 \param path the path to the file
-	 \param size will contain the number of bytes loaded from the file
-	 \return a pointer to the file binary data
+	/** Find the images of a 2D texture: either a single image or container, or one image per custom mipmap level (name_0, name_1,...).
+	 \param name the texture base name
+	 \return the path of each level
+	 */
+	const std::vector<std::string> getTexturePaths(const std::string & name);
+	
+	/** Find the faces images of a cubemap, with custom mipmap levels if present, or a container holding all faces and levels.
+	 \param name the cubemap base name
+	 \return the paths of the six faces of each level, or the container path alone
 	 */
-	char * getRawData(const std::string & path, size_t & size);
+	const std::vector<std::vector<std::string>> getCubemapLevelsPaths(const std::string & name);
+	
+	/// \brief A texture or mesh loaded in the background.
+	struct Request;
+	
+	/// \brief Mesh data loaded on the CPU, waiting to be uploaded.
+	struct MeshData;
+	
+	/** Load a mesh on the CPU, from its preprocessed binary version (.mesh) if it is valid and up to date, else from the OBJ file. In the latter case, the binary version is regenerated.
+	 \param sourcePath the path to the OBJ file, if available
+	 \param blobPath the path to the binary mesh, if available
+	 \param data will contain the mesh data
+	 \return false if the mesh couldn't be loaded
+	 \note This can be called from multiple threads at once.
+	 */
+	bool loadMeshData(const std::string & sourcePath, const std::string & blobPath, MeshData & data);
+	
+	/** Upload a mesh loaded on the CPU to the GPU and register it. If the mesh already has a handle, it is updated.
+	 \param name the mesh name
+	 \param data the mesh data
+	 \return the mesh handle
+	 */
+	const std::shared_ptr<MeshInfos> finishMesh(const std::string & name, MeshData & data);
+	
+	/** Submit a background request to the loading threads.
+	 \param request the request to execute
+	 */
+	void startRequest(const std::shared_ptr<Request> & request);
+	
+	/** Record an asset request in the current manifest, if recording.
+	 \param type the asset type (texture, cubemap or mesh)
+	 \param name the asset name
+	 \param srgb is the texture gamma corrected
+	 */
+	void recordRequest(const std::string & type, const std::string & name, const bool srgb);
+	
+	/** Upload the result of a decoded background request, register it and update its handle.
+	 \param request the decoded request
+	 \return the number of bytes uploaded
+	 */
+	size_t finishRequest(Request & request);
+	
+	/** Wait for a background request to be decoded and finish it immediately.
+	 \param request the request to wait for
+	 */
+	void waitRequest(const std::shared_ptr<Request> & request);
+	
+	/** Query the texture displayed while a texture is loaded in the background, created on first use.
+	 \param cubemap is the placeholder a cubemap
+	 \param srgb is the placeholder a gamma corrected color (else a flat normal, for 2D textures)
+	 \return the placeholder texture informations
+	 */
+	const TextureInfos & getPlaceholder(const bool cubemap, const bool srgb);
+	
+	/** Evict resources not referenced anymore, least recently used first, until the cache fits in its budget.
+	 */
+	void trimCache();
+	
+	/** Reload the resources whose files were modified on disk: programs using a modified shader are rebuilt, textures and meshes are reloaded in the background and updated in place.
+	 */
+	void reloadChanges();
 	
 public:
 	
 	
-	/** Add another resources directory/archive.
-	 \param path the path to the additional directory/archive to parse
+	/** Add another resources directory, zip archive (.zip) or resource pack (.pack).
+	 \param path the path to the additional directory/archive/pack to parse
 	 */
 	void addResources(const std::string & path);
 	
+	/** Access the content of a resource file. Files stored uncompressed in a resource pack are referenced in place, files on disk are mapped, compressed files are extracted to the heap.
+	 \param path the path to the file
+	 \return the read-only file content, empty if the file couldn't be loaded
+	 \note This can be called from multiple threads at once, as long as no resources are added in the meantime.
+	 */
+	ResourceData getData(const std::string & path);
+	
 	/** Get a text file resource.
 	 \param filename the file name
 	 \return the string content of the file
@@ -81,23 +319,68 @@ public:
 	
 	/** Get a geometric mesh resource.
 	 \param name the mesh file name
-	 \return the mesh informations
+	 \return a handle to the mesh informations, the mesh stays resident as long as it is referenced
 	 */
-	const MeshInfos getMesh(const std::string & name);
+	const std::shared_ptr<MeshInfos> getMesh(const std::string & name);
 	
 	/** Get a 2D texture resource. Automatically handle custom mipmaps if present.
 	 \param name the texture base name
 	 \param srgb should the texture be gamma corrected
-	 \return the texture informations
+	 \return a handle to the texture informations, the texture stays resident as long as it is referenced
 	 */
-	const TextureInfos getTexture(const std::string & name, bool srgb = true);
+	const std::shared_ptr<TextureInfos> getTexture(const std::string & name, bool srgb = true);
 	
 	/** Get a cubemap texture resource. Automatically handle custom mipmaps if present.
 	 \param name the texture base name
 	 \param srgb should the texture be gamma corrected
-	 \return the texture informations
+	 \return a handle to the texture informations, the texture stays resident as long as it is referenced
+	 */
+	const std::shared_ptr<TextureInfos> getCubemap(const std::string & name, bool srgb = true);
+	
+	/** Get a 2D texture resource, loaded in the background if needed. Until the texture is ready, the handle contains a placeholder texture.
+	 \param name the texture base name
+	 \param srgb should the texture be gamma corrected
+	 \return a handle to the texture informations, updated by update() once the texture is loaded
+	 */
+	const std::shared_ptr<TextureInfos> getTextureAsync(const std::string & name, bool srgb = true);
+	
+	/** Get a cubemap texture resource, loaded in the background if needed. Until the texture is ready, the handle contains a placeholder cubemap.
+	 \param name the texture base name
+	 \param srgb should the texture be gamma corrected
+	 \return a handle to the texture informations, updated by update() once the texture is loaded
+	 */
+	const std::shared_ptr<TextureInfos> getCubemapAsync(const std::string & name, bool srgb = true);
+	
+	/** Get a geometric mesh resource, loaded in the background if needed. Until the mesh is ready, the handle contains an empty mesh.
+	 \param name the mesh file name
+	 \return a handle to the mesh informations, updated by update() once the mesh is loaded
+	 */
+	const std::shared_ptr<MeshInfos> getMeshAsync(const std::string & name);
+	
+	/** Reload modified resources if watching files, upload the resources loaded in the background since the last call, within the per-frame budget, and evict unused resources if the cache is over budget. Should be called once per frame on the main thread.
+	 \see Resources::uploadBudget, Resources::cacheBudget
+	 */
+	void update();
+	
+	/** Query the number of resources still loading in the background.
+	 \return the number of pending resources
+	 */
+	size_t pendingCount() const;
+	
+	/** Start recording the textures and meshes requested for a named set of assets (a scene for instance), in order. If a manifest has been recorded for this name during a previous run (or shipped as name.manifest with the resources), all the assets it lists are first requested in the background, so that they are decoded in parallel and mostly ready when requested again.
+	 \param name the manifest name
+	 */
+	void beginManifest(const std::string & name);
+	
+	/** Stop recording the requested assets, and save the manifest in the artifacts cache if it changed. Nothing is saved when the cache is disabled.
 	 */
-	const TextureInfos getCubemap(const std::string & name, bool srgb = true);
+	void endManifest();
+	
+	/** Query memory statistics for a type of resources. The size of programs is not tracked.
+	 \param type the type of resources
+	 \return the statistics
+	 */
+	const Statistics getStatistics(const ResourceType type) const;
 	
 	/** Get a shader text resource.
 	 \param name the shader file name
@@ -129,10 +412,71 @@ public:
 	 */
 	const std::shared_ptr<ProgramInfos> getProgram2D(const std::string & name);
 	
+	/** Issue a handle to an OpenGL program resource, loading it if needed. Rendering code called every frame should keep handles instead of querying resources by name.
+	 \param name the identifying name of the program
+	 \param vertexName the name of the vertex shader
+	 \param fragmentName the name of the fragment shader
+	 \param geometryName the name of the (optional) geometry shader
+	 \return a handle to the program, keeping it resident until released
+	 */
+	ProgramHandle getProgramHandle(const std::string & name, const std::string & vertexName, const std::string & fragmentName, const std::string & geometryName = "");
+	
+	/** Issue a handle to a geometric mesh resource, loading it if needed.
+	 \param name the mesh file name
+	 \return a handle to the mesh, keeping it resident until released
+	 */
+	MeshHandle getMeshHandle(const std::string & name);
+	
+	/** Issue a handle to a 2D texture resource, loading it if needed.
+	 \param name the texture base name
+	 \param srgb should the texture be gamma corrected
+	 \return a handle to the texture, keeping it resident until released
+	 */
+	TextureHandle getTextureHandle(const std::string & name, bool srgb = true);
+	
+	/** Resolve a program handle, in constant time.
+	 \param handle the handle
+	 \return the program informations, or null if the handle was released
+	 */
+	ProgramInfos * resolve(const ProgramHandle & handle) const { return _programHandles.resolve(handle); }
+	
+	/** Resolve a mesh handle, in constant time.
+	 \param handle the handle
+	 \return the mesh informations, or null if the handle was released
+	 */
+	MeshInfos * resolve(const MeshHandle & handle) const { return _meshHandles.resolve(handle); }
+	
+	/** Resolve a texture handle, in constant time.
+	 \param handle the handle
+	 \return the texture informations, or null if the handle was released
+	 */
+	TextureInfos * resolve(const TextureHandle & handle) const { return _textureHandles.resolve(handle); }
+	
+	/** Release a program handle. The program can then be reloaded or evicted as any other resource.
+	 \param handle the handle to release
+	 */
+	void release(const ProgramHandle & handle);
+	
+	/** Release a mesh handle. The mesh can then be evicted from the cache if not referenced anymore.
+	 \param handle the handle to release
+	 */
+	void release(const MeshHandle & handle);
+	
+	/** Release a texture handle. The texture can then be evicted from the cache if not referenced anymore.
+	 \param handle the handle to release
+	 */
+	void release(const TextureHandle & handle);
+	
 	/** Reload all shader programs.
 	 */
 	void reload();
 	
+	/** Watch the resources directories on disk, and reload the modified resources in update(). Directories added later are also watched.
+	 \param enable should the directories be watched
+	 \note Using inotify on Linux, polling otherwise. Only files already known to the manager are reloaded.
+	 */
+	void watchFiles(const bool enable);
+	
 	/** Load raw binary data from an external file
 	 \param path the path to the file on disk
 	 \param size will contain the number of bytes loaded from the file
@@ -140,6 +484,20 @@ public:
 	 */
 	static char * loadRawDataFromExternalFile(const std::string & path, size_t & size);
 	
+	/** Query the size and modification time of an external file.
+	 \param path the path to the file on disk
+	 \param size will contain the size of the file in bytes
+	 \param time will contain the last modification time of the file
+	 \return false if the file doesn't exist
+	 */
+	static bool getExternalFileInfos(const std::string & path, uint64_t & size, uint64_t & time);
+	
+	/** List all files in an external directory and its subdirectories, skipping system files.
+	 \param directoryPath the path to the directory on disk
+	 \param files will contain the path of each file, relative to the directory
+	 */
+	static void getExternalFiles(const std::string & directoryPath, std::vector<std::string> & files);
+	
 	/** Load text data from an external file
 	 \param path the  path to the file on disk
 	 \return the file string content
@@ -151,8 +509,9 @@ public:
 	 \param path the  path to the file on disk
 	 \param rawContent a pointer to the file binary data
 	 \param size will contain the number of bytes loaded from the file
+	 \return true if the file was written
 	 */
-	static void saveRawDataToExternalFile(const std::string & path, char * rawContent, const size_t size);
+	static bool saveRawDataToExternalFile(const std::string & path, char * rawContent, const size_t size);
 	
 	/** Write text data to an external file
 	 \param path the  path to the file on disk
@@ -185,10 +544,31 @@ private:
 	Resources (const Resources&) = delete;
 	
 	
-	std::map<std::string, std::string> _files; ///< Listing of available files and their paths.
-	std::map<std::string, TextureInfos> _textures; ///< Loaded textures, identified by name.
-	std::map<std::string, MeshInfos> _meshes; ///< Loaded meshes, identified by name.
+	std::unordered_map<std::string, std::string> _files; ///< Listing of available files and their paths.
+	std::unordered_map<std::string, ImageVariants> _images; ///< Images available for each base name (without extension).
+	std::map<std::string, Entry<TextureInfos>> _textures; ///< Loaded textures, identified by name.
+	std::map<std::string, Entry<MeshInfos>> _meshes; ///< Loaded meshes, identified by name.
 	std::map<std::string, std::shared_ptr<ProgramInfos>> _programs; ///< Loaded shader programs, identified by name.
+	HandleTable<ProgramInfos> _programHandles; ///< Programs referenced by handles.
+	HandleTable<MeshInfos> _meshHandles; ///< Meshes referenced by handles.
+	HandleTable<TextureInfos> _textureHandles; ///< Textures referenced by handles.
+	std::vector<std::shared_ptr<Archive>> _archives; ///< Opened archives.
+	std::map<std::string, std::pair<size_t, unsigned int>> _archiveEntries; ///< Index of the archive and of the entry in this archive for each archived file, identified by path.
+	std::map<std::string, std::shared_ptr<ResourcePack>> _packs; ///< Mounted resource packs, identified by path.
+	std::vector<std::string> _directories; ///< Resources directories on disk.
+	std::shared_ptr<FileWatcher> _watcher; ///< Watch the resources directories, if enabled.
+	
+	std::unique_ptr<ThreadPool> _loader; ///< Loading threads, created on first use.
+	std::map<std::string, std::shared_ptr<Request>> _pendingTextures; ///< Textures loading in the background, identified by name.
+	std::map<std::string, std::shared_ptr<Request>> _pendingMeshes; ///< Meshes loading in the background, identified by name.
+	std::deque<std::shared_ptr<Request>> _decoded; ///< Requests decoded and waiting to be uploaded.
+	std::mutex _decodedMutex; ///< Protect the decoded requests list.
+	std::condition_variable _decodedCondition; ///< Signal a newly decoded request.
+	TextureInfos _placeholders[3]; ///< Placeholder textures: color, normal and cubemap.
+	uint64_t _frame = 0; ///< Number of calls to update().
+	std::string _manifestName; ///< Name of the manifest being recorded, if any.
+	std::vector<std::string> _manifest; ///< Assets requested since the manifest recording started, in order.
+	std::vector<std::string> _previousManifest; ///< Assets listed in the previous version of the manifest.
 	
 };
 
@@ -0,0 +1,693 @@
+#include "TextureCompression.hpp"
+#include "../helpers/ThreadUtilities.hpp"
+#include "../helpers/HalfFloat.hpp"
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+/// SSE instructions are available.
+#define TEXTURE_COMPRESSION_SSE
+#endif
+
+// sRGB variants of the S3TC formats, from EXT_texture_sRGB.
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+/// Largest finite half float, as bits.
+const float compressionMaxHalf = float(0x7BFF);
+
+/// Interpolation weights of the 4 bits indices of BC6H and BC7, in 64th.
+const float compressionWeights4[16] = {
+	0.0f, 4.0f/64.0f, 9.0f/64.0f, 13.0f/64.0f, 17.0f/64.0f, 21.0f/64.0f, 26.0f/64.0f, 30.0f/64.0f,
+	34.0f/64.0f, 38.0f/64.0f, 43.0f/64.0f, 47.0f/64.0f, 51.0f/64.0f, 55.0f/64.0f, 60.0f/64.0f, 1.0f
+};
+
+/// Interpolation weights of the BC1 colors, sorted from the first endpoint to the second one.
+const float compressionWeightsBC1[4] = { 0.0f, 1.0f/3.0f, 2.0f/3.0f, 1.0f };
+
+/// Interpolation weights of the BC4 values in eight values mode, sorted from the first endpoint to the second one.
+const float compressionWeightsBC4[8] = { 0.0f, 1.0f/7.0f, 2.0f/7.0f, 3.0f/7.0f, 4.0f/7.0f, 5.0f/7.0f, 6.0f/7.0f, 1.0f };
+
+/// \brief Pixels of a 4x4 block, one array per channel.
+struct CompressionBlock {
+	alignas(16) float values[4][16]; ///< Values of each channel, row by row.
+};
+
+/// \brief Endpoints and indices of an encoded block.
+struct CompressionFit {
+	float endpoints[2][4]; ///< Dequantized endpoints.
+	uint32_t quantized[2][4]; ///< Quantized endpoints.
+	uint32_t pbits[2]; ///< Shared least significant bit of each endpoint, for BC7.
+	uint8_t indices[16]; ///< Palette entry of each pixel, sorted from the first endpoint to the second one.
+	float error; ///< Squared error of the block.
+};
+
+/// \brief Write bits in a block, least significant first.
+struct CompressionBitWriter {
+	uint8_t * data; ///< The zero-initialized block.
+	unsigned int position; ///< The current bit position.
+
+	/** Constructor.
+	 \param dst the block, will be cleared
+	 \param size the block size in bytes
+	 */
+	CompressionBitWriter(uint8_t * dst, const size_t size) : data(dst), position(0) {
+		std::memset(data, 0, size);
+	}
+
+	/** Append bits.
+	 \param value the bits to write
+	 \param count the number of bits
+	 */
+	void write(const uint32_t value, const unsigned int count){
+		for(unsigned int i = 0; i < count; ++i, ++position){
+			if((value >> i) & 1u){
+				data[position >> 3] |= uint8_t(1u << (position & 7u));
+			}
+		}
+	}
+};
+
+/** Read the pixels of a block, clamping at the image borders.
+ \param image the image
+ \param bx the horizontal block index
+ \param by the vertical block index
+ \param halfBits should HDR values be converted to half float bits
+ \param block will contain the pixels, in [0,255] for LDR images
+ */
+void loadCompressionBlock(const DecodedImage & image, const unsigned int bx, const unsigned int by, const bool halfBits, CompressionBlock & block){
+	const unsigned int channels = image.channels;
+	for(unsigned int y = 0; y < 4; ++y){
+		const size_t sy = (std::min)(4 * by + y, image.height - 1);
+		for(unsigned int x = 0; x < 4; ++x){
+			const size_t sx = (std::min)(4 * bx + x, image.width - 1);
+			const size_t offset = (sy * image.width + sx) * channels;
+			const unsigned int pid = 4 * y + x;
+			float pixel[4] = {};
+			if(!image.hdr){
+				const unsigned char * src = static_cast<const unsigned char *>(image.data) + offset;
+				for(unsigned int c = 0; c < channels; ++c){
+					pixel[c] = float(src[c]);
+				}
+			} else if(image.half){
+				const uint16_t * src = static_cast<const uint16_t *>(image.data) + offset;
+				for(unsigned int c = 0; c < channels; ++c){
+					pixel[c] = halfBits ? float(src[c]) : HalfFloat::toFloat(src[c]);
+				}
+			} else {
+				const float * src = static_cast<const float *>(image.data) + offset;
+				for(unsigned int c = 0; c < channels; ++c){
+					pixel[c] = halfBits ? float(HalfFloat::fromFloat(src[c])) : src[c];
+				}
+			}
+			// Grey images are expanded, missing alpha is opaque.
+			for(unsigned int c = 0; c < 3; ++c){
+				block.values[c][pid] = pixel[(std::min)(c, channels - 1)];
+			}
+			block.values[3][pid] = channels == 4 ? pixel[3] : (image.hdr ? 1.0f : 255.0f);
+		}
+	}
+	if(!halfBits){
+		return;
+	}
+	// BC6H only stores unsigned finite values, negative half floats have their sign bit set.
+	for(unsigned int c = 0; c < 3; ++c){
+		for(unsigned int pid = 0; pid < 16; ++pid){
+			float & value = block.values[c][pid];
+			value = value >= float(0x8000) ? 0.0f : (std::min)(value, compressionMaxHalf);
+		}
+	}
+}
+
+/** Find the palette entry closest to each pixel of a block.
+ \param block the pixels
+ \param channels the number of channels to consider
+ \param endpoints the dequantized endpoints
+ \param weights the interpolation weight of each palette entry
+ \param levels the number of palette entries
+ \param indices will contain the palette entry of each pixel
+ \return the squared error of the block
+ */
+float selectIndices(const CompressionBlock & block, const int channels, const float endpoints[2][4], const float * weights, const int levels, uint8_t * indices){
+	float palette[16][4];
+	for(int l = 0; l < levels; ++l){
+		for(int c = 0; c < channels; ++c){
+			palette[l][c] = endpoints[0][c] + weights[l] * (endpoints[1][c] - endpoints[0][c]);
+		}
+	}
+	float total = 0.0f;
+#ifdef TEXTURE_COMPRESSION_SSE
+	// Process four pixels at once.
+	for(int group = 0; group < 16; group += 4){
+		__m128 bestError = _mm_set1_ps(std::numeric_limits<float>::max());
+		__m128 bestIndex = _mm_setzero_ps();
+		for(int l = 0; l < levels; ++l){
+			__m128 error = _mm_setzero_ps();
+			for(int c = 0; c < channels; ++c){
+				const __m128 diff = _mm_sub_ps(_mm_load_ps(&block.values[c][group]), _mm_set1_ps(palette[l][c]));
+				error = _mm_add_ps(error, _mm_mul_ps(diff, diff));
+			}
+			const __m128 better = _mm_cmplt_ps(error, bestError);
+			bestError = _mm_min_ps(error, bestError);
+			bestIndex = _mm_or_ps(_mm_and_ps(better, _mm_set1_ps(float(l))), _mm_andnot_ps(better, bestIndex));
+		}
+		alignas(16) float errors[4];
+		alignas(16) float ids[4];
+		_mm_store_ps(errors, bestError);
+		_mm_store_ps(ids, bestIndex);
+		for(int i = 0; i < 4; ++i){
+			total += errors[i];
+			indices[group + i] = uint8_t(ids[i]);
+		}
+	}
+#else
+	for(int pid = 0; pid < 16; ++pid){
+		float bestError = std::numeric_limits<float>::max();
+		int bestIndex = 0;
+		for(int l = 0; l < levels; ++l){
+			float error = 0.0f;
+			for(int c = 0; c < channels; ++c){
+				const float diff = block.values[c][pid] - palette[l][c];
+				error += diff * diff;
+			}
+			if(error < bestError){
+				bestError = error;
+				bestIndex = l;
+			}
+		}
+		total += bestError;
+		indices[pid] = uint8_t(bestIndex);
+	}
+#endif
+	return total;
+}
+
+/** Compute endpoints at the extremities of the block pixels projected on their principal axis.
+ \param block the pixels
+ \param channels the number of channels to consider
+ \param endpoints will contain the endpoints
+ */
+void principalEndpoints(const CompressionBlock & block, const int channels, float endpoints[2][4]){
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for(int c = 0; c < channels; ++c){
+		for(int pid = 0; pid < 16; ++pid){
+			mean[c] += block.values[c][pid];
+		}
+		mean[c] /= 16.0f;
+	}
+	float covariance[4][4] = {};
+	for(int pid = 0; pid < 16; ++pid){
+		for(int a = 0; a < channels; ++a){
+			const float da = block.values[a][pid] - mean[a];
+			for(int b = a; b < channels; ++b){
+				covariance[a][b] += da * (block.values[b][pid] - mean[b]);
+			}
+		}
+	}
+	// Start the power iteration from the covariance row with the largest variance.
+	int largest = 0;
+	for(int a = 0; a < channels; ++a){
+		for(int b = 0; b < a; ++b){
+			covariance[a][b] = covariance[b][a];
+		}
+		if(covariance[a][a] > covariance[largest][largest]){
+			largest = a;
+		}
+	}
+	float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for(int c = 0; c < channels; ++c){
+		axis[c] = covariance[largest][c];
+	}
+	float norm = 0.0f;
+	for(int it = 0; it < 8; ++it){
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		norm = 0.0f;
+		for(int a = 0; a < channels; ++a){
+			for(int b = 0; b < channels; ++b){
+				next[a] += covariance[a][b] * axis[b];
+			}
+			norm = (std::max)(norm, std::abs(next[a]));
+		}
+		if(norm < 1e-12f){
+			break;
+		}
+		for(int c = 0; c < channels; ++c){
+			axis[c] = next[c] / norm;
+		}
+	}
+	float length = 0.0f;
+	for(int c = 0; c < channels; ++c){
+		length += axis[c] * axis[c];
+	}
+	if(norm < 1e-12f || length < 1e-12f){
+		// Uniform block.
+		for(int c = 0; c < channels; ++c){
+			endpoints[0][c] = endpoints[1][c] = mean[c];
+		}
+		return;
+	}
+	length = std::sqrt(length);
+	float tMin = std::numeric_limits<float>::max();
+	float tMax = -std::numeric_limits<float>::max();
+	for(int pid = 0; pid < 16; ++pid){
+		float t = 0.0f;
+		for(int c = 0; c < channels; ++c){
+			t += (block.values[c][pid] - mean[c]) * axis[c];
+		}
+		tMin = (std::min)(tMin, t);
+		tMax = (std::max)(tMax, t);
+	}
+	for(int c = 0; c < channels; ++c){
+		const float dir = axis[c] / (length * length);
+		endpoints[0][c] = mean[c] + tMin * dir;
+		endpoints[1][c] = mean[c] + tMax * dir;
+	}
+}
+
+/** Compute endpoints at the corners of the block pixels bounding box.
+ \param block the pixels
+ \param channels the number of channels to consider
+ \param endpoints will contain the endpoints
+ */
+void boundingEndpoints(const CompressionBlock & block, const int channels, float endpoints[2][4]){
+	for(int c = 0; c < channels; ++c){
+		endpoints[0][c] = *std::min_element(block.values[c], block.values[c] + 16);
+		endpoints[1][c] = *std::max_element(block.values[c], block.values[c] + 16);
+	}
+}
+
+/** Compute the endpoints minimizing the squared error of the block for fixed indices.
+ \param block the pixels
+ \param channels the number of channels to consider
+ \param weights the interpolation weight of each palette entry
+ \param indices the palette entry of each pixel
+ \param endpoints will contain the endpoints
+ \return false if the system is degenerate
+ */
+bool leastSquaresEndpoints(const CompressionBlock & block, const int channels, const float * weights, const uint8_t * indices, float endpoints[2][4]){
+	float a = 0.0f;
+	float b = 0.0f;
+	float c = 0.0f;
+	float x0[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float x1[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for(int pid = 0; pid < 16; ++pid){
+		const float t = weights[indices[pid]];
+		const float s = 1.0f - t;
+		a += s * s;
+		b += s * t;
+		c += t * t;
+		for(int ch = 0; ch < channels; ++ch){
+			x0[ch] += s * block.values[ch][pid];
+			x1[ch] += t * block.values[ch][pid];
+		}
+	}
+	const float det = a * c - b * b;
+	if(std::abs(det) < 1e-6f){
+		return false;
+	}
+	for(int ch = 0; ch < channels; ++ch){
+		endpoints[0][ch] = (c * x0[ch] - b * x1[ch]) / det;
+		endpoints[1][ch] = (a * x1[ch] - b * x0[ch]) / det;
+	}
+	return true;
+}
+
+/** Fit quantized endpoints and indices to a block.
+ \param block the pixels
+ \param channels the number of channels to consider
+ \param weights the interpolation weight of each palette entry, sorted
+ \param levels the number of palette entries
+ \param quality the encoding quality
+ \param quantizer the endpoint quantization function, receiving an endpoint, the quantized values, the shared bit and the dequantized values
+ \param best will contain the best fit found
+ */
+template<typename Quantizer>
+void fitBlock(const CompressionBlock & block, const int channels, const float * weights, const int levels, const TextureCompression::Quality quality, const Quantizer & quantizer, CompressionFit & best){
+	best.error = std::numeric_limits<float>::max();
+	const int starts = quality == TextureCompression::High ? 2 : 1;
+	const int iterations = quality == TextureCompression::Fast ? 0 : (quality == TextureCompression::Normal ? 1 : 8);
+	for(int start = 0; start < starts; ++start){
+		float endpoints[2][4] = {};
+		if(start == 0){
+			principalEndpoints(block, channels, endpoints);
+		} else {
+			boundingEndpoints(block, channels, endpoints);
+		}
+		for(int it = 0; it <= iterations; ++it){
+			CompressionFit fit = {};
+			for(int eid = 0; eid < 2; ++eid){
+				quantizer(endpoints[eid], fit.quantized[eid], fit.pbits[eid], fit.endpoints[eid]);
+			}
+			fit.error = selectIndices(block, channels, fit.endpoints, weights, levels, fit.indices);
+			const bool improved = fit.error < best.error;
+			if(improved){
+				best = fit;
+			}
+			// Stop when the refinement doesn't help anymore.
+			if((!improved && it > 0) || best.error == 0.0f || it == iterations){
+				break;
+			}
+			if(!leastSquaresEndpoints(block, channels, weights, fit.indices, endpoints)){
+				break;
+			}
+		}
+	}
+}
+
+/** Encode a BC1 block.
+ \param block the pixels, RGB in [0,255]
+ \param quality the encoding quality
+ \param dst the 8 bytes destination
+ */
+void encodeBC1(const CompressionBlock & block, const TextureCompression::Quality quality, uint8_t * dst){
+	const auto quantizer = [](const float * value, uint32_t * quantized, uint32_t & pbit, float * dequantized){
+		static const uint32_t maxs[3] = { 31, 63, 31 };
+		for(int c = 0; c < 3; ++c){
+			const uint32_t bits = maxs[c] == 63 ? 6 : 5;
+			quantized[c] = uint32_t(glm::clamp(value[c] * float(maxs[c]) / 255.0f + 0.5f, 0.0f, float(maxs[c])));
+			// Expand by replicating the high bits.
+			dequantized[c] = float((quantized[c] << (8 - bits)) | (quantized[c] >> (2 * bits - 8)));
+		}
+		pbit = 0;
+	};
+	CompressionFit fit = {};
+	fitBlock(block, 3, compressionWeightsBC1, 4, quality, quantizer, fit);
+	uint16_t color0 = uint16_t((fit.quantized[0][0] << 11) | (fit.quantized[0][1] << 5) | fit.quantized[0][2]);
+	uint16_t color1 = uint16_t((fit.quantized[1][0] << 11) | (fit.quantized[1][1] << 5) | fit.quantized[1][2]);
+	// The four colors mode requires the first endpoint to be greater.
+	bool swap = false;
+	if(color0 < color1){
+		std::swap(color0, color1);
+		swap = true;
+	}
+	static const uint32_t sortedToIndex[4] = { 0, 2, 3, 1 };
+	uint32_t indices = 0;
+	if(color0 != color1){
+		for(int pid = 0; pid < 16; ++pid){
+			const uint32_t sorted = swap ? 3u - fit.indices[pid] : fit.indices[pid];
+			indices |= sortedToIndex[sorted] << (2 * pid);
+		}
+	}
+	dst[0] = uint8_t(color0 & 0xFF);
+	dst[1] = uint8_t(color0 >> 8);
+	dst[2] = uint8_t(color1 & 0xFF);
+	dst[3] = uint8_t(color1 >> 8);
+	for(int i = 0; i < 4; ++i){
+		dst[4 + i] = uint8_t((indices >> (8 * i)) & 0xFF);
+	}
+}
+
+/** Encode a BC4 block, also used for the alpha of BC3 and the channels of BC5.
+ \param block the pixels, the first channel in [0,255]
+ \param quality the encoding quality
+ \param dst the 8 bytes destination
+ */
+void encodeBC4(const CompressionBlock & block, const TextureCompression::Quality quality, uint8_t * dst){
+	const auto quantizer = [](const float * value, uint32_t * quantized, uint32_t & pbit, float * dequantized){
+		quantized[0] = uint32_t(glm::clamp(value[0] + 0.5f, 0.0f, 255.0f));
+		dequantized[0] = float(quantized[0]);
+		pbit = 0;
+	};
+	CompressionFit fit = {};
+	fitBlock(block, 1, compressionWeightsBC4, 8, quality, quantizer, fit);
+	uint32_t value0 = fit.quantized[0][0];
+	uint32_t value1 = fit.quantized[1][0];
+	// The eight values mode requires the first endpoint to be greater.
+	bool swap = false;
+	if(value0 < value1){
+		std::swap(value0, value1);
+		swap = true;
+	}
+	uint64_t indices = 0;
+	if(value0 != value1){
+		for(int pid = 0; pid < 16; ++pid){
+			const uint64_t sorted = swap ? 7u - fit.indices[pid] : fit.indices[pid];
+			// Endpoints come first, then the interpolated values.
+			const uint64_t index = sorted == 0 ? 0 : (sorted == 7 ? 1 : sorted + 1);
+			indices |= index << (3 * pid);
+		}
+	}
+	dst[0] = uint8_t(value0);
+	dst[1] = uint8_t(value1);
+	for(int i = 0; i < 6; ++i){
+		dst[2 + i] = uint8_t((indices >> (8 * i)) & 0xFF);
+	}
+}
+
+/** Encode a BC6H block using mode 11, with a single subset and 10 bits endpoints.
+ \param block the pixels, RGB as half float bits
+ \param quality the encoding quality
+ \param dst the 16 bytes destination
+ */
+void encodeBC6H(const CompressionBlock & block, const TextureCompression::Quality quality, uint8_t * dst){
+	const auto quantizer = [](const float * value, uint32_t * quantized, uint32_t & pbit, float * dequantized){
+		for(int c = 0; c < 3; ++c){
+			// Unquantized values are q * 64 + 32, scaled by 31/64 when converted back to half floats.
+			const float unquantized = glm::clamp(value[c], 0.0f, compressionMaxHalf) * 64.0f / 31.0f;
+			quantized[c] = uint32_t(glm::clamp((unquantized - 32.0f) / 64.0f + 0.5f, 0.0f, 1023.0f));
+			const uint32_t expanded = quantized[c] == 0 ? 0 : (quantized[c] == 1023 ? 0xFFFF : quantized[c] * 64 + 32);
+			dequantized[c] = float((expanded * 31) >> 6);
+		}
+		pbit = 0;
+	};
+	CompressionFit fit = {};
+	fitBlock(block, 3, compressionWeights4, 16, quality, quantizer, fit);
+	// The most significant bit of the first index is implicitly zero.
+	if(fit.indices[0] >= 8){
+		std::swap(fit.quantized[0], fit.quantized[1]);
+		for(int pid = 0; pid < 16; ++pid){
+			fit.indices[pid] = uint8_t(15 - fit.indices[pid]);
+		}
+	}
+	CompressionBitWriter writer(dst, 16);
+	writer.write(0x03, 5);
+	for(int eid = 0; eid < 2; ++eid){
+		for(int c = 0; c < 3; ++c){
+			writer.write(fit.quantized[eid][c], 10);
+		}
+	}
+	writer.write(fit.indices[0], 3);
+	for(int pid = 1; pid < 16; ++pid){
+		writer.write(fit.indices[pid], 4);
+	}
+}
+
+/** Encode a BC7 block using mode 6, with a single subset and 7 bits RGBA endpoints with a shared bit.
+ \param block the pixels, RGBA in [0,255]
+ \param quality the encoding quality
+ \param dst the 16 bytes destination
+ */
+void encodeBC7(const CompressionBlock & block, const TextureCompression::Quality quality, uint8_t * dst){
+	const auto quantizer = [](const float * value, uint32_t * quantized, uint32_t & pbit, float * dequantized){
+		// Pick the shared bit giving the smallest error.
+		float bestError = std::numeric_limits<float>::max();
+		for(uint32_t p = 0; p < 2; ++p){
+			uint32_t candidates[4];
+			float error = 0.0f;
+			for(int c = 0; c < 4; ++c){
+				candidates[c] = uint32_t(glm::clamp((value[c] - float(p)) * 0.5f + 0.5f, 0.0f, 127.0f));
+				const float diff = float((candidates[c] << 1) | p) - value[c];
+				error += diff * diff;
+			}
+			if(error < bestError){
+				bestError = error;
+				pbit = p;
+				std::memcpy(quantized, candidates, sizeof(candidates));
+			}
+		}
+		for(int c = 0; c < 4; ++c){
+			dequantized[c] = float((quantized[c] << 1) | pbit);
+		}
+	};
+	CompressionFit fit = {};
+	fitBlock(block, 4, compressionWeights4, 16, quality, quantizer, fit);
+	// The most significant bit of the first index is implicitly zero.
+	if(fit.indices[0] >= 8){
+		std::swap(fit.quantized[0], fit.quantized[1]);
+		std::swap(fit.pbits[0], fit.pbits[1]);
+		for(int pid = 0; pid < 16; ++pid){
+			fit.indices[pid] = uint8_t(15 - fit.indices[pid]);
+		}
+	}
+	CompressionBitWriter writer(dst, 16);
+	writer.write(1u << 6, 7);
+	for(int c = 0; c < 4; ++c){
+		writer.write(fit.quantized[0][c], 7);
+		writer.write(fit.quantized[1][c], 7);
+	}
+	writer.write(fit.pbits[0], 1);
+	writer.write(fit.pbits[1], 1);
+	writer.write(fit.indices[0], 3);
+	for(int pid = 1; pid < 16; ++pid){
+		writer.write(fit.indices[pid], 4);
+	}
+}
+
+/** Move a channel of a block to the first channel of another block.
+ \param block the source block
+ \param channel the channel to move
+ \param dst the destination block
+ */
+void extractChannel(const CompressionBlock & block, const int channel, CompressionBlock & dst){
+	std::memcpy(dst.values[0], block.values[channel], sizeof(block.values[channel]));
+}
+
+bool TextureCompression::encode(DecodedImage & image, const Format format, const Quality quality, const bool sRGB){
+	if(format == None || image.data == NULL || image.compressedFormat != 0 || image.width == 0 || image.height == 0 || image.channels == 0 || image.channels > 4){
+		return false;
+	}
+	// Only BC6H stores HDR values.
+	if((format == BC6H) != image.hdr){
+		return false;
+	}
+	const unsigned int blocksX = (image.width + 3) / 4;
+	const unsigned int blocksY = (image.height + 3) / 4;
+	const size_t size = blockSize(format);
+	uint8_t * blocks = static_cast<uint8_t *>(malloc(size_t(blocksX) * size_t(blocksY) * size));
+	if(blocks == NULL){
+		return false;
+	}
+	// Each thread encodes rows of blocks.
+	ThreadUtilities::parallelFor(blocksY, [&](size_t begin, size_t end, unsigned int){
+		CompressionBlock block;
+		CompressionBlock channel;
+		for(size_t by = begin; by < end; ++by){
+			for(unsigned int bx = 0; bx < blocksX; ++bx){
+				loadCompressionBlock(image, bx, (unsigned int)by, format == BC6H, block);
+				uint8_t * dst = blocks + (by * blocksX + bx) * size;
+				switch(format){
+					case BC1:
+						encodeBC1(block, quality, dst);
+						break;
+					case BC3:
+						extractChannel(block, 3, channel);
+						encodeBC4(channel, quality, dst);
+						encodeBC1(block, quality, dst + 8);
+						break;
+					case BC4:
+						encodeBC4(block, quality, dst);
+						break;
+					case BC5:
+						encodeBC4(block, quality, dst);
+						extractChannel(block, 1, channel);
+						encodeBC4(channel, quality, dst + 8);
+						break;
+					case BC6H:
+						encodeBC6H(block, quality, dst);
+						break;
+					case BC7:
+						encodeBC7(block, quality, dst);
+						break;
+					default:
+						break;
+				}
+			}
+		}
+	});
+	free(image.data);
+	image.data = blocks;
+	image.compressedFormat = glFormat(format, sRGB);
+	image.blockSize = (unsigned int)size;
+	return true;
+}
+
+GLenum TextureCompression::glFormat(const Format format, const bool sRGB){
+	switch(format){
+		case BC1:
+			return sRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BC3:
+			return sRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case BC4:
+			return GL_COMPRESSED_RED_RGTC1;
+		case BC5:
+			return GL_COMPRESSED_RG_RGTC2;
+		case BC6H:
+			return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+		case BC7:
+			return sRGB ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+		default:
+			break;
+	}
+	return 0;
+}
+
+unsigned int TextureCompression::blockSize(const Format format){
+	switch(format){
+		case BC1:
+		case BC4:
+			return 8;
+		case BC3:
+		case BC5:
+		case BC6H:
+		case BC7:
+			return 16;
+		default:
+			break;
+	}
+	return 0;
+}
+
+bool TextureCompression::isSupported(const Format format, const bool sRGB){
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	switch(format){
+		case BC1:
+		case BC3:
+			if(!GLUtilities::isExtensionSupported("GL_EXT_texture_compression_s3tc")){
+				return false;
+			}
+			return !sRGB || GLUtilities::isExtensionSupported("GL_EXT_texture_sRGB") || GLUtilities::isExtensionSupported("GL_EXT_texture_compression_s3tc_srgb");
+		case BC4:
+		case BC5:
+			// Core since OpenGL 3.0, but without sRGB variants.
+			return !sRGB;
+		case BC6H:
+		case BC7:
+			// Core since OpenGL 4.2. BC6H has no sRGB variant, but HDR textures are never gamma corrected.
+			return (major > 4 || (major == 4 && minor >= 2)) || GLUtilities::isExtensionSupported("GL_ARB_texture_compression_bptc");
+		default:
+			break;
+	}
+	return false;
+}
+
+bool TextureCompression::parseQuality(const std::string & name, Quality & quality){
+	if(name == "fast"){
+		quality = Fast;
+	} else if(name == "normal"){
+		quality = Normal;
+	} else if(name == "high"){
+		quality = High;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool TextureCompression::parseFormat(const std::string & name, Format & format){
+	if(name == "bc1"){
+		format = BC1;
+	} else if(name == "bc3"){
+		format = BC3;
+	} else if(name == "bc4"){
+		format = BC4;
+	} else if(name == "bc5"){
+		format = BC5;
+	} else if(name == "bc6h"){
+		format = BC6H;
+	} else if(name == "bc7"){
+		format = BC7;
+	} else {
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,80 @@
+#ifndef TextureCompression_h
+#define TextureCompression_h
+
+#include "../Common.hpp"
+#include "../graphics/GLUtilities.hpp"
+
+/**
+ \brief Encode decoded images into GPU block-compressed formats (BC1 to BC7), on multiple threads.
+ \details Each block of 4x4 pixels is encoded independently: endpoints are fitted along the principal axis of the block colors, then refined by least squares depending on the quality. Only the single subset modes are used for BC6H (mode 11) and BC7 (mode 6). LDR images are encoded from their stored values, gamma encoded or not. HDR images are fitted in the half float bits domain, where BC6H interpolates.
+ \ingroup Resources
+ */
+class TextureCompression {
+
+public:
+
+	/// \brief Block compression format.
+	enum Format {
+		None = 0, ///< No compression.
+		BC1, ///< RGB, 4 bits per pixel.
+		BC3, ///< RGBA with interpolated alpha, 8 bits per pixel.
+		BC4, ///< Single channel, 4 bits per pixel.
+		BC5, ///< Two channels, 8 bits per pixel, for normal maps.
+		BC6H, ///< Unsigned half float RGB, 8 bits per pixel.
+		BC7 ///< High quality RGBA, 8 bits per pixel.
+	};
+	
+	/// \brief Encoding quality preset.
+	enum Quality {
+		Fast = 0, ///< Principal axis endpoints, no refinement.
+		Normal, ///< Principal axis endpoints, refined once.
+		High ///< Principal axis and bounding box endpoints, refined until convergence.
+	};
+	
+	/** Encode an image in place. The pixels are replaced by the compressed blocks.
+	 \param image the image to compress, 4 channels LDR or 3 channels HDR
+	 \param format the compression format, BC6H for HDR images only
+	 \param quality the encoding quality
+	 \param sRGB should the texture be gamma corrected when sampled
+	 \return true if the image was compressed
+	 */
+	static bool encode(DecodedImage & image, const Format format, const Quality quality, const bool sRGB);
+	
+	/** Query the OpenGL format corresponding to a compression format.
+	 \param format the compression format
+	 \param sRGB should the texture be gamma corrected when sampled
+	 \return the OpenGL compressed format
+	 */
+	static GLenum glFormat(const Format format, const bool sRGB);
+	
+	/** Query the size of a compressed 4x4 block.
+	 \param format the compression format
+	 \return the size in bytes
+	 */
+	static unsigned int blockSize(const Format format);
+	
+	/** Check if the current OpenGL context supports a compression format.
+	 \param format the compression format
+	 \param sRGB will the texture be gamma corrected when sampled
+	 \return true if textures can be uploaded in this format
+	 \warning Should be called on the main thread.
+	 */
+	static bool isSupported(const Format format, const bool sRGB);
+	
+	/** Parse a quality name.
+	 \param name the quality name: fast, normal or high
+	 \param quality will contain the quality
+	 \return true if the name is valid
+	 */
+	static bool parseQuality(const std::string & name, Quality & quality);
+	
+	/** Parse a format name.
+	 \param name the format name: bc1, bc3, bc4, bc5, bc6h or bc7
+	 \param format will contain the format
+	 \return true if the name is valid
+	 */
+	static bool parseFormat(const std::string & name, Format & format);
+	
+};
+
+#endif
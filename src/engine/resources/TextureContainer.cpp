@@ -0,0 +1,403 @@
+#include "TextureContainer.hpp"
+#include "TextureCompression.hpp"
+#include "ResourcesManager.hpp"
+#include "../helpers/Telemetry.hpp"
+#include <cstring>
+
+/// KTX2 file identifier.
+const unsigned char containerIdentifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+/// Size of the identifier, header and index, before the level index.
+const size_t containerHeaderSize = 80;
+
+/// Size of a level index entry.
+const size_t containerLevelEntrySize = 24;
+
+/// \brief A texture format supported in containers.
+struct ContainerFormat {
+	uint32_t vkFormat; ///< The Vulkan format identifier.
+	TextureCompression::Format compression; ///< The block compression format, None for uncompressed formats.
+	bool sRGB; ///< Is the format gamma encoded.
+	bool hdr; ///< Does the format store floats.
+	bool half; ///< Does the format store half floats.
+	unsigned int channels; ///< The number of channels of uncompressed images.
+	uint32_t typeSize; ///< The size of a channel of uncompressed formats, 1 for compressed formats.
+};
+
+/// Supported formats, linear formats first.
+const ContainerFormat containerFormats[] = {
+	{ 37, TextureCompression::None, false, false, false, 4, 1 }, // R8G8B8A8_UNORM
+	{ 43, TextureCompression::None, true, false, false, 4, 1 }, // R8G8B8A8_SRGB
+	{ 90, TextureCompression::None, false, true, true, 3, 2 }, // R16G16B16_SFLOAT
+	{ 106, TextureCompression::None, false, true, false, 3, 4 }, // R32G32B32_SFLOAT
+	{ 131, TextureCompression::BC1, false, false, false, 4, 1 }, // BC1_RGB_UNORM_BLOCK
+	{ 132, TextureCompression::BC1, true, false, false, 4, 1 }, // BC1_RGB_SRGB_BLOCK
+	{ 137, TextureCompression::BC3, false, false, false, 4, 1 }, // BC3_UNORM_BLOCK
+	{ 138, TextureCompression::BC3, true, false, false, 4, 1 }, // BC3_SRGB_BLOCK
+	{ 139, TextureCompression::BC4, false, false, false, 4, 1 }, // BC4_UNORM_BLOCK
+	{ 141, TextureCompression::BC5, false, false, false, 4, 1 }, // BC5_UNORM_BLOCK
+	{ 143, TextureCompression::BC6H, false, true, true, 3, 1 }, // BC6H_UFLOAT_BLOCK
+	{ 145, TextureCompression::BC7, false, false, false, 4, 1 }, // BC7_UNORM_BLOCK
+	{ 146, TextureCompression::BC7, true, false, false, 4, 1 }, // BC7_SRGB_BLOCK
+};
+
+/** Find the container format of a Vulkan format identifier.
+ \param vkFormat the Vulkan format
+ \return the container format, or NULL if unsupported
+ */
+const ContainerFormat * findContainerFormat(const uint32_t vkFormat){
+	for(const ContainerFormat & format : containerFormats){
+		if(format.vkFormat == vkFormat){
+			return &format;
+		}
+	}
+	return NULL;
+}
+
+/** Find the container format storing an image.
+ \param image the image
+ \param sRGB is the uncompressed LDR image gamma encoded
+ \return the container format, or NULL if unsupported
+ */
+const ContainerFormat * findContainerFormat(const DecodedImage & image, const bool sRGB){
+	for(const ContainerFormat & format : containerFormats){
+		if(image.compressedFormat != 0){
+			if(format.compression != TextureCompression::None && TextureCompression::glFormat(format.compression, format.sRGB) == image.compressedFormat){
+				return &format;
+			}
+		} else if(format.compression == TextureCompression::None && format.hdr == image.hdr && format.channels == image.channels && (image.hdr ? format.half == image.half : format.sRGB == sRGB)){
+			return &format;
+		}
+	}
+	return NULL;
+}
+
+/** Query the size of a texel block: a 4x4 block for compressed formats, a pixel else.
+ \param format the container format
+ \return the size in bytes
+ */
+size_t containerTexelBlockSize(const ContainerFormat & format){
+	if(format.compression != TextureCompression::None){
+		return TextureCompression::blockSize(format.compression);
+	}
+	return size_t(format.channels) * format.typeSize;
+}
+
+/** Generate the data format descriptor of a container format.
+ \param format the container format
+ \param words will contain the descriptor, with its total size first
+ */
+void containerDescriptor(const ContainerFormat & format, std::vector<uint32_t> & words){
+	/// \brief A sample of the descriptor: a channel of a pixel or block.
+	struct Sample {
+		uint32_t offset; ///< Bit offset.
+		uint32_t length; ///< Bit length.
+		uint32_t type; ///< Channel identifier and qualifiers.
+		uint32_t lower; ///< Value mapped to 0.
+		uint32_t upper; ///< Value mapped to 1.
+	};
+	// Qualifiers and bounds.
+	const uint32_t linear = 0x10;
+	const uint32_t floating = 0x80 | 0x40;
+	const uint32_t floatZero = 0x00000000;
+	const uint32_t floatMinusOne = 0xBF800000;
+	const uint32_t floatOne = 0x3F800000;
+	const uint32_t unorm = 0xFFFFFFFF;
+	// Color models.
+	uint32_t model = 1;
+	std::vector<Sample> samples;
+	switch(format.compression){
+		case TextureCompression::BC1:
+			model = 128;
+			samples.push_back({ 0, 64, 0, 0, unorm });
+			break;
+		case TextureCompression::BC3:
+			model = 130;
+			samples.push_back({ 0, 64, 15u | (format.sRGB ? linear : 0u), 0, unorm });
+			samples.push_back({ 64, 64, 0, 0, unorm });
+			break;
+		case TextureCompression::BC4:
+			model = 131;
+			samples.push_back({ 0, 64, 0, 0, unorm });
+			break;
+		case TextureCompression::BC5:
+			model = 132;
+			samples.push_back({ 0, 64, 0, 0, unorm });
+			samples.push_back({ 64, 64, 1, 0, unorm });
+			break;
+		case TextureCompression::BC6H:
+			model = 133;
+			samples.push_back({ 0, 128, 0x80, floatZero, floatOne });
+			break;
+		case TextureCompression::BC7:
+			model = 134;
+			samples.push_back({ 0, 128, 0, 0, unorm });
+			break;
+		default:
+			if(!format.hdr){
+				samples.push_back({ 0, 8, 0, 0, 255 });
+				samples.push_back({ 8, 8, 1, 0, 255 });
+				samples.push_back({ 16, 8, 2, 0, 255 });
+				samples.push_back({ 24, 8, 15u | (format.sRGB ? linear : 0u), 0, 255 });
+			} else {
+				const uint32_t bits = 8 * format.typeSize;
+				for(uint32_t c = 0; c < 3; ++c){
+					samples.push_back({ c * bits, bits, c | floating, floatMinusOne, floatOne });
+				}
+			}
+			break;
+	}
+	const bool compressed = format.compression != TextureCompression::None;
+	const uint32_t blockSize = 24 + 16 * uint32_t(samples.size());
+	words.clear();
+	words.push_back(4 + blockSize);
+	// Vendor and descriptor type, version and size.
+	words.push_back(0);
+	words.push_back(2 | (blockSize << 16));
+	// Color model, BT709 primaries, transfer function, straight alpha.
+	words.push_back(model | (1u << 8) | ((format.sRGB ? 2u : 1u) << 16));
+	// Texel block dimensions minus one.
+	words.push_back(compressed ? (3u | (3u << 8)) : 0u);
+	// Bytes in the first plane.
+	words.push_back(uint32_t(containerTexelBlockSize(format)));
+	words.push_back(0);
+	for(const Sample & sample : samples){
+		words.push_back(sample.offset | ((sample.length - 1) << 16) | (sample.type << 24));
+		words.push_back(0);
+		words.push_back(sample.lower);
+		words.push_back(sample.upper);
+	}
+}
+
+/** Append a value to a buffer.
+ \param value the value
+ \param buffer the buffer
+ */
+template<typename T>
+void containerWrite(const T value, std::vector<char> & buffer){
+	const char * bytes = reinterpret_cast<const char *>(&value);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+/** Read a value from a buffer.
+ \param data the buffer
+ \param offset the position of the value
+ \return the value
+ */
+template<typename T>
+T containerRead(const char * data, const size_t offset){
+	T value;
+	std::memcpy(&value, data + offset, sizeof(T));
+	return value;
+}
+
+/** Pad a buffer with zeros.
+ \param alignment the alignment of the final size
+ \param buffer the buffer
+ */
+void containerAlign(const size_t alignment, std::vector<char> & buffer){
+	buffer.resize((buffer.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+/** Should the rows of a texture be stored bottom row first, as uploaded to OpenGL.
+ \param cubemap is the texture a cubemap
+ \param hdr is the texture HDR
+ \return true for 2D LDR textures, which are flipped when loaded
+ */
+bool containerBottomRowFirst(const bool cubemap, const bool hdr){
+	return !cubemap && !hdr;
+}
+
+bool TextureContainer::isContainer(const std::string & path){
+	return path.size() > 5 && path.compare(path.size() - 5, 5, ".ktx2") == 0;
+}
+
+bool TextureContainer::load(const std::string & path, std::vector<DecodedImage> & images, bool & cubemap, const bool externalFile){
+	images.clear();
+	ResourceData content;
+	if(externalFile){
+		size_t rawSize = 0;
+		char * rawData = Resources::loadRawDataFromExternalFile(path, rawSize);
+		content = ResourceData(rawData, rawSize, true);
+	} else {
+		content = Resources::manager().getData(path);
+	}
+	if(content.empty()){
+		return false;
+	}
+	const char * data = content.data();
+	const size_t size = content.size();
+	Telemetry::Scope scope(Telemetry::Decode, path);
+	scope.setBytes(size);
+
+	if(size < containerHeaderSize || std::memcmp(data, containerIdentifier, sizeof(containerIdentifier)) != 0){
+		Log::Error() << Log::Resources << "Invalid texture container at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	const uint32_t vkFormat = containerRead<uint32_t>(data, 12);
+	const uint32_t width = containerRead<uint32_t>(data, 20);
+	const uint32_t height = containerRead<uint32_t>(data, 24);
+	const uint32_t depth = containerRead<uint32_t>(data, 28);
+	const uint32_t layerCount = containerRead<uint32_t>(data, 32);
+	const uint32_t faceCount = containerRead<uint32_t>(data, 36);
+	const uint32_t levelCount = (std::max)(containerRead<uint32_t>(data, 40), 1u);
+	const uint32_t supercompression = containerRead<uint32_t>(data, 44);
+	const uint32_t kvdOffset = containerRead<uint32_t>(data, 56);
+	const uint32_t kvdLength = containerRead<uint32_t>(data, 60);
+	const ContainerFormat * format = findContainerFormat(vkFormat);
+	if(format == NULL || width == 0 || height == 0 || depth > 1 || layerCount > 1 || (faceCount != 1 && faceCount != 6) || supercompression != 0 || levelCount > 32 || containerHeaderSize + levelCount * containerLevelEntrySize > size){
+		Log::Error() << Log::Resources << "Unsupported texture container at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	cubemap = faceCount == 6;
+
+	// Only the orientation is read from the key/value data, rows go down by default.
+	bool bottomRowFirst = false;
+	if(size_t(kvdOffset) + size_t(kvdLength) <= size){
+		size_t offset = kvdOffset;
+		while(offset + 4 <= size_t(kvdOffset) + size_t(kvdLength)){
+			const uint32_t length = containerRead<uint32_t>(data, offset);
+			offset += 4;
+			if(offset + length > size_t(kvdOffset) + size_t(kvdLength)){
+				break;
+			}
+			const std::string entry(data + offset, length);
+			const size_t separator = entry.find('\0');
+			if(separator != std::string::npos && entry.substr(0, separator) == "KTXorientation"){
+				bottomRowFirst = entry.size() > separator + 2 && entry[separator + 2] == 'u';
+			}
+			offset += (size_t(length) + 3) / 4 * 4;
+		}
+	}
+	const bool compressed = format->compression != TextureCompression::None;
+	const bool flip = bottomRowFirst != containerBottomRowFirst(cubemap, format->hdr);
+	if(flip && compressed){
+		Log::Warning() << Log::Resources << "Texture container at path \"" << path << "\" has an unexpected orientation, it will be uploaded as is." << std::endl;
+	}
+
+	for(uint32_t lid = 0; lid < levelCount; ++lid){
+		const size_t entry = containerHeaderSize + lid * containerLevelEntrySize;
+		const uint64_t levelOffset = containerRead<uint64_t>(data, entry);
+		const uint64_t levelLength = containerRead<uint64_t>(data, entry + 8);
+		DecodedImage image;
+		image.width = (std::max)(width >> lid, 1u);
+		image.height = (std::max)(height >> lid, 1u);
+		image.channels = format->channels;
+		image.hdr = format->hdr;
+		image.half = format->half;
+		if(compressed){
+			image.compressedFormat = TextureCompression::glFormat(format->compression, format->sRGB);
+			image.blockSize = TextureCompression::blockSize(format->compression);
+		}
+		const size_t imageSize = image.size();
+		if(levelOffset + levelLength > size || levelLength < uint64_t(imageSize) * faceCount){
+			Log::Error() << Log::Resources << "Truncated texture container at path \"" << path << "\"." << std::endl;
+			for(DecodedImage & previous : images){
+				free(previous.data);
+			}
+			images.clear();
+			return false;
+		}
+		// Faces of a level are stored one after the other.
+		for(uint32_t fid = 0; fid < faceCount; ++fid){
+			const char * src = data + levelOffset + fid * imageSize;
+			image.data = malloc(imageSize);
+			if(flip && !compressed){
+				const size_t rowSize = imageSize / image.height;
+				for(unsigned int y = 0; y < image.height; ++y){
+					std::memcpy(static_cast<char *>(image.data) + y * rowSize, src + (image.height - 1 - y) * rowSize, rowSize);
+				}
+			} else {
+				std::memcpy(image.data, src, imageSize);
+			}
+			image.status = 0;
+			images.push_back(image);
+		}
+	}
+	return true;
+}
+
+bool TextureContainer::save(const std::string & path, const std::vector<DecodedImage> & images, const bool cubemap, const bool sRGB){
+	const size_t faceCount = cubemap ? 6 : 1;
+	if(images.empty() || images.size() % faceCount != 0){
+		Log::Error() << Log::Resources << "Unable to save texture container at path \"" << path << "\", missing faces." << std::endl;
+		return false;
+	}
+	const DecodedImage & first = images[0];
+	const ContainerFormat * format = findContainerFormat(first, sRGB);
+	if(format == NULL){
+		Log::Error() << Log::Resources << "Unable to save texture container at path \"" << path << "\", unsupported format." << std::endl;
+		return false;
+	}
+	const size_t levelCount = images.size() / faceCount;
+	for(size_t iid = 0; iid < images.size(); ++iid){
+		const DecodedImage & image = images[iid];
+		const size_t lid = iid / faceCount;
+		if(image.data == NULL || findContainerFormat(image, sRGB) != format || image.width != (std::max)(first.width >> lid, 1u) || image.height != (std::max)(first.height >> lid, 1u)){
+			Log::Error() << Log::Resources << "Unable to save texture container at path \"" << path << "\", images should share the same format and be successive levels." << std::endl;
+			return false;
+		}
+	}
+
+	std::vector<char> buffer(containerIdentifier, containerIdentifier + sizeof(containerIdentifier));
+	containerWrite<uint32_t>(format->vkFormat, buffer);
+	containerWrite<uint32_t>(format->typeSize, buffer);
+	containerWrite<uint32_t>(first.width, buffer);
+	containerWrite<uint32_t>(first.height, buffer);
+	containerWrite<uint32_t>(0, buffer);
+	containerWrite<uint32_t>(0, buffer);
+	containerWrite<uint32_t>(uint32_t(faceCount), buffer);
+	containerWrite<uint32_t>(uint32_t(levelCount), buffer);
+	containerWrite<uint32_t>(0, buffer);
+	// The index and level index are filled once the layout is known.
+	buffer.resize(containerHeaderSize + levelCount * containerLevelEntrySize, 0);
+
+	// Data format descriptor.
+	const uint32_t dfdOffset = uint32_t(buffer.size());
+	std::vector<uint32_t> words;
+	containerDescriptor(*format, words);
+	for(const uint32_t word : words){
+		containerWrite<uint32_t>(word, buffer);
+	}
+	const uint32_t dfdLength = uint32_t(buffer.size()) - dfdOffset;
+
+	// Key/value data, sorted by key.
+	const uint32_t kvdOffset = uint32_t(buffer.size());
+	const std::string orientation = containerBottomRowFirst(cubemap, format->hdr) ? "ru" : "rd";
+	const std::vector<std::pair<std::string, std::string>> entries = { { "KTXorientation", orientation }, { "KTXwriter", "GL_Template" } };
+	for(const auto & entry : entries){
+		const std::string keyValue = entry.first + std::string(1, '\0') + entry.second + std::string(1, '\0');
+		containerWrite<uint32_t>(uint32_t(keyValue.size()), buffer);
+		buffer.insert(buffer.end(), keyValue.begin(), keyValue.end());
+		containerAlign(4, buffer);
+	}
+	const uint32_t kvdLength = uint32_t(buffer.size()) - kvdOffset;
+
+	// Levels are stored from the smallest to the largest, aligned on the texel block size and 4 bytes.
+	size_t alignment = containerTexelBlockSize(*format);
+	while(alignment % 4 != 0){
+		alignment += containerTexelBlockSize(*format);
+	}
+	std::vector<uint64_t> levelOffsets(levelCount);
+	std::vector<uint64_t> levelLengths(levelCount);
+	for(size_t lid = levelCount; lid-- > 0;){
+		containerAlign(alignment, buffer);
+		levelOffsets[lid] = buffer.size();
+		for(size_t fid = 0; fid < faceCount; ++fid){
+			const DecodedImage & image = images[lid * faceCount + fid];
+			const char * data = static_cast<const char *>(image.data);
+			buffer.insert(buffer.end(), data, data + image.size());
+		}
+		levelLengths[lid] = buffer.size() - levelOffsets[lid];
+	}
+
+	// Fill the index and the level index.
+	const uint32_t index[4] = { dfdOffset, dfdLength, kvdOffset, kvdLength };
+	std::memcpy(&buffer[48], index, sizeof(index));
+	std::memset(&buffer[64], 0, 16);
+	for(size_t lid = 0; lid < levelCount; ++lid){
+		const uint64_t entry[3] = { levelOffsets[lid], levelLengths[lid], levelLengths[lid] };
+		std::memcpy(&buffer[containerHeaderSize + lid * containerLevelEntrySize], entry, sizeof(entry));
+	}
+	return Resources::saveRawDataToExternalFile(path, &buffer[0], buffer.size());
+}
@@ -0,0 +1,42 @@
+#ifndef TextureContainer_h
+#define TextureContainer_h
+
+#include "../Common.hpp"
+#include "../graphics/GLUtilities.hpp"
+
+/**
+ \brief Load and save all mipmap levels and cubemap faces of a texture in a single KTX2 file.
+ \details Supported formats are RGBA8 (linear or sRGB), RGB16F and RGB32F for uncompressed textures, and BC1, BC3, BC4, BC5, BC6H and BC7 for compressed ones. Levels are stored tightly packed in the order OpenGL expects them, so that they can be uploaded without any conversion. Files on disk are memory mapped when loaded, each image is copied once. 2D LDR textures are stored bottom row first (KTXorientation "ru"), other textures top row first ("rd"); uncompressed textures with another orientation are flipped when loaded. Supercompressed files are not supported.
+ \ingroup Resources
+ */
+class TextureContainer {
+	
+public:
+	
+	/** Check if a file is a texture container, from its extension.
+	 \param path the file path
+	 \return true if the file is a KTX2 container
+	 */
+	static bool isContainer(const std::string & path);
+	
+	/** Load all levels and faces of a texture container.
+	 \param path the container path
+	 \param images will contain the images, level by level, with six faces per level for a cubemap
+	 \param cubemap will denote if the texture is a cubemap
+	 \param externalFile is the file outside of the resources directory
+	 \return true if the container was loaded
+	 */
+	static bool load(const std::string & path, std::vector<DecodedImage> & images, bool & cubemap, const bool externalFile = false);
+	
+	/** Save levels and faces of a texture in a container.
+	 \param path the destination path, on disk
+	 \param images the images, level by level, with six faces per level for a cubemap. They should share the same format, each level being half the size of the previous one.
+	 \param cubemap are the images cubemap faces
+	 \param sRGB are the uncompressed LDR images gamma encoded, compressed images store this in their format
+	 \return true if the container was saved
+	 */
+	static bool save(const std::string & path, const std::vector<DecodedImage> & images, const bool cubemap, const bool sRGB);
+	
+};
+
+#endif
@@ -0,0 +1,380 @@
+#include "Common.hpp"
+#include "Config.hpp"
+#include "resources/ImageUtilities.hpp"
+#include "resources/MeshUtilities.hpp"
+#include "resources/ResourcesManager.hpp"
+#include "raycaster/Raycaster.hpp"
+#include "helpers/ThreadUtilities.hpp"
+#include <cmath>
+
+/**
+ \defgroup AOBaker Ambient Occlusion Baker
+ \brief Bake ambient occlusion and bent normals of a mesh in texture space, by ray tracing the mesh itself.
+ \details Each texel covered by the mesh texture parameterization casts cosine-distributed rays in the hemisphere around its normal. The fraction of unoccluded rays gives the ambient occlusion, and their average direction the bent normal. The mesh texture coordinates are expected to be in [0,1] and non-overlapping.
+ \ingroup Tools
+ */
+
+/** \brief Configuration for the ambient occlusion baking tool.
+ \ingroup AOBaker
+ */
+class AOBakerConfig : public Config {
+public:
+
+	/** Initialize a new config object, parsing the input arguments and filling the attributes with their values.
+	 \param argc the number of input arguments.
+	 \param argv a pointer to the raw input arguments.
+	 */
+	AOBakerConfig(int argc, char** argv) : Config(argc, argv) {
+		processArguments();
+	}
+	
+	/**
+	 Read the internal (key, [values]) populated dictionary, and transfer their values to the configuration attributes.
+	 */
+	void processArguments(){
+	
+		for(const auto & arg : _rawArguments){
+			const std::string key = arg.first;
+			const std::vector<std::string> & values = arg.second;
+			
+			if(key == "mesh-path"){
+				meshPath = values[0];
+			} else if(key == "output-path"){
+				outputPath = values[0];
+			} else if(key == "material-path"){
+				materialPath = values[0];
+			} else if(key == "resolution"){
+				resolution = (unsigned int)std::stoi(values[0]);
+			} else if(key == "samples"){
+				samples = (unsigned int)std::stoi(values[0]);
+			} else if(key == "max-distance"){
+				maxDistance = std::stof(values[0]);
+			} else if(key == "dilation"){
+				dilation = (unsigned int)std::stoi(values[0]);
+			} else if(key == "bent-normals"){
+				bentNormals = true;
+			} else if(key == "threads"){
+				threads = (unsigned int)std::stoi(values[0]);
+			}
+		}
+	}
+
+public:
+
+	std::string meshPath = ""; ///< Path to the OBJ file to bake.
+	
+	std::string outputPath = ""; ///< Output image path. The format (.png or .exr) is deduced from the extension.
+	
+	std::string materialPath = ""; ///< Optional roughness/metalness/AO texture, whose blue channel will be replaced by the baked occlusion.
+	
+	unsigned int resolution = 1024; ///< Output image resolution, ignored if a material texture is given.
+	
+	unsigned int samples = 128; ///< Number of rays per texel.
+	
+	float maxDistance = 0.25f; ///< Maximum occlusion distance, relative to the mesh bounding box diagonal.
+	
+	unsigned int dilation = 4; ///< Number of texels to extend the result by around the texture islands.
+	
+	bool bentNormals = false; ///< Should the object space bent normals be saved next to the occlusion.
+	
+	unsigned int threads = 0; ///< Number of threads to use (0 to use all hardware threads).
+
+};
+
+/** \brief Surface point covered by a texel.
+ \ingroup AOBaker
+ */
+struct TexelSample {
+	glm::vec3 position = glm::vec3(0.0f); ///< Position on the surface.
+	glm::vec3 normal = glm::vec3(0.0f); ///< Interpolated shading normal.
+	glm::vec3 offset = glm::vec3(0.0f); ///< Geometric normal, oriented as the shading normal, used to offset ray origins.
+	bool valid = false; ///< Is the texel covered by the mesh.
+};
+
+/** Find the surface point covered by each texel center, by rasterizing the mesh triangles in texture space.
+ \param mesh the mesh to rasterize
+ \param width the image width
+ \param height the image height
+ \param texels will contain the surface samples, row by row, the first row corresponding to v = 0
+ \ingroup AOBaker
+ */
+void rasterizeTexels(const Mesh & mesh, const unsigned int width, const unsigned int height, std::vector<TexelSample> & texels){
+	texels.assign(size_t(width) * height, TexelSample());
+	const glm::vec2 size(width, height);
+	for(size_t iid = 0; iid + 2 < mesh.indices.size(); iid += 3){
+		const unsigned int i0 = mesh.indices[iid], i1 = mesh.indices[iid + 1], i2 = mesh.indices[iid + 2];
+		// Texel centers are at integer coordinates in this space.
+		const glm::vec2 a = mesh.texcoords[i0] * size - 0.5f;
+		const glm::vec2 b = mesh.texcoords[i1] * size - 0.5f;
+		const glm::vec2 c = mesh.texcoords[i2] * size - 0.5f;
+		const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if(std::abs(area) < 1e-12f){
+			continue;
+		}
+		const glm::vec3 & p0 = mesh.positions[i0];
+		const glm::vec3 & p1 = mesh.positions[i1];
+		const glm::vec3 & p2 = mesh.positions[i2];
+		const glm::vec3 geometricNormal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+		
+		const glm::vec2 minis = glm::max(glm::floor(glm::min(a, glm::min(b, c))), glm::vec2(0.0f));
+		const glm::vec2 maxis = glm::min(glm::ceil(glm::max(a, glm::max(b, c))), size - 1.0f);
+		for(int y = int(minis.y); y <= int(maxis.y); ++y){
+			for(int x = int(minis.x); x <= int(maxis.x); ++x){
+				const glm::vec2 p(x, y);
+				// Barycentric coordinates from the edge functions.
+				const float w1 = ((p.x - a.x) * (c.y - a.y) - (p.y - a.y) * (c.x - a.x)) / area;
+				const float w2 = ((b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)) / area;
+				const float w0 = 1.0f - w1 - w2;
+				if(w0 < 0.0f || w1 < 0.0f || w2 < 0.0f){
+					continue;
+				}
+				TexelSample & texel = texels[size_t(y) * width + x];
+				texel.position = w0 * p0 + w1 * p1 + w2 * p2;
+				texel.normal = geometricNormal;
+				if(!mesh.normals.empty()){
+					const glm::vec3 n = w0 * mesh.normals[i0] + w1 * mesh.normals[i1] + w2 * mesh.normals[i2];
+					texel.normal = glm::length(n) > 0.0f ? glm::normalize(n) : geometricNormal;
+				}
+				texel.offset = glm::dot(geometricNormal, texel.normal) < 0.0f ? -geometricNormal : geometricNormal;
+				texel.valid = true;
+			}
+		}
+	}
+}
+
+/** Generate the i-th point of a Hammersley sequence in the unit square.
+ \param i the point index
+ \param count the total number of points
+ \return the 2D point
+ \ingroup AOBaker
+ */
+glm::vec2 hammersley(const unsigned int i, const unsigned int count){
+	unsigned int bits = i;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return glm::vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10f);
+}
+
+/** Hash an integer to a float in [0,1), used to decorrelate the samples of neighbouring texels.
+ \param x the integer to hash
+ \return a pseudo-random float
+ \ingroup AOBaker
+ */
+float hashToFloat(unsigned int x){
+	x ^= x >> 16u;
+	x *= 0x7feb352du;
+	x ^= x >> 15u;
+	x *= 0x846ca68bu;
+	x ^= x >> 16u;
+	return float(x >> 8u) / float(1u << 24u);
+}
+
+/** Extend the valid texels values to their invalid neighbours, to avoid seams when filtering the texture.
+ \param texels the texels coverage, updated in place
+ \param values the per-texel values to extend
+ \param width the image width
+ \param height the image height
+ \param passes the number of texels to extend by
+ \ingroup AOBaker
+ */
+void dilate(std::vector<TexelSample> & texels, std::vector<glm::vec4> & values, const unsigned int width, const unsigned int height, const unsigned int passes){
+	for(unsigned int pass = 0; pass < passes; ++pass){
+		std::vector<TexelSample> newTexels = texels;
+		std::vector<glm::vec4> newValues = values;
+		for(int y = 0; y < int(height); ++y){
+			for(int x = 0; x < int(width); ++x){
+				const size_t tid = size_t(y) * width + x;
+				if(texels[tid].valid){
+					continue;
+				}
+				glm::vec4 sum(0.0f);
+				int count = 0;
+				for(int dy = -1; dy <= 1; ++dy){
+					for(int dx = -1; dx <= 1; ++dx){
+						const int nx = x + dx, ny = y + dy;
+						if(nx < 0 || ny < 0 || nx >= int(width) || ny >= int(height) || !texels[size_t(ny) * width + nx].valid){
+							continue;
+						}
+						sum += values[size_t(ny) * width + nx];
+						++count;
+					}
+				}
+				if(count > 0){
+					newValues[tid] = sum / float(count);
+					newTexels[tid].valid = true;
+				}
+			}
+		}
+		std::swap(texels, newTexels);
+		std::swap(values, newValues);
+	}
+}
+
+/** Ambient occlusion and bent normals baker.
+ Expects "--mesh-path path/to/mesh.obj", "--output-path path/to/ao.png" and optionally "--material-path path/to/rough_met_ao.png", "--resolution N", "--samples N", "--max-distance D", "--dilation N", "--bent-normals" and "--threads N".
+ \param argc the number of input arguments.
+ \param argv a pointer to the raw input arguments.
+ \return a general error code.
+ \ingroup AOBaker
+ */
+int main(int argc, char** argv) {
+
+	AOBakerConfig config(argc, argv);
+	
+	if(config.meshPath.empty()){
+		Log::Error() << Log::Utilities << "Need a mesh path." << std::endl;
+		return 2;
+	}
+	if(config.outputPath.empty()){
+		Log::Error() << Log::Utilities << "Need an output path." << std::endl;
+		return 2;
+	}
+	
+	// Load the mesh.
+	Log::Info() << Log::Utilities << "Loading mesh at path " << config.meshPath << "..." << std::endl;
+	size_t rawSize = 0;
+	char * rawContent = Resources::loadRawDataFromExternalFile(config.meshPath, rawSize);
+	if(rawContent == NULL || rawSize == 0){
+		free(rawContent);
+		Log::Error() << Log::Resources << "Unable to load the mesh." << std::endl;
+		return 1;
+	}
+	Mesh mesh;
+	MeshUtilities::loadObjParallel(rawContent, rawSize, mesh, MeshUtilities::Indexed, config.threads);
+	free(rawContent);
+	if(mesh.indices.empty() || mesh.texcoords.size() != mesh.positions.size()){
+		Log::Error() << Log::Resources << "The mesh has no triangles or no texture coordinates." << std::endl;
+		return 3;
+	}
+	
+	// Load the material texture if needed, its size determines the output size.
+	unsigned int width = config.resolution;
+	unsigned int height = config.resolution;
+	unsigned char * material = NULL;
+	if(!config.materialPath.empty()){
+		unsigned int channels = 4;
+		if(ImageUtilities::loadImage(config.materialPath, width, height, channels, (void**)&material, true, true) != 0 || material == NULL){
+			Log::Error() << Log::Resources << "Unable to load the material texture at path " << config.materialPath << "." << std::endl;
+			return 1;
+		}
+	}
+	
+	// Build the hierarchy.
+	Raycaster raycaster;
+	raycaster.addMesh(mesh);
+	raycaster.updateHierarchy(config.threads);
+	const BoundingBox bbox = MeshUtilities::computeBoundingBox(mesh);
+	const float diagonal = glm::length(bbox.maxis - bbox.minis);
+	const float maxDistance = config.maxDistance * diagonal;
+	const float epsilon = 1e-4f * diagonal;
+	
+	// Find the surface points.
+	std::vector<TexelSample> texels;
+	rasterizeTexels(mesh, width, height, texels);
+	
+	// Cast rays for each texel, the AO is stored in the last component of each value, the bent normal in the first three.
+	Log::Info() << Log::Utilities << "Baking " << width << "x" << height << " texels with " << config.samples << " samples..." << std::endl;
+	std::vector<glm::vec4> values(texels.size(), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	const unsigned int samples = (std::max)(1u, config.samples);
+	ThreadUtilities::parallelFor(texels.size(), [&](size_t begin, size_t end, unsigned int){
+		for(size_t tid = begin; tid < end; ++tid){
+			const TexelSample & texel = texels[tid];
+			if(!texel.valid){
+				continue;
+			}
+			// Tangent frame around the normal (Duff et al., "Building an Orthonormal Basis, Revisited").
+			const glm::vec3 & n = texel.normal;
+			const float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+			const float a = -1.0f / (sign + n.z);
+			const float b = n.x * n.y * a;
+			const glm::vec3 t(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+			const glm::vec3 bt(b, sign + n.y * n.y * a, -n.y);
+			// Per-texel rotation of the sample pattern.
+			const glm::vec2 shift(hashToFloat(2u * (unsigned int)tid), hashToFloat(2u * (unsigned int)tid + 1u));
+			const glm::vec3 origin = texel.position + epsilon * texel.offset;
+			
+			glm::vec3 bentNormal(0.0f);
+			unsigned int visible = 0;
+			for(unsigned int sid = 0; sid < samples; ++sid){
+				// Cosine-weighted direction in the hemisphere.
+				const glm::vec2 xi = glm::fract(hammersley(sid, samples) + shift);
+				const float r = std::sqrt(xi.x);
+				const float phi = 2.0f * float(M_PI) * xi.y;
+				const glm::vec3 local(r * std::cos(phi), r * std::sin(phi), std::sqrt((std::max)(0.0f, 1.0f - xi.x)));
+				const glm::vec3 direction = local.x * t + local.y * bt + local.z * n;
+				if(!raycaster.intersectsAny(origin, direction, 0.0f, maxDistance)){
+					bentNormal += direction;
+					++visible;
+				}
+			}
+			const float lengthBent = glm::length(bentNormal);
+			values[tid] = glm::vec4(lengthBent > 0.0f ? bentNormal / lengthBent : n, float(visible) / float(samples));
+		}
+	}, config.threads);
+	
+	// Extend the result around texture islands.
+	dilate(texels, values, width, height, config.dilation);
+	
+	// Output.
+	const bool hdr = ImageUtilities::isHDR(config.outputPath);
+	int ret = 0;
+	if(material != NULL){
+		// Replace the occlusion channel of the material.
+		for(size_t tid = 0; tid < texels.size(); ++tid){
+			if(texels[tid].valid){
+				material[4 * tid + 2] = (unsigned char)glm::clamp(values[tid].w * 255.0f + 0.5f, 0.0f, 255.0f);
+			}
+		}
+		ret = ImageUtilities::saveLDRImage(config.outputPath, width, height, 4, material, true);
+		free(material);
+	} else if(hdr){
+		std::vector<float> occlusion(texels.size());
+		for(size_t tid = 0; tid < texels.size(); ++tid){
+			occlusion[tid] = values[tid].w;
+		}
+		ret = ImageUtilities::saveHDRImage(config.outputPath, width, height, 1, &occlusion[0], true);
+	} else {
+		std::vector<unsigned char> occlusion(texels.size());
+		for(size_t tid = 0; tid < texels.size(); ++tid){
+			occlusion[tid] = (unsigned char)glm::clamp(values[tid].w * 255.0f + 0.5f, 0.0f, 255.0f);
+		}
+		ret = ImageUtilities::saveLDRImage(config.outputPath, width, height, 1, &occlusion[0], true);
+	}
+	if(ret != 0){
+		Log::Error() << Log::Resources << "Unable to save the occlusion at path " << config.outputPath << "." << std::endl;
+		return 1;
+	}
+	
+	if(config.bentNormals){
+		// Object space bent normals, next to the occlusion result.
+		const size_t extensionPos = config.outputPath.find_last_of(".");
+		const std::string bentPath = config.outputPath.substr(0, extensionPos) + "_bent" + (extensionPos == std::string::npos ? (hdr ? ".exr" : ".png") : config.outputPath.substr(extensionPos));
+		if(hdr){
+			std::vector<float> normals(3 * texels.size());
+			for(size_t tid = 0; tid < texels.size(); ++tid){
+				normals[3 * tid + 0] = values[tid].x;
+				normals[3 * tid + 1] = values[tid].y;
+				normals[3 * tid + 2] = values[tid].z;
+			}
+			ret = ImageUtilities::saveHDRImage(bentPath, width, height, 3, &normals[0], true);
+		} else {
+			std::vector<unsigned char> normals(3 * texels.size());
+			for(size_t tid = 0; tid < texels.size(); ++tid){
+				for(int cid = 0; cid < 3; ++cid){
+					normals[3 * tid + cid] = (unsigned char)glm::clamp((values[tid][cid] * 0.5f + 0.5f) * 255.0f + 0.5f, 0.0f, 255.0f);
+				}
+			}
+			ret = ImageUtilities::saveLDRImage(bentPath, width, height, 3, &normals[0], true);
+		}
+		if(ret != 0){
+			Log::Error() << Log::Resources << "Unable to save the bent normals at path " << bentPath << "." << std::endl;
+			return 1;
+		}
+	}
+	
+	Log::Info() << Log::Utilities << "Done." << std::endl;
+	return 0;
+}
@@ -3,12 +3,17 @@
 #include "input/Input.hpp"
 #include "renderers/utils/Renderer2D.hpp"
 #include "renderers/utils/RendererCube.hpp"
+#include "resources/ArtifactCache.hpp"
+#include "resources/TextureContainer.hpp"
+#include "resources/TextureCompression.hpp"
+#include "helpers/HalfFloat.hpp"
 #include "scenes/Scenes.hpp"
 
 
 /**
  \defgroup BRDFEstimator BRDF Estimation
  \brief Perform cubemap GGX convolution, precompute BRDF lookup table.
+ \details Convolved cubemaps are saved as one image per face and roughness level, or with --container as a single KTX2 file holding all faces and levels as half floats, block compressed with --compress [fast|normal|high].
  \see GLSL::Frag::Cubemap_convo
  \see GLSL::Frag::Brdf_sampler
  \ingroup Tools
@@ -46,6 +51,14 @@ public:
 				outputPath = values[0];
 			} else if(key == "brdf"){
 				precomputeBRDF = true;
+			} else if(key == "container"){
+				container = true;
+			} else if(key == "compress"){
+				container = true;
+				compress = true;
+				if(!values.empty() && !TextureCompression::parseQuality(values[0], quality)){
+					Log::Warning() << Log::Utilities << "Unknown compression quality \"" << values[0] << "\"." << std::endl;
+				}
 			}
 		}
 		
@@ -58,9 +71,61 @@ public:
 	std::string outputPath = ""; ///< Result output path.
 	
 	bool precomputeBRDF = false; ///< Toggles the computation of the BRDF lookup table.
+	
+	bool container = false; ///< Save all convolved faces and levels in a single container.
+	
+	bool compress = false; ///< Block compress the container content.
+	
+	TextureCompression::Quality quality = TextureCompression::Normal; ///< The block compression quality.
 
 };
 
+/** Fetch the results of a previous run with the same inputs from the artifacts cache, and save them.
+ \param key the key identifying the inputs
+ \param outputPaths the path of each output file
+ \return true if all results were found in the cache
+ \ingroup BRDFEstimator
+ */
+bool fetchResults(const ArtifactCache::Key & key, const std::vector<std::string> & outputPaths){
+	if(!ArtifactCache::enabled()){
+		return false;
+	}
+	std::vector<std::vector<char>> results(outputPaths.size());
+	for(size_t rid = 0; rid < outputPaths.size(); ++rid){
+		ArtifactCache::Key resultKey = key;
+		resultKey.add(uint64_t(rid));
+		if(!ArtifactCache::fetch(resultKey, results[rid])){
+			return false;
+		}
+	}
+	for(size_t rid = 0; rid < outputPaths.size(); ++rid){
+		Resources::saveRawDataToExternalFile(outputPaths[rid], results[rid].data(), results[rid].size());
+	}
+	return true;
+}
+
+/** Store the output files in the artifacts cache, for the next runs with the same inputs.
+ \param key the key identifying the inputs
+ \param outputPaths the path of each output file
+ \ingroup BRDFEstimator
+ */
+void storeResults(const ArtifactCache::Key & key, const std::vector<std::string> & outputPaths){
+	if(!ArtifactCache::enabled()){
+		return;
+	}
+	for(size_t rid = 0; rid < outputPaths.size(); ++rid){
+		size_t size = 0;
+		char * content = Resources::loadRawDataFromExternalFile(outputPaths[rid], size);
+		if(content == NULL){
+			continue;
+		}
+		ArtifactCache::Key resultKey = key;
+		resultKey.add(uint64_t(rid));
+		ArtifactCache::store(resultKey, content, size);
+		free(content);
+	}
+}
+
 /**
  Compute either a series of cubemaps convolved with a BRDF using increasing roughness values, or generate a linearized BRDF lookup table.
  \param argc the number of input arguments.
@@ -83,6 +148,53 @@ int main(int argc, char** argv) {
 		return 3;
 	}
 	
+	// Two cases:
+	// - compute the two coefficients of the BRDF linear approximation.
+	// - apply BRDF convolution to an existing envmap.
+	const bool precomputeBRDF = config.precomputeBRDF;
+	const unsigned int outputWidth = config.initialWidth;
+	const unsigned int outputHeight = config.initialHeight;
+	
+	// Results only depend on the shaders, the output size and the cubemap content, look for them in the artifacts cache.
+	ArtifactCache::Key key("brdf", 1);
+	std::vector<std::string> outputPaths;
+	if(ArtifactCache::enabled()){
+		key.add(uint64_t(outputWidth)).add(uint64_t(outputHeight)).add(uint64_t(precomputeBRDF ? 1 : 0));
+		key.add(uint64_t(config.container)).add(uint64_t(config.compress)).add(uint64_t(config.quality));
+		if(precomputeBRDF){
+			key.add(Resources::manager().getShader("passthrough", Resources::Vertex)).add(Resources::manager().getShader("brdf_sampler", Resources::Fragment));
+			outputPaths.push_back(config.outputPath + ".exr");
+		} else {
+			key.add(Resources::manager().getShader("skybox_basic", Resources::Vertex)).add(Resources::manager().getShader("cubemap_convo", Resources::Fragment));
+			// All images of the cubemap, with any extension.
+			for(const std::string extension : { "ktx2", "png", "jpg", "jpeg", "bmp", "tga", "exr" }){
+				std::map<std::string, std::string> files;
+				Resources::manager().getFiles(extension, files);
+				for(const auto & file : files){
+					if(file.first.compare(0, config.cubemapName.size() + 1, config.cubemapName + "_") == 0){
+						const ResourceData content = Resources::manager().getData(file.second);
+						key.add(file.first).add(content.data(), content.size());
+					}
+				}
+			}
+			if(config.container){
+				outputPaths.push_back(config.outputPath + config.cubemapName + ".ktx2");
+			} else {
+				// Same names as the files saved by RendererCube::drawCube.
+				const std::string suffixes[6] = { "px", "nx", "pz", "nz", "py", "ny"};
+				for(float rr = 0.0f; rr < 1.1f; rr += 0.2f){
+					for(size_t i = 0; i < 6; ++i){
+						outputPaths.push_back(config.outputPath + config.cubemapName + "-" + std::to_string(rr) + "-" + suffixes[i] + ".exr");
+					}
+				}
+			}
+		}
+		if(fetchResults(key, outputPaths)){
+			Log::Info() << Log::Utilities << "Found results in cache, done." << std::endl;
+			return 0;
+		}
+	}
+	
 	// Initialize glfw, which will create and setup an OpenGL context.
 	if (!glfwInit()) {
 		Log::Error() << Log::OpenGL << "Could not start GLFW3" << std::endl;
@@ -126,13 +238,7 @@ int main(int argc, char** argv) {
 	
 	Input::manager().update();
 	
-	// Two cases:
-	// - compute the two coefficients of the BRDF linear approximation.
-	// - apply BRDF convolution to an existing envmap.
-	const bool precomputeBRDF = config.precomputeBRDF;
-	const unsigned int outputWidth = config.initialWidth;
-	const unsigned int outputHeight = config.initialHeight;
-	
+	bool saved = true;
 	if(precomputeBRDF){
 		std::shared_ptr<Renderer2D> renderer(new Renderer2D(config, "brdf_sampler", outputWidth, outputHeight, GL_RG32F));
 		renderer->update();
@@ -148,6 +254,8 @@ int main(int argc, char** argv) {
 		renderer->update();
 		
 		// Generate convolution map for increments of roughness.
+		// Each roughness is stored in a mipmap level of the container.
+		std::vector<DecodedImage> levels;
 		unsigned int count = 0;
 		for(float rr = 0.0f; rr < 1.1f; rr += 0.2f){
 			glUseProgram(Resources::manager().getProgram("cubemap_convo")->id());
@@ -158,10 +266,37 @@ int main(int argc, char** argv) {
 			const unsigned int localWidth = outputWidth/powe;
 			const unsigned int localHeight = outputHeight/powe;
 			
-			renderer->drawCube(localWidth, localHeight, config.outputPath + cubemapName + "-" + std::to_string(rr));
+			if(config.container){
+				std::vector<DecodedImage> faces;
+				renderer->drawCube(localWidth, localHeight, faces);
+				for(DecodedImage & face : faces){
+					if(config.compress){
+						TextureCompression::encode(face, TextureCompression::BC6H, config.quality, false);
+					} else {
+						// Store half floats, as they would be uploaded.
+						const size_t valueCount = size_t(face.width) * face.height * face.channels;
+						uint16_t * halfs = static_cast<uint16_t *>(malloc(valueCount * sizeof(uint16_t)));
+						HalfFloat::fromFloats(static_cast<const float *>(face.data), valueCount, halfs);
+						free(face.data);
+						face.data = halfs;
+						face.half = true;
+					}
+					levels.push_back(face);
+				}
+			} else {
+				renderer->drawCube(localWidth, localHeight, config.outputPath + cubemapName + "-" + std::to_string(rr));
+			}
 			
 			++count;
 		}
+		if(config.container){
+			const std::string containerPath = config.outputPath + cubemapName + ".ktx2";
+			Log::Info() << Log::Utilities << "Saving convolved cubemap to file " << containerPath << "." << std::endl;
+			saved = TextureContainer::save(containerPath, levels, true, false);
+			for(DecodedImage & level : levels){
+				free(level.data);
+			}
+		}
 		renderer->clean();
 	}
 	
@@ -174,6 +309,11 @@ int main(int argc, char** argv) {
 	// Close GL context and any other GLFW resources.
 	glfwTerminate();
 	
+	if(!saved){
+		Log::Error() << Log::Utilities << "Unable to save the results." << std::endl;
+		return 4;
+	}
+	storeResults(key, outputPaths);
 	Log::Info() << Log::Utilities << "Done." << std::endl;
 	
 	return 0;
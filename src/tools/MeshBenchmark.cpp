@@ -0,0 +1,505 @@
+#include "Common.hpp"
+#include "Config.hpp"
+#include "resources/MeshUtilities.hpp"
+#include "resources/ResourcesManager.hpp"
+#include "helpers/ThreadUtilities.hpp"
+#include "helpers/GenerationUtilities.hpp"
+#include "raycaster/Raycaster.hpp"
+#include <chrono>
+#include <sstream>
+#include <map>
+#include <tuple>
+#include <limits>
+#include <cmath>
+
+/**
+ \defgroup MeshBenchmark Mesh Benchmark
+ \brief Measure the performances of the mesh loading and processing utilities, on a given OBJ file or on a generated grid.
+ \ingroup Tools
+ */
+
+/** \brief Configuration for the mesh benchmark tool.
+ \ingroup MeshBenchmark
+ */
+class MeshBenchmarkConfig : public Config {
+public:
+
+	/** Initialize a new config object, parsing the input arguments and filling the attributes with their values.
+	 \param argc the number of input arguments.
+	 \param argv a pointer to the raw input arguments.
+	 */
+	MeshBenchmarkConfig(int argc, char** argv) : Config(argc, argv) {
+		processArguments();
+	}
+
+	/**
+	 Read the internal (key, [values]) populated dictionary, and transfer their values to the configuration attributes.
+	 */
+	void processArguments(){
+
+		for(const auto & arg : _rawArguments){
+			const std::string key = arg.first;
+			const std::vector<std::string> & values = arg.second;
+
+			if(key == "mesh-path"){
+				meshPath = values[0];
+			} else if(key == "iterations"){
+				iterations = (unsigned int)std::stoi(values[0]);
+			} else if(key == "grid-size"){
+				gridSize = (unsigned int)std::stoi(values[0]);
+			} else if(key == "threads"){
+				threads = (unsigned int)std::stoi(values[0]);
+			} else if(key == "tangents-grid-size"){
+				tangentsGridSize = (unsigned int)std::stoi(values[0]);
+			} else if(key == "rays"){
+				rays = (unsigned int)std::stoi(values[0]);
+			}
+		}
+	}
+
+public:
+
+	std::string meshPath = ""; ///< Path to the OBJ file to use. If empty, a grid will be generated.
+
+	unsigned int iterations = 5; ///< Number of repetitions of each measurement.
+
+	unsigned int gridSize = 1000; ///< Number of quads along each side of the generated grid.
+
+	unsigned int threads = 0; ///< Number of threads for parallel processing (0 to use all hardware threads).
+	
+	unsigned int tangentsGridSize = 2240; ///< Number of quads along each side of the grid used for the tangents benchmark (2240 gives 10M triangles).
+	
+	unsigned int rays = 1000000; ///< Number of rays cast against the mesh hierarchy.
+
+};
+
+/** Generate the OBJ text of a subdivided grid with positions, normals and texture coordinates.
+ \param size the number of quads along each side
+ \return the OBJ file content
+ \ingroup MeshBenchmark
+ */
+std::string generateGridObj(const unsigned int size){
+	std::stringstream str;
+	str.precision(6);
+	const unsigned int vsize = size + 1;
+	for(unsigned int y = 0; y < vsize; ++y){
+		for(unsigned int x = 0; x < vsize; ++x){
+			const float u = float(x)/float(size);
+			const float v = float(y)/float(size);
+			str << "v " << (2.0f * u - 1.0f) << " " << 0.1f * std::sin(10.0f * u) * std::cos(7.0f * v) << " " << (2.0f * v - 1.0f) << "\n";
+			str << "vt " << u << " " << v << "\n";
+		}
+	}
+	str << "vn 0.0 1.0 0.0\n";
+	for(unsigned int y = 0; y < size; ++y){
+		for(unsigned int x = 0; x < size; ++x){
+			const unsigned int i0 = y * vsize + x + 1;
+			const unsigned int i1 = i0 + 1;
+			const unsigned int i2 = i0 + vsize;
+			const unsigned int i3 = i2 + 1;
+			str << "f " << i0 << "/" << i0 << "/1 " << i2 << "/" << i2 << "/1 " << i1 << "/" << i1 << "/1\n";
+			str << "f " << i1 << "/" << i1 << "/1 " << i2 << "/" << i2 << "/1 " << i3 << "/" << i3 << "/1\n";
+		}
+	}
+	return str.str();
+}
+
+/** Generate a subdivided grid mesh directly in memory, with a tiling texture parameterization.
+ \param size the number of quads along each side
+ \param mesh will contain the grid
+ \ingroup MeshBenchmark
+ */
+void generateGridMesh(const unsigned int size, Mesh & mesh){
+	const unsigned int vsize = size + 1;
+	mesh = Mesh();
+	mesh.positions.resize(size_t(vsize) * vsize);
+	mesh.normals.resize(mesh.positions.size());
+	mesh.texcoords.resize(mesh.positions.size());
+	for(unsigned int y = 0; y < vsize; ++y){
+		for(unsigned int x = 0; x < vsize; ++x){
+			const float u = float(x)/float(size);
+			const float v = float(y)/float(size);
+			const size_t vid = size_t(y) * vsize + x;
+			const float h = 0.1f * std::sin(10.0f * u) * std::cos(7.0f * v);
+			mesh.positions[vid] = glm::vec3(2.0f * u - 1.0f, h, 2.0f * v - 1.0f);
+			mesh.normals[vid] = glm::normalize(glm::vec3(-0.5f * std::cos(10.0f * u) * std::cos(7.0f * v), 1.0f, 0.35f * std::sin(10.0f * u) * std::sin(7.0f * v)));
+			mesh.texcoords[vid] = glm::vec2(8.0f * u, 8.0f * v * v);
+		}
+	}
+	mesh.indices.reserve(size_t(size) * size * 6);
+	for(unsigned int y = 0; y < size; ++y){
+		for(unsigned int x = 0; x < size; ++x){
+			const unsigned int i0 = y * vsize + x;
+			const unsigned int i1 = i0 + 1;
+			const unsigned int i2 = i0 + vsize;
+			const unsigned int i3 = i2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { i0, i2, i1, i1, i2, i3 });
+		}
+	}
+}
+
+/** Reference tangents computation: serial loop over faces, scattering the contributions to the vertices.
+ \param mesh the mesh to process
+ \ingroup MeshBenchmark
+ */
+void computeTangentsAndBinormalsSerial(Mesh & mesh){
+	mesh.tangents.assign(mesh.positions.size(), glm::vec3(0.0f));
+	mesh.binormals.assign(mesh.positions.size(), glm::vec3(0.0f));
+	for(size_t fid = 0; fid < mesh.indices.size(); fid += 3){
+		const unsigned int i0 = mesh.indices[fid], i1 = mesh.indices[fid+1], i2 = mesh.indices[fid+2];
+		const glm::vec3 deltaPosition1 = mesh.positions[i1] - mesh.positions[i0];
+		const glm::vec3 deltaPosition2 = mesh.positions[i2] - mesh.positions[i0];
+		const glm::vec2 deltaUv1 = mesh.texcoords[i1] - mesh.texcoords[i0];
+		const glm::vec2 deltaUv2 = mesh.texcoords[i2] - mesh.texcoords[i0];
+		const float denom = deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x;
+		const float det = (std::abs(denom) < 0.001f) ? 1.0f : (1.0f / denom);
+		const glm::vec3 tangent = det * (deltaPosition1 * deltaUv2.y - deltaPosition2 * deltaUv1.y);
+		const glm::vec3 binormal = det * (deltaPosition2 * deltaUv1.x - deltaPosition1 * deltaUv2.x);
+		mesh.tangents[i0] += tangent; mesh.tangents[i1] += tangent; mesh.tangents[i2] += tangent;
+		mesh.binormals[i0] += binormal; mesh.binormals[i1] += binormal; mesh.binormals[i2] += binormal;
+	}
+	for(size_t tid = 0; tid < mesh.tangents.size(); ++tid){
+		mesh.tangents[tid] = glm::normalize(mesh.tangents[tid] - mesh.normals[tid] * glm::dot(mesh.normals[tid], mesh.tangents[tid]));
+		if(glm::dot(glm::cross(mesh.normals[tid], mesh.tangents[tid]), mesh.binormals[tid]) < 0.0f){
+			mesh.tangents[tid] *= -1.0f;
+		}
+	}
+}
+
+/** Compute the largest difference between two lists of vectors.
+ \param a the first list
+ \param b the second list
+ \return the maximum absolute difference over all components
+ \ingroup MeshBenchmark
+ */
+float maxDifference(const std::vector<glm::vec3> & a, const std::vector<glm::vec3> & b){
+	if(a.size() != b.size()){
+		return std::numeric_limits<float>::infinity();
+	}
+	float diff = 0.0f;
+	for(size_t i = 0; i < a.size(); ++i){
+		const glm::vec3 d = glm::abs(a[i] - b[i]);
+		diff = (std::max)(diff, (std::max)(d.x, (std::max)(d.y, d.z)));
+	}
+	return diff;
+}
+
+/** Reference ray-mesh intersection, testing all triangles.
+ \param mesh the mesh to test
+ \param origin the ray origin
+ \param direction the ray direction
+ \return the distance to the closest intersection, or -1 if there is none
+ \ingroup MeshBenchmark
+ */
+float intersectsBruteForce(const Mesh & mesh, const glm::vec3 & origin, const glm::vec3 & direction){
+	float best = std::numeric_limits<float>::max();
+	for(size_t iid = 0; iid + 2 < mesh.indices.size(); iid += 3){
+		const glm::vec3 & v0 = mesh.positions[mesh.indices[iid]];
+		const glm::vec3 e1 = mesh.positions[mesh.indices[iid + 1]] - v0;
+		const glm::vec3 e2 = mesh.positions[mesh.indices[iid + 2]] - v0;
+		const glm::vec3 p = glm::cross(direction, e2);
+		const float det = glm::dot(e1, p);
+		if(std::abs(det) <= 1e-12f){
+			continue;
+		}
+		const glm::vec3 s = origin - v0;
+		const float u = glm::dot(s, p) / det;
+		const glm::vec3 q = glm::cross(s, e1);
+		const float v = glm::dot(direction, q) / det;
+		const float t = glm::dot(e2, q) / det;
+		if(u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < best){
+			best = t;
+		}
+	}
+	return best == std::numeric_limits<float>::max() ? -1.0f : best;
+}
+
+/** Run a task several times and return the best duration.
+ \param iterations the number of repetitions
+ \param task the task to measure
+ \return the shortest duration, in seconds
+ \ingroup MeshBenchmark
+ */
+template<typename Task>
+double measure(const unsigned int iterations, Task task){
+	double best = 1e30;
+	for(unsigned int i = 0; i < iterations; ++i){
+		const auto start = std::chrono::high_resolution_clock::now();
+		task();
+		const auto end = std::chrono::high_resolution_clock::now();
+		best = (std::min)(best, std::chrono::duration<double>(end - start).count());
+	}
+	return best;
+}
+
+/** List the thread counts to benchmark: the powers of two below the maximum, followed by the maximum itself.
+ \param maxThreads the maximum number of threads
+ \return the increasing thread counts
+ \ingroup MeshBenchmark
+ */
+std::vector<unsigned int> threadCounts(const unsigned int maxThreads){
+	std::vector<unsigned int> counts;
+	for(unsigned int threads = 1; threads < maxThreads; threads *= 2){
+		counts.push_back(threads);
+	}
+	counts.push_back((std::max)(maxThreads, 1u));
+	return counts;
+}
+
+/** Check if two meshes have exactly the same content.
+ \param mesh0 the first mesh
+ \param mesh1 the second mesh
+ \return true if all attributes and indices are identical
+ \ingroup MeshBenchmark
+ */
+bool identicalMeshes(const Mesh & mesh0, const Mesh & mesh1){
+	return mesh0.positions == mesh1.positions && mesh0.normals == mesh1.normals && mesh0.texcoords == mesh1.texcoords && mesh0.indices == mesh1.indices;
+}
+
+/** Reference vertex deduplication, based on an ordered map.
+ \param corners the (position, uv, normal) indices of each face corner
+ \param indices will contain the index of the distinct triplet used by each corner
+ \param uniqueCorners will contain the distinct triplets
+ \ingroup MeshBenchmark
+ */
+void deduplicateCornersWithMap(const std::vector<glm::ivec3> & corners, std::vector<unsigned int> & indices, std::vector<glm::ivec3> & uniqueCorners){
+	std::map<std::tuple<int, int, int>, unsigned int> indicesUsed;
+	indices.clear();
+	uniqueCorners.clear();
+	for(const glm::ivec3 & corner : corners){
+		const auto key = std::make_tuple(corner[0], corner[1], corner[2]);
+		const auto existing = indicesUsed.find(key);
+		if(existing != indicesUsed.end()){
+			indices.push_back(existing->second);
+			continue;
+		}
+		const unsigned int index = (unsigned int)uniqueCorners.size();
+		indicesUsed[key] = index;
+		indices.push_back(index);
+		uniqueCorners.push_back(corner);
+	}
+}
+
+/** Benchmark the mesh utilities on a mesh file or a generated grid.
+ Expects "--mesh-path path/to/mesh.obj" (optional), "--iterations N", "--grid-size N", "--threads N", "--tangents-grid-size N" and "--rays N".
+ \param argc the number of input arguments.
+ \param argv a pointer to the raw input arguments.
+ \return a general error code.
+ \ingroup MeshBenchmark
+ */
+int main(int argc, char** argv) {
+
+	MeshBenchmarkConfig config(argc, argv);
+
+	// Load or generate the OBJ content.
+	std::string content;
+	if(!config.meshPath.empty()){
+		Log::Info() << Log::Utilities << "Loading mesh at path " << config.meshPath << "." << std::endl;
+		content = Resources::loadStringFromExternalFile(config.meshPath);
+	} else {
+		Log::Info() << Log::Utilities << "Generating a " << config.gridSize << "x" << config.gridSize << " grid." << std::endl;
+		content = generateGridObj(config.gridSize);
+	}
+	if(content.empty()){
+		Log::Error() << Log::Utilities << "No mesh data." << std::endl;
+		return 1;
+	}
+	const double megabytes = double(content.size()) / (1024.0 * 1024.0);
+	Log::Info() << Log::Utilities << "OBJ size: " << megabytes << " MB." << std::endl;
+
+	// OBJ parsing throughput for each mode.
+	const std::vector<std::pair<MeshUtilities::LoadMode, std::string>> modes = {
+		{ MeshUtilities::Points, "Points" }, { MeshUtilities::Expanded, "Expanded" }, { MeshUtilities::Indexed, "Indexed" }
+	};
+	for(const auto & mode : modes){
+		Mesh mesh;
+		const double duration = measure(config.iterations, [&content, &mesh, &mode](){
+			MeshUtilities::loadObj(content.c_str(), content.size(), mesh, mode.first);
+		});
+		Log::Info() << Log::Utilities << "loadObj (" << mode.second << "): " << duration * 1000.0 << " ms, " << megabytes / duration << " MB/s, " << mesh.indices.size() / 3 << " faces, " << mesh.positions.size() << " vertices." << std::endl;
+		
+		// Parallel version, checked against the serial result.
+		Mesh meshParallel;
+		const unsigned int threads = config.threads;
+		const double durationParallel = measure(config.iterations, [&content, &meshParallel, &mode, threads](){
+			MeshUtilities::loadObjParallel(content.c_str(), content.size(), meshParallel, mode.first, threads);
+		});
+		Log::Info() << Log::Utilities << "loadObjParallel (" << mode.second << "): " << durationParallel * 1000.0 << " ms, " << megabytes / durationParallel << " MB/s, speedup x" << duration / durationParallel << ", " << (identicalMeshes(mesh, meshParallel) ? "identical" : "DIFFERENT") << " result." << std::endl;
+	}
+	
+	// Vertex deduplication, on face corners sharing positions and texture coordinates, with one normal per quad.
+	{
+		Mesh mesh;
+		MeshUtilities::loadObj(content.c_str(), content.size(), mesh, MeshUtilities::Indexed);
+		std::vector<glm::ivec3> corners(mesh.indices.size());
+		for(size_t cid = 0; cid < corners.size(); ++cid){
+			const int index = int(mesh.indices[cid]);
+			corners[cid] = glm::ivec3(index, index, int(cid / 6));
+		}
+		std::vector<unsigned int> indicesMap, indicesHash;
+		std::vector<glm::ivec3> uniqueMap, uniqueHash;
+		const double durationMap = measure(config.iterations, [&](){
+			deduplicateCornersWithMap(corners, indicesMap, uniqueMap);
+		});
+		const double durationHash = measure(config.iterations, [&](){
+			MeshUtilities::deduplicateCorners(corners, indicesHash, uniqueHash);
+		});
+		const bool identical = indicesMap == indicesHash && uniqueMap == uniqueHash;
+		Log::Info() << Log::Utilities << "deduplicateCorners (" << corners.size() << " corners, " << uniqueHash.size() << " vertices): ordered map " << durationMap * 1000.0 << " ms, hash table " << durationHash * 1000.0 << " ms, speedup x" << durationMap / durationHash << ", " << (identical ? "identical" : "DIFFERENT") << " result." << std::endl;
+	}
+	
+	// Vertex cache optimization, with statistics on a 16 entries FIFO cache.
+	{
+		Mesh mesh;
+		MeshUtilities::loadObj(content.c_str(), content.size(), mesh, MeshUtilities::Indexed);
+		float acmr, atvr;
+		MeshUtilities::analyzeVertexCache(mesh, 16, acmr, atvr);
+		Log::Info() << Log::Utilities << "Input order: ACMR " << acmr << ", ATVR " << atvr << "." << std::endl;
+		Mesh optimized;
+		const double durationCache = measure(config.iterations, [&mesh, &optimized](){
+			optimized = mesh;
+			MeshUtilities::optimizeVertexCache(optimized);
+		});
+		MeshUtilities::analyzeVertexCache(optimized, 16, acmr, atvr);
+		Log::Info() << Log::Utilities << "optimizeVertexCache: " << durationCache * 1000.0 << " ms, ACMR " << acmr << ", ATVR " << atvr << "." << std::endl;
+		const double durationOverdraw = measure(1, [&optimized](){
+			MeshUtilities::optimizeOverdraw(optimized);
+		});
+		MeshUtilities::analyzeVertexCache(optimized, 16, acmr, atvr);
+		Log::Info() << Log::Utilities << "optimizeOverdraw: " << durationOverdraw * 1000.0 << " ms, ACMR " << acmr << ", ATVR " << atvr << "." << std::endl;
+		const double durationFetch = measure(1, [&optimized](){
+			MeshUtilities::optimizeVertexFetch(optimized);
+		});
+		Log::Info() << Log::Utilities << "optimizeVertexFetch: " << durationFetch * 1000.0 << " ms." << std::endl;
+		
+		// Check that the same triangles are still present, using positions to identify them.
+		auto sortedTriangles = [](const Mesh & m){
+			std::vector<std::vector<float>> triangles(m.indices.size() / 3);
+			for(size_t tid = 0; tid < triangles.size(); ++tid){
+				for(size_t k = 0; k < 3; ++k){
+					const glm::vec3 & p = m.positions[m.indices[3 * tid + k]];
+					triangles[tid].insert(triangles[tid].end(), { p.x, p.y, p.z });
+				}
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		};
+		Log::Info() << Log::Utilities << "Optimized mesh has " << (sortedTriangles(mesh) == sortedTriangles(optimized) ? "identical" : "DIFFERENT") << " triangles." << std::endl;
+	}
+	
+	// Levels of detail generation.
+	{
+		Mesh mesh;
+		MeshUtilities::loadObj(content.c_str(), content.size(), mesh, MeshUtilities::Indexed);
+		Mesh simplified;
+		const double duration = measure(1, [&mesh, &simplified](){
+			simplified = mesh;
+			MeshUtilities::generateLevels(simplified, Resources::meshLevelCount, Resources::meshLevelMaxError);
+		});
+		Log::Info() << Log::Utilities << "generateLevels: " << duration * 1000.0 << " ms." << std::endl;
+		for(size_t lid = 0; lid < simplified.levels.size(); ++lid){
+			Log::Info() << Log::Utilities << "Level " << lid << ": " << simplified.levels[lid].indexCount / 3 << " faces, error " << simplified.levels[lid].error << "." << std::endl;
+		}
+	}
+	
+	// Hierarchy construction and ray queries.
+	if(config.rays > 0){
+		Mesh mesh;
+		MeshUtilities::loadObj(content.c_str(), content.size(), mesh, MeshUtilities::Indexed);
+		const unsigned int maxThreads = config.threads > 0 ? config.threads : ThreadUtilities::threadCount();
+		Raycaster raycaster;
+		raycaster.addMesh(mesh);
+		double durationBuildSerial = 0.0;
+		for(const unsigned int threads : threadCounts(maxThreads)){
+			const double duration = measure(config.iterations, [&raycaster, threads](){
+				raycaster.updateHierarchy(threads);
+			});
+			durationBuildSerial = threads == 1 ? duration : durationBuildSerial;
+			Log::Info() << Log::Utilities << "Raycaster::updateHierarchy (" << threads << " threads): " << duration * 1000.0 << " ms, " << raycaster.nodeCount() << " nodes, speedup x" << durationBuildSerial / duration << "." << std::endl;
+		}
+		
+		// Rays from a sphere around the mesh toward random points in its bounding box.
+		const BoundingBox bbox = MeshUtilities::computeBoundingBox(mesh);
+		const BoundingSphere sphere = bbox.getSphere();
+		std::vector<glm::vec3> origins(config.rays);
+		std::vector<glm::vec3> directions(config.rays);
+		Random::seed(2019);
+		for(size_t rid = 0; rid < config.rays; ++rid){
+			const float phi = Random::Float(0.0f, 2.0f * float(M_PI));
+			const float cosTheta = Random::Float(-1.0f, 1.0f);
+			const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			origins[rid] = sphere.center + 2.0f * sphere.radius * glm::vec3(sinTheta * std::cos(phi), cosTheta, sinTheta * std::sin(phi));
+			const glm::vec3 target = bbox.minis + glm::vec3(Random::Float(), Random::Float(), Random::Float()) * (bbox.maxis - bbox.minis);
+			directions[rid] = glm::normalize(target - origins[rid]);
+		}
+		
+		// Check a subset of rays against a brute force test.
+		const size_t checkCount = (std::min)(size_t(config.rays), size_t(1000));
+		float maxError = 0.0f;
+		size_t mismatches = 0;
+		for(size_t rid = 0; rid < checkCount; ++rid){
+			const Raycaster::RayHit hit = raycaster.intersects(origins[rid], directions[rid]);
+			const float reference = intersectsBruteForce(mesh, origins[rid], directions[rid]);
+			if(hit.hit != (reference >= 0.0f) || hit.hit != raycaster.intersectsAny(origins[rid], directions[rid])){
+				++mismatches;
+			} else if(hit.hit){
+				maxError = (std::max)(maxError, std::abs(hit.dist - reference));
+			}
+		}
+		Log::Info() << Log::Utilities << "Raycaster: " << mismatches << " mismatches with brute force on " << checkCount << " rays, max distance error " << maxError << "." << std::endl;
+		
+		std::vector<unsigned char> hits(config.rays);
+		for(const unsigned int threads : threadCounts(maxThreads)){
+			const double durationClosest = measure(config.iterations, [&](){
+				ThreadUtilities::parallelFor(config.rays, [&](size_t begin, size_t end, unsigned int){
+					for(size_t rid = begin; rid < end; ++rid){
+						hits[rid] = raycaster.intersects(origins[rid], directions[rid]).hit ? 1 : 0;
+					}
+				}, threads);
+			});
+			const double durationAny = measure(config.iterations, [&](){
+				ThreadUtilities::parallelFor(config.rays, [&](size_t begin, size_t end, unsigned int){
+					for(size_t rid = begin; rid < end; ++rid){
+						hits[rid] = raycaster.intersectsAny(origins[rid], directions[rid]) ? 1 : 0;
+					}
+				}, threads);
+			});
+			const double durationPoint = measure(config.iterations, [&](){
+				ThreadUtilities::parallelFor(config.rays, [&](size_t begin, size_t end, unsigned int){
+					for(size_t rid = begin; rid < end; ++rid){
+						// Query points scattered around the surface.
+						hits[rid] = raycaster.closestPoint(0.5f * (origins[rid] + sphere.center)).hit ? 1 : 0;
+					}
+				}, threads);
+			});
+			const double megaRays = double(config.rays) / 1000000.0;
+			Log::Info() << Log::Utilities << "Raycaster (" << threads << " threads): closest hit " << megaRays / durationClosest << " Mrays/s, any hit " << megaRays / durationAny << " Mrays/s, closest point " << megaRays / durationPoint << " Mqueries/s." << std::endl;
+		}
+	}
+	
+	// Tangents computation on a large grid, serial reference against the parallel version with an increasing number of threads.
+	if(config.tangentsGridSize > 0){
+		Mesh mesh;
+		generateGridMesh(config.tangentsGridSize, mesh);
+		Log::Info() << Log::Utilities << "Tangents on a grid with " << mesh.indices.size() / 3 << " triangles." << std::endl;
+		const double durationSerial = measure(config.iterations, [&mesh](){
+			computeTangentsAndBinormalsSerial(mesh);
+		});
+		const std::vector<glm::vec3> tangentsRef = mesh.tangents;
+		const std::vector<glm::vec3> binormalsRef = mesh.binormals;
+		Log::Info() << Log::Utilities << "Serial reference: " << durationSerial * 1000.0 << " ms." << std::endl;
+		const unsigned int maxThreads = config.threads > 0 ? config.threads : ThreadUtilities::threadCount();
+		for(const unsigned int threads : threadCounts(maxThreads)){
+			const double duration = measure(config.iterations, [&mesh, threads](){
+				MeshUtilities::computeTangentsAndBinormals(mesh, MeshUtilities::Accumulated, threads);
+			});
+			Log::Info() << Log::Utilities << "computeTangentsAndBinormals (" << threads << " threads): " << duration * 1000.0 << " ms, speedup x" << durationSerial / duration << ", max difference " << (std::max)(maxDifference(mesh.tangents, tangentsRef), maxDifference(mesh.binormals, binormalsRef)) << "." << std::endl;
+		}
+		const double durationMikk = measure(config.iterations, [&mesh, maxThreads](){
+			MeshUtilities::computeTangentsAndBinormals(mesh, MeshUtilities::MikkTSpace, maxThreads);
+		});
+		Log::Info() << Log::Utilities << "computeTangentsAndBinormals (MikkTSpace, " << maxThreads << " threads): " << durationMikk * 1000.0 << " ms, max tangent difference with the accumulated mode " << maxDifference(mesh.tangents, tangentsRef) << "." << std::endl;
+	}
+
+	return 0;
+}
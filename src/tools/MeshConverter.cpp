@@ -0,0 +1,132 @@
+#include "Common.hpp"
+#include "Config.hpp"
+#include "resources/MeshUtilities.hpp"
+#include "resources/ResourcesManager.hpp"
+
+/**
+ \defgroup MeshConverter Mesh Converter
+ \brief Convert OBJ files to preprocessed binary meshes (.mesh), containing the final indexed attributes, tangents and bounding box.
+ \details The resulting files can be shipped instead of the OBJs, and are loaded by the resources manager without any parsing or processing.
+ \ingroup Tools
+ */
+
+/** \brief Configuration for the mesh conversion tool.
+ \ingroup MeshConverter
+ */
+class MeshConverterConfig : public Config {
+public:
+	
+	/** Initialize a new config object, parsing the input arguments and filling the attributes with their values.
+	 \param argc the number of input arguments.
+	 \param argv a pointer to the raw input arguments.
+	 */
+	MeshConverterConfig(int argc, char** argv) : Config(argc, argv) {
+		processArguments();
+	}
+	
+	/**
+	 Read the internal (key, [values]) populated dictionary, and transfer their values to the configuration attributes.
+	 */
+	void processArguments(){
+		
+		for(const auto & arg : _rawArguments){
+			const std::string key = arg.first;
+			const std::vector<std::string> & values = arg.second;
+			
+			if(key == "mesh-path"){
+				meshPaths = values;
+			} else if(key == "output-path"){
+				outputPath = values[0];
+			} else if(key == "levels"){
+				levelCount = (unsigned int)std::stoi(values[0]);
+			} else if(key == "max-error"){
+				maxError = std::stof(values[0]);
+			}
+		}
+	}
+	
+public:
+	
+	std::vector<std::string> meshPaths; ///< Paths to the OBJ files to convert.
+	
+	std::string outputPath = ""; ///< Result output path, only used when converting a single file.
+	
+	unsigned int levelCount = Resources::meshLevelCount; ///< Maximum number of levels of detail, including the original mesh.
+	
+	float maxError = Resources::meshLevelMaxError; ///< Maximum error of levels of detail, relative to the mesh size.
+	
+};
+
+/** Convert an OBJ file to a binary mesh.
+ \param inputPath the path to the OBJ file
+ \param outputPath the path to the binary mesh to write
+ \param config the conversion settings
+ \return true if the conversion succeeded
+ \ingroup MeshConverter
+ */
+bool convertMesh(const std::string & inputPath, const std::string & outputPath, const MeshConverterConfig & config){
+	size_t rawSize = 0;
+	char * rawContent = Resources::loadRawDataFromExternalFile(inputPath, rawSize);
+	if(rawContent == NULL || rawSize == 0){
+		free(rawContent);
+		return false;
+	}
+	// Same processing as the one performed by the resources manager.
+	Mesh mesh;
+	MeshUtilities::loadObjParallel(rawContent, rawSize, mesh, MeshUtilities::Indexed);
+	free(rawContent);
+	MeshUtilities::generateLevels(mesh, config.levelCount, config.maxError);
+	MeshUtilities::optimizeMesh(mesh);
+	MeshUtilities::computeTangentsAndBinormals(mesh);
+	const BoundingBox bbox = MeshUtilities::computeBoundingBox(mesh);
+	
+	// Store the source file infos, so that the blob can be invalidated if the OBJ is modified.
+	uint64_t sourceSize = 0;
+	uint64_t sourceTime = 0;
+	Resources::getExternalFileInfos(inputPath, sourceSize, sourceTime);
+	std::vector<char> blob;
+	if(!MeshUtilities::saveMeshBlob(mesh, bbox, sourceSize, sourceTime, blob)){
+		return false;
+	}
+	Resources::saveRawDataToExternalFile(outputPath, &blob[0], blob.size());
+	Log::Info() << Log::Utilities << "Converted " << inputPath << " to " << outputPath << " (" << mesh.positions.size() << " vertices)." << std::endl;
+	for(size_t lid = 0; lid < mesh.levels.size(); ++lid){
+		Log::Info() << Log::Utilities << "Level " << lid << ": " << mesh.levels[lid].indexCount / 3 << " faces, error " << mesh.levels[lid].error << "." << std::endl;
+	}
+	return true;
+}
+
+/** Binary mesh converter.
+ Expects "--mesh-path path/to/mesh0.obj path/to/mesh1.obj ..." and optionally "--output-path path/to/output.mesh" when converting a single file, "--levels N" and "--max-error E" to configure the levels of detail. By default, each binary mesh is saved next to its OBJ file.
+ \param argc the number of input arguments.
+ \param argv a pointer to the raw input arguments.
+ \return a general error code.
+ \ingroup MeshConverter
+ */
+int main(int argc, char** argv) {
+	
+	MeshConverterConfig config(argc, argv);
+	
+	if(config.meshPaths.empty()){
+		Log::Error() << Log::Utilities << "Need at least one mesh path." << std::endl;
+		return 2;
+	}
+	if(!config.outputPath.empty() && config.meshPaths.size() > 1){
+		Log::Error() << Log::Utilities << "An output path can only be specified for a single mesh." << std::endl;
+		return 2;
+	}
+	
+	int errors = 0;
+	for(const std::string & meshPath : config.meshPaths){
+		std::string outputPath = config.outputPath;
+		if(outputPath.empty()){
+			const size_t lastPoint = meshPath.find_last_of(".");
+			outputPath = (lastPoint == std::string::npos ? meshPath : meshPath.substr(0, lastPoint)) + ".mesh";
+		}
+		if(!convertMesh(meshPath, outputPath, config)){
+			Log::Error() << Log::Utilities << "Unable to convert mesh at path " << meshPath << "." << std::endl;
+			++errors;
+		}
+	}
+	return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+#include "Common.hpp"
+#include "Config.hpp"
+#include "resources/ImageUtilities.hpp"
+#include "resources/MipmapUtilities.hpp"
+#include "resources/ResourcesManager.hpp"
+#include "resources/TextureCompression.hpp"
+#include "resources/TextureContainer.hpp"
+#include "helpers/HalfFloat.hpp"
+
+/**
+ \defgroup MipmapGenerator Mipmap Generator
+ \brief Generate the mipmap levels of textures and cubemaps offline, filtering in linear space.
+ \details The levels are saved as name_0, name_1,... down to 1x1 (name_0_px, name_0_nx,... for cubemaps), or in a single name.ktx2 container holding all levels and faces, optionally block compressed. They can be shipped instead of the original images, and are then uploaded as is by the resources manager.
+ \ingroup Tools
+ */
+
+/** \brief Configuration for the mipmap generation tool.
+ \ingroup MipmapGenerator
+ */
+class MipmapGeneratorConfig : public Config {
+public:
+
+	/** Initialize a new config object, parsing the input arguments and filling the attributes with their values.
+	 \param argc the number of input arguments.
+	 \param argv a pointer to the raw input arguments.
+	 */
+	MipmapGeneratorConfig(int argc, char** argv) : Config(argc, argv) {
+		processArguments();
+	}
+	
+	/**
+	 Read the internal (key, [values]) populated dictionary, and transfer their values to the configuration attributes.
+	 */
+	void processArguments(){
+	
+		for(const auto & arg : _rawArguments){
+			const std::string key = arg.first;
+			const std::vector<std::string> & values = arg.second;
+			
+			if(key == "image-path"){
+				imagePaths = values;
+			} else if(key == "cubemap-path"){
+				cubemapPaths = values;
+			} else if(key == "output-path" && !values.empty()){
+				outputPath = values[0];
+			} else if(key == "filter"){
+				if(!values.empty() && !MipmapUtilities::parseFilter(values[0], filter)){
+					Log::Warning() << Log::Utilities << "Unknown filter " << values[0] << ", expected box, kaiser or lanczos." << std::endl;
+				}
+			} else if(key == "linear"){
+				sRGB = false;
+			} else if(key == "coverage"){
+				preserveCoverage = true;
+			} else if(key == "container"){
+				container = true;
+			} else if(key == "compress"){
+				container = true;
+				if(!values.empty() && !TextureCompression::parseFormat(values[0], compression)){
+					Log::Warning() << Log::Utilities << "Unknown compression format " << values[0] << ", expected bc1, bc3, bc4, bc5, bc6h or bc7." << std::endl;
+				}
+			} else if(key == "quality"){
+				if(!values.empty() && !TextureCompression::parseQuality(values[0], quality)){
+					Log::Warning() << Log::Utilities << "Unknown compression quality " << values[0] << ", expected fast, normal or high." << std::endl;
+				}
+			}
+		}
+	}
+
+public:
+
+	std::vector<std::string> imagePaths; ///< Paths to the images to process.
+	
+	std::vector<std::string> cubemapPaths; ///< Base paths of the cubemaps to process, without the faces suffixes and extension.
+	
+	std::string outputPath = ""; ///< Output directory, by default the levels are saved next to their source.
+	
+	MipmapUtilities::Filter filter = Resources::mipmapFilter; ///< Downsampling kernel.
+	
+	bool sRGB = true; ///< Are LDR images gamma encoded.
+	
+	bool preserveCoverage = false; ///< Should the alpha coverage be preserved in all levels, for alpha-tested textures.
+	
+	bool container = false; ///< Save all levels and faces in a single container.
+	
+	TextureCompression::Format compression = TextureCompression::None; ///< Block compression of the container content.
+	
+	TextureCompression::Quality quality = TextureCompression::Normal; ///< Block compression quality.
+
+};
+
+/** Split a path into the directory and the base name of the file.
+ \param path the file path, with or without extension
+ \param directory will contain the directory, with a trailing separator if not empty
+ \param name will contain the file name without extension
+ \ingroup MipmapGenerator
+ */
+void splitPath(const std::string & path, std::string & directory, std::string & name){
+	const size_t separator = path.find_last_of("/\\");
+	directory = separator == std::string::npos ? "" : path.substr(0, separator + 1);
+	name = separator == std::string::npos ? path : path.substr(separator + 1);
+	const size_t dot = name.find_last_of(".");
+	if(dot != std::string::npos && dot > 0){
+		name = name.substr(0, dot);
+	}
+}
+
+/** Load images from disk.
+ \param paths the images paths
+ \param flip should LDR images be vertically flipped
+ \param images will contain the decoded images
+ \return true if all images were loaded
+ \ingroup MipmapGenerator
+ */
+bool loadImages(const std::vector<std::string> & paths, const bool flip, std::vector<DecodedImage> & images){
+	images.assign(paths.size(), DecodedImage());
+	for(size_t iid = 0; iid < paths.size(); ++iid){
+		DecodedImage & image = images[iid];
+		image.hdr = ImageUtilities::isHDR(paths[iid]);
+		image.status = ImageUtilities::loadNativeImage(paths[iid], image.width, image.height, image.channels, &image.data, image.half, flip && !image.hdr, true);
+		if(image.status != 0){
+			Log::Error() << Log::Resources << "Unable to load the image at path " << paths[iid] << "." << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/** Save an image level to disk, as a PNG for LDR images or an EXR for HDR images.
+ \param image the image
+ \param path the path without extension
+ \return true if the image was saved
+ \ingroup MipmapGenerator
+ */
+bool saveImage(const DecodedImage & image, const std::string & path){
+	if(!image.hdr){
+		return ImageUtilities::saveLDRImage(path + ".png", image.width, image.height, image.channels, static_cast<const unsigned char *>(image.data), false) == 0;
+	}
+	const size_t count = size_t(image.width) * size_t(image.height) * size_t(image.channels);
+	if(!image.half){
+		return ImageUtilities::saveHDRImage(path + ".exr", image.width, image.height, image.channels, static_cast<const float *>(image.data), false) == 0;
+	}
+	std::vector<float> values(count);
+	HalfFloat::toFloats(static_cast<const uint16_t *>(image.data), count, &values[0]);
+	return ImageUtilities::saveHDRImage(path + ".exr", image.width, image.height, image.channels, &values[0], false) == 0;
+}
+
+/** Generate and save the mipmap levels of a texture or a cubemap.
+ \param paths the images paths, one for a texture, six faces for a cubemap
+ \param outputName the output path, without level suffix and extension
+ \param cubemap are the images cubemap faces
+ \param config the generation settings
+ \return true if all levels were saved
+ \ingroup MipmapGenerator
+ */
+bool generateMipmaps(const std::vector<std::string> & paths, const std::string & outputName, const bool cubemap, const MipmapGeneratorConfig & config){
+	std::vector<DecodedImage> images;
+	// Containers store 2D textures as uploaded, flipped.
+	bool success = loadImages(paths, config.container && !cubemap, images);
+	if(success && !MipmapUtilities::generate(images, cubemap, config.sRGB, config.filter, config.preserveCoverage)){
+		Log::Error() << Log::Utilities << "Unable to generate mipmaps for " << outputName << ", images should have the same size and format." << std::endl;
+		success = false;
+	}
+	if(success && config.compression != TextureCompression::None){
+		for(DecodedImage & image : images){
+			if(!TextureCompression::encode(image, config.compression, config.quality, config.sRGB)){
+				Log::Error() << Log::Utilities << "Unable to compress " << outputName << ", BC6H is for HDR images only and other formats for LDR images." << std::endl;
+				success = false;
+				break;
+			}
+		}
+	}
+	if(success && config.container && !TextureContainer::save(outputName + ".ktx2", images, cubemap, config.sRGB)){
+		success = false;
+	}
+	const std::vector<std::string> suffixes = { "_px", "_nx", "_py", "_ny", "_pz", "_nz" };
+	const size_t faceCount = cubemap ? 6 : 1;
+	for(size_t iid = 0; iid < images.size() && success && !config.container; ++iid){
+		const std::string levelName = outputName + "_" + std::to_string(iid / faceCount) + (cubemap ? suffixes[iid % faceCount] : "");
+		if(!saveImage(images[iid], levelName)){
+			Log::Error() << Log::Utilities << "Unable to save level at path " << levelName << "." << std::endl;
+			success = false;
+		}
+	}
+	for(DecodedImage & image : images){
+		free(image.data);
+		image.data = NULL;
+	}
+	if(success){
+		Log::Info() << Log::Utilities << "Generated " << images.size() / faceCount << " levels for " << outputName << "." << std::endl;
+	}
+	return success;
+}
+
+/** Mipmap generator.
+ Expects "--image-path path/to/image0.png path/to/image1.exr ..." and/or "--cubemap-path path/to/cubemap0 ..." (without the faces suffixes and extension). Optionally "--output-path path/to/directory", "--filter box|kaiser|lanczos", "--linear" for LDR images that are not gamma encoded (normal maps, roughness,...), "--coverage" to preserve the alpha coverage of alpha-tested textures, "--container" to save all levels in a single KTX2 file and "--compress bc1|bc3|bc4|bc5|bc6h|bc7" with "--quality fast|normal|high" to block compress its content. By default, the levels are saved next to each source.
+ \param argc the number of input arguments.
+ \param argv a pointer to the raw input arguments.
+ \return a general error code.
+ \ingroup MipmapGenerator
+ */
+int main(int argc, char** argv) {
+
+	MipmapGeneratorConfig config(argc, argv);
+	
+	if(config.imagePaths.empty() && config.cubemapPaths.empty()){
+		Log::Error() << Log::Utilities << "Need at least one image or cubemap path." << std::endl;
+		return 2;
+	}
+	
+	int errors = 0;
+	std::string directory;
+	std::string name;
+	for(const std::string & imagePath : config.imagePaths){
+		splitPath(imagePath, directory, name);
+		const std::string outputDirectory = config.outputPath.empty() ? directory : (config.outputPath + "/");
+		if(!generateMipmaps({ imagePath }, outputDirectory + name, false, config)){
+			++errors;
+		}
+	}
+	
+	// Find the extension of the cubemap faces.
+	const std::vector<std::string> extensions = { ".exr", ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+	for(const std::string & cubemapPath : config.cubemapPaths){
+		std::vector<std::string> paths;
+		for(const std::string & extension : extensions){
+			uint64_t size = 0;
+			uint64_t time = 0;
+			if(Resources::getExternalFileInfos(cubemapPath + "_px" + extension, size, time)){
+				for(const char * suffix : { "_px", "_nx", "_py", "_ny", "_pz", "_nz" }){
+					paths.push_back(cubemapPath + suffix + extension);
+				}
+				break;
+			}
+		}
+		if(paths.empty()){
+			Log::Error() << Log::Utilities << "Unable to find cubemap at path " << cubemapPath << "." << std::endl;
+			++errors;
+			continue;
+		}
+		splitPath(cubemapPath, directory, name);
+		const std::string outputDirectory = config.outputPath.empty() ? directory : (config.outputPath + "/");
+		if(!generateMipmaps(paths, outputDirectory + name, true, config)){
+			++errors;
+		}
+	}
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "Common.hpp"
+#include "Config.hpp"
+#include "resources/ResourcePack.hpp"
+#include "resources/ResourcesManager.hpp"
+
+/**
+ \defgroup ResourcePacker Resource Packer
+ \brief Build a resource pack (.pack) from a resources directory.
+ \details Packs store files uncompressed by default, each aligned on a memory page, so that the resources manager can map the pack and reference the files in place. Files can optionally be compressed with LZ4 when it reduces their size significantly.
+ \ingroup Tools
+ */
+
+/** \brief Configuration for the resource packing tool.
+ \ingroup ResourcePacker
+ */
+class ResourcePackerConfig : public Config {
+public:
+
+	/** Initialize a new config object, parsing the input arguments and filling the attributes with their values.
+	 \param argc the number of input arguments.
+	 \param argv a pointer to the raw input arguments.
+	 */
+	ResourcePackerConfig(int argc, char** argv) : Config(argc, argv) {
+		processArguments();
+	}
+	
+	/**
+	 Read the internal (key, [values]) populated dictionary, and transfer their values to the configuration attributes.
+	 */
+	void processArguments(){
+	
+		for(const auto & arg : _rawArguments){
+			const std::string key = arg.first;
+			const std::vector<std::string> & values = arg.second;
+			
+			if(key == "input-path"){
+				inputPath = values[0];
+			} else if(key == "output-path"){
+				outputPath = values[0];
+			} else if(key == "compress"){
+				compress = true;
+			}
+		}
+	}
+
+public:
+
+	std::string inputPath = ""; ///< Path to the resources directory to pack.
+	
+	std::string outputPath = ""; ///< Path to the pack to write, by default next to the directory.
+	
+	bool compress = false; ///< Should the files be compressed when possible.
+
+};
+
+/** Resource packer.
+ Expects "--input-path path/to/resources/directory" and optionally "--output-path path/to/output.pack" and "--compress". By default, the pack is saved next to the directory, with the same name. Files are stored with their path relative to the directory.
+ \param argc the number of input arguments.
+ \param argv a pointer to the raw input arguments.
+ \return a general error code.
+ \ingroup ResourcePacker
+ */
+int main(int argc, char** argv) {
+
+	ResourcePackerConfig config(argc, argv);
+	
+	// Remove trailing separators from the directory path.
+	std::string inputPath = config.inputPath;
+	while(!inputPath.empty() && (inputPath.back() == '/' || inputPath.back() == '\\')){
+		inputPath.pop_back();
+	}
+	if(inputPath.empty()){
+		Log::Error() << Log::Utilities << "Need a resources directory path." << std::endl;
+		return 2;
+	}
+	const std::string outputPath = config.outputPath.empty() ? (inputPath + ".pack") : config.outputPath;
+	
+	std::vector<std::string> names;
+	Resources::getExternalFiles(inputPath, names);
+	if(names.empty()){
+		Log::Error() << Log::Utilities << "No files found in directory " << inputPath << "." << std::endl;
+		return 1;
+	}
+	std::map<std::string, std::string> files;
+	for(const std::string & name : names){
+		files[name] = inputPath + "/" + name;
+	}
+	
+	if(!ResourcePack::save(outputPath, files, config.compress)){
+		Log::Error() << Log::Utilities << "Unable to build the resource pack." << std::endl;
+		return 1;
+	}
+	
+	// Summary of the pack content.
+	ResourcePack pack;
+	if(!pack.open(outputPath)){
+		return 1;
+	}
+	uint64_t rawSize = 0;
+	uint64_t storedSize = 0;
+	size_t compressedCount = 0;
+	for(size_t eid = 0; eid < pack.entryCount(); ++eid){
+		const PackEntry & entry = pack.entry(eid);
+		rawSize += entry.rawSize;
+		storedSize += entry.size;
+		compressedCount += (entry.compression != PackEntry::None) ? 1 : 0;
+	}
+	Log::Info() << Log::Utilities << "Packed " << pack.entryCount() << " files (" << compressedCount << " compressed) to " << outputPath << ", " << rawSize << " bytes stored in " << storedSize << " bytes." << std::endl;
+	return 0;
+}
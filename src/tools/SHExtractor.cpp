@@ -2,6 +2,7 @@
 #include "Config.hpp"
 #include "resources/ImageUtilities.hpp"
 #include "resources/ResourcesManager.hpp"
+#include "resources/ArtifactCache.hpp"
 #include <map>
 
 ///
@@ -78,6 +79,27 @@ int main(int argc, char** argv) {
 
 	// Paths for each side.
 	const std::vector<std::string> paths { rootPath + "_px.exr", rootPath + "_nx.exr", rootPath + "_py.exr", rootPath + "_ny.exr", rootPath + "_pz.exr", rootPath + "_nz.exr" };
+	const std::string destinationPath = config.outputPath + "_shcoeffsll.txt";
+	
+	// The coefficients only depend on the cubemap content, look for them in the artifacts cache.
+	ArtifactCache::Key key("shcoeffs", 1);
+	bool cacheResult = ArtifactCache::enabled();
+	for(size_t side = 0; side < 6 && cacheResult; ++side){
+		size_t size = 0;
+		char * content = Resources::loadRawDataFromExternalFile(paths[side], size);
+		if(content == NULL){
+			cacheResult = false;
+			break;
+		}
+		key.add(content, size);
+		free(content);
+	}
+	std::vector<char> artifact;
+	if(cacheResult && ArtifactCache::fetch(key, artifact)){
+		Log::Info() << Log::Utilities << "Found SH coefficients for envmap at path " << rootPath << " in cache." << std::endl;
+		Resources::saveRawDataToExternalFile(destinationPath, artifact.data(), artifact.size());
+		return 0;
+	}
 	
 	// Load cubemap sides.
 	Log::Info() << Log::Utilities << "Loading envmap at path " << rootPath << " ..." << std::endl;
@@ -208,8 +230,11 @@ int main(int argc, char** argv) {
 	for(int i = 0; i < 9; ++i){
 		outputStr << SCoeffs[i][0] << " " << SCoeffs[i][1] << " " << SCoeffs[i][2] << std::endl;
 	}
-	const std::string destinationPath = config.outputPath + "_shcoeffsll.txt";
 	Resources::saveStringToExternalFile(destinationPath, outputStr.str());
+	if(cacheResult){
+		const std::string result = outputStr.str();
+		ArtifactCache::store(key, result.c_str(), result.size());
+	}
 	
 	return 0;
 }
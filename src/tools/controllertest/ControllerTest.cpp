@@ -216,7 +216,7 @@ int main(int argc, char** argv) {
 	std::vector<int> buttonsMapping(Controller::ControllerInputCount, -1);
 	std::vector<int> axesMapping(Controller::ControllerInputCount, -1);
 	// Controller texture.
-	const GLuint controllerTexId = Resources::manager().getTexture("ControllerLayout").id;
+	const std::shared_ptr<TextureInfos> controllerTex = Resources::manager().getTexture("ControllerLayout");
 	
 	bool firstFrame = true;
 	const ImU32 highlightColor = IM_COL32(172, 172, 172, 255);
@@ -396,7 +396,7 @@ int main(int argc, char** argv) {
 					}
 					
 					// Overlay the controller transparent texture.
-					ImGui::Image(reinterpret_cast<void*>(controllerTexId), ImVec2(450, 300), ImVec2(0, 1), ImVec2(1,0));
+					ImGui::Image(reinterpret_cast<void*>(controllerTex->id), ImVec2(450, 300), ImVec2(0, 1), ImVec2(1,0));
 					
 					ImGui::EndChild();
 					ImGui::SameLine();